@@ -0,0 +1,60 @@
+/**
+ * @file main.cpp
+ * @brief Linux gateway example - same API on a Raspberry Pi
+ *
+ * Build with the linux environment (IOT_POSIX):
+ *   pio run -e linux
+ *   .pio/build/linux/program 192.168.1.10 1883
+ *
+ * Without arguments the broker comes from $IOT_CONFIG_DIR/iot-mesurable.prefs
+ * ("broker=..." and "port=..." lines). Replace readCpuTemperature() with your
+ * Modbus or serial reads.
+ */
+
+#include <IotMesurable.h>
+
+IotMesurable brain("linux-gateway");
+
+// SoC temperature in °C, NAN if unavailable
+static float readCpuTemperature() {
+    FILE* file = fopen("/sys/class/thermal/thermal_zone0/temp", "r");
+    if (!file) return NAN;
+    long milliDegrees = 0;
+    bool ok = fscanf(file, "%ld", &milliDegrees) == 1;
+    fclose(file);
+    return ok ? milliDegrees / 1000.0f : NAN;
+}
+
+// The linux test suites link src/ and this file; they bring their own main
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char** argv) {
+    Serial.println("=== iot-mesurable Linux Gateway ===");
+
+    brain.registerHardware("soc", "SoC");
+    brain.addSensor("soc", "temperature");
+
+    // No WiFi to set up: the host's network is used
+    bool started = argc > 1
+        ? brain.begin("", "", argv[1], argc > 2 ? (uint16_t)atoi(argv[2]) : 1883)
+        : brain.begin();
+    if (!started) {
+        Serial.println("No broker configured");
+        return 1;
+    }
+
+    unsigned long lastRead = 0;
+    while (true) {
+        if (millis() - lastRead >= 5000) {
+            lastRead = millis();
+            float temperature = readCpuTemperature();
+            if (!isnan(temperature)) {
+                brain.publish("soc", "temperature", temperature);
+            }
+        }
+
+        // MQTT I/O, status, config and rules
+        brain.loop();
+        delay(10);
+    }
+}
+#endif
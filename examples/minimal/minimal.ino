@@ -0,0 +1,30 @@
+/**
+ * @file minimal.ino
+ * @brief Minimal example - one analog sensor, no external library
+ *
+ * Build with -DIOT_MINIMAL to leave out OTA, the WiFiManager portal,
+ * system info and status publishing. scripts/footprint.sh builds this
+ * sketch in every profile.
+ */
+
+#include <IotMesurable.h>
+
+IotMesurable brain("my-probe");
+
+void setup() {
+    Serial.begin(115200);
+
+    brain.registerHardware("soil", "Soil Moisture");
+    brain.addSensor("soil", "moisture");
+
+    if (!brain.begin("your-ssid", "your-password", "192.168.1.10", 1883)) {
+        Serial.println("Failed to initialize!");
+        while (true) delay(1000);
+    }
+}
+
+void loop() {
+    brain.publish("soil", "moisture", analogRead(34) * 100.0f / 4095.0f);
+    brain.loop();
+    delay(1000);
+}
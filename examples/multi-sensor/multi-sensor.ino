@@ -26,11 +26,14 @@ void setup() {
     }
     
     // Register multiple hardware
+    // Raw ADC counts are scaled to % and filtered by the library
     brain.registerHardware("soil-moisture", "Capacitive Soil Sensor");
-    brain.addSensor("soil-moisture", "moisture");
+    brain.addSensor("soil-moisture", "moisture",
+                    SensorPipeline().linear(100.0f / 4095.0f, 0).median(5));
     
     brain.registerHardware("ldr", "Light Sensor");
-    brain.addSensor("ldr", "light");
+    brain.addSensor("ldr", "light",
+                    SensorPipeline().linear(100.0f / 4095.0f, 0).hampel(5).ema(0.3f));
     
     brain.registerHardware("water-flow", "Flow Meter");
     brain.addSensor("water-flow", "flow_rate");
@@ -57,15 +60,9 @@ volatile unsigned long pulseCount = 0;
 float totalLiters = 0;
 
 void loop() {
-    // Read soil moisture
-    int soilRaw = analogRead(SOIL_PIN);
-    float moisture = map(soilRaw, 0, 4095, 0, 100);
-    brain.publish("soil-moisture", "moisture", moisture);
-    
-    // Read light level
-    int lightRaw = analogRead(LIGHT_PIN);
-    float light = map(lightRaw, 0, 4095, 0, 100);
-    brain.publish("ldr", "light", light);
+    // Publish raw readings, calibration and filtering run in the pipeline
+    brain.publish("soil-moisture", "moisture", analogRead(SOIL_PIN));
+    brain.publish("ldr", "light", analogRead(LIGHT_PIN));
     
     // Calculate water flow (simplified)
     float flowRate = pulseCount * 2.25; // mL per pulse
@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+#
+# Flash and RAM footprint of each build profile
+#
+# Builds examples/minimal with the library in every esp32dev* environment of
+# platformio.ini and prints a Markdown table, with the difference from the
+# full build.
+#
+# Usage: scripts/footprint.sh [env...]
+
+set -euo pipefail
+
+cd "$(dirname "$0")/.."
+
+ENVS=("$@")
+if [ ${#ENVS[@]} -eq 0 ]; then
+    ENVS=(esp32dev esp32dev_no_ota esp32dev_no_portal esp32dev_no_system_info
+          esp32dev_no_status esp32dev_minimal)
+fi
+
+SKETCH=examples/minimal/minimal.ino
+LOG=$(mktemp)
+trap 'rm -f "$LOG"' EXIT
+
+# "Flash: [==   ]  21.0% (used 275097 bytes from 1310720 bytes)" -> 275097
+used() {
+    grep -E "^$1:" "$LOG" | tail -n 1 | sed -E 's/.*used ([0-9]+) bytes.*/\1/'
+}
+
+delta() {
+    printf "%+d" $(($2 - $1))
+}
+
+echo "| Profile | Flash | RAM | Flash vs full | RAM vs full |"
+echo "|---------|-------|-----|---------------|-------------|"
+
+BASE_FLASH=""
+BASE_RAM=""
+for ENV in "${ENVS[@]}"; do
+    if ! pio ci "$SKETCH" --lib=. --project-conf=platformio.ini -e "$ENV" > "$LOG" 2>&1; then
+        echo "| $ENV | build failed | | | |"
+        tail -n 20 "$LOG" >&2
+        continue
+    fi
+    FLASH=$(used Flash)
+    RAM=$(used RAM)
+    if [ -z "$BASE_FLASH" ]; then
+        BASE_FLASH=$FLASH
+        BASE_RAM=$RAM
+        echo "| $ENV | $FLASH | $RAM | - | - |"
+        continue
+    fi
+    echo "| $ENV | $FLASH | $RAM | $(delta "$BASE_FLASH" "$FLASH") | $(delta "$BASE_RAM" "$RAM") |"
+done
@@ -29,40 +29,122 @@
 #define IOT_MESURABLE_H
 
 #include <Arduino.h>
-#include <functional>
+#include <initializer_list>
+#include <type_traits>
+
+#include "core/Callback.h"
+#include "core/Clock.h"
+#include "core/ConfigManager.h"
+#include "core/ConfigShadow.h"
+#include "core/ConfigSources.h"
+#include "core/DerivedFunctions.h"
+#include "core/Features.h"
+#include "core/Limits.h"
+#include "core/Logger.h"
+#include "core/Metrics.h"
+#include "core/MqttClient.h"
+#include "core/MqttHub.h"
+#include "core/PeriodicTask.h"
+#include "core/RadioScheduler.h"
+#include "core/RuleEngine.h"
+#include "core/SensorPipeline.h"
+#include "core/SensorRegistry.h"
+#include "core/StackMonitor.h"
+#include "core/StateReport.h"
 
 // Forward declarations
-class SensorRegistry;
-class MqttClient;
-class ConfigManager;
+class JsonEncoder;
 
 /**
  * @brief Callback types
  */
-using ConfigCallback =
-    std::function<void(const char *hardware, int intervalMs)>;
-using EnableCallback = std::function<void(const char *hardware, bool enabled)>;
-using ConnectCallback = std::function<void(bool connected)>;
-using ResetCallback = std::function<void(const char *hardware)>;
+using ConfigCallback = Callback<void(const char *hardware, int intervalMs)>;
+using EnableCallback = Callback<void(const char *hardware, bool enabled)>;
+using ConnectCallback = Callback<void(bool connected)>;
+using ResetCallback = Callback<void(const char *hardware)>;
+using ReadCallback = Callback<void(const char *hardware)>;
+using RuleCallback =
+    Callback<void(const char *ruleId, const char *action, bool active)>;
+
+/**
+ * @brief Session policy of a module with its own MQTT client
+ *
+ * The client is held by value. Modules on an MqttHub use HubSession and
+ * hold none.
+ */
+template <class Transport> class OwnSession {
+public:
+  static const bool OWNS_CLIENT = true;
+  Transport *client(MqttHub *) { return &_client; }
+
+private:
+  Transport _client;
+};
 
 /**
  * @brief Main library class
  *
  * Provides a simple API to register hardware sensors and publish
  * telemetry data to the IoT Grow Brain ecosystem via MQTT.
+ *
+ * The collaborators are policies chosen at compile time, called directly
+ * (no virtual dispatch) and held by value except the MQTT client of a
+ * module on an MqttHub:
+ *
+ * - Transport: MQTT client (MqttClient API: broker, publish, subscribe,
+ *   loop, batching and retained-cache counters)
+ * - Store: WiFi join and persisted settings (ConfigManager API)
+ * - Encoder: payload formats (static functions, see JsonEncoder)
+ * - Limits: buffer sizes (see DefaultLimits)
+ * - Session: where the client lives (OwnSession, or HubSession for
+ *   HubModule: the hub's client, nothing held by the module)
+ *
+ * IotMesurable and HubModule are the default configurations, compiled once
+ * in IotMesurable.cpp. Other configurations include IotMesurableImpl.h in
+ * one source file; only the member functions they use are then compiled.
+ *
+ * @example
+ * struct SmallLimits : DefaultLimits {
+ *     static const size_t STATUS = 512;
+ * };
+ * BasicIotMesurable<MqttClient, ConfigManager, JsonEncoder, SmallLimits> brain("m");
  */
-class IotMesurable {
+template <class Transport = MqttClient, class Store = ConfigManager,
+          class Encoder = JsonEncoder, class Limits = DefaultLimits,
+          class Session = OwnSession<Transport>>
+class BasicIotMesurable {
 public:
   /**
    * @brief Construct with module ID
    * @param moduleId Unique identifier for this device (e.g., "growbox-01")
    */
-  explicit IotMesurable(const char *moduleId);
+  template <class S = Session,
+            class = typename std::enable_if<S::OWNS_CLIENT>::type>
+  explicit BasicIotMesurable(const char *moduleId)
+      : BasicIotMesurable(moduleId, nullptr) {}
+
+  /**
+   * @brief Construct a module sharing the MQTT session of a hub (HubModule)
+   *
+   * Broker, credentials and transport are set on hub.client(); begin()
+   * joins WiFi once and attaches the module to the hub.
+   *
+   * @param moduleId Unique identifier for this module (e.g., "climate-01")
+   * @param hub Hub shared with the other modules of the device
+   */
+  template <class S = Session,
+            class = typename std::enable_if<!S::OWNS_CLIENT>::type>
+  BasicIotMesurable(const char *moduleId, MqttHub &hub)
+      : BasicIotMesurable(moduleId, &hub) {}
 
   /**
    * @brief Destructor
    */
-  ~IotMesurable();
+  ~BasicIotMesurable();
+
+  // A module owns its session and callbacks bound to this: not copyable
+  BasicIotMesurable(const BasicIotMesurable &) = delete;
+  BasicIotMesurable &operator=(const BasicIotMesurable &) = delete;
 
   // =========================================================================
   // Initialization
@@ -70,6 +152,9 @@ public:
 
   /**
    * @brief Initialize with WiFiManager (captive portal if not configured)
+   *
+   * With IOT_FEATURE_WIFI_MANAGER=0, joins the network saved by the last
+   * successful connection instead.
    * @return true if connected successfully
    */
   bool begin();
@@ -106,10 +191,61 @@ public:
 
   /**
    * @brief Set module type (e.g., "air-quality", "climate")
+   *
+   * The module also follows the shared types/<type>/sensors/config topic.
+   *
    * @param type Module type string
    */
   void setModuleType(const char *type);
 
+  /**
+   * @brief Join a user-defined group
+   *
+   * The module follows groups/<group>/sensors/config. Settings from the
+   * module's own config topic win over groups, groups joined later win over
+   * earlier ones, and all groups win over the module type topic.
+   *
+   * @param group Group name (no '/', '+' or '#')
+   * @return true if joined
+   */
+  bool joinGroup(const char *group);
+
+  /**
+   * @brief Set the publish phase of the module
+   *
+   * Status, system info, the connection's full config report and the first
+   * sensor publish of each hardware are offset by this fraction of their
+   * period, so modules that boot together do not publish in lockstep. The
+   * default is derived from the chip ID; a backend can assign one with a
+   * "phase" field on the module config topics.
+   *
+   * @param phase Phase in per-mille of each period (0-999)
+   */
+  void setPhase(uint16_t phase);
+
+  /**
+   * @brief Get the publish phase of the module
+   */
+  uint16_t getPhase() const { return _phase; }
+
+  /**
+   * @brief Batch transmissions into periodic radio windows
+   *
+   * Messages are queued between windows while WiFi is in modem sleep and
+   * sent together when a window opens (retained state is coalesced per
+   * topic). Status and system info are sent at most once per window and
+   * sensor intervals longer than a window are rounded up to whole windows.
+   * Values therefore reach the broker up to one period late; use aligned
+   * sampling when sample times matter. Radio-on time is reported as the
+   * radioOnMsPerHour metric.
+   *
+   * @param windowPeriodMs Time between windows (0 disables power saving)
+   * @param windowMs Radio-on time per window
+   * @return true if applied
+   */
+  bool setPowerSaving(unsigned long windowPeriodMs,
+                      unsigned long windowMs = 2000);
+
   /**
    * @brief Set MQTT credentials
    * @param username MQTT username
@@ -117,7 +253,28 @@ public:
    */
   void setCredentials(const char *username, const char *password);
 
-  // =========================================================================
+  /**
+   * @brief Use another MQTT transport (e.g., MQTT-SN over UDP)
+   *
+   * Call before begin(). The broker address becomes the gateway address.
+   * Sensor value topics are announced as predefined topic IDs (see
+   * SensorRegistry::getSensorTopicId()), and power-saving windows put the
+   * session to sleep between windows.
+   *
+   * @param transport Transport to use, not owned (nullptr for the default)
+   */
+  void setTransport(MqttTransport *transport);
+
+  /**
+   * @brief Set the minimum time between status publishes
+   *
+   * Status is published only when a value, sensor status or enabled state
+   * changed (liveness is on the presence topic), and at most once per
+   * interval.
+   *
+   * @param intervalMs Status interval in ms (default 5000)
+   */
+  void setStatusInterval(unsigned long intervalMs);
 
   // =========================================================================
   // Sensor Registration
@@ -137,6 +294,84 @@ public:
    */
   void addSensor(const char *hardwareKey, const char *sensorType);
 
+  /**
+   * @brief Add a sensor with a processing pipeline
+   *
+   * Every raw value passed to publish() runs through the pipeline
+   * (calibration, conversion, filtering) before being published.
+   *
+   * @param hardwareKey The hardware key to attach this sensor to
+   * @param sensorType Type of measurement
+   * @param pipeline Processing stages (e.g., SensorPipeline().ema(0.2f))
+   */
+  void addSensor(const char *hardwareKey, const char *sensorType,
+                 const SensorPipeline &pipeline);
+
+  /**
+   * @brief Add a sensor computed from other sensors
+   *
+   * The value is recomputed only when an input changes, then published
+   * with the same throttling and status rules as a physical sensor.
+   *
+   * @param hardwareKey The hardware key to attach this sensor to
+   * @param sensorType Type of measurement (e.g., "vpd")
+   * @param inputs Composite keys of the inputs (e.g., "dht22:humidity")
+   * @param compute Function of the inputs (see DerivedFunctions)
+   */
+  void addDerivedSensor(const char *hardwareKey, const char *sensorType,
+                        std::initializer_list<const char *> inputs,
+                        DerivedFunction compute);
+
+  /**
+   * @brief Let the publish interval follow the signal variability
+   *
+   * The effective interval moves from maxIntervalMs (stable signal) down to
+   * minIntervalMs when the rate of change reaches changeRate. The setting
+   * is persisted and reported in the config shadow.
+   *
+   * @param hardwareKey Hardware key
+   * @param minIntervalMs Fastest interval (e.g., 5000)
+   * @param maxIntervalMs Slowest interval (e.g., 300000)
+   * @param changeRate Rate of change, in units per second, considered fast
+   */
+  void setAdaptiveInterval(const char *hardwareKey, int minIntervalMs,
+                           int maxIntervalMs, float changeRate);
+
+  /**
+   * @brief Publish a hardware on wall-clock multiples of its interval
+   *
+   * With a 60 s interval every module samples at :00, so values from
+   * different modules join without interpolation. Needs a synchronized
+   * clock (NTP is started by begin(), or use setClock()); until then the
+   * regular schedule is used. The delay after each boundary is reported as
+   * the alignErrorMs / alignErrorMaxMs metrics. The setting is persisted.
+   *
+   * @param hardwareKey Hardware key
+   * @param aligned true to align on the wall clock
+   */
+  void setAlignedSampling(const char *hardwareKey, bool aligned);
+
+  /**
+   * @brief Provide wall-clock time from an external source (RTC, GPS, ...)
+   * @param epochMs Milliseconds since the Unix epoch
+   */
+  void setClock(uint64_t epochMs);
+
+  // =========================================================================
+  // Local Rules
+  // =========================================================================
+
+  /**
+   * @brief Add a local rule evaluated on-device
+   *
+   * Rules deployed on the rules topic replace the whole set, including
+   * rules added here. The deployed set is saved and restored by begin().
+   *
+   * @param spec Rule definition (sensor, threshold, hysteresis, hold time)
+   * @return true if the rule compiled
+   */
+  bool addRule(const RuleSpec &spec);
+
   // =========================================================================
   // Publishing
   // =========================================================================
@@ -159,7 +394,12 @@ public:
 
   /**
    * @brief Publish a log message
-   * @param level Log level (e.g., "error", "info", "warn")
+   *
+   * Buffered with the library logs: sent to moduleId/logs once connected,
+   * oldest dropped if the buffer fills first. On an MqttHub, logs of all
+   * modules go to the hub's clientId/logs, this one prefixed "[moduleId]".
+   *
+   * @param level Log level ("debug", "info", "warn", "error")
    * @param msg Log message
    */
   void log(const char *level, const char *msg);
@@ -169,7 +409,8 @@ public:
    *
    * Useful to call after hardware registration to immediately notify
    * the backend of sensor availability, rather than waiting for the
-   * next automatic status publish (which occurs every 5 seconds).
+   * next automatic status publish (at most every 5 seconds, on change).
+   * Does nothing with IOT_FEATURE_STATUS=0.
    */
   void publishStatusNow();
 
@@ -206,6 +447,22 @@ public:
    */
   void onResetChange(ResetCallback callback);
 
+  /**
+   * @brief Set callback for on-demand read requests
+   *
+   * Called when the backend asks for fresh values (sensors/get with
+   * "read": true). Values published from the callback bypass the interval.
+   *
+   * @param callback Function reading and publishing the given hardware
+   */
+  void onReadRequest(ReadCallback callback);
+
+  /**
+   * @brief Set callback for local rule transitions
+   * @param callback Function called when a rule becomes active or clears
+   */
+  void onRule(RuleCallback callback);
+
   /**
    * @brief Set callback for connection state changes
    * @param callback Function called on connect/disconnect
@@ -241,37 +498,117 @@ public:
    */
   const char *getChipId() const;
 
+  /**
+   * @brief Deepest stack use of a library entry point
+   * @return Bytes, 0 if not measured (see StackMonitor)
+   */
+  size_t getStackDepth(StackEntry entry) const { return _stack.depth(entry); }
+
 private:
-  char _moduleId[64];
-  char _moduleType[64];
+  BasicIotMesurable(const char *moduleId, MqttHub *hub);
+
+  char _moduleId[Limits::MODULE_ID];
+  char _moduleType[Limits::MODULE_TYPE];
   char _chipId[17]; // Hex string: 16 chars + null terminator
-  char _broker[128];
+  char _broker[Limits::BROKER];
   uint16_t _port;
 
-  SensorRegistry *_registry;
-  MqttClient *_mqtt;
-  ConfigManager *_config;
+  SensorRegistry _registry;
+  Session _session; // Holds the client unless on a hub
+  Transport *_mqtt;  // Client of _session or of the hub
+  MqttHub *_hub;
+  Store _config;
+  RuleEngine _rules;
+  Metrics _metrics;
+  ConfigSources _sources;
+  ConfigShadow _shadow;
+  RadioScheduler _radio;
+  MessageQueue _outbox;
+  StateReport _state;
+  StackMonitor _stack;
 
   ConfigCallback _onConfigChange;
   EnableCallback _onEnableChange;
   ResetCallback _onResetChange;
   ConnectCallback _onConnect;
-
-  unsigned long _lastStatusPublish;
-  unsigned long _lastSystemPublish;
-  unsigned long _lastConfigPublish;
-  static const unsigned long STATUS_INTERVAL = 5000;
+  RuleCallback _onRule;
+  ReadCallback _onReadRequest;
+
+  PeriodicTask _statusTask;
+  PeriodicTask _systemTask;
+  unsigned long _statusIntervalMs;
+  uint16_t _phase;
+  bool _radioOn;
+  static const unsigned long STATUS_INTERVAL = 5000; // Default status interval
   static const unsigned long SYSTEM_INTERVAL =
-      30000; // Publish system info every 30s
-  static const unsigned long CONFIG_INTERVAL =
-      60000; // Publish sensors config every 60s
-
+      30000; // Sample system state every 30s
+  static const unsigned long STATE_MAX_SILENCE =
+      600000; // Send system state at least every 10 min
+  static const unsigned long REPORT_SPREAD =
+      10000; // Birth and full shadow reports spread over 10s after connect
+  static const long MIN_VALID_EPOCH = 1577836800; // 2020-01-01
+
+  // Fields of the volatile system state, in StateReport order
+  enum SystemStateField {
+    STATE_UPTIME,
+    STATE_HEAP_FREE,
+    STATE_HEAP_MIN,
+    STATE_RSSI
+  };
+
+  // handleConfigMessage() sources that are not shared config topics
+  static const int MODULE_SOURCE = -1;
+  static const int SHADOW_SOURCE = -2;
+
+  bool _publishingDerived;
+  bool _statusPending; // Send status at the next status period even unchanged
+  bool _birthPending; // Send birth messages once _reportAt is reached
+  bool _reportFull;   // Send a full shadow report once _reportAt is reached
+  unsigned long _reportAt;
+
+  void publishDerived();
   void publishStatus();
-  void publishConfig();
+  void publishReported(bool full);
+  void send(const char *topic, const char *payload, bool retain);
+  void sendTo(const char *suffix, const char *payload, size_t length,
+              size_t bufferSize, bool retain);
+  void flushOutbox();
+  void mqttPublish(const char *topic, const char *payload, bool retain);
+  void mqttSubscribe(const char *topic);
+  bool connectMqtt();
+  void applySchedules();
+  void setModemSleep(bool sleep);
+  void predefineSensorTopic(const char *hardwareKey, const char *sensorType);
+  void predefineSensorTopics();
+  void syncClock();
   void publishSystemInfo();
   void publishHardwareInfo();
+  void publishSystemState(unsigned long now);
+  void publishMetrics();
+  void deliverLogs();
+  void publishBurstAck(const char *hardware, int intervalMs,
+                       unsigned long durationMs, const char *status);
+  void handleConfigMessage(const char *payload, uint8_t priority, int source);
+  void handleBurstMessage(const char *payload);
+  void handleGetMessage(const char *payload);
+  void handleRuleEvent(const RuleEvent &event);
+  bool applyRules(const char *payload);
+  void restoreRules();
+  void handleRulesMessage(const char *payload);
   void handleMqttMessage(const char *topic, const char *payload);
   void setupSubscriptions();
 };
 
+// The default configurations are compiled once, in IotMesurable.cpp
+extern template class BasicIotMesurable<>;
+extern template class BasicIotMesurable<MqttClient, ConfigManager, JsonEncoder,
+                                        DefaultLimits, HubSession>;
+
+typedef BasicIotMesurable<> IotMesurable;
+
+// Module sharing the session of an MqttHub
+typedef BasicIotMesurable<MqttClient, ConfigManager, JsonEncoder, DefaultLimits,
+                          HubSession>
+    HubModule;
+
 #endif // IOT_MESURABLE_H
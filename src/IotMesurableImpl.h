@@ -0,0 +1,1663 @@
+/**
+ * @file IotMesurableImpl.h
+ * @brief Main library implementation
+ *
+ * Member definitions of BasicIotMesurable. IotMesurable.cpp compiles the
+ * default configuration; include this file in one source file to compile
+ * another one.
+ */
+
+#ifndef IOT_MESURABLE_IMPL_H
+#define IOT_MESURABLE_IMPL_H
+
+#include "IotMesurable.h"
+#include "core/JsonEncoder.h"
+#include "core/MqttClient.h"
+#include "core/MqttHub.h"
+#include "core/MqttTransport.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifndef NATIVE_BUILD
+#include <ArduinoJson.h>
+#include <sys/time.h>
+#include <time.h>
+#ifdef IOT_POSIX
+#include "posix/PosixSystem.h"
+#else
+#if IOT_FEATURE_OTA
+#include <ArduinoOTA.h>
+#endif
+#ifdef ESP32
+#include <WiFi.h>
+#include <esp_system.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#endif
+#endif
+#endif
+
+#ifndef IOT_NTP_SERVER
+#define IOT_NTP_SERVER "pool.ntp.org"
+#endif
+
+// =============================================================================
+// Constructor / Destructor
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::BasicIotMesurable(
+    const char *moduleId, MqttHub *hub)
+    // Modules sharing a hub share its client (one session, one send buffer)
+    : _port(1883), _mqtt(_session.client(hub)), _hub(hub),
+      _state(STATE_MAX_SILENCE), _statusTask(STATUS_INTERVAL),
+      _systemTask(SYSTEM_INTERVAL), _statusIntervalMs(STATUS_INTERVAL),
+      _phase(0), _radioOn(true), _publishingDerived(false),
+      _statusPending(false), _birthPending(false), _reportFull(false),
+      _reportAt(0) {
+
+  strncpy(_moduleId, moduleId, sizeof(_moduleId) - 1);
+  _moduleId[sizeof(_moduleId) - 1] = '\0';
+
+  _moduleType[0] = '\0';
+  memset(_broker, 0, sizeof(_broker));
+
+  // Extract unique chip ID
+#ifndef NATIVE_BUILD
+#ifdef ESP32
+  uint64_t chipid = ESP.getEfuseMac();
+  snprintf(_chipId, sizeof(_chipId), "%016llX", chipid);
+#elif defined(ESP8266)
+  uint32_t chipid = ESP.getChipId();
+  snprintf(_chipId, sizeof(_chipId), "%08X", chipid);
+#elif defined(IOT_POSIX)
+  PosixSystem::machineId(_chipId, sizeof(_chipId));
+#endif
+#else
+  snprintf(_chipId, sizeof(_chipId), "NATIVE_TEST_ID");
+#endif
+
+  // Deadbands of the volatile system state (uptime alone never triggers)
+  _state.addField("uptime", 0);
+  _state.addField("heapFreeKb", 4);
+  _state.addField("heapMinFreeKb", 4);
+  _state.addField("rssi", 6);
+
+  // Spread the fleet's schedules from the start, even before any backend
+  // assignment (modules powered up together boot in lockstep)
+  setPhase(PeriodicTask::phaseFromId(_chipId));
+
+  if (!_hub) {
+    _mqtt->setClientId(_moduleId);
+
+    // Liveness comes from the broker (last will), not from status heartbeats
+    char presenceTopic[Limits::TOPIC];
+    snprintf(presenceTopic, sizeof(presenceTopic), "%s/presence", _moduleId);
+    _mqtt->setPresenceTopic(presenceTopic);
+  }
+
+  _rules.onEvent([this](const RuleEvent &event) { handleRuleEvent(event); });
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::~BasicIotMesurable() {
+  if (_hub) {
+    _hub->detach(_moduleId);
+  }
+}
+
+// =============================================================================
+// Initialization
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::begin() {
+  StackProbe probe(_stack, StackEntry::Begin);
+  _config.loadConfig();
+  _shadow.restoreDesiredVersion(_config.loadShadowVersion());
+#ifdef IOT_LOW_RAM
+  // Sensors are registered before begin(): drop the vectors' spare capacity
+  _registry.shrinkToFit();
+#endif
+  restoreRules();
+  if (_config.hasPhase()) {
+    setPhase(_config.loadPhase());
+  }
+
+  // Use WiFiManager with module ID as AP name
+  if (!_config.beginWiFiManager(_moduleId)) {
+    return false;
+  }
+
+#ifdef ESP32
+  // Critical for AsyncTCP stability
+  WiFi.setSleep(false);
+#endif
+
+  // Get broker from config
+  if (strlen(_config.getBroker()) > 0) {
+    setBroker(_config.getBroker(), _config.getPort());
+  }
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+#if IOT_FEATURE_OTA
+  // Start OTA
+  ArduinoOTA.setHostname(_moduleId);
+  ArduinoOTA.begin();
+#endif
+
+  // Wall clock for aligned sampling
+  configTime(0, 0, IOT_NTP_SERVER);
+#endif
+
+  // Allow WiFi stack to stabilize
+  delay(1000);
+
+  return connectMqtt();
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::begin(
+    const char *ssid, const char *password) {
+  StackProbe probe(_stack, StackEntry::Begin);
+  _config.loadConfig();
+  _shadow.restoreDesiredVersion(_config.loadShadowVersion());
+#ifdef IOT_LOW_RAM
+  // Sensors are registered before begin(): drop the vectors' spare capacity
+  _registry.shrinkToFit();
+#endif
+  restoreRules();
+  if (_config.hasPhase()) {
+    setPhase(_config.loadPhase());
+  }
+
+  if (!_config.beginWiFi(ssid, password)) {
+    return false;
+  }
+
+#ifdef ESP32
+  WiFi.setSleep(false);
+#endif
+
+  // Get broker from config or use default
+  if (strlen(_broker) == 0 && strlen(_config.getBroker()) > 0) {
+    setBroker(_config.getBroker(), _config.getPort());
+  }
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+#if IOT_FEATURE_OTA
+  // Start OTA
+  ArduinoOTA.setHostname(_moduleId);
+  ArduinoOTA.begin();
+#endif
+
+  // Wall clock for aligned sampling
+  configTime(0, 0, IOT_NTP_SERVER);
+#endif
+
+  return connectMqtt();
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::begin(
+    const char *ssid, const char *password, const char *broker, uint16_t port) {
+  setBroker(broker, port);
+  return begin(ssid, password);
+}
+
+// =============================================================================
+// Configuration
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setBroker(
+    const char *host, uint16_t port) {
+  strncpy(_broker, host, sizeof(_broker) - 1);
+  _broker[sizeof(_broker) - 1] = '\0';
+  _port = port;
+
+  _mqtt->setBroker(host, port);
+  _config.setBroker(host, port);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setModuleType(
+    const char *type) {
+  if (!type)
+    return;
+  strncpy(_moduleType, type, sizeof(_moduleType) - 1);
+  _moduleType[sizeof(_moduleType) - 1] = '\0';
+
+  // Modules of the same type share types/<type>/sensors/config
+  if (_sources.setModuleType(_moduleType)) {
+    _sources.restoreVersion(0, _config.loadSourceVersion(_sources.get(0).topic));
+    if (isConnected()) {
+      mqttSubscribe(_sources.get(0).topic);
+    }
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::joinGroup(
+    const char *group) {
+  if (!_sources.joinGroup(group))
+    return false;
+
+  size_t index = _sources.count() - 1;
+  const ConfigSource &source = _sources.get(index);
+  _sources.restoreVersion(index, _config.loadSourceVersion(source.topic));
+  if (isConnected()) {
+    mqttSubscribe(source.topic);
+  }
+  return true;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setCredentials(
+    const char *username, const char *password) {
+  _mqtt->setCredentials(username, password);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setTransport(
+    MqttTransport *transport) {
+  _mqtt->setTransport(transport);
+  predefineSensorTopics();
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setStatusInterval(
+    unsigned long intervalMs) {
+  if (intervalMs > 0) {
+    _statusIntervalMs = intervalMs;
+    applySchedules();
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setPowerSaving(
+    unsigned long windowPeriodMs, unsigned long windowMs) {
+  if (windowPeriodMs == 0) {
+    _radio.disable();
+  } else if (!_radio.configure(windowPeriodMs, windowMs, _phase)) {
+    return false;
+  }
+  applySchedules();
+  return true;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setPhase(
+    uint16_t phase) {
+  _phase = phase % IOT_PHASE_STEPS;
+  _statusTask.setPhase(_phase);
+  _systemTask.setPhase(_phase);
+  _registry.setPublishPhase(_phase);
+  _radio.setPhase(_phase);
+}
+
+// =============================================================================
+// Sensor Registration
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::registerHardware(
+    const char *key, const char *name) {
+  _registry.registerHardware(key, name);
+
+  // Load persisted enabled state
+  bool enabled = _config.loadHardwareEnabled(key, true);
+  _registry.setHardwareEnabled(key, enabled);
+
+  // Load persisted interval
+  int interval = _config.loadInterval(key, 60000);
+  _registry.setHardwareInterval(key, interval);
+
+  // Load which config source (module, group, type) owns this hardware
+  _registry.setConfigPriority(key, _config.loadConfigPriority(key));
+
+  // Load persisted adaptive sampling
+  int minMs, maxMs;
+  float changeRate;
+  if (_config.loadAdaptive(key, minMs, maxMs, changeRate)) {
+    _registry.setAdaptiveInterval(key, minMs, maxMs, changeRate);
+  }
+
+  // Load persisted wall-clock alignment
+  if (_config.loadAligned(key)) {
+    _registry.setAlignedSampling(key, true, Clock::now());
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::addSensor(
+    const char *hardwareKey, const char *sensorType) {
+  if (_registry.addSensor(hardwareKey, sensorType)) {
+    predefineSensorTopic(hardwareKey, sensorType);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::addSensor(
+    const char *hardwareKey, const char *sensorType,
+    const SensorPipeline &pipeline) {
+  if (_registry.addSensor(hardwareKey, sensorType, pipeline)) {
+    predefineSensorTopic(hardwareKey, sensorType);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::addDerivedSensor(
+    const char *hardwareKey, const char *sensorType,
+    std::initializer_list<const char *> inputs, DerivedFunction compute) {
+  if (_registry.addDerivedSensor(hardwareKey, sensorType, inputs.begin(),
+                                  static_cast<uint8_t>(inputs.size()),
+                                  compute)) {
+    predefineSensorTopic(hardwareKey, sensorType);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setAdaptiveInterval(
+    const char *hardwareKey, int minIntervalMs, int maxIntervalMs,
+    float changeRate) {
+  if (_registry.setAdaptiveInterval(hardwareKey, minIntervalMs, maxIntervalMs,
+                                     changeRate)) {
+    _config.saveAdaptive(hardwareKey, minIntervalMs, maxIntervalMs,
+                          changeRate);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setAlignedSampling(
+    const char *hardwareKey, bool aligned) {
+  if (_registry.setAlignedSampling(hardwareKey, aligned, Clock::now())) {
+    _config.saveAligned(hardwareKey, aligned);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setClock(
+    uint64_t epochMs) {
+  _registry.setClock(epochMs, Clock::now());
+}
+
+// =============================================================================
+// Local Rules
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::addRule(
+    const RuleSpec &spec) {
+  return _rules.addRule(spec, _registry);
+}
+
+// =============================================================================
+// Publishing
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publish(
+    const char *hardwareKey, const char *sensorType, float value) {
+  StackProbe probe(_stack, StackEntry::Publish);
+  // Skip if hardware is disabled
+  if (!_registry.isHardwareEnabled(hardwareKey)) {
+    return;
+  }
+
+  // Run every raw sample through the sensor pipeline, even throttled ones,
+  // so filters see the full signal. Rejected samples are never published.
+  float processed;
+  if (!_registry.processSample(hardwareKey, sensorType, value, processed)) {
+    return;
+  }
+  value = processed;
+
+  // Local rules and adaptive sampling see every sample, not only published
+  // ones
+  unsigned long now = Clock::now();
+  SensorRef ref;
+  if (_registry.findSensorRef(hardwareKey, sensorType, ref)) {
+    _rules.onSample(ref, value, now);
+  }
+  _registry.observeSample(hardwareKey, sensorType, value, now);
+
+  // Get last publish time
+  unsigned long lastPublish = _registry.getLastPublishTime(hardwareKey);
+
+  // Check throttling: allow if interval passed OR within 10ms of last publish
+  // (same read cycle) This ensures all measurements from the same hardware can
+  // be published together even if they span multiple milliseconds during
+  // sequential publish() calls
+  // On-demand reads bypass the interval once. The first publish is decided
+  // by canPublish() too, so it lands on the module's phase offset.
+  const unsigned long SAME_CYCLE_WINDOW_MS = 10;
+  bool intervalElapsed = _registry.consumeImmediatePublish(hardwareKey) ||
+                         _registry.canPublish(hardwareKey, now);
+  bool sameCycle =
+      (lastPublish != 0) && ((now - lastPublish) < SAME_CYCLE_WINDOW_MS);
+  bool shouldPublish = intervalElapsed || sameCycle;
+
+  if (!shouldPublish) {
+    return;
+  }
+
+  // Update registry
+  _registry.updateSensorValue(hardwareKey, sensorType, value);
+
+  // Build topic: moduleId/hardware/sensor
+  char topic[Limits::TOPIC];
+  size_t topicLength = snprintf(topic, sizeof(topic), "%s/%s/%s", _moduleId,
+                                hardwareKey, sensorType);
+
+  // Build payload
+  char payload[32];
+  size_t length = Encoder::value(payload, sizeof(payload), value);
+
+  if (topicLength < sizeof(topic) && length < sizeof(payload)) {
+    send(topic, payload, false);
+  }
+
+  // Update timestamp only if not already updated this millisecond
+  if (now != lastPublish) {
+    _registry.updatePublishTime(hardwareKey, now);
+
+    // Downstream joins rely on aligned samples: track how late they are
+    long alignError = _registry.getAlignmentError(hardwareKey);
+    if (alignError >= 0) {
+      _metrics.set("alignErrorMs", alignError);
+      _metrics.keepMax("alignErrorMaxMs", alignError);
+    }
+  }
+
+  publishDerived();
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publish(
+    const char *hardwareKey, const char *sensorType, int value) {
+  publish(hardwareKey, sensorType, static_cast<float>(value));
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::log(
+    const char *level, const char *msg) {
+  LogLevel logLevel = Logger::parseLevel(level);
+  if ((int)logLevel < IOT_LOG_LEVEL)
+    return;
+  // The log buffer is process-wide: say which module logged
+  Logger::instance().write(logLevel, msg, _moduleId);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishStatusNow() {
+  // Explicit requests go out even if the broker holds the same status
+  char topic[Limits::TOPIC];
+  snprintf(topic, sizeof(topic), "%s/sensors/status", _moduleId);
+  _mqtt->refreshRetained(topic);
+  publishStatus();
+}
+
+// =============================================================================
+// Main Loop
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::loop() {
+  StackProbe probe(_stack, StackEntry::Loop);
+  // A shared client is serviced once per round of module loops
+  if (_hub) {
+    _hub->beginTick(_moduleId);
+  } else {
+    _mqtt->loop();
+  }
+  Logger::instance().printPending();
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX) && IOT_FEATURE_OTA
+  ArduinoOTA.handle();
+#endif
+
+  // Take the wall clock from NTP as soon as it is set
+  if (!_registry.hasClock()) {
+    syncClock();
+  }
+
+  unsigned long now = Clock::now();
+
+  // Power saving: radio on only during transmit windows
+  bool radioOn = _radio.update(now);
+  if (radioOn != _radioOn) {
+    _radioOn = radioOn;
+    setModemSleep(!radioOn);
+  }
+
+  // Fire local rules whose hold duration elapsed
+  _rules.tick(now);
+
+  // Revert burst intervals whose duration elapsed
+  const char *expired;
+  while ((expired = _registry.expireNextOverride(now)) != nullptr) {
+    _metrics.add("burstExpired");
+    _metrics.add("burstActive", -1);
+    publishBurstAck(expired, 0, 0, "expired");
+  }
+
+  // Publish status on change only, at most once per status period (on the
+  // module's phase)
+  if (_statusTask.due(now) &&
+      (_registry.consumeStatusChange() || _statusPending)) {
+    publishStatus();
+  }
+
+  // Publish system info less frequently
+  if (_systemTask.due(now)) {
+    syncClock(); // Follow NTP corrections and millis() rollover
+    _metrics.set("radioOnMsPerHour", _radio.radioOnPerHour());
+    _metrics.set("radioQueued", _outbox.count());
+    _metrics.set("radioDropped", _outbox.dropped());
+    _metrics.set("retainedSuppressedBytes", _mqtt->retainedSuppressedBytes());
+    _metrics.set("mqttPackets", _mqtt->batchPackets());
+    _metrics.set("mqttWrites", _mqtt->batchWrites());
+    _metrics.set("mqttDropped", _mqtt->batchDropped());
+    _metrics.set("logDropped", Logger::instance().dropped());
+    _metrics.set("logSuppressed", Logger::instance().suppressed());
+    for (uint8_t entry = 0; entry < (uint8_t)StackEntry::Count; entry++) {
+      _metrics.set(StackMonitor::metricName((StackEntry)entry),
+                   _stack.depth((StackEntry)entry));
+    }
+#if IOT_STACK_WATERMARK
+    _metrics.set("stackFreeMin", StackMonitor::taskFreeMin());
+#endif
+    if (_hub) {
+      // The counters above are the shared session's; these are this module's
+      const MqttHubStats *stats = _hub->stats(_moduleId);
+      if (stats) {
+        _metrics.set("modulePublished", stats->published);
+        _metrics.set("modulePublishedBytes", stats->publishedBytes);
+        _metrics.set("moduleReceived", stats->received);
+      }
+    }
+    publishSystemState(now);
+    publishMetrics();
+  }
+
+  // Static facts once per connection (retained "birth" messages)
+  if (_birthPending && (long)(now - _reportAt) >= 0) {
+    _birthPending = false;
+    _state.invalidate();
+    publishSystemInfo();
+    publishHardwareInfo();
+    publishSystemState(now);
+  }
+
+  // Report config changes: everything once per connection, then deltas
+  if (_reportFull) {
+    if ((long)(now - _reportAt) >= 0) {
+      publishReported(true);
+    }
+  } else if (_shadow.needsReport(_registry)) {
+    publishReported(false);
+  }
+
+  // Send everything queued since the last window
+  if (_radioOn) {
+    flushOutbox();
+  }
+
+  // Logs recorded while offline go out once connected
+  if (_radioOn && isConnected()) {
+    deliverLogs();
+  }
+
+  // Everything published during this tick leaves in one write (on a hub,
+  // with what the other modules published in the same round)
+  if (_hub) {
+    _hub->endTick(_moduleId);
+  } else {
+    _mqtt->flush();
+  }
+}
+
+// =============================================================================
+// Callbacks
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::onConfigChange(
+    ConfigCallback callback) {
+  _onConfigChange = callback;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::onEnableChange(
+    EnableCallback callback) {
+  _onEnableChange = callback;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::onResetChange(
+    ResetCallback callback) {
+  _onResetChange = callback;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::onReadRequest(
+    ReadCallback callback) {
+  _onReadRequest = callback;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::onRule(
+    RuleCallback callback) {
+  _onRule = callback;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::onConnect(
+    ConnectCallback callback) {
+  _onConnect = callback;
+}
+
+// =============================================================================
+// State
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::isConnected() const {
+  return _mqtt->isConnected();
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::isHardwareEnabled(
+    const char *hardwareKey) const {
+  return _registry.isHardwareEnabled(hardwareKey);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+const char *BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::getModuleId() const {
+  return _moduleId;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+const char *BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::getChipId() const {
+  return _chipId;
+}
+
+// =============================================================================
+// Private Methods
+// =============================================================================
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishDerived() {
+  // Derived values are published through publish() and may themselves feed
+  // other derived sensors: the outermost call drains the whole chain.
+  if (_publishingDerived)
+    return;
+  _publishingDerived = true;
+
+  const char *hardwareKey;
+  const char *sensorType;
+  float value;
+  while (_registry.computeNextDerived(hardwareKey, sensorType, value)) {
+    publish(hardwareKey, sensorType, value);
+  }
+
+  _publishingDerived = false;
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishStatus() {
+  if (!isConnected())
+    return;
+  _statusPending = false;
+
+#if IOT_FEATURE_STATUS
+  // Status with metadata, in parts of whole sensor entries when the sensors
+  // do not fit one buffer; retained, so the last part stays on the broker
+  char buffer[Limits::STATUS];
+  size_t next = 0;
+  do {
+    size_t length = Encoder::status(buffer, sizeof(buffer), _moduleId,
+                                    _moduleType, _registry, &next);
+    sendTo("sensors/status", buffer, length, sizeof(buffer), true);
+  } while (next != 0);
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishReported(
+    bool full) {
+  if (!isConnected())
+    return;
+
+  // Parts of whole hardware entries until everything is reported; retained
+  // so a backend that subscribes later sees the latest one
+  char buffer[Limits::REPORT];
+  do {
+    size_t length =
+        _shadow.buildReport(_registry, buffer, sizeof(buffer), full);
+    if (length >= sizeof(buffer)) {
+      IOT_LOG_WARN("[MQTT] Shadow report buffer too small");
+      return;
+    }
+    full = false;
+    _reportFull = false;
+    sendTo("shadow/reported", buffer, length, sizeof(buffer), true);
+  } while (_shadow.needsReport(_registry));
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::send(
+    const char *topic, const char *payload, bool retain) {
+  // Between windows, hold the message until the radio is back on
+  if (!_radioOn) {
+    _outbox.push(topic, payload, retain);
+    return;
+  }
+  flushOutbox();
+  mqttPublish(topic, payload, retain);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::sendTo(
+    const char *suffix, const char *payload, size_t length, size_t bufferSize,
+    bool retain) {
+  // A truncated payload is not valid JSON: drop it
+  if (length >= bufferSize) {
+    IOT_LOG_WARN("[MQTT] %s payload too large", suffix);
+    _metrics.add("payloadDropped");
+    return;
+  }
+
+  // Publish to moduleId/<suffix>
+  char topic[Limits::TOPIC];
+  if ((size_t)snprintf(topic, sizeof(topic), "%s/%s", _moduleId, suffix) >=
+      sizeof(topic))
+    return;
+  send(topic, payload, retain);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::flushOutbox() {
+  // Queued messages survive a disconnection until the next window
+  if (!isConnected())
+    return;
+
+  const char *topic;
+  const char *payload;
+  bool retain;
+  while (_outbox.peek(topic, payload, retain)) {
+    mqttPublish(topic, payload, retain);
+    _outbox.pop();
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::mqttPublish(
+    const char *topic, const char *payload, bool retain) {
+  if (_hub) {
+    _hub->publish(topic, payload, retain);
+  } else {
+    _mqtt->publish(topic, payload, retain);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::mqttSubscribe(
+    const char *topic) {
+  if (_hub) {
+    _hub->subscribe(_moduleId, topic);
+  } else {
+    _mqtt->subscribe(topic);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::connectMqtt() {
+  MqttConnectCallback onConnect = [this](bool connected) {
+    if (connected) {
+      setupSubscriptions();
+      _statusPending = true;
+      _birthPending = true;
+      _reportFull = true;
+      _reportAt = Clock::now() + PeriodicTask::offsetFor(REPORT_SPREAD, _phase);
+    }
+    if (_onConnect) {
+      _onConnect(connected);
+    }
+  };
+  MqttMessageCallback onMessage = [this](const char *topic,
+                                         const char *payload) {
+    handleMqttMessage(topic, payload);
+  };
+
+  if (!_hub) {
+    _mqtt->onConnect(onConnect);
+    _mqtt->onMessage(onMessage);
+    return _mqtt->connect();
+  }
+  // The first module starts the shared session; later ones join it
+  if (!_hub->attach(_moduleId, onConnect, onMessage)) {
+    return false;
+  }
+  return _hub->connect();
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::applySchedules() {
+  // Tasks faster than the radio windows could not send more often anyway
+  _statusTask.setPeriod(_radio.quantize(_statusIntervalMs));
+  _systemTask.setPeriod(_radio.quantize(SYSTEM_INTERVAL));
+  _registry.setIntervalQuantum(_radio.enabled() ? (int)_radio.period() : 0);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setModemSleep(
+    bool sleep) {
+  // A shared modem sleeps once no module on the hub needs it
+  if (_hub && !_hub->setRadioNeeded(_moduleId, !sleep))
+    return;
+
+#ifdef ESP32
+  // Modem sleep keeps the association and TCP session; the radio only wakes
+  // for beacons, so the MQTT connection survives between windows
+  WiFi.setSleep(sleep);
+#elif defined(ESP8266)
+  WiFi.setSleepMode(sleep ? WIFI_MODEM_SLEEP : WIFI_NONE_SLEEP);
+#endif
+
+  // Transports with a sleeping session (MQTT-SN) let the gateway hold
+  // incoming messages until the next window
+  if (sleep) {
+    _mqtt->sleep(_radio.period());
+  } else {
+    _mqtt->wake();
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::predefineSensorTopic(
+    const char *hardwareKey, const char *sensorType) {
+  uint16_t topicId = _registry.getSensorTopicId(hardwareKey, sensorType);
+  if (topicId == 0)
+    return;
+
+  char topic[Limits::TOPIC];
+  snprintf(topic, sizeof(topic), "%s/%s/%s", _moduleId, hardwareKey,
+           sensorType);
+  _mqtt->predefineTopic(topic, topicId);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::predefineSensorTopics() {
+  for (const auto &hw : _registry.getAllHardware()) {
+    for (const auto &sensor : hw.sensors) {
+      predefineSensorTopic(hw.key, sensor.type);
+    }
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::syncClock() {
+#ifndef NATIVE_BUILD
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  // Before the first NTP answer the clock counts from 1970
+  if (tv.tv_sec < MIN_VALID_EPOCH)
+    return;
+  uint64_t epochMs = (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+  _registry.setClock(epochMs, Clock::now());
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishSystemInfo() {
+#if !defined(NATIVE_BUILD) && IOT_FEATURE_SYSTEM_INFO
+  if (!isConnected())
+    return;
+
+  // Static facts only: published once per connection (birth), retained.
+  // Heap, RSSI and uptime go to system/state.
+  char ip[16] = "0.0.0.0";
+  char mac[18] = "00:00:00:00:00:00";
+
+  // Memory info
+  uint32_t heapTotal = 0;
+
+  // Flash info
+  uint32_t flashTotal = 0;
+  uint32_t flashSketchSize = 0;
+  uint32_t flashFreeSketch = 0;
+
+#ifdef ESP32
+  heapTotal = ESP.getHeapSize() / 1024;
+
+  flashTotal = ESP.getFlashChipSize() / 1024;
+  flashSketchSize = ESP.getSketchSize() / 1024;
+  flashFreeSketch = ESP.getFreeSketchSpace() / 1024;
+#elif defined(ESP8266)
+  // ESP8266 doesn't have getHeapSize() easily available like ESP32 without
+  // internal SDK calls We'll leave heapTotal as 0 or estimate if needed, but
+  // for simplicity 0
+
+  flashTotal = ESP.getFlashChipRealSize() / 1024;
+  flashSketchSize = ESP.getSketchSize() / 1024;
+  flashFreeSketch = ESP.getFreeSketchSpace() / 1024;
+#elif defined(IOT_POSIX)
+  heapTotal = PosixSystem::memoryTotalKb();
+#endif
+
+  // Get network info
+#ifdef IOT_POSIX
+  PosixSystem::network(ip, sizeof(ip), mac, sizeof(mac));
+#else
+  if (WiFi.status() == WL_CONNECTED) {
+    IPAddress localIP = WiFi.localIP();
+    snprintf(ip, sizeof(ip), "%d.%d.%d.%d", localIP[0], localIP[1], localIP[2],
+             localIP[3]);
+
+    uint8_t macAddr[6];
+    WiFi.macAddress(macAddr);
+    snprintf(mac, sizeof(mac), "%02X:%02X:%02X:%02X:%02X:%02X", macAddr[0],
+             macAddr[1], macAddr[2], macAddr[3], macAddr[4], macAddr[5]);
+  }
+#endif
+
+  SystemInfo info = {ip, mac, _chipId, _moduleType,
+                     heapTotal, flashTotal, flashSketchSize, flashFreeSketch};
+  char buffer[Limits::INFO];
+  size_t length = Encoder::systemInfo(buffer, sizeof(buffer), info);
+  sendTo("system/config", buffer, length, sizeof(buffer), true);
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishSystemState(
+    unsigned long now) {
+#if !defined(NATIVE_BUILD) && IOT_FEATURE_SYSTEM_INFO
+  if (!isConnected())
+    return;
+
+  uint32_t heapFree = 0;
+  uint32_t heapMinFree = 0;
+#ifdef ESP32
+  heapFree = ESP.getFreeHeap() / 1024;
+  heapMinFree = ESP.getMinFreeHeap() / 1024;
+#elif defined(ESP8266)
+  heapFree = ESP.getFreeHeap() / 1024;
+  heapMinFree =
+      ESP.getMaxFreeBlockSize() / 1024; // Approximation for fragmentation
+#elif defined(IOT_POSIX)
+  // The host's available memory; there is no low-water mark to report
+  heapFree = PosixSystem::memoryAvailableKb();
+  heapMinFree = heapFree;
+#endif
+
+  _state.set(STATE_UPTIME, (long)(Clock::now() / 1000));
+  _state.set(STATE_HEAP_FREE, (long)heapFree);
+  _state.set(STATE_HEAP_MIN, (long)heapMinFree);
+#ifdef IOT_POSIX
+  _state.set(STATE_RSSI, 0);
+#else
+  _state.set(STATE_RSSI, WiFi.RSSI());
+#endif
+
+  // Only when something moved past its deadband (or as a rare heartbeat)
+  if (!_state.due(now))
+    return;
+
+  char buffer[Limits::EVENT];
+  size_t length = _state.buildJson(buffer, sizeof(buffer));
+  if (length >= sizeof(buffer))
+    return;
+  _state.markSent(now);
+  sendTo("system/state", buffer, length, sizeof(buffer), true);
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishHardwareInfo() {
+#if !defined(NATIVE_BUILD) && IOT_FEATURE_SYSTEM_INFO
+  if (!isConnected())
+    return;
+
+  const char *chipModel = "Unknown";
+  int cpuFreq = 0;
+  int flashKb = 0;
+  int cores = 1;
+  int rev = 0;
+
+#ifdef ESP32
+  // Get chip info
+  esp_chip_info_t chipInfo;
+  esp_chip_info(&chipInfo);
+
+  if (chipInfo.model == CHIP_ESP32)
+    chipModel = "ESP32";
+  else if (chipInfo.model == CHIP_ESP32S2)
+    chipModel = "ESP32-S2";
+  else if (chipInfo.model == CHIP_ESP32S3)
+    chipModel = "ESP32-S3";
+  else if (chipInfo.model == CHIP_ESP32C3)
+    chipModel = "ESP32-C3";
+
+  cpuFreq = ESP.getCpuFreqMHz();
+  flashKb = ESP.getFlashChipSize() / 1024;
+  cores = chipInfo.cores;
+  rev = chipInfo.revision;
+#elif defined(ESP8266)
+  chipModel = "ESP8266";
+  cpuFreq = ESP.getCpuFreqMHz();
+  flashKb = ESP.getFlashChipRealSize() / 1024;
+  cores = 1;
+  // ESP8266 revision?
+  rev = 0;
+#elif defined(IOT_POSIX)
+  chipModel = PosixSystem::machine();
+  cores = PosixSystem::cpuCount();
+#endif
+
+  ChipInfo info = {chipModel, rev, cpuFreq, flashKb, cores};
+  char buffer[Limits::INFO];
+  size_t length = Encoder::chipInfo(buffer, sizeof(buffer), info);
+  sendTo("hardware/config", buffer, length, sizeof(buffer), true);
+#endif
+}
+
+#ifndef NATIVE_BUILD
+// Rule: { "id": "hum-high", "sensor": "dht22:humidity", "op": ">", "value": 85,
+//         "hysteresis": 3, "for": 60, "action": "fan" }
+inline RuleSpec ruleSpec(JsonObject rule) {
+  RuleSpec spec;
+  spec.id = rule["id"];
+  spec.sensor = rule["sensor"];
+  spec.op = rule["op"] | ">";
+  spec.threshold = rule["value"] | NAN;
+  spec.hysteresis = rule["hysteresis"] | 0.0f;
+  spec.holdMs = (rule["for"] | 0UL) * 1000UL;
+  spec.action = rule["action"] | "";
+  return spec;
+}
+
+// Pipeline config: { "<sensorType>": [ { "type": "ema", "alpha": 0.2 }, ... ] }
+inline bool buildPipeline(JsonArray stages, SensorPipeline &pipeline) {
+  for (JsonObject stage : stages) {
+    const char *type = stage["type"];
+    switch (SensorPipeline::stageTypeFromName(type)) {
+    case StageType::Linear:
+      pipeline.linear(stage["gain"] | 1.0f, stage["offset"] | 0.0f);
+      break;
+    case StageType::Polynomial: {
+      float coeffs[4];
+      uint8_t count = 0;
+      for (float c : stage["coeffs"].as<JsonArray>()) {
+        if (count < 4)
+          coeffs[count] = c;
+        count++;
+      }
+      pipeline.polynomial(coeffs, count);
+      break;
+    }
+    case StageType::Ema:
+      pipeline.ema(stage["alpha"] | 0.0f);
+      break;
+    case StageType::Median:
+      pipeline.median(stage["window"] | 5);
+      break;
+    case StageType::Hampel:
+      pipeline.hampel(stage["window"] | 5, stage["threshold"] | 3.0f);
+      break;
+    case StageType::Range:
+      pipeline.range(stage["min"] | -INFINITY, stage["max"] | INFINITY);
+      break;
+    case StageType::None:
+    default:
+      // "convert" is sugar for a linear stage
+      if (type && strcmp(type, "convert") == 0) {
+        pipeline.convert(stage["unit"]);
+      } else {
+        return false;
+      }
+      break;
+    }
+  }
+  return pipeline.isValid();
+}
+
+inline void applyPipelineConfig(SensorRegistry &registry,
+                                const char *hardwareKey, JsonObject pipelines) {
+  for (JsonPair entry : pipelines) {
+    SensorPipeline pipeline;
+    if (!buildPipeline(entry.value().as<JsonArray>(), pipeline)) {
+      IOT_LOG_WARN("[MQTT] Invalid pipeline for %s:%s", hardwareKey,
+                    entry.key().c_str());
+      continue;
+    }
+    if (registry.setSensorPipeline(hardwareKey, entry.key().c_str(),
+                                   pipeline)) {
+      IOT_LOG_INFO("[MQTT] Pipeline updated for %s:%s (%d stages)",
+                    hardwareKey, entry.key().c_str(), pipeline.stageCount());
+    }
+  }
+}
+
+template <class Store>
+void applyAdaptiveConfig(SensorRegistry &registry, Store &config,
+                         const char *hardwareKey, JsonVariant adaptive) {
+  // "adaptive": { "min": 5, "max": 300, "rate": 2.0 } (seconds), or false
+  if (!adaptive.is<JsonObject>()) {
+    registry.clearAdaptiveInterval(hardwareKey);
+    config.saveAdaptive(hardwareKey, 0, 0, 0.0f);
+    IOT_LOG_INFO("[MQTT] Adaptive sampling disabled for %s", hardwareKey);
+    return;
+  }
+
+  int minMs = (adaptive["min"] | 0) * 1000;
+  int maxMs = (adaptive["max"] | 0) * 1000;
+  float changeRate = adaptive["rate"] | 0.0f;
+  if (registry.setAdaptiveInterval(hardwareKey, minMs, maxMs, changeRate)) {
+    config.saveAdaptive(hardwareKey, minMs, maxMs, changeRate);
+    IOT_LOG_INFO("[MQTT] Adaptive sampling for %s: %d-%d ms", hardwareKey,
+                  minMs, maxMs);
+  }
+}
+#endif
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishMetrics() {
+  if (!isConnected())
+    return;
+
+  char buffer[Limits::INFO];
+  size_t length = _metrics.buildJson(buffer, sizeof(buffer));
+  sendTo("system/metrics", buffer, length, sizeof(buffer), false);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::deliverLogs() {
+  // A few records per tick: they leave in the tick's batch
+  char msg[Limits::LOG / 2];
+  char buffer[Limits::LOG];
+  char source[Limits::MODULE_ID];
+  LogLevel level;
+  unsigned long time;
+  for (int i = 0; i < IOT_LOG_DELIVERY_BATCH; i++) {
+    // On a hub the source stays in the message as "[moduleId] "
+    if (!Logger::instance().next(LogSink::Mqtt, msg, sizeof(msg), level, time,
+                                 _hub ? nullptr : source, sizeof(source))) {
+      break;
+    }
+    size_t length = Encoder::log(buffer, sizeof(buffer),
+                                 Logger::levelName(level), msg, time);
+    if (length >= sizeof(buffer)) {
+      _metrics.add("payloadDropped");
+      continue;
+    }
+    if (_hub) {
+      // One buffer for the device: whichever module loops sends it
+      send(_hub->logTopic(), buffer, false);
+      continue;
+    }
+    // The buffer is process-wide: another module's records go to its topic
+    char topic[Limits::TOPIC];
+    if ((size_t)snprintf(topic, sizeof(topic), "%s/logs",
+                         source[0] ? source : _moduleId) < sizeof(topic))
+      send(topic, buffer, false);
+  }
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::publishBurstAck(
+    const char *hardware, int intervalMs, unsigned long durationMs,
+    const char *status) {
+  if (!isConnected())
+    return;
+
+  char buffer[Limits::EVENT];
+  size_t length = Encoder::burstAck(buffer, sizeof(buffer), hardware,
+                                    intervalMs, durationMs, status);
+  sendTo("sensors/burst/ack", buffer, length, sizeof(buffer), false);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::handleBurstMessage(
+    const char *payload) {
+#ifndef NATIVE_BUILD
+  // Parse burst message: { "hardware": "dht22", "interval": 1, "duration": 600 }
+  // (seconds). Interval or duration 0 cancels a running burst.
+  StaticJsonDocument<Limits::COMMAND_DOC> doc;
+  DeserializationError error = deserializeJson(doc, payload);
+  if (error)
+    return;
+
+  const char *hardware = doc["hardware"];
+  if (!hardware)
+    return;
+  int intervalMs = (doc["interval"] | 0) * 1000;
+  unsigned long durationMs = (doc["duration"] | 0UL) * 1000UL;
+
+  bool wasActive = _registry.hasIntervalOverride(hardware);
+  if (intervalMs <= 0 || durationMs == 0) {
+    if (_registry.clearIntervalOverride(hardware)) {
+      _metrics.add("burstActive", -1);
+      publishBurstAck(hardware, 0, 0, "cancelled");
+    }
+    return;
+  }
+
+  // Temporary override only: nothing is written to NVS
+  if (!_registry.setIntervalOverride(hardware, intervalMs, durationMs,
+                                      Clock::now())) {
+    publishBurstAck(hardware, intervalMs, durationMs, "rejected");
+    return;
+  }
+
+  IOT_LOG_INFO("[MQTT] Burst %s: %d ms for %lu ms", hardware, intervalMs,
+                durationMs);
+  _metrics.add("burstStarted");
+  if (!wasActive) {
+    _metrics.add("burstActive");
+  }
+  publishBurstAck(hardware, intervalMs, durationMs, "started");
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::handleGetMessage(
+    const char *payload) {
+#ifndef NATIVE_BUILD
+  // Parse get message: { "id": "req-42", "hardware": "dht22", "read": true }
+  // "hardware" is optional (all hardware), "read" triggers reader callbacks
+  StaticJsonDocument<Limits::COMMAND_DOC> doc;
+  DeserializationError error = deserializeJson(doc, payload);
+  if (error)
+    return;
+
+  // The correlation ID is echoed verbatim: refuse anything needing escaping
+  const char *id = doc["id"] | "";
+  if (strlen(id) > 64 || strpbrk(id, "\"\\") != nullptr)
+    return;
+  const char *hardware = doc["hardware"];
+  if (hardware && !_registry.hasHardware(hardware))
+    hardware = nullptr;
+
+  if ((doc["read"] | false) && _onReadRequest) {
+    for (const auto &hw : _registry.getAllHardware()) {
+      if (!hw.enabled || (hardware && strcmp(hw.key, hardware) != 0))
+        continue;
+      _registry.requestImmediatePublish(hw.key);
+      _onReadRequest(hw.key);
+    }
+  }
+  _metrics.add("getRequests");
+
+  char buffer[Limits::STATUS];
+  size_t length = Encoder::snapshot(buffer, sizeof(buffer), id, _moduleId,
+                                    Clock::now(), _registry, hardware);
+  sendTo("sensors/get/response", buffer, length, sizeof(buffer), false);
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::handleRuleEvent(
+    const RuleEvent &event) {
+  // Local reaction first: actuators must not wait for the network
+  if (_onRule) {
+    _onRule(event.ruleId, event.action, event.active);
+  }
+
+  if (!isConnected())
+    return;
+
+  char buffer[Limits::EVENT];
+  size_t length = Encoder::ruleEvent(buffer, sizeof(buffer), event, Clock::now());
+  sendTo("rules/events", buffer, length, sizeof(buffer), false);
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+bool BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::applyRules(
+    const char *payload) {
+#ifndef NATIVE_BUILD
+  // Parse rules message: { "rules": [ <rule>, ... ] }
+  StaticJsonDocument<Limits::RULES_DOC> doc;
+  DeserializationError error = deserializeJson(doc, payload);
+  if (error)
+    return false;
+
+  JsonArray rules = doc["rules"];
+  if (rules.size() > IOT_RULES_MAX)
+    return false;
+
+  // Deploy atomically: a single invalid rule keeps the previous set
+  for (JsonObject rule : rules) {
+    if (!RuleEngine::validate(ruleSpec(rule), _registry))
+      return false;
+  }
+  _rules.clear();
+  for (JsonObject rule : rules) {
+    _rules.addRule(ruleSpec(rule), _registry);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::restoreRules() {
+#ifndef NATIVE_BUILD
+  // The last deployed set runs from boot, before the broker is reachable
+  char stored[Limits::RULES];
+  if (_config.loadRules(stored, sizeof(stored)) > 0 && applyRules(stored)) {
+    IOT_LOG_INFO("[MQTT] Rules restored (%u rules)", (unsigned)_rules.count());
+  }
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::handleRulesMessage(
+    const char *payload) {
+#ifndef NATIVE_BUILD
+  bool ok = applyRules(payload);
+  IOT_LOG_INFO("[MQTT] Rules %s (%u rules)", ok ? "deployed" : "rejected",
+                (unsigned)_rules.count());
+
+  // Only a deployed set is saved: a rejected one leaves the saved set
+  if (ok) {
+    if (strlen(payload) < Limits::RULES) {
+      _config.saveRules(payload);
+    } else {
+      IOT_LOG_WARN("[MQTT] Rule set too large to save (%u bytes)",
+                   (unsigned)strlen(payload));
+    }
+  }
+
+  char buffer[Limits::EVENT];
+  size_t length =
+      Encoder::rulesStatus(buffer, sizeof(buffer), ok, _rules.count());
+  sendTo("rules/status", buffer, length, sizeof(buffer), false);
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::handleConfigMessage(
+    const char *payload, uint8_t priority, int source) {
+#ifndef NATIVE_BUILD
+  IOT_LOG_INFO("[MQTT] Config received (priority %d)", priority);
+  IOT_LOG_DEBUG("[MQTT] Payload: %s", payload);
+
+  // Parse config message
+  StaticJsonDocument<Limits::CONFIG_DOC> doc;
+  DeserializationError error = deserializeJson(doc, payload);
+  if (error) {
+    IOT_LOG_WARN("[MQTT] JSON parse error: %s", error.c_str());
+    return;
+  }
+
+  // The shadow applies each desired version once; unversioned documents
+  // cannot be acknowledged and are dropped
+  if (source == SHADOW_SOURCE) {
+    uint32_t version = doc["version"] | 0UL;
+    if (!_shadow.acceptDesired(version)) {
+      IOT_LOG_INFO("[MQTT] Desired version %lu ignored (applied %lu)",
+                    (unsigned long)version,
+                    (unsigned long)_shadow.desiredVersion());
+      return;
+    }
+    _config.saveShadowVersion(version);
+  }
+
+  // Shared topics apply each version once, even when redelivered as retained
+  if (source >= 0 && doc.containsKey("version")) {
+    uint32_t version = doc["version"];
+    if (!_sources.acceptVersion(source, version)) {
+      IOT_LOG_DEBUG("[MQTT] Config version %lu already applied",
+                    (unsigned long)version);
+      return;
+    }
+    _config.saveSourceVersion(_sources.get(source).topic, version);
+  }
+
+  // Phase assigned by the backend: { "phase": 250 } (per-mille)
+  if (priority == ConfigSources::MODULE_PRIORITY && doc.containsKey("phase")) {
+    uint16_t phase = (doc["phase"] | 0) % IOT_PHASE_STEPS;
+    IOT_LOG_INFO("[MQTT] Phase set to %u", phase);
+    setPhase(phase);
+    _config.savePhase(phase);
+  }
+
+  // Look for interval updates per hardware
+  JsonObject sensors = doc["sensors"];
+  if (!sensors)
+    return;
+
+  IOT_LOG_DEBUG("[MQTT] Processing sensor configs...");
+  for (const auto &hw : _registry.getAllHardware()) {
+    if (!sensors.containsKey(hw.key))
+      continue;
+    JsonObject hwConfig = sensors[hw.key];
+
+    // "inherit" on the module topic hands the hardware back to its groups
+    if (priority == ConfigSources::MODULE_PRIORITY && (hwConfig["inherit"] | false)) {
+      _registry.setConfigPriority(hw.key, ConfigSources::DEFAULT_PRIORITY);
+      _config.saveConfigPriority(hw.key, ConfigSources::DEFAULT_PRIORITY);
+      continue;
+    }
+
+    // A more specific source configured this hardware: keep its settings
+    if (priority < hw.configPriority) {
+      IOT_LOG_INFO("[MQTT] %s keeps config from priority %d", hw.key,
+                    hw.configPriority);
+      continue;
+    }
+    if (priority != hw.configPriority) {
+      _registry.setConfigPriority(hw.key, priority);
+      _config.saveConfigPriority(hw.key, priority);
+    }
+
+    if (hwConfig.containsKey("adaptive")) {
+      applyAdaptiveConfig(_registry, _config, hw.key,
+                          hwConfig["adaptive"].as<JsonVariant>());
+    }
+    if (hwConfig.containsKey("aligned")) {
+      bool aligned = hwConfig["aligned"];
+      _registry.setAlignedSampling(hw.key, aligned, Clock::now());
+      _config.saveAligned(hw.key, aligned);
+    }
+    if (hwConfig.containsKey("pipeline")) {
+      applyPipelineConfig(_registry, hw.key,
+                          hwConfig["pipeline"].as<JsonObject>());
+    }
+    if (hwConfig.containsKey("interval")) {
+      int interval = hwConfig["interval"];
+      IOT_LOG_INFO("[MQTT] Setting %s interval to %d seconds", hw.key,
+                    interval);
+      _registry.setHardwareInterval(hw.key, interval * 1000);
+      _config.saveInterval(hw.key, interval * 1000);
+
+      if (_onConfigChange) {
+        _onConfigChange(hw.key, interval * 1000);
+      }
+    }
+  }
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::handleMqttMessage(
+    const char *topic, const char *payload) {
+  StackProbe probe(_stack, StackEntry::Message);
+#ifndef NATIVE_BUILD
+  // Parse topic to extract message type
+  // Expected formats:
+  //   moduleId/sensors/config  - configuration update (unversioned)
+  //   moduleId/shadow/desired  - versioned configuration update
+  //   types/<type>/sensors/config, groups/<group>/sensors/config
+  //                            - shared configuration update
+  //   moduleId/sensors/enable  - enable/disable hardware
+  //   moduleId/sensors/reset   - hardware reset request
+  //   moduleId/sensors/burst   - temporary interval override
+  //   moduleId/sensors/get     - on-demand snapshot request
+  //   moduleId/rules           - local rule set deployment
+
+  // Topics of this module: "<moduleId>/<suffix>", matched on the suffix
+  size_t idLength = strlen(_moduleId);
+  const char *suffix =
+      strncmp(topic, _moduleId, idLength) == 0 && topic[idLength] == '/'
+          ? topic + idLength + 1
+          : "";
+
+  int source = _sources.match(topic);
+  if (strcmp(suffix, "sensors/config") == 0) {
+    handleConfigMessage(payload, ConfigSources::MODULE_PRIORITY,
+                        MODULE_SOURCE);
+  } else if (strcmp(suffix, "shadow/desired") == 0) {
+    handleConfigMessage(payload, ConfigSources::MODULE_PRIORITY,
+                        SHADOW_SOURCE);
+  } else if (source >= 0) {
+    handleConfigMessage(payload, _sources.get(source).priority, source);
+  } else if (strcmp(suffix, "sensors/enable") == 0) {
+    // Parse enable message: { "hardware": "dht22", "enabled": true }
+    StaticJsonDocument<Limits::COMMAND_DOC> doc;
+    DeserializationError error = deserializeJson(doc, payload);
+    if (error)
+      return;
+
+    const char *hardware = doc["hardware"];
+    bool enabled = doc["enabled"];
+
+    if (hardware) {
+      _registry.setHardwareEnabled(hardware, enabled);
+      _config.saveHardwareEnabled(hardware, enabled);
+
+      if (_onEnableChange) {
+        _onEnableChange(hardware, enabled);
+      }
+    }
+  } else if (strcmp(suffix, "sensors/reset") == 0) {
+    // Parse reset message: { "sensor": "dht22" }
+    StaticJsonDocument<Limits::COMMAND_DOC> doc;
+    DeserializationError error = deserializeJson(doc, payload);
+    if (error)
+      return;
+
+    const char *sensor = doc["sensor"];
+
+    if (sensor && _onResetChange) {
+      _onResetChange(sensor);
+    }
+  } else if (strcmp(suffix, "rules") == 0) {
+    handleRulesMessage(payload);
+  } else if (strcmp(suffix, "sensors/burst") == 0) {
+    handleBurstMessage(payload);
+  } else if (strcmp(suffix, "sensors/get") == 0) {
+    handleGetMessage(payload);
+  }
+#endif
+}
+
+template <class Transport, class Store, class Encoder, class Limits,
+          class Session>
+void BasicIotMesurable<Transport, Store, Encoder, Limits, Session>::setupSubscriptions() {
+  char topic[Limits::TOPIC];
+
+  // Subscribe to config topic
+  snprintf(topic, sizeof(topic), "%s/sensors/config", _moduleId);
+  mqttSubscribe(topic);
+
+  // Subscribe to desired shadow (retained desired state is applied once)
+  snprintf(topic, sizeof(topic), "%s/shadow/desired", _moduleId);
+  mqttSubscribe(topic);
+
+  // Subscribe to enable topic
+  snprintf(topic, sizeof(topic), "%s/sensors/enable", _moduleId);
+  mqttSubscribe(topic);
+
+  // Subscribe to reset topic
+  snprintf(topic, sizeof(topic), "%s/sensors/reset", _moduleId);
+  mqttSubscribe(topic);
+
+  // Subscribe to burst topic
+  snprintf(topic, sizeof(topic), "%s/sensors/burst", _moduleId);
+  mqttSubscribe(topic);
+
+  // Subscribe to on-demand snapshot topic
+  snprintf(topic, sizeof(topic), "%s/sensors/get", _moduleId);
+  mqttSubscribe(topic);
+
+  // Subscribe to shared config topics (module type and groups)
+  for (size_t i = 0; i < _sources.count(); i++) {
+    mqttSubscribe(_sources.get(i).topic);
+  }
+
+  // Subscribe to rules topic (retained rule sets are redeployed on connect)
+  snprintf(topic, sizeof(topic), "%s/rules", _moduleId);
+  mqttSubscribe(topic);
+}
+
+#endif // IOT_MESURABLE_IMPL_H
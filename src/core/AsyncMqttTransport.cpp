@@ -0,0 +1,74 @@
+/**
+ * @file AsyncMqttTransport.cpp
+ * @brief Implementation of AsyncMqttTransport
+ */
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+
+#include "AsyncMqttTransport.h"
+#include "Logger.h"
+#include <cstring>
+
+AsyncMqttTransport::AsyncMqttTransport() {
+    _client.onConnect([this](bool sessionPresent) {
+        notifyConnect(true);
+    });
+
+    _client.onDisconnect([this](AsyncMqttClientDisconnectReason reason) {
+        IOT_LOG_WARN("[MQTT] Disconnected (reason: %d)", (int)reason);
+        notifyConnect(false);
+    });
+
+    _client.onMessage([this](char* topic, char* payload,
+                             AsyncMqttClientMessageProperties properties,
+                             size_t len, size_t index, size_t total) {
+        if (payload) {
+            // Create null-terminated copy
+            char buffer[512];
+            size_t copyLen = len < sizeof(buffer) - 1 ? len : sizeof(buffer) - 1;
+            memcpy(buffer, payload, copyLen);
+            buffer[copyLen] = '\0';
+
+            notifyMessage(topic, buffer);
+        }
+    });
+}
+
+bool AsyncMqttTransport::connect(const MqttSessionConfig& config) {
+    // AsyncMqttClient keeps the pointers: MqttClient owns the strings
+    _client.setServer(config.host, config.port);
+    _client.setClientId(config.clientId);
+    if (config.username[0] != '\0') {
+        _client.setCredentials(config.username, config.password);
+    }
+    if (config.willTopic) {
+        _client.setWill(config.willTopic, 1, true, config.willPayload);
+    }
+
+    if (!_client.connected()) {
+        IOT_LOG_INFO("[MQTT] Connecting to %s:%d...", config.host, config.port);
+        _client.connect();
+    }
+    return true;
+}
+
+void AsyncMqttTransport::disconnect() {
+    _client.disconnect();
+}
+
+bool AsyncMqttTransport::connected() const {
+    return _client.connected();
+}
+
+bool AsyncMqttTransport::subscribe(const char* topic) {
+    return _client.subscribe(topic, 0) != 0;
+}
+
+bool AsyncMqttTransport::publish(const char* topic, const uint8_t* payload, size_t length,
+                                 int8_t qos, bool retain) {
+    // No session-less publishing over TCP
+    if (qos < 0) qos = MqttQos::AtMostOnce;
+    return _client.publish(topic, qos, retain, (const char*)payload, length) != 0;
+}
+
+#endif // !NATIVE_BUILD && !IOT_POSIX
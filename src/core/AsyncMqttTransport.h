@@ -0,0 +1,40 @@
+/**
+ * @file AsyncMqttTransport.h
+ * @brief MQTT 3.1.1 over TCP through AsyncMqttClient (ESP32/ESP8266)
+ */
+
+#ifndef ASYNC_MQTT_TRANSPORT_H
+#define ASYNC_MQTT_TRANSPORT_H
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+
+#include <AsyncMqttClient.h>
+#include "MqttTransport.h"
+
+/**
+ * @brief Default transport on the device
+ *
+ * AsyncMqttClient frames its own packets and does not expose its TCP
+ * client, so a batch could only be replayed one publish() per packet:
+ * MqttClient does not batch over this transport, and device builds have no
+ * batch buffer (IOT_MQTT_BATCH_BYTES 0). Only the TCP stack (Nagle) may
+ * merge publishes into fewer segments.
+ */
+class AsyncMqttTransport : public MqttTransport {
+public:
+    AsyncMqttTransport();
+
+    bool connect(const MqttSessionConfig& config) override;
+    void disconnect() override;
+    bool connected() const override;
+    bool subscribe(const char* topic) override;
+    bool publish(const char* topic, const uint8_t* payload, size_t length,
+                 int8_t qos, bool retain) override;
+
+private:
+    AsyncMqttClient _client;
+};
+
+#endif // !NATIVE_BUILD && !IOT_POSIX
+
+#endif // ASYNC_MQTT_TRANSPORT_H
@@ -0,0 +1,165 @@
+/**
+ * @file Callback.h
+ * @brief Non-allocating callable storage for callbacks
+ */
+
+#ifndef IOT_CALLBACK_H
+#define IOT_CALLBACK_H
+
+#include <stddef.h>
+#include <string.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifndef IOT_CALLBACK_BYTES
+#define IOT_CALLBACK_BYTES (4 * sizeof(void*))   // Captures of up to four pointers
+#endif
+
+template <class Signature, size_t Capacity = IOT_CALLBACK_BYTES>
+class Callback;
+
+/**
+ * @brief Drop-in for std::function that never allocates
+ *
+ * The callable (lambda, functor or function pointer) is stored inline in
+ * Capacity bytes; a capture that does not fit fails to compile instead of
+ * going to the heap. A call is one indirect call. Trivially copyable
+ * captures (pointers, this, numbers) are copied with memcpy, others through
+ * their copy constructor.
+ *
+ * @code
+ * Callback<void(bool)> onConnect = [this](bool connected) { ... };
+ * if (onConnect) onConnect(true);
+ * @endcode
+ */
+template <class R, class... Args, size_t Capacity>
+class Callback<R(Args...), Capacity> {
+public:
+    Callback() : _invoke(nullptr), _manage(nullptr) {}
+    Callback(std::nullptr_t) : _invoke(nullptr), _manage(nullptr) {}
+
+    template <class F, class = typename std::enable_if<
+                           !std::is_same<typename std::decay<F>::type, Callback>::value>::type>
+    Callback(F&& function) : _invoke(nullptr), _manage(nullptr) {
+        assign(std::forward<F>(function));
+    }
+
+    Callback(const Callback& other) : _invoke(nullptr), _manage(nullptr) { copyFrom(other); }
+    Callback(Callback&& other) : _invoke(nullptr), _manage(nullptr) { moveFrom(other); }
+    ~Callback() { reset(); }
+
+    Callback& operator=(const Callback& other) {
+        if (this != &other) {
+            reset();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    Callback& operator=(Callback&& other) {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    Callback& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    template <class F, class = typename std::enable_if<
+                           !std::is_same<typename std::decay<F>::type, Callback>::value>::type>
+    Callback& operator=(F&& function) {
+        reset();
+        assign(std::forward<F>(function));
+        return *this;
+    }
+
+    explicit operator bool() const { return _invoke != nullptr; }
+
+    /**
+     * @brief Call the stored callable (must not be empty)
+     */
+    R operator()(Args... args) const {
+        return _invoke(const_cast<void*>(static_cast<const void*>(&_storage)),
+                       std::forward<Args>(args)...);
+    }
+
+private:
+    enum Operation { Copy, Move, Destroy };
+
+    typedef R (*Invoker)(void* storage, Args... args);
+    typedef void (*Manager)(Operation operation, void* target, void* source);
+
+    typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type _storage;
+    Invoker _invoke;
+    Manager _manage;    // nullptr for trivially copyable callables
+
+    template <class F>
+    static R invoke(void* storage, Args... args) {
+        return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+    }
+
+    template <class F>
+    static void manage(Operation operation, void* target, void* source) {
+        switch (operation) {
+            case Copy: new (target) F(*static_cast<const F*>(source)); break;
+            case Move: new (target) F(std::move(*static_cast<F*>(source))); break;
+            case Destroy: static_cast<F*>(target)->~F(); break;
+        }
+    }
+
+    // Empty function pointers give an empty callback, as with std::function
+    template <class F>
+    static bool isNull(const F& function, std::true_type) { return function == nullptr; }
+    template <class F>
+    static bool isNull(const F&, std::false_type) { return false; }
+
+    template <class F>
+    void assign(F&& function) {
+        typedef typename std::decay<F>::type Stored;
+        static_assert(sizeof(Stored) <= Capacity,
+                      "Callback capture too large: capture less or raise IOT_CALLBACK_BYTES");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t),
+                      "Callback capture over-aligned");
+        if (isNull<Stored>(function, std::is_pointer<Stored>())) return;
+        new (&_storage) Stored(std::forward<F>(function));
+        _invoke = &invoke<Stored>;
+        _manage = std::is_trivially_copyable<Stored>::value ? nullptr : &manage<Stored>;
+    }
+
+    void copyFrom(const Callback& other) {
+        if (!other._invoke) return;
+        if (other._manage) {
+            other._manage(Copy, &_storage, const_cast<void*>(static_cast<const void*>(&other._storage)));
+        } else {
+            memcpy(&_storage, &other._storage, sizeof(_storage));
+        }
+        _invoke = other._invoke;
+        _manage = other._manage;
+    }
+
+    void moveFrom(Callback& other) {
+        if (!other._invoke) return;
+        if (other._manage) {
+            other._manage(Move, &_storage, &other._storage);
+        } else {
+            memcpy(&_storage, &other._storage, sizeof(_storage));
+        }
+        _invoke = other._invoke;
+        _manage = other._manage;
+        other.reset();
+    }
+
+    void reset() {
+        if (_manage) _manage(Destroy, &_storage, nullptr);
+        _invoke = nullptr;
+        _manage = nullptr;
+    }
+};
+
+#endif // IOT_CALLBACK_H
@@ -0,0 +1,10 @@
+/**
+ * @file Clock.cpp
+ * @brief Time source of native builds
+ */
+
+#include "Clock.h"
+
+#ifdef NATIVE_BUILD
+ClockSource Clock::_source;
+#endif
@@ -0,0 +1,42 @@
+/**
+ * @file Clock.h
+ * @brief Millisecond time base of the library timers
+ */
+
+#ifndef IOT_CLOCK_H
+#define IOT_CLOCK_H
+
+#include <Arduino.h>
+#include "Callback.h"
+
+using ClockSource = Callback<unsigned long()>;
+
+/**
+ * @brief Time read by every library timer
+ *
+ * millis() on the device and on Linux. Native builds can take time from a
+ * simulated clock instead (FakeBroker hands over its own), so tests move
+ * reconnect, status and metrics timers forward without sleeping.
+ */
+class Clock {
+public:
+    static unsigned long now() {
+#ifdef NATIVE_BUILD
+        return _source ? _source() : millis();
+#else
+        return millis();
+#endif
+    }
+
+#ifdef NATIVE_BUILD
+    /**
+     * @brief Read time from a source instead of millis() (nullptr: millis())
+     */
+    static void setSource(ClockSource source) { _source = source; }
+
+private:
+    static ClockSource _source;
+#endif
+};
+
+#endif // IOT_CLOCK_H
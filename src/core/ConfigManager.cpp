@@ -6,14 +6,16 @@
 #include "ConfigManager.h"
 #include <cstring>
 
-#ifndef NATIVE_BUILD
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
 #ifdef ESP32
 #include <WiFi.h>
 #elif defined(ESP8266)
 #include <ESP8266WiFi.h>
 #endif
+#if IOT_FEATURE_WIFI_MANAGER
 #include <WiFiManager.h>
 #endif
+#endif
 
 ConfigManager::ConfigManager() : _port(1883) {
     memset(_broker, 0, sizeof(_broker));
@@ -27,7 +29,7 @@ ConfigManager::~ConfigManager() {
 }
 
 bool ConfigManager::beginWiFiManager(const char* apName) {
-#ifndef NATIVE_BUILD
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX) && IOT_FEATURE_WIFI_MANAGER
     WiFiManager wm;
     
     // Custom parameters for MQTT broker
@@ -44,6 +46,9 @@ bool ConfigManager::beginWiFiManager(const char* apName) {
     }
     
     return connected;
+#elif !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+    // Built without the portal
+    return beginWiFi(nullptr, nullptr);
 #else
     return true;
 #endif
@@ -51,9 +56,18 @@ bool ConfigManager::beginWiFiManager(const char* apName) {
 
 bool ConfigManager::beginWiFi(const char* ssid, const char* password,
                                unsigned long timeoutMs) {
-#ifndef NATIVE_BUILD
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+    // Already joined by another module of the same device
+    if (WiFi.status() == WL_CONNECTED) {
+        return true;
+    }
+
     WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, password);
+    if (ssid) {
+        WiFi.begin(ssid, password);
+    } else {
+        WiFi.begin();
+    }
     
     unsigned long start = millis();
     while (WiFi.status() != WL_CONNECTED) {
@@ -65,12 +79,13 @@ bool ConfigManager::beginWiFi(const char* ssid, const char* password,
     
     return true;
 #else
+    // Native tests have no network; Linux gateways use the host's
     return true;
 #endif
 }
 
 bool ConfigManager::isWiFiConnected() const {
-#ifndef NATIVE_BUILD
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
     return WiFi.status() == WL_CONNECTED;
 #else
     return true;
@@ -107,6 +122,29 @@ bool ConfigManager::loadHardwareEnabled(const char* hardwareKey, bool defaultVal
 #endif
 }
 
+void ConfigManager::saveAligned(const char* hardwareKey, bool aligned) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", false);
+    char key[48];
+    snprintf(key, sizeof(key), "al_%s", hardwareKey);
+    _prefs.putBool(key, aligned);
+    _prefs.end();
+#endif
+}
+
+bool ConfigManager::loadAligned(const char* hardwareKey) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    char key[48];
+    snprintf(key, sizeof(key), "al_%s", hardwareKey);
+    bool value = _prefs.getBool(key, false);
+    _prefs.end();
+    return value;
+#else
+    return false;
+#endif
+}
+
 void ConfigManager::saveInterval(const char* hardwareKey, int intervalMs) {
 #ifndef NATIVE_BUILD
     _prefs.begin("iot-mesurable", false);
@@ -130,6 +168,176 @@ int ConfigManager::loadInterval(const char* hardwareKey, int defaultValue) {
 #endif
 }
 
+namespace {
+struct StoredAdaptive {
+    int32_t minIntervalMs;
+    int32_t maxIntervalMs;
+    float changeRate;
+};
+}
+
+void ConfigManager::saveAdaptive(const char* hardwareKey, int minIntervalMs,
+                                 int maxIntervalMs, float changeRate) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", false);
+    char key[48];
+    snprintf(key, sizeof(key), "ad_%s", hardwareKey);
+    if (minIntervalMs <= 0) {
+        _prefs.remove(key);
+    } else {
+        StoredAdaptive stored = {minIntervalMs, maxIntervalMs, changeRate};
+        _prefs.putBytes(key, &stored, sizeof(stored));
+    }
+    _prefs.end();
+#endif
+}
+
+bool ConfigManager::loadAdaptive(const char* hardwareKey, int& minIntervalMs,
+                                 int& maxIntervalMs, float& changeRate) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    char key[48];
+    snprintf(key, sizeof(key), "ad_%s", hardwareKey);
+    StoredAdaptive stored;
+    bool found = _prefs.getBytes(key, &stored, sizeof(stored)) == sizeof(stored);
+    _prefs.end();
+    if (!found) return false;
+    
+    minIntervalMs = stored.minIntervalMs;
+    maxIntervalMs = stored.maxIntervalMs;
+    changeRate = stored.changeRate;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ConfigManager::saveConfigPriority(const char* hardwareKey, uint8_t priority) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", false);
+    char key[48];
+    snprintf(key, sizeof(key), "pr_%s", hardwareKey);
+    _prefs.putUChar(key, priority);
+    _prefs.end();
+#endif
+}
+
+uint8_t ConfigManager::loadConfigPriority(const char* hardwareKey) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    char key[48];
+    snprintf(key, sizeof(key), "pr_%s", hardwareKey);
+    uint8_t value = _prefs.getUChar(key, 0);
+    _prefs.end();
+    return value;
+#else
+    return 0;
+#endif
+}
+
+void ConfigManager::saveSourceVersion(const char* topic, uint32_t version) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", false);
+    char key[16];
+    sourceKey(topic, key, sizeof(key));
+    _prefs.putUInt(key, version);
+    _prefs.end();
+#endif
+}
+
+uint32_t ConfigManager::loadSourceVersion(const char* topic) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    char key[16];
+    sourceKey(topic, key, sizeof(key));
+    uint32_t value = _prefs.getUInt(key, 0);
+    _prefs.end();
+    return value;
+#else
+    return 0;
+#endif
+}
+
+void ConfigManager::saveShadowVersion(uint32_t version) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", false);
+    _prefs.putUInt("shadow_ver", version);
+    _prefs.end();
+#endif
+}
+
+uint32_t ConfigManager::loadShadowVersion() {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    uint32_t value = _prefs.getUInt("shadow_ver", 0);
+    _prefs.end();
+    return value;
+#else
+    return 0;
+#endif
+}
+
+void ConfigManager::savePhase(uint16_t phase) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", false);
+    _prefs.putUShort("phase", phase);
+    _prefs.end();
+#endif
+}
+
+bool ConfigManager::hasPhase() {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    bool exists = _prefs.isKey("phase");
+    _prefs.end();
+    return exists;
+#else
+    return false;
+#endif
+}
+
+uint16_t ConfigManager::loadPhase() {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    uint16_t value = _prefs.getUShort("phase", 0);
+    _prefs.end();
+    return value;
+#else
+    return 0;
+#endif
+}
+
+void ConfigManager::saveRules(const char* json) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", false);
+    _prefs.putString("rules", json);
+    _prefs.end();
+#endif
+}
+
+size_t ConfigManager::loadRules(char* buffer, size_t bufferSize) {
+#ifndef NATIVE_BUILD
+    _prefs.begin("iot-mesurable", true);
+    size_t length = _prefs.isKey("rules") ? _prefs.getString("rules", buffer, bufferSize) : 0;
+    _prefs.end();
+    if (length == 0) return 0;
+    buffer[bufferSize - 1] = '\0';
+    return strlen(buffer);
+#else
+    return 0;
+#endif
+}
+
+void ConfigManager::sourceKey(const char* topic, char* key, size_t keySize) {
+    // NVS keys are limited to 15 chars: store topics under their FNV-1a hash
+    uint32_t hash = 2166136261u;
+    for (const char* c = topic; *c; c++) {
+        hash ^= static_cast<uint8_t>(*c);
+        hash *= 16777619u;
+    }
+    snprintf(key, keySize, "sv_%08lx", (unsigned long)hash);
+}
+
 void ConfigManager::loadConfig() {
 #ifndef NATIVE_BUILD
     _prefs.begin("iot-mesurable", true);
@@ -7,6 +7,7 @@
 #define CONFIG_MANAGER_H
 
 #include <Arduino.h>
+#include "Features.h"
 
 #ifndef NATIVE_BUILD
 #include <Preferences.h>
@@ -22,6 +23,8 @@ public:
     
     /**
      * @brief Initialize WiFi with WiFiManager (captive portal)
+     *
+     * Built with IOT_FEATURE_WIFI_MANAGER=0, joins the saved network instead.
      * @param apName Access point name for portal
      * @return true if connected
      */
@@ -29,7 +32,7 @@ public:
     
     /**
      * @brief Initialize WiFi with direct credentials
-     * @param ssid Network name
+     * @param ssid Network name (nullptr: network saved by the last connection)
      * @param password Network password
      * @param timeoutMs Connection timeout in ms
      * @return true if connected
@@ -67,6 +70,16 @@ public:
      */
     bool loadHardwareEnabled(const char* hardwareKey, bool defaultValue = true);
     
+    /**
+     * @brief Save hardware wall-clock alignment
+     */
+    void saveAligned(const char* hardwareKey, bool aligned);
+    
+    /**
+     * @brief Load hardware wall-clock alignment
+     */
+    bool loadAligned(const char* hardwareKey);
+    
     /**
      * @brief Save hardware interval
      */
@@ -76,6 +89,75 @@ public:
      * @brief Load hardware interval
      */
     int loadInterval(const char* hardwareKey, int defaultValue = 60000);
+    
+    /**
+     * @brief Save adaptive sampling settings (minIntervalMs 0 disables)
+     */
+    void saveAdaptive(const char* hardwareKey, int minIntervalMs,
+                      int maxIntervalMs, float changeRate);
+    
+    /**
+     * @brief Load adaptive sampling settings
+     * @return true if adaptive sampling is configured for this hardware
+     */
+    bool loadAdaptive(const char* hardwareKey, int& minIntervalMs,
+                      int& maxIntervalMs, float& changeRate);
+
+    /**
+     * @brief Save the priority of the source that configured a hardware
+     */
+    void saveConfigPriority(const char* hardwareKey, uint8_t priority);
+    
+    /**
+     * @brief Load the priority of the source that configured a hardware
+     */
+    uint8_t loadConfigPriority(const char* hardwareKey);
+    
+    /**
+     * @brief Save the last applied version of a shared config topic
+     */
+    void saveSourceVersion(const char* topic, uint32_t version);
+    
+    /**
+     * @brief Load the last applied version of a shared config topic
+     */
+    uint32_t loadSourceVersion(const char* topic);
+    
+    /**
+     * @brief Save the last applied desired shadow version
+     */
+    void saveShadowVersion(uint32_t version);
+    
+    /**
+     * @brief Load the last applied desired shadow version
+     */
+    uint32_t loadShadowVersion();
+    
+    /**
+     * @brief Save the publish phase assigned by the backend
+     */
+    void savePhase(uint16_t phase);
+    
+    /**
+     * @brief Check if a publish phase was assigned
+     */
+    bool hasPhase();
+    
+    /**
+     * @brief Load the publish phase assigned by the backend
+     */
+    uint16_t loadPhase();
+
+    /**
+     * @brief Save the last deployed rule set (JSON as received)
+     */
+    void saveRules(const char* json);
+
+    /**
+     * @brief Load the last deployed rule set
+     * @return Length of the JSON copied to buffer, 0 if none was saved
+     */
+    size_t loadRules(char* buffer, size_t bufferSize);
 
     /**
      * @brief Load configuration from flash
@@ -91,6 +173,7 @@ private:
 #ifndef NATIVE_BUILD
     Preferences _prefs;
 #endif
+    static void sourceKey(const char* topic, char* key, size_t keySize);
     char _broker[128];
     uint16_t _port;
 };
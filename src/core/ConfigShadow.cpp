@@ -0,0 +1,50 @@
+/**
+ * @file ConfigShadow.cpp
+ * @brief Implementation of ConfigShadow
+ */
+
+#include "ConfigShadow.h"
+#include <cstdio>
+
+ConfigShadow::ConfigShadow() : _desiredVersion(0), _reportedVersion(0), _seq(0) {}
+
+bool ConfigShadow::acceptDesired(uint32_t version) {
+    if (version <= _desiredVersion) return false;
+    _desiredVersion = version;
+    return true;
+}
+
+bool ConfigShadow::needsReport(const SensorRegistry& registry) const {
+    return _reportedVersion != _desiredVersion || registry.hasPendingReport();
+}
+
+size_t ConfigShadow::buildReport(SensorRegistry& registry, char* buffer,
+                                 size_t bufferSize, bool full) {
+    if (full) registry.markReportPending();
+
+    size_t written = snprintf(buffer, bufferSize,
+        "{\"version\":%lu,\"seq\":%lu,%s\"sensors\":",
+        (unsigned long)_desiredVersion, (unsigned long)(_seq + 1),
+        full ? "\"full\":true," : "");
+    if (written + MORE_BYTES >= bufferSize) return bufferSize;
+
+    // As many whole entries as fit; the others go in the next part
+    size_t included = 0;
+    written += registry.buildReportedJson(buffer + written, bufferSize - written - MORE_BYTES,
+                                          false, &included);
+    if (written + MORE_BYTES >= bufferSize) return bufferSize;
+
+    registry.clearPendingReport(included);
+    bool more = registry.hasPendingReport();
+    if (more && included == 0) {
+        // An entry larger than a whole report can never be sent: skip it
+        registry.clearPendingReport(1);
+        more = registry.hasPendingReport();
+    }
+    written += snprintf(buffer + written, bufferSize - written, "%s}",
+                        more ? ",\"more\":true" : "");
+
+    _seq++;
+    if (!more) _reportedVersion = _desiredVersion;
+    return written;
+}
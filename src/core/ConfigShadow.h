@@ -0,0 +1,82 @@
+/**
+ * @file ConfigShadow.h
+ * @brief Desired/reported config versions of the module
+ */
+
+#ifndef CONFIG_SHADOW_H
+#define CONFIG_SHADOW_H
+
+#include <Arduino.h>
+#include "SensorRegistry.h"
+
+/**
+ * @brief Versioned config shadow
+ *
+ * The backend publishes a desired document with a version. The module
+ * applies a desired version at most once and answers with a reported
+ * document carrying the same version and only the fields that changed:
+ *
+ *   desired:  { "version": 7, "sensors": { "dht22": { "interval": 30 } } }
+ *   reported: { "version": 7, "seq": 12, "sensors": { "dht22": { "interval": 30 } } }
+ *
+ * The module has converged once reported.version equals desired.version.
+ * "seq" increases with every report so a missed delta can be detected;
+ * a full report ("full": true) is sent on every connection.
+ *
+ * A report larger than the buffer is split into parts of whole hardware
+ * entries with consecutive seqs. Every part but the last has "more": true;
+ * only the first part of a full report has "full": true.
+ */
+class ConfigShadow {
+public:
+    ConfigShadow();
+
+    /**
+     * @brief Accept a desired version if it is newer than the applied one
+     * @return true if the desired document must be applied
+     */
+    bool acceptDesired(uint32_t version);
+
+    /**
+     * @brief Restore the applied desired version (e.g., from flash)
+     */
+    void restoreDesiredVersion(uint32_t version) { _desiredVersion = version; }
+
+    /**
+     * @brief Last applied desired version, 0 if none
+     */
+    uint32_t desiredVersion() const { return _desiredVersion; }
+
+    /**
+     * @brief Desired version covered by the last report
+     */
+    uint32_t reportedVersion() const { return _reportedVersion; }
+
+    /**
+     * @brief Check if a delta report is due (changed fields or new version)
+     */
+    bool needsReport(const SensorRegistry& registry) const;
+
+    /**
+     * @brief Build the next reported part and mark its fields as reported
+     *
+     * Call again while needsReport() is true to send the remaining parts.
+     *
+     * @param registry Registry holding the config
+     * @param buffer Output buffer
+     * @param bufferSize Buffer size
+     * @param full Start a full report: every field of every hardware
+     * @return Number of bytes written, bufferSize if not even the header fits
+     */
+    size_t buildReport(SensorRegistry& registry, char* buffer, size_t bufferSize,
+                       bool full);
+
+private:
+    static const size_t MORE_BYTES = sizeof(",\"more\":true}") - 1;
+
+    uint32_t _desiredVersion;
+    uint32_t _reportedVersion;
+    uint32_t _seq;
+};
+
+#endif // CONFIG_SHADOW_H
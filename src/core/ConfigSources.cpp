@@ -0,0 +1,84 @@
+/**
+ * @file ConfigSources.cpp
+ * @brief Implementation of ConfigSources
+ */
+
+#include "ConfigSources.h"
+#include <cstring>
+#include <cstdio>
+
+ConfigSources::ConfigSources() : _count(0), _hasType(false) {
+    memset(_sources, 0, sizeof(_sources));
+}
+
+bool ConfigSources::setModuleType(const char* type) {
+    if (!validName(type)) return false;
+    
+    // The type source always sits at index 0
+    if (!_hasType) {
+        if (_count > IOT_GROUPS_MAX) return false;
+        memmove(&_sources[1], &_sources[0], _count * sizeof(ConfigSource));
+        _count++;
+        _hasType = true;
+    }
+    fill(_sources[0], "types", type, TYPE_PRIORITY);
+    return true;
+}
+
+bool ConfigSources::joinGroup(const char* group) {
+    if (!validName(group)) return false;
+    
+    size_t groups = _count - (_hasType ? 1 : 0);
+    if (groups >= IOT_GROUPS_MAX) return false;
+    
+    for (size_t i = _hasType ? 1 : 0; i < _count; i++) {
+        if (strcmp(_sources[i].name, group) == 0) return false;
+    }
+    
+    // Later joins get a higher priority so the order is deterministic
+    fill(_sources[_count], "groups", group,
+         static_cast<uint8_t>(TYPE_PRIORITY + 1 + groups));
+    _count++;
+    return true;
+}
+
+int ConfigSources::match(const char* topic) const {
+    if (!topic) return -1;
+    for (size_t i = 0; i < _count; i++) {
+        if (strcmp(_sources[i].topic, topic) == 0) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void ConfigSources::restoreVersion(size_t index, uint32_t version) {
+    if (index < _count) {
+        _sources[index].version = version;
+    }
+}
+
+bool ConfigSources::acceptVersion(size_t index, uint32_t version) {
+    if (index >= _count) return false;
+    if (version <= _sources[index].version) return false;
+    _sources[index].version = version;
+    return true;
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+bool ConfigSources::validName(const char* name) {
+    if (!name || name[0] == '\0') return false;
+    if (strlen(name) >= sizeof(ConfigSource::name)) return false;
+    // Wildcards or separators would subscribe to more than one group
+    return strpbrk(name, "/+#") == nullptr;
+}
+
+void ConfigSources::fill(ConfigSource& source, const char* prefix, const char* name,
+                         uint8_t priority) {
+    strncpy(source.name, name, sizeof(source.name) - 1);
+    source.name[sizeof(source.name) - 1] = '\0';
+    snprintf(source.topic, sizeof(source.topic), "%s/%s/sensors/config", prefix, name);
+    source.priority = priority;
+    source.version = 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file ConfigSources.h
+ * @brief Shared (fleet) config topics with precedence and version checks
+ */
+
+#ifndef CONFIG_SOURCES_H
+#define CONFIG_SOURCES_H
+
+#include <Arduino.h>
+
+#ifndef IOT_GROUPS_MAX
+#define IOT_GROUPS_MAX 4
+#endif
+
+/**
+ * @brief One shared config topic the module listens to
+ */
+struct ConfigSource {
+    char topic[96];     // e.g., "groups/greenhouse-a/sensors/config"
+    char name[32];      // Group name or module type
+    uint8_t priority;   // Higher wins; see ConfigSources
+    uint32_t version;   // Last applied version, 0 if none
+};
+
+/**
+ * @brief Shared config topics and their precedence
+ *
+ * A hardware setting is applied only if its source has a priority greater
+ * than or equal to the one that last set it:
+ *
+ *   module topic (MODULE_PRIORITY) > user groups (later joins win)
+ *                                  > module type (TYPE_PRIORITY)
+ *
+ * Each source only applies a versioned message once: a retained broadcast
+ * redelivered on reconnect is ignored unless its version increased.
+ */
+class ConfigSources {
+public:
+    static const uint8_t DEFAULT_PRIORITY = 0;   // Nothing applied yet
+    static const uint8_t TYPE_PRIORITY = 1;
+    static const uint8_t MODULE_PRIORITY = 255;
+
+    ConfigSources();
+
+    /**
+     * @brief Set the module type source ("types/<type>/sensors/config")
+     * @return true if the source was set
+     */
+    bool setModuleType(const char* type);
+
+    /**
+     * @brief Join a user group ("groups/<group>/sensors/config")
+     * @return true if joined (false if full, invalid or already joined)
+     */
+    bool joinGroup(const char* group);
+
+    /**
+     * @brief Number of sources (type first, then groups in join order)
+     */
+    size_t count() const { return _count; }
+
+    /**
+     * @brief Get a source by index
+     */
+    const ConfigSource& get(size_t index) const { return _sources[index]; }
+
+    /**
+     * @brief Find the source a topic belongs to
+     * @return Source index, -1 if the topic is not a shared config topic
+     */
+    int match(const char* topic) const;
+
+    /**
+     * @brief Restore the last applied version of a source (e.g., from flash)
+     */
+    void restoreVersion(size_t index, uint32_t version);
+
+    /**
+     * @brief Accept a message version if it is newer than the last one
+     * @return true if the message must be applied
+     */
+    bool acceptVersion(size_t index, uint32_t version);
+
+private:
+    ConfigSource _sources[IOT_GROUPS_MAX + 1];
+    size_t _count;
+    bool _hasType;
+
+    static bool validName(const char* name);
+    static void fill(ConfigSource& source, const char* prefix, const char* name,
+                     uint8_t priority);
+};
+
+#endif // CONFIG_SOURCES_H
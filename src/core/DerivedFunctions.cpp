@@ -0,0 +1,36 @@
+/**
+ * @file DerivedFunctions.cpp
+ * @brief Implementation of built-in derived sensor functions
+ */
+
+#include "DerivedFunctions.h"
+#include <cmath>
+
+namespace DerivedFunctions {
+
+// Magnus coefficients over water, valid from -45 to 60 °C
+static const float MAGNUS_B = 17.62f;
+static const float MAGNUS_C = 243.12f;
+
+float dewPoint(const float* inputs, uint8_t count) {
+    if (count < 2 || inputs[1] <= 0.0f) return NAN;
+    float t = inputs[0];
+    float gamma = logf(inputs[1] / 100.0f) + (MAGNUS_B * t) / (MAGNUS_C + t);
+    return (MAGNUS_C * gamma) / (MAGNUS_B - gamma);
+}
+
+float vpd(const float* inputs, uint8_t count) {
+    if (count < 2) return NAN;
+    float t = inputs[0];
+    float svp = 0.6108f * expf((17.27f * t) / (t + 237.3f));
+    return svp * (1.0f - inputs[1] / 100.0f);
+}
+
+float absoluteHumidity(const float* inputs, uint8_t count) {
+    if (count < 2) return NAN;
+    float t = inputs[0];
+    float svpHpa = 6.112f * expf((17.67f * t) / (t + 243.5f));
+    return (svpHpa * inputs[1] * 2.1674f) / (273.15f + t);
+}
+
+} // namespace DerivedFunctions
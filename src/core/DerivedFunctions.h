@@ -0,0 +1,40 @@
+/**
+ * @file DerivedFunctions.h
+ * @brief Built-in functions for derived sensors
+ */
+
+#ifndef DERIVED_FUNCTIONS_H
+#define DERIVED_FUNCTIONS_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Psychrometric functions usable with addDerivedSensor()
+ *
+ * All functions expect inputs in the order { temperature (°C), humidity (%RH) }.
+ *
+ * @example
+ * brain.addDerivedSensor("climate", "vpd",
+ *                        {"dht22:temperature", "dht22:humidity"},
+ *                        DerivedFunctions::vpd);
+ */
+namespace DerivedFunctions {
+
+/**
+ * @brief Dew point in °C (Magnus formula)
+ */
+float dewPoint(const float* inputs, uint8_t count);
+
+/**
+ * @brief Vapour pressure deficit in kPa (Tetens formula)
+ */
+float vpd(const float* inputs, uint8_t count);
+
+/**
+ * @brief Absolute humidity in g/m³
+ */
+float absoluteHumidity(const float* inputs, uint8_t count);
+
+} // namespace DerivedFunctions
+
+#endif // DERIVED_FUNCTIONS_H
@@ -0,0 +1,296 @@
+/**
+ * @file FakeBroker.cpp
+ * @brief Implementation of FakeBroker
+ */
+
+#ifdef NATIVE_BUILD
+
+#include "FakeBroker.h"
+#include "Clock.h"
+#include "PacketBatcher.h"
+#include <cstring>
+
+// Broker whose clock the library reads (the latest one created)
+static FakeBroker* clockBroker = nullptr;
+
+FakeBroker::FakeBroker()
+    : _state(Idle), _now(0), _latency(0), _bandwidth(0), _writeOverhead(40),
+      _lossPercent(0), _random(1), _retransmitMs(200), _pubackDelay(0),
+      _maxInflight(16), _reachable(true), _connackAt(0), _linkFreeAt(0),
+      _lastArrival(0), _writes(0), _wireBytes(0), _retransmits(0), _connects(0),
+      _inflight(0), _rejected(0) {
+    clockBroker = this;
+    Clock::setSource([]() { return clockBroker->now(); });
+}
+
+FakeBroker::~FakeBroker() {
+    if (clockBroker == this) {
+        clockBroker = nullptr;
+        Clock::setSource(nullptr);
+    }
+}
+
+void FakeBroker::setLoss(uint8_t percent, uint32_t seed) {
+    // A link losing everything is a dropped connection, not a slow one
+    _lossPercent = percent > 99 ? 99 : percent;
+    _random = seed != 0 ? seed : 1;
+}
+
+void FakeBroker::dropConnection() {
+    if (_state != Connecting && _state != Connected) return;
+
+    _uplink.clear();
+    _downlink.clear();
+    _subscriptions.clear();
+    _inflight = 0;
+    _linkFreeAt = _now;
+    _lastArrival = _now;
+    if (!_willTopic.empty()) {
+        BrokerMessage will = {_willTopic, _willPayload, MqttQos::AtLeastOnce, true, _now};
+        accept(will);
+    }
+    // The client notices on its next loop()
+    _state = Dropped;
+}
+
+// =============================================================================
+// Clock
+// =============================================================================
+
+void FakeBroker::advance(unsigned long ms) {
+    unsigned long target = _now + ms;
+    while (!_uplink.empty() && _uplink.front().arriveAt <= target) {
+        Write write = _uplink.front();
+        _uplink.pop_front();
+        _now = write.arriveAt;
+        for (size_t i = 0; i < write.messages.size(); i++) {
+            accept(write.messages[i]);
+        }
+    }
+    _now = target;
+}
+
+unsigned long FakeBroker::settle() {
+    if (_uplink.empty() || _uplink.back().arriveAt <= _now) {
+        advance(0);
+        return 0;
+    }
+    unsigned long elapsed = _uplink.back().arriveAt - _now;
+    advance(elapsed);
+    return elapsed;
+}
+
+// =============================================================================
+// Broker Side
+// =============================================================================
+
+bool FakeBroker::deliver(const char* topic, const char* payload, bool retain) {
+    if (retain) {
+        if (payload[0] == '\0') {
+            _retained.erase(topic);
+        } else {
+            _retained[topic] = payload;
+        }
+    }
+    if (_state != Connected || !subscribed(topic)) return false;
+    queueToClient(_now + _latency, false, topic, payload);
+    return true;
+}
+
+const char* FakeBroker::retained(const char* topic) const {
+    std::map<std::string, std::string>::const_iterator it = _retained.find(topic);
+    return it == _retained.end() ? nullptr : it->second.c_str();
+}
+
+bool FakeBroker::subscribed(const char* topic) const {
+    for (size_t i = 0; i < _subscriptions.size(); i++) {
+        if (matches(_subscriptions[i].c_str(), topic)) return true;
+    }
+    return false;
+}
+
+// =============================================================================
+// MqttTransport
+// =============================================================================
+
+bool FakeBroker::connect(const MqttSessionConfig& config) {
+    if (_state == Connecting || _state == Connected) return true;
+
+    _connects++;
+    _willTopic = config.willTopic ? config.willTopic : "";
+    _willPayload = config.willPayload ? config.willPayload : "";
+    _downlink.clear();
+    _subscriptions.clear(); // Clean session
+    _inflight = 0;
+    // CONNECT and CONNACK: one round trip
+    _connackAt = _now + 2 * _latency;
+    _state = Connecting;
+    return true;
+}
+
+void FakeBroker::disconnect() {
+    if (_state == Idle) return;
+
+    // Writes already sent still arrive, ahead of the DISCONNECT
+    _downlink.clear();
+    _subscriptions.clear();
+    _inflight = 0;
+    _state = Idle;
+    notifyConnect(false);
+}
+
+bool FakeBroker::subscribe(const char* topic) {
+    if (_state != Connected) return false;
+    _subscriptions.push_back(topic);
+
+    // Retained messages follow the SUBACK
+    for (std::map<std::string, std::string>::const_iterator it = _retained.begin();
+         it != _retained.end(); ++it) {
+        if (matches(topic, it->first.c_str())) {
+            queueToClient(_now + 2 * _latency, false, it->first, it->second);
+        }
+    }
+    return true;
+}
+
+bool FakeBroker::publish(const char* topic, const uint8_t* payload, size_t length,
+                         int8_t qos, bool retain) {
+    if (_state != Connected) return false;
+    if (qos < 0) qos = MqttQos::AtMostOnce;
+    if (qos > 0 && _inflight >= _maxInflight) {
+        _rejected++;
+        return false;
+    }
+
+    Write write;
+    BrokerMessage message = {topic, std::string((const char*)payload, length), qos, retain, 0};
+    write.messages.push_back(message);
+    if (qos > 0) _inflight++;
+
+    // Fixed header, topic, packet ID, payload
+    size_t remaining = 2 + strlen(topic) + (qos > 0 ? 2 : 0) + length;
+    size_t header = remaining < 128 ? 2 : remaining < 16384 ? 3 : 4;
+    send(write, header + remaining);
+    return true;
+}
+
+size_t FakeBroker::writePackets(const uint8_t* data, size_t length, size_t& writes) {
+    writes = 0;
+    if (_state != Connected) return 0;
+
+    Write write;
+    size_t offset = 0;
+    char topic[256];
+    const uint8_t* payload;
+    size_t payloadLength;
+    bool retain;
+    while (PacketBatcher::decode(data, length, offset, topic, sizeof(topic), payload,
+                                 payloadLength, retain)) {
+        BrokerMessage message = {topic, std::string((const char*)payload, payloadLength),
+                                 MqttQos::AtMostOnce, retain, 0};
+        write.messages.push_back(message);
+    }
+    // The whole batch is one write on the wire
+    send(write, length);
+    writes = 1;
+    return length;
+}
+
+void FakeBroker::loop() {
+    if (_state == Dropped) {
+        _state = Idle;
+        notifyConnect(false);
+        return;
+    }
+    if (_state == Connecting) {
+        if (_now < _connackAt) return;
+        _state = _reachable ? Connected : Idle;
+        notifyConnect(_reachable);
+        if (_state != Connected) return;
+    }
+    if (_state != Connected) return;
+
+    // Callbacks may publish and queue more: take what is due first
+    std::vector<Event> due;
+    for (std::deque<Event>::iterator it = _downlink.begin(); it != _downlink.end();) {
+        if (it->at <= _now) {
+            due.push_back(*it);
+            it = _downlink.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (size_t i = 0; i < due.size() && _state == Connected; i++) {
+        if (due[i].puback) {
+            if (_inflight > 0) _inflight--;
+        } else {
+            notifyMessage(due[i].topic.c_str(), due[i].payload.c_str());
+        }
+    }
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+void FakeBroker::send(Write& write, size_t bytes) {
+    size_t wire = bytes + _writeOverhead;
+    _writes++;
+    _wireBytes += wire;
+
+    // Serialization on the uplink, then propagation
+    unsigned long start = _linkFreeAt > _now ? _linkFreeAt : _now;
+    unsigned long duration = _bandwidth ? (unsigned long)((wire * 1000 + _bandwidth - 1) / _bandwidth) : 0;
+    _linkFreeAt = start + duration;
+    unsigned long arriveAt = _linkFreeAt + _latency;
+
+    while (lose()) {
+        _retransmits++;
+        _wireBytes += wire;
+        arriveAt += _retransmitMs;
+    }
+
+    // In order: nothing overtakes a retransmitted write
+    if (arriveAt < _lastArrival) arriveAt = _lastArrival;
+    _lastArrival = arriveAt;
+    write.arriveAt = arriveAt;
+    _uplink.push_back(write);
+}
+
+void FakeBroker::accept(const BrokerMessage& message) {
+    BrokerMessage stored = message;
+    stored.at = _now;
+    _received.push_back(stored);
+
+    if (message.retain) {
+        if (message.payload.empty()) {
+            _retained.erase(message.topic);
+        } else {
+            _retained[message.topic] = message.payload;
+        }
+    }
+    if (_state != Connected) return;
+    if (message.qos > 0) {
+        queueToClient(_now + _pubackDelay + _latency, true, "", "");
+    }
+    if (subscribed(message.topic.c_str())) {
+        queueToClient(_now + _latency, false, message.topic, message.payload);
+    }
+}
+
+void FakeBroker::queueToClient(unsigned long at, bool puback, const std::string& topic,
+                               const std::string& payload) {
+    Event event = {at, puback, topic, payload};
+    _downlink.push_back(event);
+}
+
+bool FakeBroker::lose() {
+    if (_lossPercent == 0) return false;
+    // xorshift32: the same seed gives the same loss pattern
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random % 100 < _lossPercent;
+}
+
+#endif // NATIVE_BUILD
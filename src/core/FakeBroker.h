@@ -0,0 +1,225 @@
+/**
+ * @file FakeBroker.h
+ * @brief In-process MQTT broker and link simulator for native tests
+ */
+
+#ifndef FAKE_BROKER_H
+#define FAKE_BROKER_H
+
+#ifdef NATIVE_BUILD
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "MqttTransport.h"
+
+/**
+ * @brief Message as accepted by the broker
+ */
+struct BrokerMessage {
+    std::string topic;
+    std::string payload;
+    int8_t qos;
+    bool retain;
+    unsigned long at;       // Broker clock when it arrived
+};
+
+/**
+ * @brief Transport double: a broker at the end of a simulated TCP link
+ *
+ * Plug it into MqttClient with setTransport(). Time is the broker's own
+ * clock, moved by advance(), so every run is deterministic; while a broker
+ * exists the library timers read it too (Clock), starting at 0:
+ *
+ * - Each write (a publish or a whole batch) is serialized on the uplink at
+ *   the configured bandwidth, plus a per-write header overhead, then
+ *   travels for the one-way latency.
+ * - A lost write is retransmitted after the retransmission timeout; later
+ *   writes wait behind it (in-order delivery, as over TCP).
+ * - QoS 1 publishes occupy the inflight window until their PUBACK returns,
+ *   after the PUBACK delay; publish() fails while the window is full.
+ * - dropConnection() cuts the link: writes still in flight are lost and the
+ *   will is published, as for a client that vanished.
+ *
+ * Subscriptions match '+' and '#' wildcards and retained messages are
+ * replayed on subscribe. Control packets (CONNECT, SUBSCRIBE) take one
+ * round trip but no bandwidth.
+ */
+class FakeBroker : public MqttTransport {
+public:
+    FakeBroker();
+    ~FakeBroker();
+
+    // -------------------------------------------------------------------------
+    // Link
+    // -------------------------------------------------------------------------
+
+    /**
+     * @brief One-way latency in ms
+     */
+    void setLatency(unsigned long ms) { _latency = ms; }
+
+    /**
+     * @brief Uplink bandwidth in bytes per second (0 = unlimited)
+     */
+    void setBandwidth(unsigned long bytesPerSecond) { _bandwidth = bytesPerSecond; }
+
+    /**
+     * @brief Bytes added to every write on the wire (default 40: TCP/IPv4 headers)
+     */
+    void setWriteOverhead(size_t bytes) { _writeOverhead = bytes; }
+
+    /**
+     * @brief Lose a share of writes (each is retransmitted after retransmitMs)
+     * @param percent 0-100
+     * @param seed Seed of the loss pattern
+     */
+    void setLoss(uint8_t percent, uint32_t seed = 1);
+
+    /**
+     * @brief Retransmission timeout of a lost write (default 200 ms)
+     */
+    void setRetransmitTimeout(unsigned long ms) { _retransmitMs = ms; }
+
+    /**
+     * @brief Time the broker takes to acknowledge a QoS 1 publish
+     */
+    void setPubackDelay(unsigned long ms) { _pubackDelay = ms; }
+
+    /**
+     * @brief Unacknowledged QoS 1 publishes allowed (default 16)
+     */
+    void setMaxInflight(size_t count) { _maxInflight = count; }
+
+    /**
+     * @brief Refuse new connections (broker down)
+     */
+    void setReachable(bool reachable) { _reachable = reachable; }
+
+    /**
+     * @brief Cut the connection without a DISCONNECT (the will is published)
+     */
+    void dropConnection();
+
+    // -------------------------------------------------------------------------
+    // Clock
+    // -------------------------------------------------------------------------
+
+    /**
+     * @brief Move the broker clock; writes arriving meanwhile are accepted
+     */
+    void advance(unsigned long ms);
+
+    /**
+     * @brief Advance until every write in flight has arrived
+     * @return Time advanced in ms
+     */
+    unsigned long settle();
+
+    unsigned long now() const { return _now; }
+
+    // -------------------------------------------------------------------------
+    // Broker side
+    // -------------------------------------------------------------------------
+
+    /**
+     * @brief Publish to the client as another client would
+     * @return false if the client is not connected or not subscribed
+     */
+    bool deliver(const char* topic, const char* payload, bool retain = false);
+
+    /**
+     * @brief Messages accepted by the broker (and the will), in order
+     */
+    const std::vector<BrokerMessage>& received() const { return _received; }
+
+    /**
+     * @brief Retained payload of a topic, nullptr if none
+     */
+    const char* retained(const char* topic) const;
+
+    bool subscribed(const char* topic) const;
+
+    // -------------------------------------------------------------------------
+    // Statistics
+    // -------------------------------------------------------------------------
+
+    size_t writes() const { return _writes; }
+    size_t wireBytes() const { return _wireBytes; }
+    size_t retransmits() const { return _retransmits; }
+    size_t connects() const { return _connects; }
+    size_t inflight() const { return _inflight; }
+    size_t rejected() const { return _rejected; }
+
+    // -------------------------------------------------------------------------
+    // MqttTransport
+    // -------------------------------------------------------------------------
+
+    bool connect(const MqttSessionConfig& config) override;
+    void disconnect() override;
+    bool connected() const override { return _state == Connected; }
+    bool subscribe(const char* topic) override;
+    bool publish(const char* topic, const uint8_t* payload, size_t length,
+                 int8_t qos, bool retain) override;
+    size_t writePackets(const uint8_t* data, size_t length, size_t& writes) override;
+    bool writesBatches() const override { return true; }
+    void loop() override;
+
+private:
+    enum State { Idle, Connecting, Connected, Dropped };
+
+    // One write on the uplink
+    struct Write {
+        unsigned long arriveAt;
+        std::vector<BrokerMessage> messages;
+    };
+
+    // Something arriving at the client
+    struct Event {
+        unsigned long at;
+        bool puback;
+        std::string topic;
+        std::string payload;
+    };
+
+    State _state;
+    unsigned long _now;
+    unsigned long _latency;
+    unsigned long _bandwidth;
+    size_t _writeOverhead;
+    uint8_t _lossPercent;
+    uint32_t _random;
+    unsigned long _retransmitMs;
+    unsigned long _pubackDelay;
+    size_t _maxInflight;
+    bool _reachable;
+    unsigned long _connackAt;
+    unsigned long _linkFreeAt;      // Uplink busy serializing until then
+    unsigned long _lastArrival;     // In-order delivery
+    std::string _willTopic;
+    std::string _willPayload;
+
+    std::deque<Write> _uplink;
+    std::deque<Event> _downlink;
+    std::vector<std::string> _subscriptions;
+    std::map<std::string, std::string> _retained;
+    std::vector<BrokerMessage> _received;
+
+    size_t _writes;
+    size_t _wireBytes;
+    size_t _retransmits;
+    size_t _connects;
+    size_t _inflight;
+    size_t _rejected;
+
+    void send(Write& write, size_t bytes);
+    void accept(const BrokerMessage& message);
+    void queueToClient(unsigned long at, bool puback, const std::string& topic,
+                       const std::string& payload);
+    bool lose();
+};
+
+#endif // NATIVE_BUILD
+
+#endif // FAKE_BROKER_H
@@ -0,0 +1,35 @@
+/**
+ * @file Features.h
+ * @brief Optional features of BasicIotMesurable
+ *
+ * Each feature can be removed with -DIOT_FEATURE_<NAME>=0; its code and
+ * the libraries it pulls in are then not linked. -DIOT_MINIMAL turns every
+ * feature off by default (a -D flag still turns one back on).
+ */
+
+#ifndef IOT_FEATURES_H
+#define IOT_FEATURES_H
+
+#ifdef IOT_MINIMAL
+#define IOT_FEATURE_DEFAULT 0
+#else
+#define IOT_FEATURE_DEFAULT 1
+#endif
+
+#ifndef IOT_FEATURE_OTA
+#define IOT_FEATURE_OTA IOT_FEATURE_DEFAULT           // ArduinoOTA updates
+#endif
+
+#ifndef IOT_FEATURE_WIFI_MANAGER
+#define IOT_FEATURE_WIFI_MANAGER IOT_FEATURE_DEFAULT  // Captive portal in begin()
+#endif
+
+#ifndef IOT_FEATURE_SYSTEM_INFO
+#define IOT_FEATURE_SYSTEM_INFO IOT_FEATURE_DEFAULT   // system/config, system/state, hardware/config
+#endif
+
+#ifndef IOT_FEATURE_STATUS
+#define IOT_FEATURE_STATUS IOT_FEATURE_DEFAULT        // sensors/status
+#endif
+
+#endif // IOT_FEATURES_H
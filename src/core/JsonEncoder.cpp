@@ -0,0 +1,141 @@
+/**
+ * @file JsonEncoder.cpp
+ * @brief Implementation of JsonEncoder
+ */
+
+#include "JsonEncoder.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+size_t JsonEncoder::value(char* buffer, size_t bufferSize, float value) {
+    return snprintf(buffer, bufferSize, "%.2f", value);
+}
+
+size_t JsonEncoder::status(char* buffer, size_t bufferSize, const char* moduleId,
+                           const char* moduleType, const SensorRegistry& registry,
+                           size_t* next) {
+    size_t written = snprintf(buffer, bufferSize,
+                              "{\"moduleId\":\"%s\",\"moduleType\":\"%s\",\"sensors\":",
+                              moduleId, moduleType);
+    if (!next) return appendSensors(buffer, bufferSize, written, registry, nullptr);
+
+    // As many whole entries as fit; the others go in the next part
+    if (written + MORE_BYTES >= bufferSize) {
+        *next = 0;
+        return bufferSize;
+    }
+    written += registry.buildStatusPart(buffer + written, bufferSize - written - MORE_BYTES,
+                                        *next);
+    if (written + MORE_BYTES >= bufferSize) return bufferSize;
+    written += snprintf(buffer + written, bufferSize - written, "%s}",
+                        *next != 0 ? ",\"more\":true" : "");
+    return written;
+}
+
+size_t JsonEncoder::snapshot(char* buffer, size_t bufferSize, const char* requestId,
+                             const char* moduleId, unsigned long time,
+                             const SensorRegistry& registry, const char* hardwareKey) {
+    size_t written = snprintf(buffer, bufferSize,
+                              "{\"id\":\"%s\",\"moduleId\":\"%s\",\"time\":%lu,\"sensors\":",
+                              requestId, moduleId, time);
+    return appendSensors(buffer, bufferSize, written, registry, hardwareKey);
+}
+
+size_t JsonEncoder::log(char* buffer, size_t bufferSize, const char* level,
+                        const char* msg, unsigned long time) {
+    size_t written = snprintf(buffer, bufferSize, "{\"level\":\"%s\",\"msg\":\"", level);
+    written = appendEscaped(buffer, bufferSize, written, msg);
+    size_t end = written < bufferSize ? written : bufferSize;
+    return written + snprintf(buffer + end, bufferSize - end, "\",\"time\":%lu}", time);
+}
+
+size_t JsonEncoder::systemInfo(char* buffer, size_t bufferSize, const SystemInfo& info) {
+    return snprintf(buffer, bufferSize,
+                    "{\"ip\":\"%s\",\"mac\":\"%s\",\"chipId\":\"%s\","
+                    "\"moduleType\":\"%s\",\"memory\":{\"heapTotalKb\":%lu},"
+                    "\"flash\":{\"totalKb\":%lu,\"usedKb\":%lu,\"freeKb\":%lu}}",
+                    info.ip, info.mac, info.chipId, info.moduleType,
+                    (unsigned long)info.heapTotalKb, (unsigned long)info.flashTotalKb,
+                    (unsigned long)info.flashUsedKb, (unsigned long)info.flashFreeKb);
+}
+
+size_t JsonEncoder::chipInfo(char* buffer, size_t bufferSize, const ChipInfo& info) {
+    return snprintf(buffer, bufferSize,
+                    "{\"chip\":{\"model\":\"%s\",\"rev\":%d,\"cpuFreqMhz\":%d,"
+                    "\"flashKb\":%d,\"cores\":%d}}",
+                    info.model, info.rev, info.cpuFreqMhz, info.flashKb, info.cores);
+}
+
+size_t JsonEncoder::burstAck(char* buffer, size_t bufferSize, const char* hardwareKey,
+                             int intervalMs, unsigned long durationMs, const char* status) {
+    // Seconds, as in the burst request
+    return snprintf(buffer, bufferSize,
+                    "{\"hardware\":\"%s\",\"interval\":%d,\"duration\":%lu,"
+                    "\"status\":\"%s\"}",
+                    hardwareKey, intervalMs / 1000, durationMs / 1000, status);
+}
+
+size_t JsonEncoder::ruleEvent(char* buffer, size_t bufferSize, const RuleEvent& event,
+                              unsigned long time) {
+    if (std::isnan(event.value)) {
+        return snprintf(buffer, bufferSize,
+                        "{\"rule\":\"%s\",\"action\":\"%s\",\"active\":%s,"
+                        "\"value\":null,\"time\":%lu}",
+                        event.ruleId, event.action, event.active ? "true" : "false", time);
+    }
+    return snprintf(buffer, bufferSize,
+                    "{\"rule\":\"%s\",\"action\":\"%s\",\"active\":%s,"
+                    "\"value\":%.2f,\"time\":%lu}",
+                    event.ruleId, event.action, event.active ? "true" : "false",
+                    event.value, time);
+}
+
+size_t JsonEncoder::rulesStatus(char* buffer, size_t bufferSize, bool ok, size_t count) {
+    return snprintf(buffer, bufferSize, "{\"ok\":%s,\"count\":%u}", ok ? "true" : "false",
+                    (unsigned)count);
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+size_t JsonEncoder::appendEscaped(char* buffer, size_t bufferSize, size_t offset,
+                                  const char* text) {
+    // Quotes, backslashes and control characters (log messages carry payloads)
+    for (const char* c = text; *c; c++) {
+        char escaped[7];
+        size_t length;
+        if (*c == '"' || *c == '\\') {
+            escaped[0] = '\\';
+            escaped[1] = *c;
+            length = 2;
+        } else if (*c == '\n') {
+            memcpy(escaped, "\\n", 2);
+            length = 2;
+        } else if ((unsigned char)*c < 0x20) {
+            length = snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)*c);
+        } else {
+            escaped[0] = *c;
+            length = 1;
+        }
+        if (offset + length < bufferSize) {
+            memcpy(buffer + offset, escaped, length);
+            buffer[offset + length] = '\0';
+        }
+        offset += length;
+    }
+    return offset;
+}
+
+size_t JsonEncoder::appendSensors(char* buffer, size_t bufferSize, size_t offset,
+                                  const SensorRegistry& registry, const char* hardwareKey) {
+    // Built in place: no second buffer for the sensor map
+    if (offset + 1 >= bufferSize) return offset + 1;
+    size_t written = offset + registry.buildStatusJson(buffer + offset, bufferSize - offset,
+                                                        hardwareKey);
+    if (written + 1 >= bufferSize) return written + 1;
+    buffer[written++] = '}';
+    buffer[written] = '\0';
+    return written;
+}
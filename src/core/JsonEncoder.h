@@ -0,0 +1,117 @@
+/**
+ * @file JsonEncoder.h
+ * @brief Payload formats of the messages published by IotMesurable
+ */
+
+#ifndef JSON_ENCODER_H
+#define JSON_ENCODER_H
+
+#include <Arduino.h>
+#include "RuleEngine.h"
+#include "SensorRegistry.h"
+
+/**
+ * @brief Static facts of the module (system/config)
+ */
+struct SystemInfo {
+    const char* ip;
+    const char* mac;
+    const char* chipId;
+    const char* moduleType;
+    uint32_t heapTotalKb;
+    uint32_t flashTotalKb;
+    uint32_t flashUsedKb;
+    uint32_t flashFreeKb;
+};
+
+/**
+ * @brief Chip description (hardware/config)
+ */
+struct ChipInfo {
+    const char* model;
+    int rev;
+    int cpuFreqMhz;
+    int flashKb;
+    int cores;
+};
+
+/**
+ * @brief Encoder policy of the default configuration: JSON, as expected by
+ * the IoT Grow Brain backend
+ *
+ * An encoder is a class of static functions with these signatures, so
+ * BasicIotMesurable calls it directly. Each function writes a
+ * null-terminated payload and returns its length like snprintf: a result
+ * >= bufferSize means the payload did not fit and is not sent.
+ */
+class JsonEncoder {
+public:
+    /**
+     * @brief Sensor value (moduleId/<hardware>/<sensor>)
+     */
+    static size_t value(char* buffer, size_t bufferSize, float value);
+
+    /**
+     * @brief Sensor status (moduleId/sensors/status)
+     * @param next nullptr for every sensor in one payload, else the sensor
+     *             to start a part from (see SensorRegistry::buildStatusPart);
+     *             parts but the last carry "more":true
+     */
+    static size_t status(char* buffer, size_t bufferSize, const char* moduleId,
+                         const char* moduleType, const SensorRegistry& registry,
+                         size_t* next = nullptr);
+
+    /**
+     * @brief Answer to an on-demand snapshot (moduleId/sensors/get/response)
+     * @param hardwareKey Only this hardware, nullptr for all
+     */
+    static size_t snapshot(char* buffer, size_t bufferSize, const char* requestId,
+                           const char* moduleId, unsigned long time,
+                           const SensorRegistry& registry, const char* hardwareKey);
+
+    /**
+     * @brief Log message (moduleId/logs), msg escaped
+     */
+    static size_t log(char* buffer, size_t bufferSize, const char* level,
+                      const char* msg, unsigned long time);
+
+    /**
+     * @brief Static facts (moduleId/system/config)
+     */
+    static size_t systemInfo(char* buffer, size_t bufferSize, const SystemInfo& info);
+
+    /**
+     * @brief Chip description (moduleId/hardware/config)
+     */
+    static size_t chipInfo(char* buffer, size_t bufferSize, const ChipInfo& info);
+
+    /**
+     * @brief Burst acknowledgement (moduleId/sensors/burst/ack)
+     */
+    static size_t burstAck(char* buffer, size_t bufferSize, const char* hardwareKey,
+                           int intervalMs, unsigned long durationMs, const char* status);
+
+    /**
+     * @brief Local rule transition (moduleId/rules/events)
+     */
+    static size_t ruleEvent(char* buffer, size_t bufferSize, const RuleEvent& event,
+                            unsigned long time);
+
+    /**
+     * @brief Result of a rule set deployment (moduleId/rules/status)
+     */
+    static size_t rulesStatus(char* buffer, size_t bufferSize, bool ok, size_t count);
+
+private:
+    static const size_t MORE_BYTES = sizeof(",\"more\":true}") - 1;
+
+    // JSON string content of text, appended at offset
+    static size_t appendEscaped(char* buffer, size_t bufferSize, size_t offset,
+                                const char* text);
+
+    // Sensor map from the registry, appended at offset
+    static size_t appendSensors(char* buffer, size_t bufferSize, size_t offset,
+                                const SensorRegistry& registry, const char* hardwareKey);
+};
+
+#endif // JSON_ENCODER_H
@@ -0,0 +1,94 @@
+/**
+ * @file Limits.h
+ * @brief Buffer sizes of BasicIotMesurable
+ */
+
+#ifndef IOT_LIMITS_H
+#define IOT_LIMITS_H
+
+#include <stddef.h>
+
+// Default size, and the smaller one of low-RAM builds (-DIOT_LOW_RAM)
+#ifdef IOT_LOW_RAM
+#define IOT_RAM_SIZE(size, lowRamSize) lowRamSize
+#else
+#define IOT_RAM_SIZE(size, lowRamSize) size
+#endif
+
+#ifndef IOT_MODULE_ID_BYTES
+#define IOT_MODULE_ID_BYTES IOT_RAM_SIZE(64, 32)
+#endif
+
+#ifndef IOT_BROKER_BYTES
+#define IOT_BROKER_BYTES IOT_RAM_SIZE(128, 64)
+#endif
+
+#ifndef IOT_TOPIC_BYTES
+#define IOT_TOPIC_BYTES IOT_RAM_SIZE(128, 80)
+#endif
+
+#ifndef IOT_MQTT_CREDENTIAL_BYTES
+#define IOT_MQTT_CREDENTIAL_BYTES IOT_RAM_SIZE(64, 32)   // MQTT username and password
+#endif
+
+#ifndef IOT_STATUS_BYTES
+#define IOT_STATUS_BYTES IOT_RAM_SIZE(1536, 768)  // Status and snapshot, sensors included
+#endif
+
+#ifndef IOT_REPORT_BYTES
+#define IOT_REPORT_BYTES IOT_RAM_SIZE(1024, 512)  // Shadow report
+#endif
+
+#ifndef IOT_INFO_BYTES
+#define IOT_INFO_BYTES IOT_RAM_SIZE(512, 384)     // System and hardware info, metrics
+#endif
+
+#ifndef IOT_EVENT_BYTES
+#define IOT_EVENT_BYTES IOT_RAM_SIZE(160, 128)    // System state, burst acks, rule events
+#endif
+
+#ifndef IOT_LOG_BYTES
+#define IOT_LOG_BYTES IOT_RAM_SIZE(256, 160)
+#endif
+
+#ifndef IOT_CONFIG_DOC_BYTES
+#define IOT_CONFIG_DOC_BYTES IOT_RAM_SIZE(1024, 768)  // Parsed config
+#endif
+
+#ifndef IOT_RULES_DOC_BYTES
+#define IOT_RULES_DOC_BYTES IOT_RAM_SIZE(3072, 1024)  // Parsed rule set of IOT_RULES_MAX rules
+#endif
+
+#ifndef IOT_RULES_BYTES
+#define IOT_RULES_BYTES IOT_RAM_SIZE(2048, 768)  // Rule set saved for the next boot
+#endif
+
+#ifndef IOT_COMMAND_DOC_BYTES
+#define IOT_COMMAND_DOC_BYTES IOT_RAM_SIZE(192, 160)  // Parsed enable, reset, burst and get
+#endif
+
+/**
+ * @brief Buffer sizes of the default configuration
+ *
+ * Every buffer of BasicIotMesurable is sized from its Limits policy at
+ * compile time. A constrained build passes a struct with the same members
+ * (or overrides the IOT_*_BYTES macros for the default one). Payloads that
+ * do not fit are dropped, never truncated.
+ */
+struct DefaultLimits {
+    static const size_t MODULE_ID = IOT_MODULE_ID_BYTES;
+    static const size_t MODULE_TYPE = IOT_MODULE_ID_BYTES;
+    static const size_t BROKER = IOT_BROKER_BYTES;
+    static const size_t TOPIC = IOT_TOPIC_BYTES;
+    static const size_t STATUS = IOT_STATUS_BYTES;
+    static const size_t REPORT = IOT_REPORT_BYTES;
+    static const size_t INFO = IOT_INFO_BYTES;
+    static const size_t EVENT = IOT_EVENT_BYTES;
+    static const size_t LOG = IOT_LOG_BYTES;
+    static const size_t CONFIG_DOC = IOT_CONFIG_DOC_BYTES;
+    static const size_t RULES = IOT_RULES_BYTES;
+    static const size_t RULES_DOC = IOT_RULES_DOC_BYTES;
+    static const size_t COMMAND_DOC = IOT_COMMAND_DOC_BYTES;
+};
+
+#endif // IOT_LIMITS_H
@@ -0,0 +1,316 @@
+/**
+ * @file Logger.cpp
+ * @brief Implementation of Logger
+ */
+
+#include "Logger.h"
+#include <cctype>
+#include <cstring>
+
+// MQTT callbacks log from the network task on ESP32
+#if defined(ESP32) && !defined(NATIVE_BUILD)
+static portMUX_TYPE logLock = portMUX_INITIALIZER_UNLOCKED;
+#define LOG_LOCK() portENTER_CRITICAL(&logLock)
+#define LOG_UNLOCK() portEXIT_CRITICAL(&logLock)
+#else
+#define LOG_LOCK()
+#define LOG_UNLOCK()
+#endif
+
+// Record header: size, level, suppressed calls, time, format
+static const size_t HEADER_BYTES = 2 + 1 + 2 + 4 + sizeof(const char*);
+
+static const uint8_t MQTT = (uint8_t)LogSink::Mqtt;
+
+// Level byte flag: the first argument is the module that wrote the record
+static const uint8_t SOURCED = 0x80;
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() {
+    clear();
+}
+
+void Logger::clear() {
+    LOG_LOCK();
+    _head = 0;
+    _tail = 0;
+    _read[0] = 0;
+    _read[1] = 0;
+    _used = 0;
+    _dropped = 0;
+    _suppressed = 0;
+    LOG_UNLOCK();
+}
+
+// =============================================================================
+// Recording
+// =============================================================================
+
+bool Logger::admit(LogSite& site, unsigned long now, uint16_t& suppressed) {
+    LOG_LOCK();
+    if (site.count == 0 || now - site.windowStart >= IOT_LOG_SITE_WINDOW_MS) {
+        site.windowStart = now;
+        site.count = 0;
+    }
+    bool admitted = site.count < IOT_LOG_SITE_BURST;
+    if (admitted) {
+        site.count++;
+        suppressed = site.suppressed;
+        site.suppressed = 0;
+    } else {
+        if (site.suppressed < 0xFFFF) site.suppressed++;
+        _suppressed++;
+    }
+    LOG_UNLOCK();
+    return admitted;
+}
+
+void Logger::write(LogLevel level, const char* msg, const char* source) {
+    uint8_t encoded[IOT_LOG_RECORD_BYTES];
+    size_t length = 0;
+    if (source) encode(encoded, length, source);
+    encode(encoded, length, msg);
+    append(level, source ? "[%s] %s" : "%s", Clock::now(), 0, encoded, length,
+           source != nullptr);
+}
+
+void Logger::append(LogLevel level, const char* format, unsigned long time,
+                    uint16_t suppressed, const uint8_t* args, size_t argsLength,
+                    bool sourced) {
+    uint16_t size = (uint16_t)(HEADER_BYTES + argsLength);
+    if (size >= sizeof(_buffer)) return;
+
+    uint8_t header[HEADER_BYTES];
+    uint32_t time32 = (uint32_t)time;
+    memcpy(header, &size, 2);
+    header[2] = (uint8_t)level | (sourced ? SOURCED : 0);
+    memcpy(header + 3, &suppressed, 2);
+    memcpy(header + 5, &time32, 4);
+    memcpy(header + 9, &format, sizeof(format));
+
+    LOG_LOCK();
+    // Never completely full: head == tail means empty
+    while (_used + size >= sizeof(_buffer)) {
+        dropOldest();
+    }
+    put(_head, header, HEADER_BYTES);
+    put(advance(_head, HEADER_BYTES), args, argsLength);
+    _head = advance(_head, size);
+    _used += size;
+    LOG_UNLOCK();
+}
+
+void Logger::dropOldest() {
+    uint16_t size;
+    get(_tail, &size, 2);
+    size_t next = advance(_tail, size);
+    // Lost before MQTT delivery
+    if (_read[MQTT] == _tail) _dropped++;
+    for (size_t i = 0; i < 2; i++) {
+        if (_read[i] == _tail) _read[i] = next;
+    }
+    _tail = next;
+    _used -= size;
+}
+
+void Logger::encode(uint8_t* buffer, size_t& length, const char* value) {
+    if (!value) value = "(null)";
+    // Tag, characters, terminator
+    if (length + 2 > IOT_LOG_RECORD_BYTES) return;
+    size_t available = IOT_LOG_RECORD_BYTES - length - 2;
+    size_t textLength = strlen(value);
+    if (textLength > available) textLength = available;
+    buffer[length++] = Text;
+    memcpy(buffer + length, value, textLength);
+    length += textLength;
+    buffer[length++] = '\0';
+}
+
+// =============================================================================
+// Reading
+// =============================================================================
+
+bool Logger::next(LogSink sink, char* msg, size_t msgSize, LogLevel& level,
+                  unsigned long& time, char* source, size_t sourceSize) {
+    uint8_t record[HEADER_BYTES + IOT_LOG_RECORD_BYTES];
+    uint16_t size;
+
+    LOG_LOCK();
+    size_t& read = _read[(uint8_t)sink];
+    if (read == _head) {
+        LOG_UNLOCK();
+        return false;
+    }
+    get(read, &size, 2);
+    get(read, record, size);
+    read = advance(read, size);
+    LOG_UNLOCK();
+
+    uint16_t suppressed;
+    uint32_t time32;
+    const char* format;
+    level = (LogLevel)(record[2] & ~SOURCED);
+    memcpy(&suppressed, record + 3, 2);
+    memcpy(&time32, record + 5, 4);
+    memcpy(&format, record + 9, sizeof(format));
+    time = time32;
+
+    // The source, when asked for, is taken out of the "[%s] %s" format
+    const uint8_t* args = record + HEADER_BYTES;
+    size_t argsLength = size - HEADER_BYTES;
+    if (source && sourceSize > 0) {
+        source[0] = '\0';
+        if (record[2] & SOURCED) {
+            const char* text = (const char*)args + 1;
+            snprintf(source, sourceSize, "%s", text);
+            args += 1 + strlen(text) + 1;
+            argsLength -= 1 + strlen(text) + 1;
+            format = "%s";
+        }
+    }
+
+    size_t length = this->format(msg, msgSize, format, args, argsLength);
+    if (suppressed > 0 && length < msgSize) {
+        snprintf(msg + length, msgSize - length, " (%u suppressed)", (unsigned)suppressed);
+    }
+    return true;
+}
+
+void Logger::printPending() {
+#if IOT_LOG_SERIAL
+    char msg[IOT_LOG_BYTES];
+    LogLevel level;
+    unsigned long time;
+    while (next(LogSink::Console, msg, sizeof(msg), level, time)) {
+        if (level >= LogLevel::Warn) {
+            Serial.printf("[%s] %s\n", levelName(level), msg);
+        } else {
+            Serial.printf("%s\n", msg);
+        }
+    }
+#endif
+}
+
+// Formats one conversion at a time from the encoded arguments
+size_t Logger::format(char* msg, size_t msgSize, const char* format,
+                      const uint8_t* args, size_t argsLength) {
+    size_t written = 0;
+    size_t position = 0;
+    if (msgSize == 0) return 0;
+    msg[0] = '\0';
+
+    while (*format && written + 1 < msgSize) {
+        if (*format != '%' || format[1] == '%') {
+            msg[written++] = *format;
+            format += *format == '%' ? 2 : 1;
+            continue;
+        }
+
+        // Flags, width and precision are kept, length modifiers replaced
+        char spec[24];
+        size_t specLength = 0;
+        spec[specLength++] = *format++;
+        while (*format && strchr("-+ #0123456789.", *format) && specLength < 16) {
+            spec[specLength++] = *format++;
+        }
+        while (*format && strchr("hlLjzt", *format)) format++;
+        char conversion = *format;
+        if (!conversion) break;
+        format++;
+
+        uint8_t tag = position < argsLength ? args[position] : 0;
+        int64_t integer = 0;
+        double real = 0;
+        const char* text = nullptr;
+        if (tag == Signed || tag == Unsigned) {
+            memcpy(&integer, args + position + 1, 8);
+            real = tag == Signed ? (double)integer : (double)(uint64_t)integer;
+            position += 9;
+        } else if (tag == Real) {
+            memcpy(&real, args + position + 1, 8);
+            integer = (int64_t)real;
+            position += 9;
+        } else if (tag == Text) {
+            text = (const char*)args + position + 1;
+            position += 1 + strlen(text) + 1;
+        }
+
+        size_t remaining = msgSize - written;
+        int length = -1;
+        if (tag == 0 || (tag == Text) != (conversion == 's')) {
+            length = snprintf(msg + written, remaining, "?");
+        } else if (strchr("di", conversion)) {
+            memcpy(spec + specLength, "lld", 4);
+            length = snprintf(msg + written, remaining, spec, (long long)integer);
+        } else if (strchr("uxXo", conversion)) {
+            memcpy(spec + specLength, "ll", 2);
+            spec[specLength + 2] = conversion;
+            spec[specLength + 3] = '\0';
+            length = snprintf(msg + written, remaining, spec, (unsigned long long)integer);
+        } else if (conversion == 'c') {
+            memcpy(spec + specLength, "c", 2);
+            length = snprintf(msg + written, remaining, spec, (int)integer);
+        } else if (strchr("fFeEgGaA", conversion)) {
+            spec[specLength] = conversion;
+            spec[specLength + 1] = '\0';
+            length = snprintf(msg + written, remaining, spec, real);
+        } else if (conversion == 's') {
+            memcpy(spec + specLength, "s", 2);
+            length = snprintf(msg + written, remaining, spec, text);
+        } else {
+            length = snprintf(msg + written, remaining, "?");
+        }
+        if (length > 0) {
+            written += (size_t)length < remaining ? (size_t)length : remaining - 1;
+        }
+    }
+    msg[written] = '\0';
+    return written;
+}
+
+// =============================================================================
+// Ring Buffer
+// =============================================================================
+
+void Logger::put(size_t offset, const void* data, size_t length) {
+    size_t first = sizeof(_buffer) - offset;
+    if (first > length) first = length;
+    memcpy(_buffer + offset, data, first);
+    memcpy(_buffer, (const uint8_t*)data + first, length - first);
+}
+
+void Logger::get(size_t offset, void* data, size_t length) const {
+    size_t first = sizeof(_buffer) - offset;
+    if (first > length) first = length;
+    memcpy(data, _buffer + offset, first);
+    memcpy((uint8_t*)data + first, _buffer, length - first);
+}
+
+size_t Logger::advance(size_t offset, size_t length) const {
+    return (offset + length) % sizeof(_buffer);
+}
+
+// =============================================================================
+// Levels
+// =============================================================================
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Warn: return "warn";
+        case LogLevel::Error: return "error";
+        default: return "info";
+    }
+}
+
+LogLevel Logger::parseLevel(const char* name) {
+    if (!name) return LogLevel::Info;
+    if (strcmp(name, "debug") == 0) return LogLevel::Debug;
+    if (strcmp(name, "warn") == 0 || strcmp(name, "warning") == 0) return LogLevel::Warn;
+    if (strcmp(name, "error") == 0) return LogLevel::Error;
+    return LogLevel::Info;
+}
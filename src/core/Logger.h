@@ -0,0 +1,271 @@
+/**
+ * @file Logger.h
+ * @brief Leveled logging into a ring buffer of binary records
+ */
+
+#ifndef IOT_LOGGER_H
+#define IOT_LOGGER_H
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include "Clock.h"
+#include "Limits.h"
+
+#define IOT_LOG_LEVEL_DEBUG 0
+#define IOT_LOG_LEVEL_INFO 1
+#define IOT_LOG_LEVEL_WARN 2
+#define IOT_LOG_LEVEL_ERROR 3
+#define IOT_LOG_LEVEL_NONE 4
+
+#ifndef IOT_LOG_LEVEL
+#define IOT_LOG_LEVEL IOT_LOG_LEVEL_INFO    // Calls below this level are compiled out
+#endif
+
+#ifndef IOT_LOG_BUFFER_BYTES
+#define IOT_LOG_BUFFER_BYTES IOT_RAM_SIZE(1024, 384)
+#endif
+
+#ifndef IOT_LOG_RECORD_BYTES
+#define IOT_LOG_RECORD_BYTES 128    // Encoded arguments of one record
+#endif
+
+#ifndef IOT_LOG_SITE_BURST
+#define IOT_LOG_SITE_BURST 5        // Records per call site and window
+#endif
+
+#ifndef IOT_LOG_SITE_WINDOW_MS
+#define IOT_LOG_SITE_WINDOW_MS 10000
+#endif
+
+#ifndef IOT_LOG_DELIVERY_BATCH
+#define IOT_LOG_DELIVERY_BATCH 8    // Records sent to moduleId/logs per loop
+#endif
+
+#ifndef IOT_LOG_SERIAL
+#define IOT_LOG_SERIAL 1            // Echo records on Serial
+#endif
+
+/**
+ * @brief Log levels
+ */
+enum class LogLevel : uint8_t {
+    Debug = IOT_LOG_LEVEL_DEBUG,
+    Info = IOT_LOG_LEVEL_INFO,
+    Warn = IOT_LOG_LEVEL_WARN,
+    Error = IOT_LOG_LEVEL_ERROR
+};
+
+/**
+ * @brief Static state of one logging call site
+ */
+struct LogSite {
+    const char* format;         // printf format, must be a string literal
+    LogLevel level;
+    uint8_t count;              // Records in the current window
+    uint16_t suppressed;        // Calls dropped by the rate limit since the last record
+    unsigned long windowStart;
+};
+
+/**
+ * @brief Readers of the log buffer, each with its own position
+ */
+enum class LogSink : uint8_t {
+    Console = 0,
+    Mqtt = 1
+};
+
+/**
+ * @brief Process-wide log buffer
+ *
+ * A call records the site, the time and its raw arguments (strings copied)
+ * as a binary record; nothing is formatted until a sink reads it. Serial
+ * reads records as the modules loop, MQTT while a module is connected, so
+ * records made offline are delivered on reconnect. When the buffer is
+ * full the oldest records are dropped.
+ *
+ * Each call site passes at most IOT_LOG_SITE_BURST records per
+ * IOT_LOG_SITE_WINDOW_MS; the next record of the site carries the count
+ * of the calls dropped in between.
+ */
+class Logger {
+public:
+    static Logger& instance();
+
+    /**
+     * @brief Record a call of a site (through the IOT_LOG_* macros)
+     */
+    template <class... Args>
+    void record(LogSite& site, Args... args) {
+        unsigned long now = Clock::now();
+        uint16_t suppressed;
+        if (!admit(site, now, suppressed)) return;
+        uint8_t encoded[IOT_LOG_RECORD_BYTES];
+        size_t length = 0;
+        encodeAll(encoded, length, args...);
+        append(site.level, site.format, now, suppressed, encoded, length);
+    }
+
+    /**
+     * @brief Record a message without rate limit (IotMesurable::log)
+     * @param source Module that logged it, nullptr for none
+     */
+    void write(LogLevel level, const char* msg, const char* source = nullptr);
+
+    /**
+     * @brief Format the next record not yet read by a sink
+     * @param sink Reader
+     * @param msg Formatted message (truncated to msgSize)
+     * @param level Level of the record
+     * @param time millis() of the call
+     * @param source Set to the module that wrote the record ("" for none);
+     *               nullptr to prefix msg with "[source] " instead
+     * @return false if the sink has read everything
+     */
+    bool next(LogSink sink, char* msg, size_t msgSize, LogLevel& level, unsigned long& time,
+              char* source = nullptr, size_t sourceSize = 0);
+
+    /**
+     * @brief Print the records not yet printed on Serial
+     */
+    void printPending();
+
+    /**
+     * @brief Check if a sink has records to read
+     */
+    bool hasPending(LogSink sink) const { return _read[(uint8_t)sink] != _head; }
+
+    /**
+     * @brief Records dropped because the buffer was full
+     */
+    unsigned long dropped() const { return _dropped; }
+
+    /**
+     * @brief Calls dropped by the per-site rate limit
+     */
+    unsigned long suppressed() const { return _suppressed; }
+
+    /**
+     * @brief Drop every record and reset the counters
+     */
+    void clear();
+
+    /**
+     * @brief Name of a level ("debug", "info", "warn", "error")
+     */
+    static const char* levelName(LogLevel level);
+
+    /**
+     * @brief Parse a level name (unknown names are info)
+     */
+    static LogLevel parseLevel(const char* name);
+
+private:
+    Logger();
+
+    uint8_t _buffer[IOT_LOG_BUFFER_BYTES];
+    size_t _head;               // Next write position
+    size_t _tail;               // Oldest record
+    size_t _read[2];            // Next record of each sink
+    size_t _used;
+    unsigned long _dropped;
+    unsigned long _suppressed;
+
+    bool admit(LogSite& site, unsigned long now, uint16_t& suppressed);
+    void append(LogLevel level, const char* format, unsigned long time,
+                uint16_t suppressed, const uint8_t* args, size_t argsLength,
+                bool sourced = false);
+    void dropOldest();
+    void put(size_t offset, const void* data, size_t length);
+    void get(size_t offset, void* data, size_t length) const;
+    size_t advance(size_t offset, size_t length) const;
+
+    // Argument encoding: a tag, then the value
+    enum Tag : uint8_t { Signed = 'i', Unsigned = 'u', Real = 'f', Text = 's' };
+
+    static void encodeAll(uint8_t*, size_t&) {}
+
+    template <class T, class... Rest>
+    static void encodeAll(uint8_t* buffer, size_t& length, T value, Rest... rest) {
+        encode(buffer, length, value);
+        encodeAll(buffer, length, rest...);
+    }
+
+    template <class T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    encode(uint8_t* buffer, size_t& length, T value) {
+        encodeValue(buffer, length, Signed, (int64_t)value);
+    }
+
+    template <class T>
+    static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+    encode(uint8_t* buffer, size_t& length, T value) {
+        encodeValue(buffer, length, Unsigned, (uint64_t)value);
+    }
+
+    template <class T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    encode(uint8_t* buffer, size_t& length, T value) {
+        encodeValue(buffer, length, Real, (double)value);
+    }
+
+    static void encode(uint8_t* buffer, size_t& length, const char* value);
+
+    template <class T>
+    static void encodeValue(uint8_t* buffer, size_t& length, Tag tag, T value) {
+        if (length + 1 + sizeof(value) > IOT_LOG_RECORD_BYTES) return;
+        buffer[length++] = tag;
+        memcpy(buffer + length, &value, sizeof(value));
+        length += sizeof(value);
+    }
+
+    static size_t format(char* msg, size_t msgSize, const char* format,
+                         const uint8_t* args, size_t argsLength);
+};
+
+// =============================================================================
+// Call Sites
+// =============================================================================
+
+/**
+ * @brief Record a printf-style message at a level
+ *
+ * The format is checked by the compiler but only formatted when a sink
+ * reads the record. Calls below IOT_LOG_LEVEL expand to nothing, their
+ * arguments are not evaluated.
+ */
+#define IOT_LOG_AT(logLevel, format, ...)                                     \
+    do {                                                                      \
+        static LogSite iotLogSite = {format, logLevel, 0, 0, 0};             \
+        if (false) snprintf(nullptr, 0, format, ##__VA_ARGS__);               \
+        Logger::instance().record(iotLogSite, ##__VA_ARGS__);                 \
+    } while (0)
+
+#define IOT_LOG_DISABLED(...) do {} while (0)
+
+#if IOT_LOG_LEVEL <= IOT_LOG_LEVEL_DEBUG
+#define IOT_LOG_DEBUG(...) IOT_LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#else
+#define IOT_LOG_DEBUG(...) IOT_LOG_DISABLED()
+#endif
+
+#if IOT_LOG_LEVEL <= IOT_LOG_LEVEL_INFO
+#define IOT_LOG_INFO(...) IOT_LOG_AT(LogLevel::Info, __VA_ARGS__)
+#else
+#define IOT_LOG_INFO(...) IOT_LOG_DISABLED()
+#endif
+
+#if IOT_LOG_LEVEL <= IOT_LOG_LEVEL_WARN
+#define IOT_LOG_WARN(...) IOT_LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#else
+#define IOT_LOG_WARN(...) IOT_LOG_DISABLED()
+#endif
+
+#if IOT_LOG_LEVEL <= IOT_LOG_LEVEL_ERROR
+#define IOT_LOG_ERROR(...) IOT_LOG_AT(LogLevel::Error, __VA_ARGS__)
+#else
+#define IOT_LOG_ERROR(...) IOT_LOG_DISABLED()
+#endif
+
+#endif // IOT_LOGGER_H
@@ -0,0 +1,62 @@
+/**
+ * @file Metrics.cpp
+ * @brief Implementation of Metrics
+ */
+
+#include "Metrics.h"
+#include <cstring>
+#include <cstdio>
+
+Metrics::Metrics() : _count(0) {
+    memset(_entries, 0, sizeof(_entries));
+}
+
+void Metrics::set(const char* name, long value) {
+    MetricEntry* entry = find(name, true);
+    if (entry) entry->value = value;
+}
+
+void Metrics::add(const char* name, long delta) {
+    MetricEntry* entry = find(name, true);
+    if (entry) entry->value += delta;
+}
+
+void Metrics::keepMax(const char* name, long value) {
+    MetricEntry* entry = find(name, true);
+    if (entry && value > entry->value) entry->value = value;
+}
+
+long Metrics::get(const char* name) const {
+    for (size_t i = 0; i < _count; i++) {
+        if (strcmp(_entries[i].name, name) == 0) return _entries[i].value;
+    }
+    return 0;
+}
+
+size_t Metrics::buildJson(char* buffer, size_t bufferSize) const {
+    size_t written = 0;
+    written += snprintf(buffer + written, bufferSize - written, "{");
+    
+    for (size_t i = 0; i < _count && written < bufferSize; i++) {
+        written += snprintf(buffer + written, bufferSize - written, "%s\"%s\":%ld",
+                            i > 0 ? "," : "", _entries[i].name, _entries[i].value);
+    }
+    
+    if (written < bufferSize) {
+        written += snprintf(buffer + written, bufferSize - written, "}");
+    }
+    return written;
+}
+
+MetricEntry* Metrics::find(const char* name, bool create) {
+    if (!name) return nullptr;
+    for (size_t i = 0; i < _count; i++) {
+        if (strcmp(_entries[i].name, name) == 0) return &_entries[i];
+    }
+    if (!create || _count >= IOT_METRICS_MAX) return nullptr;
+    
+    MetricEntry* entry = &_entries[_count++];
+    entry->name = name;
+    entry->value = 0;
+    return entry;
+}
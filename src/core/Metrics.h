@@ -0,0 +1,73 @@
+/**
+ * @file Metrics.h
+ * @brief Fixed-size table of named library counters and gauges
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+#ifndef IOT_METRICS_MAX
+#define IOT_METRICS_MAX 32
+#endif
+
+/**
+ * @brief Named metric value
+ */
+struct MetricEntry {
+    const char* name;   // Must point to a string literal
+    long value;
+};
+
+/**
+ * @brief Library metrics, published as a flat JSON object
+ *
+ * Entries are created on first use and never removed. When the table is
+ * full, new names are ignored.
+ */
+class Metrics {
+public:
+    Metrics();
+
+    /**
+     * @brief Set a gauge value
+     */
+    void set(const char* name, long value);
+
+    /**
+     * @brief Increment a counter
+     */
+    void add(const char* name, long delta = 1);
+
+    /**
+     * @brief Keep the maximum of the current and given value
+     */
+    void keepMax(const char* name, long value);
+
+    /**
+     * @brief Get a metric value (0 if unknown)
+     */
+    long get(const char* name) const;
+
+    /**
+     * @brief Number of metrics in the table
+     */
+    size_t count() const { return _count; }
+
+    /**
+     * @brief Build JSON object of all metrics
+     * @param buffer Output buffer
+     * @param bufferSize Buffer size
+     * @return Number of bytes written
+     */
+    size_t buildJson(char* buffer, size_t bufferSize) const;
+
+private:
+    MetricEntry _entries[IOT_METRICS_MAX];
+    size_t _count;
+
+    MetricEntry* find(const char* name, bool create);
+};
+
+#endif // METRICS_H
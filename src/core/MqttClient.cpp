@@ -4,18 +4,25 @@
  */
 
 #include "MqttClient.h"
+#include "Clock.h"
 #include <cstring>
 
-MqttClient::MqttClient() : _port(1883), _connected(false), _lastReconnectAttempt(0) {
+const char* MqttClient::PRESENCE_ONLINE = "online";
+const char* MqttClient::PRESENCE_OFFLINE = "offline";
+
+MqttClient::MqttClient() : _transport(nullptr), _port(1883), _lastReconnectAttempt(0) {
     memset(_host, 0, sizeof(_host));
     memset(_clientId, 0, sizeof(_clientId));
     memset(_username, 0, sizeof(_username));
     memset(_password, 0, sizeof(_password));
-#ifndef NATIVE_BUILD
-    setupCallbacks();
-#endif
-    memset(_username, 0, sizeof(_username));
-    memset(_password, 0, sizeof(_password));
+    memset(_presenceTopic, 0, sizeof(_presenceTopic));
+    setTransport(nullptr);
+    _batch.setWriter([this](const uint8_t* data, size_t length, size_t& writes) {
+        writes = 0;
+        size_t written = _transport ? _transport->writePackets(data, length, writes) : 0;
+        if (written < length) forgetRetained(data, length, written);
+        return written;
+    });
 }
 
 MqttClient::~MqttClient() {
@@ -26,19 +33,11 @@ void MqttClient::setBroker(const char* host, uint16_t port) {
     strncpy(_host, host, sizeof(_host) - 1);
     _host[sizeof(_host) - 1] = '\0';
     _port = port;
-    
-#ifndef NATIVE_BUILD
-    _client.setServer(_host, _port);
-#endif
 }
 
 void MqttClient::setClientId(const char* clientId) {
     strncpy(_clientId, clientId, sizeof(_clientId) - 1);
     _clientId[sizeof(_clientId) - 1] = '\0';
-    
-#ifndef NATIVE_BUILD
-    _client.setClientId(_clientId);
-#endif
 }
 
 void MqttClient::setCredentials(const char* username, const char* password) {
@@ -50,56 +49,127 @@ void MqttClient::setCredentials(const char* username, const char* password) {
         strncpy(_password, password, sizeof(_password) - 1);
         _password[sizeof(_password) - 1] = '\0';
     }
+}
 
+void MqttClient::setTransport(MqttTransport* transport) {
 #ifndef NATIVE_BUILD
-    _client.setCredentials(_username, _password);
+    if (!transport) transport = &_defaultTransport;
 #endif
+    _transport = transport;
+    bindTransport();
+
+    // Batch only where a batch is one write
+    bool batches = _transport && _transport->writesBatches();
+    setBatching(batches ? IOT_MQTT_BATCH_BYTES : 0, IOT_MQTT_BATCH_DELAY_MS);
+}
+
+void MqttClient::predefineTopic(const char* topic, uint16_t topicId) {
+    if (_transport) _transport->predefineTopic(topic, topicId);
+}
+
+void MqttClient::sleep(unsigned long durationMs) {
+    flush();
+    if (_transport) _transport->sleep(durationMs);
+}
+
+void MqttClient::wake() {
+    if (_transport) _transport->wake();
+}
+
+void MqttClient::setPresenceTopic(const char* topic) {
+    if (!topic) return;
+    strncpy(_presenceTopic, topic, sizeof(_presenceTopic) - 1);
+    _presenceTopic[sizeof(_presenceTopic) - 1] = '\0';
 }
 
 bool MqttClient::connect() {
-    if (strlen(_host) == 0) return false;
-    
+    if (strlen(_host) == 0 || !_transport) return false;
+
     // Update reconnect timer to prevent immediate loop() retry
-    _lastReconnectAttempt = millis();
-    
-#ifndef NATIVE_BUILD
-    if (!_client.connected()) {
-        Serial.printf("[MQTT] Connecting to %s:%d...\n", _host, _port);
-        _client.connect();
-    }
-#endif
-    return true;
+    _lastReconnectAttempt = Clock::now();
+
+    if (_transport->connected()) return true;
+
+    MqttSessionConfig config;
+    config.host = _host;
+    config.port = _port;
+    config.clientId = _clientId;
+    config.username = _username;
+    config.password = _password;
+    // The will marks the client offline when the connection drops without
+    // a DISCONNECT
+    config.willTopic = _presenceTopic[0] != '\0' ? _presenceTopic : nullptr;
+    config.willPayload = PRESENCE_OFFLINE;
+    return _transport->connect(config);
 }
 
 void MqttClient::disconnect() {
-#ifndef NATIVE_BUILD
-    _client.disconnect();
-#endif
-    _connected = false;
+    flush();
+    // A clean disconnect does not trigger the will
+    publishPresence(PRESENCE_OFFLINE);
+    if (_transport) _transport->disconnect();
 }
 
 bool MqttClient::isConnected() const {
-#ifndef NATIVE_BUILD
-    return _client.connected();
-#else
-    return _connected;
-#endif
+    return _transport && _transport->connected();
 }
 
 void MqttClient::subscribe(const char* topic) {
-#ifndef NATIVE_BUILD
-    if (_client.connected()) {
-        _client.subscribe(topic, 0);
+    if (isConnected()) {
+        _transport->subscribe(topic);
     }
-#endif
 }
 
 void MqttClient::publish(const char* topic, const char* payload, bool retain) {
-#ifndef NATIVE_BUILD
-    if (_client.connected()) {
-        _client.publish(topic, 0, retain, payload);
+    if (!isConnected()) return;
+    // The broker already holds this exact payload: skip the rewrite
+    if (retain && !_retained.shouldSend(topic, payload)) return;
+    if (_batch.add(topic, payload, retain, Clock::now())) return;
+
+    // Too large to batch: keep the order of what is already staged
+    flush();
+    bool sent = _transport->publish(topic, (const uint8_t*)payload, strlen(payload),
+                                    MqttQos::AtMostOnce, retain);
+    // Not on the broker: the next publish of the same payload must go out
+    if (!sent && retain) _retained.invalidate(topic);
+}
+
+void MqttClient::flush() {
+    _batch.flush();
+}
+
+void MqttClient::setBatching(size_t maxBytes, unsigned long maxDelayMs) {
+    _batch.setLimits(maxBytes, maxDelayMs);
+}
+
+void MqttClient::refreshRetained(const char* topic) {
+    if (topic) {
+        _retained.invalidate(topic);
+    } else {
+        _retained.clear();
     }
-#endif
+}
+
+void MqttClient::forgetRetained(const uint8_t* data, size_t length, size_t written) {
+    // Every packet not entirely written was dropped, a partial one included
+    char topic[IOT_TOPIC_BYTES];
+    const uint8_t* payload;
+    size_t payloadLength;
+    bool retain;
+    size_t offset = 0;
+    while (offset < length) {
+        if (!PacketBatcher::decode(data, length, offset, topic, sizeof(topic), payload,
+                                   payloadLength, retain)) {
+            break;
+        }
+        if (offset > written && retain) _retained.invalidate(topic);
+    }
+}
+
+void MqttClient::publishPresence(const char* state) {
+    if (_presenceTopic[0] == '\0' || !isConnected()) return;
+    _transport->publish(_presenceTopic, (const uint8_t*)state, strlen(state),
+                        MqttQos::AtLeastOnce, true);
 }
 
 void MqttClient::onMessage(MqttMessageCallback callback) {
@@ -111,51 +181,42 @@ void MqttClient::onConnect(MqttConnectCallback callback) {
 }
 
 void MqttClient::loop() {
-#ifndef NATIVE_BUILD
+    if (!_transport) return;
+    _transport->loop();
+
+    // Publishes made outside the loop tick still go out within the max delay
+    _batch.poll(Clock::now());
+
     // Auto-reconnect logic
-    if (!_client.connected()) {
-        unsigned long now = millis();
+    if (!_transport->connected()) {
+        unsigned long now = Clock::now();
         if (now - _lastReconnectAttempt > RECONNECT_INTERVAL) {
             _lastReconnectAttempt = now;
             connect();
         }
     }
-#endif
 }
 
-#ifndef NATIVE_BUILD
-void MqttClient::setupCallbacks() {
-    _client.onConnect([this](bool sessionPresent) {
-        _connected = true;
-        if (_onConnect) {
-            _onConnect(true);
+void MqttClient::bindTransport() {
+    if (!_transport) return;
+
+    _transport->onConnect([this](bool connected) {
+        if (connected) {
+            // Retained messages may have been cleared or changed while offline
+            _retained.clear();
+            // Overwrites the retained "offline" left by the will
+            publishPresence(PRESENCE_ONLINE);
+        } else {
+            _batch.clear();
         }
-    });
-    
-    _client.onDisconnect([this](AsyncMqttClientDisconnectReason reason) {
-        _connected = false;
-        Serial.printf("[MQTT] Disconnected (reason: %d)\n", (int)reason);
         if (_onConnect) {
-            _onConnect(false);
+            _onConnect(connected);
         }
     });
-    
-    _client.onMessage([this](char* topic, char* payload, 
-                              AsyncMqttClientMessageProperties properties,
-                              size_t len, size_t index, size_t total) {
-        if (_onMessage && payload) {
-            // Create null-terminated copy
-            char buffer[512];
-            size_t copyLen = len < sizeof(buffer) - 1 ? len : sizeof(buffer) - 1;
-            memcpy(buffer, payload, copyLen);
-            buffer[copyLen] = '\0';
-            
-            _onMessage(topic, buffer);
+
+    _transport->onMessage([this](const char* topic, const char* payload) {
+        if (_onMessage) {
+            _onMessage(topic, payload);
         }
     });
 }
-#else
-void MqttClient::setupCallbacks() {
-    // Native build - no-op
-}
-#endif
@@ -7,17 +7,27 @@
 #define MQTT_CLIENT_H
 
 #include <Arduino.h>
-#include <functional>
+#include "Callback.h"
+#include "Limits.h"
+#include "MqttTransport.h"
+#include "PacketBatcher.h"
+#include "RetainedCache.h"
 
-#ifndef NATIVE_BUILD
-#include <AsyncMqttClient.h>
+#if defined(IOT_POSIX)
+#include "../posix/PosixMqttTransport.h"
+#elif !defined(NATIVE_BUILD)
+#include "AsyncMqttTransport.h"
 #endif
 
-using MqttMessageCallback = std::function<void(const char* topic, const char* payload)>;
-using MqttConnectCallback = std::function<void(bool connected)>;
+using MqttMessageCallback = Callback<void(const char* topic, const char* payload)>;
+using MqttConnectCallback = Callback<void(bool connected)>;
 
 /**
  * @brief MQTT client wrapper with auto-reconnect
+ *
+ * The network session is delegated to a MqttTransport: AsyncMqttClient over
+ * TCP by default on the device, an epoll socket client on Linux (IOT_POSIX),
+ * none on native builds unless one is set.
  */
 class MqttClient {
 public:
@@ -39,6 +49,45 @@ public:
      */
     void setCredentials(const char* username, const char* password);
     
+    /**
+     * @brief Use another transport (e.g., MQTT-SN over UDP)
+     *
+     * The transport is not owned and must outlive the client. Set it before
+     * connect(). Batching is reset to the transport's default: on for
+     * transports that write a batch at once (MqttTransport::writesBatches()),
+     * off otherwise.
+     *
+     * @param transport Transport to use (nullptr for the default one)
+     */
+    void setTransport(MqttTransport* transport);
+    
+    /**
+     * @brief Map a topic to a predefined topic ID (transports that support it)
+     */
+    void predefineTopic(const char* topic, uint16_t topicId);
+    
+    /**
+     * @brief Let the session sleep between radio windows (transports that support it)
+     */
+    void sleep(unsigned long durationMs);
+    
+    /**
+     * @brief Wake the session and fetch messages held while sleeping
+     */
+    void wake();
+    
+    /**
+     * @brief Set the presence topic
+     *
+     * Registered as the last will ("offline", retained), so the broker marks
+     * the client offline when the connection drops without a DISCONNECT.
+     * "online" is published retained on every connect and "offline" before
+     * a clean disconnect. Must be set before connect().
+     *
+     * @param topic Presence topic (e.g., "module/presence")
+     */
+    void setPresenceTopic(const char* topic);
+    
     /**
      * @brief Connect to broker
      * @return true if connection initiated
@@ -62,12 +111,55 @@ public:
     
     /**
      * @brief Publish a message
+     *
+     * A retained payload identical to the last one sent on the topic during
+     * this connection is not sent again (see refreshRetained()). One the
+     * transport refused or dropped does not count as sent.
+     *
      * @param topic MQTT topic
      * @param payload Message payload
      * @param retain Whether to retain message
      */
     void publish(const char* topic, const char* payload, bool retain = false);
     
+    /**
+     * @brief Send publishes staged during this loop tick
+     */
+    void flush();
+    
+    /**
+     * @brief Set publish coalescing bounds
+     * @param maxBytes Batch size cap (0 sends every publish on its own)
+     * @param maxDelayMs Longest time a publish is held back
+     */
+    void setBatching(size_t maxBytes, unsigned long maxDelayMs);
+    
+    /**
+     * @brief Number of transport writes made for batches
+     */
+    unsigned long batchWrites() const { return _batch.writes(); }
+    
+    /**
+     * @brief Number of publishes sent through batches
+     */
+    unsigned long batchPackets() const { return _batch.packets(); }
+    
+    /**
+     * @brief Number of batched publishes the transport did not accept
+     */
+    unsigned long batchDropped() const { return _batch.dropped(); }
+    
+    /**
+     * @brief Let the next retained publish on a topic go out even if unchanged
+     * @param topic MQTT topic (nullptr for all topics)
+     */
+    void refreshRetained(const char* topic = nullptr);
+    
+    /**
+     * @brief Payload bytes of retained publishes suppressed as duplicates
+     */
+    unsigned long retainedSuppressedBytes() const { return _retained.suppressedBytes(); }
+    
     /**
      * @brief Set message callback
      */
@@ -84,23 +176,32 @@ public:
     void loop();
 
 private:
-#ifndef NATIVE_BUILD
-    AsyncMqttClient _client;
+#if defined(IOT_POSIX)
+    PosixMqttTransport _defaultTransport;
+#elif !defined(NATIVE_BUILD)
+    AsyncMqttTransport _defaultTransport;
 #endif
-    char _host[128];
-    char _clientId[64];
-    char _username[64];
-    char _password[64];
+    MqttTransport* _transport;
+    char _host[IOT_BROKER_BYTES];
+    char _clientId[IOT_MODULE_ID_BYTES];
+    char _username[IOT_MQTT_CREDENTIAL_BYTES];
+    char _password[IOT_MQTT_CREDENTIAL_BYTES];
+    char _presenceTopic[IOT_TOPIC_BYTES];
     uint16_t _port;
-    bool _connected;
     unsigned long _lastReconnectAttempt;
+    RetainedCache _retained;
+    PacketBatcher _batch;
     
     MqttMessageCallback _onMessage;
     MqttConnectCallback _onConnect;
     
     static const unsigned long RECONNECT_INTERVAL = 5000;
+    static const char* PRESENCE_ONLINE;
+    static const char* PRESENCE_OFFLINE;
     
-    void setupCallbacks();
+    void bindTransport();
+    void publishPresence(const char* state);
+    void forgetRetained(const uint8_t* data, size_t length, size_t written);
 };
 
 #endif // MQTT_CLIENT_H
@@ -0,0 +1,239 @@
+/**
+ * @file MqttHub.cpp
+ * @brief Implementation of MqttHub
+ */
+
+#include "MqttHub.h"
+#include "Logger.h"
+#include <cstring>
+
+MqttHub::MqttHub(const char* clientId)
+    : _ticked(0), _radioNeeded(0), _connectRequested(false) {
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        _modules[i].id = nullptr;
+        _modules[i].idLength = 0;
+    }
+    memset(_routes, 0, sizeof(_routes));
+
+    _client.setClientId(clientId);
+    char presenceTopic[128];
+    snprintf(presenceTopic, sizeof(presenceTopic), "%s/presence", clientId);
+    _client.setPresenceTopic(presenceTopic);
+    snprintf(_logTopic, sizeof(_logTopic), "%s/logs", clientId);
+
+    _client.onConnect([this](bool connected) {
+        for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+            Module& module = _modules[i];
+            if (!module.id) continue;
+            if (connected) publishPresence(module, "online");
+            if (module.onConnect) module.onConnect(connected);
+        }
+    });
+    _client.onMessage([this](const char* topic, const char* payload) {
+        route(topic, payload);
+    });
+}
+
+bool MqttHub::attach(const char* moduleId, MqttConnectCallback onConnect,
+                     MqttMessageCallback onMessage) {
+    int index = findModule(moduleId);
+    if (index < 0) {
+        for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+            if (!_modules[i].id) {
+                index = (int)i;
+                break;
+            }
+        }
+        if (index < 0) return false;
+        Module& module = _modules[index];
+        module.id = moduleId;
+        module.idLength = strlen(moduleId);
+        memset(&module.stats, 0, sizeof(module.stats));
+        // Modules start inside a window
+        _radioNeeded |= (uint8_t)(1u << index);
+    }
+
+    Module& module = _modules[index];
+    module.onConnect = onConnect;
+    module.onMessage = onMessage;
+
+    // Late module: the session is already up
+    if (_client.isConnected()) {
+        publishPresence(module, "online");
+        if (module.onConnect) module.onConnect(true);
+    }
+    return true;
+}
+
+void MqttHub::detach(const char* moduleId) {
+    int index = findModule(moduleId);
+    if (index < 0) return;
+
+    publishPresence(_modules[index], "offline");
+    _modules[index].id = nullptr;
+    _modules[index].onConnect = nullptr;
+    _modules[index].onMessage = nullptr;
+    _ticked &= (uint8_t)~(1u << index);
+    _radioNeeded &= (uint8_t)~(1u << index);
+    for (size_t i = 0; i < IOT_MQTT_HUB_ROUTES; i++) {
+        _routes[i].modules &= (uint8_t)~(1u << index);
+    }
+}
+
+bool MqttHub::connect() {
+    if (_connectRequested) return true;
+    _connectRequested = _client.connect();
+    return _connectRequested;
+}
+
+void MqttHub::disconnect() {
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        if (_modules[i].id) publishPresence(_modules[i], "offline");
+    }
+    _client.disconnect();
+    _connectRequested = false;
+}
+
+void MqttHub::subscribe(const char* moduleId, const char* topic) {
+    int index = findModule(moduleId);
+    if (index < 0) return;
+
+    // Topics under the module prefix are routed without a table entry
+    if (moduleForTopic(topic) != index) {
+        Route* route = nullptr;
+        Route* free = nullptr;
+        for (size_t i = 0; i < IOT_MQTT_HUB_ROUTES; i++) {
+            if (_routes[i].modules != 0 && strcmp(_routes[i].filter, topic) == 0) {
+                route = &_routes[i];
+                break;
+            }
+            if (_routes[i].modules == 0 && !free) free = &_routes[i];
+        }
+        // A cut filter would route other topics: leave it out
+        if (!route && free && strlen(topic) < sizeof(free->filter)) {
+            route = free;
+            strcpy(route->filter, topic);
+        }
+        if (route) {
+            route->modules |= (uint8_t)(1u << index);
+        } else {
+            IOT_LOG_WARN("[MqttHub] Route table full, %s not routed", topic);
+        }
+    }
+    _client.subscribe(topic);
+}
+
+void MqttHub::publish(const char* topic, const char* payload, bool retain) {
+    int index = moduleForTopic(topic);
+    if (index >= 0 && _client.isConnected()) {
+        _modules[index].stats.published++;
+        _modules[index].stats.publishedBytes += strlen(payload);
+    }
+    _client.publish(topic, payload, retain);
+}
+
+void MqttHub::beginTick(const char* moduleId) {
+    int index = findModule(moduleId);
+    if (index < 0) return;
+
+    // A module looping again starts a new round, even if another one skipped
+    // the last: send what that round left
+    uint8_t bit = (uint8_t)(1u << index);
+    if (_ticked & bit) {
+        _client.flush();
+        _ticked = 0;
+    }
+    if (_ticked == 0) _client.loop();
+    _ticked |= bit;
+}
+
+void MqttHub::endTick(const char* moduleId) {
+    if (findModule(moduleId) < 0) return;
+
+    // Everything the modules published in this round leaves in one write
+    uint8_t attached = attachedModules();
+    if ((_ticked & attached) == attached) _client.flush();
+}
+
+bool MqttHub::setRadioNeeded(const char* moduleId, bool needed) {
+    int index = findModule(moduleId);
+    if (index < 0) return true;
+
+    bool wasNeeded = _radioNeeded != 0;
+    if (needed) {
+        _radioNeeded |= (uint8_t)(1u << index);
+    } else {
+        _radioNeeded &= (uint8_t)~(1u << index);
+    }
+    return (_radioNeeded != 0) != wasNeeded;
+}
+
+size_t MqttHub::modules() const {
+    size_t count = 0;
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        if (_modules[i].id) count++;
+    }
+    return count;
+}
+
+const MqttHubStats* MqttHub::stats(const char* moduleId) const {
+    int index = findModule(moduleId);
+    return index < 0 ? nullptr : &_modules[index].stats;
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+void MqttHub::route(const char* topic, const char* payload) {
+    uint8_t targets = 0;
+    int owner = moduleForTopic(topic);
+    if (owner >= 0) targets |= (uint8_t)(1u << owner);
+
+    for (size_t i = 0; i < IOT_MQTT_HUB_ROUTES; i++) {
+        if (_routes[i].modules != 0 && MqttTransport::matches(_routes[i].filter, topic)) {
+            targets |= _routes[i].modules;
+        }
+    }
+
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        Module& module = _modules[i];
+        if (!(targets & (1u << i)) || !module.id) continue;
+        module.stats.received++;
+        if (module.onMessage) module.onMessage(topic, payload);
+    }
+}
+
+void MqttHub::publishPresence(const Module& module, const char* state) {
+    char topic[128];
+    snprintf(topic, sizeof(topic), "%s/presence", module.id);
+    _client.publish(topic, state, true);
+    // Not held back by batching, like the session's own presence
+    _client.flush();
+}
+
+int MqttHub::findModule(const char* moduleId) const {
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        if (_modules[i].id && strcmp(_modules[i].id, moduleId) == 0) return (int)i;
+    }
+    return -1;
+}
+
+int MqttHub::moduleForTopic(const char* topic) const {
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        const Module& module = _modules[i];
+        if (module.id && strncmp(topic, module.id, module.idLength) == 0 &&
+            topic[module.idLength] == '/') {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+uint8_t MqttHub::attachedModules() const {
+    uint8_t attached = 0;
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        if (_modules[i].id) attached |= (uint8_t)(1u << i);
+    }
+    return attached;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file MqttHub.h
+ * @brief One MQTT session shared by several modules on the same device
+ */
+
+#ifndef MQTT_HUB_H
+#define MQTT_HUB_H
+
+#include <Arduino.h>
+#include "MqttClient.h"
+
+#ifndef IOT_MQTT_HUB_MODULES
+#define IOT_MQTT_HUB_MODULES 4
+#endif
+
+#ifndef IOT_MQTT_HUB_ROUTES
+#define IOT_MQTT_HUB_ROUTES 16
+#endif
+
+static_assert(IOT_MQTT_HUB_MODULES <= 8, "Routes keep module sets in a uint8_t");
+
+/**
+ * @brief Per-module traffic on a shared session
+ */
+struct MqttHubStats {
+    unsigned long published;
+    unsigned long publishedBytes;
+    unsigned long received;
+};
+
+/**
+ * @brief Shared MQTT session for several IotMesurable modules
+ *
+ * Modules on one device (e.g. a climate and an irrigation controller)
+ * use a single MqttClient: one TCP session and, where the transport
+ * batches, one batch per loop tick. Incoming messages are routed by module prefix
+ * ("<moduleId>/..."); topics outside a module's prefix (shared type and
+ * group configs) are routed to the modules whose subscription filters
+ * ('+' and '#' wildcards included) match them.
+ *
+ * The shared client is serviced once per round of module loops: the first
+ * module of a round runs its loop(), the last one flushes it, so every
+ * attached module should loop on each pass of the sketch's loop(). The
+ * modem sleeps only while no module needs the radio.
+ *
+ * MQTT allows one will per session: the will goes to "<clientId>/presence".
+ * Each module's own presence topic gets "online" on connect and "offline"
+ * when it detaches or on a clean disconnect, but an unexpected drop only
+ * shows on the hub's topic.
+ *
+ * The log buffer is process-wide, so attached modules send it to the
+ * hub's "<clientId>/logs" rather than each to its own logs topic.
+ *
+ * @example
+ * MqttHub hub("esp32-greenhouse");
+ * HubModule climate("climate-01", hub);
+ * HubModule irrigation("irrigation-01", hub);
+ */
+class MqttHub {
+public:
+    /**
+     * @param clientId MQTT client ID of the shared session
+     */
+    explicit MqttHub(const char* clientId);
+
+    /**
+     * @brief The shared client (broker, credentials, transport, batching)
+     */
+    MqttClient& client() { return _client; }
+
+    /**
+     * @brief Logs topic of the device ("<clientId>/logs")
+     */
+    const char* logTopic() const { return _logTopic; }
+
+    /**
+     * @brief Register a module (again to replace its callbacks)
+     *
+     * A module attaching while the session is up is told at once.
+     *
+     * @param moduleId Module ID, must stay valid until detach()
+     * @return false if all IOT_MQTT_HUB_MODULES slots are taken
+     */
+    bool attach(const char* moduleId, MqttConnectCallback onConnect,
+                MqttMessageCallback onMessage);
+
+    /**
+     * @brief Remove a module and its routes
+     */
+    void detach(const char* moduleId);
+
+    /**
+     * @brief Start the session (later calls leave reconnection to the client)
+     */
+    bool connect();
+
+    /**
+     * @brief Mark every module offline and close the session
+     */
+    void disconnect();
+
+    /**
+     * @brief Subscribe on behalf of a module
+     */
+    void subscribe(const char* moduleId, const char* topic);
+
+    /**
+     * @brief Publish, counted for the module owning the topic prefix
+     */
+    void publish(const char* topic, const char* payload, bool retain = false);
+
+    /**
+     * @brief Start a module's loop tick (the first of a round loops the client)
+     */
+    void beginTick(const char* moduleId);
+
+    /**
+     * @brief End a module's loop tick (the last of a round flushes the client)
+     */
+    void endTick(const char* moduleId);
+
+    /**
+     * @brief Record whether a module needs the radio
+     * @return true if the shared modem should follow: the first module to
+     *         need the radio wakes it, the last one to let go puts it to sleep
+     */
+    bool setRadioNeeded(const char* moduleId, bool needed);
+
+    /**
+     * @brief Number of attached modules
+     */
+    size_t modules() const;
+
+    /**
+     * @brief Traffic of a module, nullptr if not attached
+     */
+    const MqttHubStats* stats(const char* moduleId) const;
+
+private:
+    struct Module {
+        const char* id;         // nullptr = free slot
+        size_t idLength;
+        MqttConnectCallback onConnect;
+        MqttMessageCallback onMessage;
+        MqttHubStats stats;
+    };
+
+    // Subscription outside a module prefix
+    struct Route {
+        char filter[IOT_TOPIC_BYTES];
+        uint8_t modules;        // Bit per module slot, 0 = free
+    };
+
+    MqttClient _client;
+    char _logTopic[IOT_TOPIC_BYTES];
+    Module _modules[IOT_MQTT_HUB_MODULES];
+    Route _routes[IOT_MQTT_HUB_ROUTES];
+    uint8_t _ticked;            // Modules that looped in the current round
+    uint8_t _radioNeeded;       // Modules inside a transmit window
+    bool _connectRequested;
+
+    void route(const char* topic, const char* payload);
+    void publishPresence(const Module& module, const char* state);
+    int findModule(const char* moduleId) const;
+    int moduleForTopic(const char* topic) const;
+    uint8_t attachedModules() const;
+};
+
+/**
+ * @brief Session policy of modules on an MqttHub (see HubModule)
+ *
+ * The module holds no client and uses the hub's.
+ */
+class HubSession {
+public:
+    static const bool OWNS_CLIENT = false;
+    MqttClient* client(MqttHub* hub) { return &hub->client(); }
+};
+
+#endif // MQTT_HUB_H
@@ -0,0 +1,224 @@
+/**
+ * @file MqttSnLoopback.cpp
+ * @brief Implementation of MqttSnLoopback
+ */
+
+#ifdef NATIVE_BUILD
+
+#include "MqttSnLoopback.h"
+#include <cstring>
+
+static uint16_t getUint16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void putUint16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back((uint8_t)(value >> 8));
+    out.push_back((uint8_t)(value & 0xFF));
+}
+
+MqttSnLoopback::MqttSnLoopback()
+    : _datagrams(0), _nextTopicId(1), _reachable(true), _connected(false),
+      _asleep(false), _sleepDuration(0), _willRequested(false), _willRetain(false) {
+    memset(_typeCounts, 0, sizeof(_typeCounts));
+}
+
+bool MqttSnLoopback::begin(const char* host, uint16_t port) {
+    return host != nullptr && port != 0;
+}
+
+size_t MqttSnLoopback::receive(uint8_t* buffer, size_t bufferSize) {
+    if (_toClient.empty()) return 0;
+    std::vector<uint8_t> packet = _toClient.front();
+    _toClient.pop_front();
+    if (packet.size() > bufferSize) return 0;
+    memcpy(buffer, packet.data(), packet.size());
+    return packet.size();
+}
+
+size_t MqttSnLoopback::count(uint8_t type) const {
+    return _typeCounts[type];
+}
+
+// =============================================================================
+// Gateway
+// =============================================================================
+
+bool MqttSnLoopback::send(const uint8_t* data, size_t length) {
+    if (!_reachable || length < 2) return true; // UDP: lost silently
+
+    size_t header = data[0] == 0x01 ? 3 : 1;
+    if (length < header + 1) return true;
+    uint8_t type = data[header];
+    const uint8_t* body = data + header + 1;
+    size_t bodyLength = length - header - 1;
+    _datagrams++;
+    _typeCounts[type]++;
+
+    switch (type) {
+    case 0x04: { // CONNECT
+        if (bodyLength < 4) break;
+        bool will = (body[0] & 0x08) != 0;
+        bool wasAsleep = _asleep;
+        _connected = true;
+        _asleep = false;
+        if (will) {
+            _willRequested = true;
+            reply(0x06, std::vector<uint8_t>()); // WILLTOPICREQ
+        } else {
+            reply(0x05, std::vector<uint8_t>(1, 0x00)); // CONNACK
+        }
+        // Messages held while the client slept
+        if (wasAsleep) {
+            for (size_t i = 0; i < _heldForClient.size(); i++) {
+                Topic* topic = findTopic(_heldForClient[i].topic, false);
+                if (topic) sendPublish(*topic, _heldForClient[i].payload.c_str());
+            }
+            _heldForClient.clear();
+        }
+        break;
+    }
+    case 0x07: // WILLTOPIC
+        _willRetain = bodyLength > 0 && (body[0] & 0x10) != 0;
+        _willTopic.assign((const char*)body + 1, bodyLength > 0 ? bodyLength - 1 : 0);
+        reply(0x08, std::vector<uint8_t>()); // WILLMSGREQ
+        break;
+    case 0x09: // WILLMSG
+        _willPayload.assign((const char*)body, bodyLength);
+        if (_willRequested) {
+            _willRequested = false;
+            reply(0x05, std::vector<uint8_t>(1, 0x00)); // CONNACK
+        }
+        break;
+    case 0x0A: { // REGISTER
+        if (bodyLength < 4) break;
+        std::string name((const char*)body + 4, bodyLength - 4);
+        Topic* topic = findTopic(name, false);
+        if (!topic) {
+            Topic created = {name, _nextTopicId++, false, false};
+            _topics.push_back(created);
+            topic = &_topics.back();
+        }
+        std::vector<uint8_t> ack;
+        putUint16(ack, topic->id);
+        ack.push_back(body[2]);
+        ack.push_back(body[3]);
+        ack.push_back(0x00);
+        reply(0x0B, ack); // REGACK
+        break;
+    }
+    case 0x0C: { // PUBLISH
+        if (bodyLength < 5) break;
+        uint8_t flags = body[0];
+        uint16_t id = getUint16(body + 1);
+        Topic* topic = findTopicById(id, (flags & 0x03) == 0x01);
+        if (!topic) break;
+        LoopbackMessage message;
+        message.topic = topic->name;
+        message.payload.assign((const char*)body + 5, bodyLength - 5);
+        message.qos = (flags & 0x60) == 0x60 ? -1 : (flags & 0x60) >> 5;
+        message.retain = (flags & 0x10) != 0;
+        _published.push_back(message);
+        break;
+    }
+    case 0x12: { // SUBSCRIBE
+        if (bodyLength < 3) break;
+        std::string name((const char*)body + 3, bodyLength - 3);
+        Topic* topic = findTopic(name, false);
+        if (!topic) {
+            Topic created = {name, _nextTopicId++, false, true};
+            _topics.push_back(created);
+            topic = &_topics.back();
+        }
+        topic->subscribed = true;
+        std::vector<uint8_t> ack;
+        ack.push_back(0x00);
+        putUint16(ack, topic->id);
+        ack.push_back(body[1]);
+        ack.push_back(body[2]);
+        ack.push_back(0x00);
+        reply(0x13, ack); // SUBACK
+        break;
+    }
+    case 0x16: // PINGREQ
+        reply(0x17, std::vector<uint8_t>()); // PINGRESP
+        break;
+    case 0x18: // DISCONNECT
+        if (bodyLength >= 2) {
+            _asleep = true;
+            _sleepDuration = getUint16(body);
+        } else {
+            _connected = false;
+        }
+        reply(0x18, std::vector<uint8_t>());
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+bool MqttSnLoopback::deliver(const char* topicName, const char* payload) {
+    Topic* topic = findTopic(topicName, false);
+    if (!topic || !topic->subscribed || !_connected) return false;
+
+    if (_asleep) {
+        LoopbackMessage message = {topicName, payload, 0, false};
+        _heldForClient.push_back(message);
+    } else {
+        sendPublish(*topic, payload);
+    }
+    return true;
+}
+
+void MqttSnLoopback::dropClient() {
+    if (!_connected) return;
+    _connected = false;
+    _asleep = false;
+    if (!_willTopic.empty()) {
+        LoopbackMessage will = {_willTopic, _willPayload, 1, _willRetain};
+        _published.push_back(will);
+    }
+}
+
+void MqttSnLoopback::predefine(const char* name, uint16_t topicId) {
+    Topic topic = {name, topicId, true, false};
+    _topics.push_back(topic);
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+void MqttSnLoopback::reply(uint8_t type, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> packet;
+    packet.push_back((uint8_t)(body.size() + 2));
+    packet.push_back(type);
+    packet.insert(packet.end(), body.begin(), body.end());
+    _toClient.push_back(packet);
+}
+
+void MqttSnLoopback::sendPublish(const Topic& topic, const char* payload) {
+    std::vector<uint8_t> body;
+    body.push_back(0x00); // QoS 0, normal topic ID
+    putUint16(body, topic.id);
+    putUint16(body, 0);
+    body.insert(body.end(), payload, payload + strlen(payload));
+    reply(0x0C, body);
+}
+
+MqttSnLoopback::Topic* MqttSnLoopback::findTopic(const std::string& name, bool predefined) {
+    for (size_t i = 0; i < _topics.size(); i++) {
+        if (_topics[i].name == name && _topics[i].predefined == predefined) return &_topics[i];
+    }
+    return nullptr;
+}
+
+MqttSnLoopback::Topic* MqttSnLoopback::findTopicById(uint16_t id, bool predefined) {
+    for (size_t i = 0; i < _topics.size(); i++) {
+        if (_topics[i].id == id && _topics[i].predefined == predefined) return &_topics[i];
+    }
+    return nullptr;
+}
+
+#endif // NATIVE_BUILD
@@ -0,0 +1,114 @@
+/**
+ * @file MqttSnLoopback.h
+ * @brief In-process MQTT-SN gateway stand-in for native tests
+ */
+
+#ifndef MQTT_SN_LOOPBACK_H
+#define MQTT_SN_LOOPBACK_H
+
+#ifdef NATIVE_BUILD
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "MqttSnTransport.h"
+
+/**
+ * @brief Message as seen by the gateway's MQTT side
+ */
+struct LoopbackMessage {
+    std::string topic;
+    std::string payload;
+    int8_t qos;
+    bool retain;
+};
+
+/**
+ * @brief Datagram socket whose other end is a minimal MQTT-SN gateway
+ *
+ * Packets are handled synchronously in send(); replies wait in a queue for
+ * receive(). The gateway supports will prompting, REGISTER, predefined
+ * topics, exact-name subscriptions and the asleep state (messages for an
+ * asleep client are held until it reconnects).
+ */
+class MqttSnLoopback : public MqttSnDatagram {
+public:
+    MqttSnLoopback();
+
+    bool begin(const char* host, uint16_t port) override;
+    bool send(const uint8_t* data, size_t length) override;
+    size_t receive(uint8_t* buffer, size_t bufferSize) override;
+
+    /**
+     * @brief Declare a predefined topic (gateway configuration)
+     */
+    void predefine(const char* topic, uint16_t topicId);
+
+    /**
+     * @brief Publish to the client as the MQTT broker would
+     * @return false if the client is not subscribed
+     */
+    bool deliver(const char* topic, const char* payload);
+
+    /**
+     * @brief Lose the client without a DISCONNECT (the will is published)
+     */
+    void dropClient();
+
+    /**
+     * @brief Stop answering (gateway down or out of range)
+     */
+    void setReachable(bool reachable) { _reachable = reachable; }
+
+    bool clientConnected() const { return _connected; }
+    bool clientAsleep() const { return _asleep; }
+    uint16_t sleepDuration() const { return _sleepDuration; }
+
+    /**
+     * @brief Messages published by the client (and its will), in order
+     */
+    const std::vector<LoopbackMessage>& published() const { return _published; }
+
+    /**
+     * @brief Number of datagrams received from the client
+     */
+    size_t datagrams() const { return _datagrams; }
+
+    /**
+     * @brief Number of datagrams of a given MQTT-SN message type
+     */
+    size_t count(uint8_t type) const;
+
+private:
+    struct Topic {
+        std::string name;
+        uint16_t id;
+        bool predefined;
+        bool subscribed;
+    };
+
+    std::vector<Topic> _topics;
+    std::vector<LoopbackMessage> _published;
+    std::deque<std::vector<uint8_t>> _toClient;
+    std::vector<LoopbackMessage> _heldForClient;
+    size_t _typeCounts[256];
+    size_t _datagrams;
+    uint16_t _nextTopicId;
+    bool _reachable;
+    bool _connected;
+    bool _asleep;
+    uint16_t _sleepDuration;
+    bool _willRequested;
+    std::string _willTopic;
+    std::string _willPayload;
+    bool _willRetain;
+
+    void reply(uint8_t type, const std::vector<uint8_t>& body);
+    void sendPublish(const Topic& topic, const char* payload);
+    Topic* findTopic(const std::string& name, bool predefined);
+    Topic* findTopicById(uint16_t id, bool predefined);
+};
+
+#endif // NATIVE_BUILD
+
+#endif // MQTT_SN_LOOPBACK_H
@@ -0,0 +1,519 @@
+/**
+ * @file MqttSnTransport.cpp
+ * @brief Implementation of MqttSnTransport
+ */
+
+#include "MqttSnTransport.h"
+#include "Clock.h"
+#include <cstring>
+
+// Message types (MQTT-SN 1.2, section 5.2.2)
+static const uint8_t SN_CONNECT = 0x04;
+static const uint8_t SN_CONNACK = 0x05;
+static const uint8_t SN_WILLTOPICREQ = 0x06;
+static const uint8_t SN_WILLTOPIC = 0x07;
+static const uint8_t SN_WILLMSGREQ = 0x08;
+static const uint8_t SN_WILLMSG = 0x09;
+static const uint8_t SN_REGISTER = 0x0A;
+static const uint8_t SN_REGACK = 0x0B;
+static const uint8_t SN_PUBLISH = 0x0C;
+static const uint8_t SN_PUBACK = 0x0D;
+static const uint8_t SN_SUBSCRIBE = 0x12;
+static const uint8_t SN_SUBACK = 0x13;
+static const uint8_t SN_PINGREQ = 0x16;
+static const uint8_t SN_PINGRESP = 0x17;
+static const uint8_t SN_DISCONNECT = 0x18;
+
+// Flags
+static const uint8_t SN_FLAG_QOS_NO_SESSION = 0x60;
+static const uint8_t SN_FLAG_QOS_1 = 0x20;
+static const uint8_t SN_FLAG_QOS_MASK = 0x60;
+static const uint8_t SN_FLAG_RETAIN = 0x10;
+static const uint8_t SN_FLAG_WILL = 0x08;
+static const uint8_t SN_FLAG_CLEAN_SESSION = 0x04;
+static const uint8_t SN_TOPIC_NORMAL = 0x00;
+static const uint8_t SN_TOPIC_PREDEFINED = 0x01;
+static const uint8_t SN_TOPIC_SHORT = 0x02;
+static const uint8_t SN_TOPIC_TYPE_MASK = 0x03;
+
+static const uint8_t SN_PROTOCOL_ID = 0x01;
+
+static void putUint16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)(value & 0xFF);
+}
+
+static uint16_t getUint16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+MqttSnTransport::MqttSnTransport(MqttSnDatagram& datagram)
+    : _datagram(datagram), _state(Disconnected), _sessionless(false),
+      _clientId(""), _willTopic(nullptr), _willPayload(nullptr), _topicCount(0),
+      _nextMsgId(0), _lastSent(0), _pingSent(0) {
+    memset(_topics, 0, sizeof(_topics));
+}
+
+// =============================================================================
+// Session
+// =============================================================================
+
+bool MqttSnTransport::connect(const MqttSessionConfig& config) {
+    if (!_datagram.begin(config.host, config.port)) return false;
+    _clientId = config.clientId;
+    _willTopic = config.willTopic;
+    _willPayload = config.willPayload;
+
+    // QoS -1 needs no session at all: the open socket is the connection
+    if (_sessionless) {
+        if (_state != Sessionless) {
+            _state = Sessionless;
+            notifyConnect(true);
+        }
+        return true;
+    }
+
+    if (_state == Disconnected || _state == Connecting) {
+        _state = Connecting;
+        sendConnect(_willTopic != nullptr, true);
+    }
+    return true;
+}
+
+void MqttSnTransport::disconnect() {
+    if (_state == Disconnected || _state == Connecting) {
+        _state = Disconnected;
+        return;
+    }
+    if (_state != Sessionless) sendPacket(SN_DISCONNECT, nullptr, 0);
+    lost();
+}
+
+bool MqttSnTransport::connected() const {
+    // An asleep session is still a session: the gateway keeps it
+    return _state == Active || _state == Asleep || _state == Waking ||
+           _state == Sessionless;
+}
+
+void MqttSnTransport::sleep(unsigned long durationMs) {
+    if (_state != Active) return;
+
+    // The gateway drops the client if it stays silent longer than announced
+    unsigned long seconds = (durationMs + 999) / 1000 + IOT_MQTTSN_KEEPALIVE_S;
+    if (seconds > 0xFFFF) seconds = 0xFFFF;
+    uint8_t body[2];
+    putUint16(body, (uint16_t)seconds);
+    sendPacket(SN_DISCONNECT, body, sizeof(body));
+    _state = Asleep;
+    _pingSent = 0;
+}
+
+void MqttSnTransport::wake() {
+    if (_state != Asleep) return;
+    // Back to active: the gateway keeps subscriptions and registrations and
+    // sends the messages it held
+    _state = Waking;
+    sendConnect(false, false);
+}
+
+void MqttSnTransport::loop() {
+    uint8_t packet[IOT_MQTTSN_PACKET_BYTES];
+    size_t length;
+    while ((length = _datagram.receive(packet, sizeof(packet))) > 0) {
+        handle(packet, length);
+    }
+
+    unsigned long now = Clock::now();
+    const unsigned long keepAliveMs = IOT_MQTTSN_KEEPALIVE_S * 1000UL;
+    if (_state == Active) {
+        if (_pingSent != 0 && now - _pingSent > keepAliveMs) {
+            lost();
+        } else if (_pingSent == 0 && now - _lastSent >= keepAliveMs / 2) {
+            sendPacket(SN_PINGREQ, nullptr, 0);
+            _pingSent = now ? now : 1;
+        }
+    } else if (_state == Waking && now - _lastSent > keepAliveMs) {
+        lost();
+    }
+}
+
+// =============================================================================
+// Topics
+// =============================================================================
+
+void MqttSnTransport::predefineTopic(const char* topic, uint16_t topicId) {
+    if (!topic || topicId == 0) return;
+    MqttSnTopic* entry = findTopic(topic);
+    if (!entry) entry = addTopic(topic);
+    if (!entry) return;
+    entry->id = topicId;
+    entry->predefined = true;
+    entry->pendingMsgId = 0;
+}
+
+uint16_t MqttSnTransport::topicId(const char* topic) const {
+    for (size_t i = 0; i < _topicCount; i++) {
+        if (strcmp(_topics[i].name, topic) == 0) return _topics[i].id;
+    }
+    return 0;
+}
+
+bool MqttSnTransport::subscribe(const char* topic) {
+    if (_state != Active || !topic) return false;
+    MqttSnTopic* entry = findTopic(topic);
+    if (!entry) entry = addTopic(topic);
+    if (!entry) return false;
+
+    size_t nameLength = strlen(topic);
+    uint8_t body[IOT_MQTTSN_TOPIC_LEN + 3];
+    body[0] = SN_TOPIC_NORMAL;
+    entry->pendingMsgId = nextMsgId();
+    putUint16(body + 1, entry->pendingMsgId);
+    memcpy(body + 3, topic, nameLength);
+    return sendPacket(SN_SUBSCRIBE, body, 3 + nameLength);
+}
+
+// =============================================================================
+// Publishing
+// =============================================================================
+
+bool MqttSnTransport::publish(const char* topic, const uint8_t* payload, size_t length,
+                              int8_t qos, bool retain) {
+    MqttSnTopic* entry = findTopic(topic);
+
+    // Without a session only predefined topics can be published (QoS -1)
+    if (!connected() || _sessionless) {
+        if (!entry || !entry->predefined) return false;
+        sendPublish(entry->id, true, payload, length, MqttQos::NoSession, retain);
+        return true;
+    }
+
+    // In a session: QoS 0 or 1 (QoS 2 is not supported, 1 is the closest)
+    if (qos < MqttQos::AtMostOnce) qos = MqttQos::AtMostOnce;
+    if (qos > MqttQos::AtLeastOnce) qos = MqttQos::AtLeastOnce;
+    if (_state == Active && entry && entry->id != 0) {
+        sendPublish(entry->id, entry->predefined, payload, length, qos, retain);
+        return true;
+    }
+
+    // Register the topic name first (the gateway answers with its ID)
+    if (!entry) entry = addTopic(topic);
+    if (!entry) return false;
+    if (_state == Active) registerTopic(*entry);
+
+    // Hold until the registration or the wake-up completes
+    char text[IOT_MQTTSN_PACKET_BYTES];
+    if (length >= sizeof(text)) return false;
+    memcpy(text, payload, length);
+    text[length] = '\0';
+    return _held.push(topic, text, retain, qos);
+}
+
+void MqttSnTransport::releaseHeld() {
+    if (_state != Active) return;
+
+    // Send what can go now, keep the rest in order
+    size_t count = _held.count();
+    for (size_t i = 0; i < count; i++) {
+        const char* topic;
+        const char* payload;
+        bool retain;
+        int8_t qos;
+        if (!_held.peek(topic, payload, retain, qos)) break;
+
+        char name[IOT_MQTTSN_TOPIC_LEN];
+        char text[IOT_MQTTSN_PACKET_BYTES];
+        strncpy(name, topic, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        strncpy(text, payload, sizeof(text) - 1);
+        text[sizeof(text) - 1] = '\0';
+        _held.pop();
+
+        MqttSnTopic* entry = findTopic(name);
+        if (entry && entry->id != 0) {
+            sendPublish(entry->id, entry->predefined, (const uint8_t*)text, strlen(text),
+                        qos, retain);
+        } else {
+            if (entry) registerTopic(*entry);
+            _held.push(name, text, retain, qos);
+        }
+    }
+}
+
+// =============================================================================
+// Incoming Packets
+// =============================================================================
+
+void MqttSnTransport::handle(const uint8_t* packet, size_t length) {
+    // Length is 1 byte, or 0x01 followed by 2 bytes
+    size_t header = 1;
+    size_t total = packet[0];
+    if (packet[0] == 0x01) {
+        if (length < 4) return;
+        header = 3;
+        total = getUint16(packet + 1);
+    }
+    if (total > length || total < header + 1) return;
+
+    uint8_t type = packet[header];
+    const uint8_t* body = packet + header + 1;
+    size_t bodyLength = total - header - 1;
+
+    switch (type) {
+    case SN_CONNACK:
+        if (bodyLength >= 1) handleConnack(body[0]);
+        break;
+    case SN_WILLTOPICREQ:
+        if (_willTopic) {
+            uint8_t reply[IOT_MQTTSN_TOPIC_LEN + 1];
+            size_t nameLength = strlen(_willTopic);
+            if (nameLength > IOT_MQTTSN_TOPIC_LEN) break;
+            reply[0] = SN_FLAG_QOS_1 | SN_FLAG_RETAIN;
+            memcpy(reply + 1, _willTopic, nameLength);
+            sendPacket(SN_WILLTOPIC, reply, 1 + nameLength);
+        }
+        break;
+    case SN_WILLMSGREQ:
+        if (_willPayload) {
+            sendPacket(SN_WILLMSG, (const uint8_t*)_willPayload, strlen(_willPayload));
+        }
+        break;
+    case SN_REGISTER:
+        handleRegister(body, bodyLength);
+        break;
+    case SN_REGACK:
+        if (bodyLength >= 5) handleAck(getUint16(body), getUint16(body + 2), body[4]);
+        break;
+    case SN_SUBACK:
+        if (bodyLength >= 6) handleAck(getUint16(body + 1), getUint16(body + 3), body[5]);
+        break;
+    case SN_PUBLISH:
+        handlePublish(body, bodyLength);
+        break;
+    case SN_PINGRESP:
+        _pingSent = 0;
+        break;
+    case SN_DISCONNECT:
+        // Acknowledges our sleep request, otherwise the gateway dropped us
+        if (_state != Asleep && _state != Sessionless) lost();
+        break;
+    default:
+        break;
+    }
+}
+
+void MqttSnTransport::handleConnack(uint8_t returnCode) {
+    if (returnCode != 0) {
+        lost();
+        return;
+    }
+
+    if (_state == Waking) {
+        _state = Active;
+        releaseHeld();
+        return;
+    }
+    if (_state != Connecting) return;
+
+    // Clean session: the gateway forgot registrations and subscriptions
+    for (size_t i = 0; i < _topicCount; i++) {
+        if (!_topics[i].predefined) _topics[i].id = 0;
+        _topics[i].pendingMsgId = 0;
+    }
+    _state = Active;
+    _pingSent = 0;
+    notifyConnect(true);
+    releaseHeld();
+}
+
+void MqttSnTransport::handlePublish(const uint8_t* body, size_t length) {
+    if (length < 5) return;
+    uint8_t flags = body[0];
+    uint16_t id = getUint16(body + 1);
+    uint16_t msgId = getUint16(body + 3);
+
+    char name[IOT_MQTTSN_TOPIC_LEN];
+    uint8_t topicType = flags & SN_TOPIC_TYPE_MASK;
+    if (topicType == SN_TOPIC_SHORT) {
+        name[0] = (char)body[1];
+        name[1] = (char)body[2];
+        name[2] = '\0';
+    } else {
+        MqttSnTopic* entry = findTopicById(id, topicType == SN_TOPIC_PREDEFINED);
+        if (!entry) return;
+        strcpy(name, entry->name);
+    }
+
+    char text[IOT_MQTTSN_PACKET_BYTES];
+    size_t dataLength = length - 5;
+    if (dataLength >= sizeof(text)) dataLength = sizeof(text) - 1;
+    memcpy(text, body + 5, dataLength);
+    text[dataLength] = '\0';
+
+    if ((flags & SN_FLAG_QOS_MASK) == SN_FLAG_QOS_1) {
+        uint8_t ack[5];
+        putUint16(ack, id);
+        putUint16(ack + 2, msgId);
+        ack[4] = 0;
+        sendPacket(SN_PUBACK, ack, sizeof(ack));
+    }
+    notifyMessage(name, text);
+}
+
+void MqttSnTransport::handleRegister(const uint8_t* body, size_t length) {
+    if (length < 5 || length - 4 >= IOT_MQTTSN_TOPIC_LEN) return;
+
+    // The gateway names the topics matched by a wildcard subscription
+    char name[IOT_MQTTSN_TOPIC_LEN];
+    memcpy(name, body + 4, length - 4);
+    name[length - 4] = '\0';
+
+    MqttSnTopic* entry = findTopic(name);
+    if (!entry) entry = addTopic(name);
+
+    uint8_t ack[5];
+    memcpy(ack, body, 4);
+    ack[4] = entry ? 0x00 : 0x02; // Rejected: no free topic slot
+    if (entry) entry->id = getUint16(body);
+    sendPacket(SN_REGACK, ack, sizeof(ack));
+}
+
+void MqttSnTransport::handleAck(uint16_t topicId, uint16_t msgId, uint8_t returnCode) {
+    for (size_t i = 0; i < _topicCount; i++) {
+        MqttSnTopic& entry = _topics[i];
+        if (entry.pendingMsgId != msgId || msgId == 0) continue;
+        entry.pendingMsgId = 0;
+        // Wildcard subscriptions get ID 0: topics are registered by the gateway
+        if (returnCode == 0 && topicId != 0) entry.id = topicId;
+        break;
+    }
+    releaseHeld();
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+void MqttSnTransport::registerTopic(MqttSnTopic& entry) {
+    if (entry.pendingMsgId != 0) return;
+
+    size_t nameLength = strlen(entry.name);
+    uint8_t body[IOT_MQTTSN_TOPIC_LEN + 4];
+    putUint16(body, 0);
+    entry.pendingMsgId = nextMsgId();
+    putUint16(body + 2, entry.pendingMsgId);
+    memcpy(body + 4, entry.name, nameLength);
+    sendPacket(SN_REGISTER, body, 4 + nameLength);
+}
+
+void MqttSnTransport::sendConnect(bool will, bool cleanSession) {
+    size_t idLength = strlen(_clientId);
+    if (idLength > 23) idLength = 23; // MQTT-SN client IDs are 1-23 chars
+
+    uint8_t body[4 + 23];
+    body[0] = (will ? SN_FLAG_WILL : 0) | (cleanSession ? SN_FLAG_CLEAN_SESSION : 0);
+    body[1] = SN_PROTOCOL_ID;
+    putUint16(body + 2, IOT_MQTTSN_KEEPALIVE_S);
+    memcpy(body + 4, _clientId, idLength);
+    sendPacket(SN_CONNECT, body, 4 + idLength);
+}
+
+void MqttSnTransport::sendPublish(uint16_t topicId, bool predefined, const uint8_t* payload,
+                                  size_t length, int8_t qos, bool retain) {
+    uint8_t body[IOT_MQTTSN_PACKET_BYTES];
+    if (length + 5 + 4 > sizeof(body)) return;
+
+    body[0] = (qos == MqttQos::NoSession ? SN_FLAG_QOS_NO_SESSION : 0) |
+              (qos == MqttQos::AtLeastOnce ? SN_FLAG_QOS_1 : 0) |
+              (retain ? SN_FLAG_RETAIN : 0) |
+              (predefined ? SN_TOPIC_PREDEFINED : SN_TOPIC_NORMAL);
+    putUint16(body + 1, topicId);
+    // QoS 0 and -1 carry no message ID
+    putUint16(body + 3, qos == MqttQos::AtLeastOnce ? nextMsgId() : 0);
+    memcpy(body + 5, payload, length);
+    sendPacket(SN_PUBLISH, body, 5 + length);
+}
+
+bool MqttSnTransport::sendPacket(uint8_t type, const uint8_t* body, size_t length) {
+    uint8_t packet[IOT_MQTTSN_PACKET_BYTES + 4];
+    size_t header;
+    size_t total = length + 2;
+    if (total <= 0xFF) {
+        packet[0] = (uint8_t)total;
+        header = 1;
+    } else {
+        total = length + 4;
+        if (total > sizeof(packet)) return false;
+        packet[0] = 0x01;
+        putUint16(packet + 1, (uint16_t)total);
+        header = 3;
+    }
+    packet[header] = type;
+    if (length > 0) memcpy(packet + header + 1, body, length);
+
+    _lastSent = Clock::now();
+    return _datagram.send(packet, total);
+}
+
+void MqttSnTransport::lost() {
+    bool hadSession = connected();
+    _state = Disconnected;
+    _pingSent = 0;
+    if (hadSession) notifyConnect(false);
+}
+
+uint16_t MqttSnTransport::nextMsgId() {
+    if (++_nextMsgId == 0) _nextMsgId = 1;
+    return _nextMsgId;
+}
+
+MqttSnTopic* MqttSnTransport::findTopic(const char* name) {
+    for (size_t i = 0; i < _topicCount; i++) {
+        if (strcmp(_topics[i].name, name) == 0) return &_topics[i];
+    }
+    return nullptr;
+}
+
+MqttSnTopic* MqttSnTransport::findTopicById(uint16_t id, bool predefined) {
+    for (size_t i = 0; i < _topicCount; i++) {
+        if (_topics[i].id == id && _topics[i].predefined == predefined) return &_topics[i];
+    }
+    return nullptr;
+}
+
+MqttSnTopic* MqttSnTransport::addTopic(const char* name) {
+    if (_topicCount >= IOT_MQTTSN_TOPICS || strlen(name) >= IOT_MQTTSN_TOPIC_LEN) {
+        return nullptr;
+    }
+    MqttSnTopic& entry = _topics[_topicCount++];
+    memset(&entry, 0, sizeof(entry));
+    strcpy(entry.name, name);
+    return &entry;
+}
+
+// =============================================================================
+// WiFi UDP Datagram
+// =============================================================================
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+bool WiFiUdpDatagram::begin(const char* host, uint16_t port) {
+    if (!WiFi.hostByName(host, _gateway)) return false;
+    _port = port;
+    // Reconnect attempts reuse the socket
+    if (!_started) _started = _udp.begin(0) == 1; // Any local port
+    return _started;
+}
+
+bool WiFiUdpDatagram::send(const uint8_t* data, size_t length) {
+    if (!_udp.beginPacket(_gateway, _port)) return false;
+    _udp.write(data, length);
+    return _udp.endPacket() == 1;
+}
+
+size_t WiFiUdpDatagram::receive(uint8_t* buffer, size_t bufferSize) {
+    int size = _udp.parsePacket();
+    if (size <= 0) return 0;
+    int read = _udp.read(buffer, bufferSize);
+    return read > 0 ? (size_t)read : 0;
+}
+#endif
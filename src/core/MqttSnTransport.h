@@ -0,0 +1,175 @@
+/**
+ * @file MqttSnTransport.h
+ * @brief MQTT-SN 1.2 client over UDP
+ */
+
+#ifndef MQTT_SN_TRANSPORT_H
+#define MQTT_SN_TRANSPORT_H
+
+#include <Arduino.h>
+#include "MqttTransport.h"
+#include "RadioScheduler.h"
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+#ifdef ESP32
+#include <WiFi.h>
+#elif defined(ESP8266)
+#include <ESP8266WiFi.h>
+#endif
+#include <WiFiUdp.h>
+#endif
+
+#ifndef IOT_MQTTSN_TOPICS
+#define IOT_MQTTSN_TOPICS 24
+#endif
+
+#ifndef IOT_MQTTSN_TOPIC_LEN
+#define IOT_MQTTSN_TOPIC_LEN 96
+#endif
+
+#ifndef IOT_MQTTSN_PACKET_BYTES
+#define IOT_MQTTSN_PACKET_BYTES 256
+#endif
+
+#ifndef IOT_MQTTSN_KEEPALIVE_S
+#define IOT_MQTTSN_KEEPALIVE_S 60
+#endif
+
+/**
+ * @brief Datagram socket to the gateway
+ */
+class MqttSnDatagram {
+public:
+    virtual ~MqttSnDatagram() {}
+
+    /**
+     * @brief Set the gateway address
+     */
+    virtual bool begin(const char* host, uint16_t port) = 0;
+
+    virtual bool send(const uint8_t* data, size_t length) = 0;
+
+    /**
+     * @brief Read the next datagram
+     * @return Datagram size, 0 if none is pending
+     */
+    virtual size_t receive(uint8_t* buffer, size_t bufferSize) = 0;
+};
+
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+/**
+ * @brief Datagram socket over the WiFi UDP stack
+ */
+class WiFiUdpDatagram : public MqttSnDatagram {
+public:
+    WiFiUdpDatagram() : _port(0), _started(false) {}
+
+    bool begin(const char* host, uint16_t port) override;
+    bool send(const uint8_t* data, size_t length) override;
+    size_t receive(uint8_t* buffer, size_t bufferSize) override;
+
+private:
+    WiFiUDP _udp;
+    IPAddress _gateway;
+    uint16_t _port;
+    bool _started;
+};
+#endif
+
+/**
+ * @brief Topic name and its MQTT-SN topic ID
+ */
+struct MqttSnTopic {
+    char name[IOT_MQTTSN_TOPIC_LEN];
+    uint16_t id;            // 0 = not registered yet
+    bool predefined;
+    uint16_t pendingMsgId;  // REGISTER/SUBSCRIBE waiting for its ack
+};
+
+/**
+ * @brief MQTT-SN client session
+ *
+ * Topic names are replaced by 2-byte IDs: predefined IDs (agreed with the
+ * gateway beforehand, e.g. sensor topics from the registry) need no
+ * registration and can be published with QoS -1 without any session;
+ * other topics are registered on first use. Messages waiting for a
+ * registration or for the session to wake are held in order, with their
+ * QoS. QoS 1 publishes are not retried: the gateway's PUBACK is not awaited.
+ *
+ * sleep() puts the session in the MQTT-SN asleep state: the gateway keeps
+ * subscriptions and holds incoming messages until wake().
+ */
+class MqttSnTransport : public MqttTransport {
+public:
+    explicit MqttSnTransport(MqttSnDatagram& datagram);
+
+    /**
+     * @brief Never open a session: only predefined topics are published (QoS -1)
+     *
+     * connect() then only opens the datagram socket and reports the
+     * transport connected, so MqttClient publishes through it as usual.
+     */
+    void setSessionless(bool sessionless) { _sessionless = sessionless; }
+
+    bool connect(const MqttSessionConfig& config) override;
+    void disconnect() override;
+    bool connected() const override;
+    bool subscribe(const char* topic) override;
+    bool publish(const char* topic, const uint8_t* payload, size_t length,
+                 int8_t qos, bool retain) override;
+    void loop() override;
+    void predefineTopic(const char* topic, uint16_t topicId) override;
+    void sleep(unsigned long durationMs) override;
+    void wake() override;
+
+    /**
+     * @brief Check if the session is in the asleep state
+     */
+    bool asleep() const { return _state == Asleep; }
+
+    /**
+     * @brief Number of messages held for a registration or a wake-up
+     */
+    size_t held() const { return _held.count(); }
+
+    /**
+     * @brief Find the topic ID of a topic name
+     * @return Topic ID, 0 if unknown or not registered yet
+     */
+    uint16_t topicId(const char* topic) const;
+
+private:
+    enum State { Disconnected, Connecting, Active, Asleep, Waking, Sessionless };
+
+    MqttSnDatagram& _datagram;
+    State _state;
+    bool _sessionless;
+    const char* _clientId;
+    const char* _willTopic;
+    const char* _willPayload;
+    MqttSnTopic _topics[IOT_MQTTSN_TOPICS];
+    size_t _topicCount;
+    MessageQueue _held;
+    uint16_t _nextMsgId;
+    unsigned long _lastSent;
+    unsigned long _pingSent;    // 0 = no PINGREQ outstanding
+
+    void handle(const uint8_t* packet, size_t length);
+    void handleConnack(uint8_t returnCode);
+    void handlePublish(const uint8_t* body, size_t length);
+    void handleRegister(const uint8_t* body, size_t length);
+    void handleAck(uint16_t topicId, uint16_t msgId, uint8_t returnCode);
+    void registerTopic(MqttSnTopic& entry);
+    void sendConnect(bool will, bool cleanSession);
+    void sendPublish(uint16_t topicId, bool predefined, const uint8_t* payload,
+                     size_t length, int8_t qos, bool retain);
+    bool sendPacket(uint8_t type, const uint8_t* body, size_t length);
+    void releaseHeld();
+    void lost();
+    uint16_t nextMsgId();
+    MqttSnTopic* findTopic(const char* name);
+    MqttSnTopic* findTopicById(uint16_t id, bool predefined);
+    MqttSnTopic* addTopic(const char* name);
+};
+
+#endif // MQTT_SN_TRANSPORT_H
@@ -0,0 +1,43 @@
+/**
+ * @file MqttTransport.cpp
+ * @brief Default batch replay and topic matching of MqttTransport
+ */
+
+#include "MqttTransport.h"
+#include "Limits.h"
+#include "PacketBatcher.h"
+#include <cstring>
+
+size_t MqttTransport::writePackets(const uint8_t* data, size_t length, size_t& writes) {
+    char topic[IOT_TOPIC_BYTES];
+    const uint8_t* payload;
+    size_t payloadLength;
+    bool retain;
+    size_t offset = 0;
+    size_t next = 0;
+    writes = 0;
+    while (PacketBatcher::decode(data, length, next, topic, sizeof(topic),
+                                 payload, payloadLength, retain)) {
+        if (!publish(topic, payload, payloadLength, MqttQos::AtMostOnce, retain)) break;
+        writes++;
+        offset = next;
+    }
+    return offset;
+}
+
+bool MqttTransport::matches(const char* filter, const char* topic) {
+    while (*filter) {
+        if (*filter == '#') return true;
+        if (*filter == '+') {
+            while (*topic && *topic != '/') topic++;
+            filter++;
+            continue;
+        }
+        // "a/#" also matches "a"
+        if (*topic == '\0') return strcmp(filter, "/#") == 0;
+        if (*filter != *topic) return false;
+        filter++;
+        topic++;
+    }
+    return *topic == '\0';
+}
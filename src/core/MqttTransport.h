@@ -0,0 +1,132 @@
+/**
+ * @file MqttTransport.h
+ * @brief Session layer below MqttClient (MQTT over TCP, MQTT-SN over UDP, ...)
+ */
+
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+#include <Arduino.h>
+#include "Callback.h"
+
+/**
+ * @brief Publish QoS levels (-1 is MQTT-SN "fire and forget" without a session)
+ */
+namespace MqttQos {
+    const int8_t NoSession = -1;
+    const int8_t AtMostOnce = 0;
+    const int8_t AtLeastOnce = 1;
+}
+
+using TransportMessageCallback = Callback<void(const char* topic, const char* payload)>;
+using TransportConnectCallback = Callback<void(bool connected)>;
+
+/**
+ * @brief Connection settings, copied by MqttClient before each connect
+ *
+ * Strings are owned by MqttClient and stay valid while the transport is in
+ * use. The will is optional (topic nullptr).
+ */
+struct MqttSessionConfig {
+    const char* host;
+    uint16_t port;
+    const char* clientId;
+    const char* username;
+    const char* password;
+    const char* willTopic;
+    const char* willPayload;   // Always sent retained
+};
+
+/**
+ * @brief Transport interface used by MqttClient
+ *
+ * Implementations own the network session: connect, subscribe, publish and
+ * deliver incoming messages as null-terminated strings. Reconnection policy,
+ * presence, retained dedup and batching stay in MqttClient.
+ */
+class MqttTransport {
+public:
+    virtual ~MqttTransport() {}
+
+    /**
+     * @brief Start connecting (completion is reported through onConnect)
+     * @return true if the attempt was started
+     */
+    virtual bool connect(const MqttSessionConfig& config) = 0;
+
+    virtual void disconnect() = 0;
+    virtual bool connected() const = 0;
+
+    virtual bool subscribe(const char* topic) = 0;
+
+    /**
+     * @brief Publish a message
+     * @param qos One of MqttQos (transports may not support all levels)
+     * @return true if the message was handed to the network
+     */
+    virtual bool publish(const char* topic, const uint8_t* payload, size_t length,
+                         int8_t qos, bool retain) = 0;
+
+    /**
+     * @brief Write a batch of encoded MQTT 3.1.1 PUBLISH packets
+     *
+     * Stream transports speaking MQTT 3.1.1 write the buffer as is. The
+     * default is for transports that frame their own packets: it replays
+     * the batch through publish(), one network write per packet, and stops
+     * at the first packet publish() refuses.
+     *
+     * @param writes Set to the number of network writes made
+     * @return Number of bytes consumed (the rest of the batch is dropped)
+     */
+    virtual size_t writePackets(const uint8_t* data, size_t length, size_t& writes);
+
+    /**
+     * @brief Whether writePackets() writes a batch in one go
+     *
+     * MqttClient only batches for transports that do: replaying a batch
+     * packet by packet saves no write and only delays publishes.
+     */
+    virtual bool writesBatches() const { return false; }
+
+    /**
+     * @brief Run network I/O (called from MqttClient::loop())
+     */
+    virtual void loop() {}
+
+    /**
+     * @brief Map a topic to a predefined topic ID (no-op unless supported)
+     */
+    virtual void predefineTopic(const char*, uint16_t) {}
+
+    /**
+     * @brief Let the session sleep for about the given milliseconds; messages
+     *        are held by the server meanwhile
+     */
+    virtual void sleep(unsigned long) {}
+
+    /**
+     * @brief Wake a sleeping session and fetch held messages
+     */
+    virtual void wake() {}
+
+    /**
+     * @brief Check if a topic filter matches a topic ('+' and '#' wildcards)
+     */
+    static bool matches(const char* filter, const char* topic);
+
+    void onConnect(TransportConnectCallback callback) { _onConnect = callback; }
+    void onMessage(TransportMessageCallback callback) { _onMessage = callback; }
+
+protected:
+    TransportConnectCallback _onConnect;
+    TransportMessageCallback _onMessage;
+
+    void notifyConnect(bool connected) {
+        if (_onConnect) _onConnect(connected);
+    }
+    void notifyMessage(const char* topic, const char* payload) {
+        if (_onMessage) _onMessage(topic, payload);
+    }
+};
+
+#endif // MQTT_TRANSPORT_H
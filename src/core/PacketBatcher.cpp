@@ -0,0 +1,154 @@
+/**
+ * @file PacketBatcher.cpp
+ * @brief Implementation of PacketBatcher
+ */
+
+#include "PacketBatcher.h"
+#include "Logger.h"
+#include <cstring>
+
+static const uint8_t PUBLISH_TYPE = 0x30;
+static const uint8_t RETAIN_FLAG = 0x01;
+
+PacketBatcher::PacketBatcher()
+    : _used(0), _staged(0), _maxBytes(IOT_MQTT_BATCH_BYTES),
+      _maxDelayMs(IOT_MQTT_BATCH_DELAY_MS), _firstStagedAt(0), _writes(0),
+      _packets(0), _dropped(0) {}
+
+void PacketBatcher::setLimits(size_t maxBytes, unsigned long maxDelayMs) {
+    flush();
+    _maxBytes = maxBytes < IOT_MQTT_BATCH_BYTES ? maxBytes : IOT_MQTT_BATCH_BYTES;
+    _maxDelayMs = maxDelayMs;
+}
+
+// =============================================================================
+// Staging
+// =============================================================================
+
+bool PacketBatcher::add(const char* topic, const char* payload, bool retain,
+                        unsigned long now) {
+    if (!topic || !payload) return false;
+
+    // Encode in place when it fits, else make room and retry once
+    size_t size = encode(topic, payload, retain, _buffer + _used, _maxBytes - _used);
+    if (size > _maxBytes - _used) {
+        if (size > _maxBytes) return false;
+        flush();
+        encode(topic, payload, retain, _buffer, _maxBytes);
+    }
+
+    if (_staged == 0) _firstStagedAt = now;
+    _used += size;
+    _staged++;
+
+    // Batching disabled or batch full: no reason to wait
+    if (_used >= _maxBytes || _maxDelayMs == 0) flush();
+    return true;
+}
+
+void PacketBatcher::poll(unsigned long now) {
+    if (_staged > 0 && now - _firstStagedAt >= _maxDelayMs) flush();
+}
+
+// Number of packets starting in data (a truncated last one included)
+static size_t countPackets(const uint8_t* data, size_t length) {
+    size_t count = 0;
+    size_t offset = 0;
+    while (offset < length) {
+        size_t p = offset + 1;
+        size_t remaining = 0;
+        size_t multiplier = 1;
+        for (int i = 0; i < 4 && p < length; i++) {
+            uint8_t digit = data[p++];
+            remaining += (digit & 0x7F) * multiplier;
+            multiplier *= 128;
+            if (!(digit & 0x80)) break;
+        }
+        offset = p + remaining;
+        count++;
+    }
+    return count;
+}
+
+size_t PacketBatcher::flush() {
+    if (_staged == 0) return 0;
+
+    size_t writes = 0;
+    size_t written = _writer ? _writer(_buffer, _used, writes) : 0;
+    size_t dropped = written < _used ? countPackets(_buffer + written, _used - written) : 0;
+    if (dropped > _staged) dropped = _staged;
+    if (dropped > 0) {
+        IOT_LOG_WARN("[MQTT] Batch write incomplete, dropped %u of %u packets",
+                     (unsigned)dropped, (unsigned)_staged);
+    }
+    _writes += writes;
+    _packets += _staged - dropped;
+    _dropped += dropped;
+    clear();
+    return written;
+}
+
+// =============================================================================
+// Encoding
+// =============================================================================
+
+size_t PacketBatcher::encode(const char* topic, const char* payload, bool retain,
+                             uint8_t* buffer, size_t bufferSize) {
+    size_t topicLength = strlen(topic);
+    size_t payloadLength = strlen(payload);
+    if (topicLength > 0xFFFF) return bufferSize + 1;
+
+    // Remaining length: variable-length integer, 7 bits per byte
+    size_t remaining = 2 + topicLength + payloadLength;
+    uint8_t header[5];
+    size_t headerLength = 0;
+    header[headerLength++] = PUBLISH_TYPE | (retain ? RETAIN_FLAG : 0);
+    size_t value = remaining;
+    do {
+        uint8_t digit = value % 128;
+        value /= 128;
+        if (value > 0) digit |= 0x80;
+        header[headerLength++] = digit;
+    } while (value > 0 && headerLength < sizeof(header));
+
+    size_t size = headerLength + remaining;
+    if (size > bufferSize) return size;
+
+    memcpy(buffer, header, headerLength);
+    uint8_t* p = buffer + headerLength;
+    *p++ = (uint8_t)(topicLength >> 8);
+    *p++ = (uint8_t)(topicLength & 0xFF);
+    memcpy(p, topic, topicLength);
+    memcpy(p + topicLength, payload, payloadLength);
+    return size;
+}
+
+bool PacketBatcher::decode(const uint8_t* data, size_t length, size_t& offset,
+                           char* topic, size_t topicSize, const uint8_t*& payload,
+                           size_t& payloadLength, bool& retain) {
+    if (offset >= length) return false;
+    if ((data[offset] & 0xF0) != PUBLISH_TYPE) return false;
+    retain = (data[offset] & RETAIN_FLAG) != 0;
+
+    size_t p = offset + 1;
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    for (int i = 0; i < 4; i++) {
+        if (p >= length) return false;
+        uint8_t digit = data[p++];
+        remaining += (digit & 0x7F) * multiplier;
+        multiplier *= 128;
+        if (!(digit & 0x80)) break;
+    }
+    if (remaining < 2 || p + remaining > length) return false;
+
+    size_t topicLength = ((size_t)data[p] << 8) | data[p + 1];
+    if (2 + topicLength > remaining || topicLength >= topicSize) return false;
+    memcpy(topic, data + p + 2, topicLength);
+    topic[topicLength] = '\0';
+
+    payload = data + p + 2 + topicLength;
+    payloadLength = remaining - 2 - topicLength;
+    offset = p + remaining;
+    return true;
+}
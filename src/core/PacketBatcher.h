@@ -0,0 +1,136 @@
+/**
+ * @file PacketBatcher.h
+ * @brief Stages MQTT PUBLISH packets and writes them in one go
+ */
+
+#ifndef PACKET_BATCHER_H
+#define PACKET_BATCHER_H
+
+#include <Arduino.h>
+#include "Callback.h"
+
+#ifndef IOT_MQTT_BATCH_BYTES
+#if !defined(NATIVE_BUILD) && !defined(IOT_POSIX)
+#define IOT_MQTT_BATCH_BYTES 0      // AsyncMqttClient cannot write a batch at once
+#elif defined(IOT_LOW_RAM)
+#define IOT_MQTT_BATCH_BYTES 512
+#else
+#define IOT_MQTT_BATCH_BYTES 1024   // Stays under one WiFi TCP segment (MSS 1436)
+#endif
+#endif
+
+#ifndef IOT_MQTT_BATCH_DELAY_MS
+#define IOT_MQTT_BATCH_DELAY_MS 50
+#endif
+
+/**
+ * @brief Receives a batch of encoded packets
+ *
+ * writes is set to the number of network writes the batch took.
+ *
+ * @return Number of bytes accepted
+ */
+using BatchWriter = Callback<size_t(const uint8_t* data, size_t length, size_t& writes)>;
+
+/**
+ * @brief Write coalescing for small MQTT publishes
+ *
+ * Every publish of a loop tick is encoded as an MQTT 3.1.1 QoS 0 PUBLISH
+ * packet into one staging buffer, and the buffer goes to the writer in a
+ * single call, so a sensor cycle costs one TCP segment instead of one per
+ * value. A batch is written when the next packet would exceed the size
+ * cap, when its oldest packet is older than the max delay, or on flush().
+ * Packets the writer does not accept are counted as dropped.
+ */
+class PacketBatcher {
+public:
+    PacketBatcher();
+
+    /**
+     * @brief Set the destination of flushed batches
+     */
+    void setWriter(BatchWriter writer) { _writer = writer; }
+
+    /**
+     * @brief Set the batch bounds
+     * @param maxBytes Size cap (clamped to IOT_MQTT_BATCH_BYTES, 0 = no batching)
+     * @param maxDelayMs Longest time a packet waits for its batch
+     */
+    void setLimits(size_t maxBytes, unsigned long maxDelayMs);
+
+    /**
+     * @brief Stage a publish
+     * @param topic MQTT topic
+     * @param payload Message payload
+     * @param retain Retain flag
+     * @param now Current time in ms
+     * @return false if the packet is larger than the size cap (send it directly)
+     */
+    bool add(const char* topic, const char* payload, bool retain, unsigned long now);
+
+    /**
+     * @brief Flush the batch if its oldest packet waited too long
+     * @param now Current time in ms
+     */
+    void poll(unsigned long now);
+
+    /**
+     * @brief Write all staged packets in one call
+     * @return Number of bytes written
+     */
+    size_t flush();
+
+    /**
+     * @brief Drop staged packets (e.g., on disconnect)
+     */
+    void clear() { _used = 0; _staged = 0; }
+
+    size_t pending() const { return _staged; }
+    size_t bytes() const { return _used; }
+
+    /**
+     * @brief Number of network writes so far, as reported by the writer
+     */
+    unsigned long writes() const { return _writes; }
+
+    /**
+     * @brief Number of packets written so far
+     */
+    unsigned long packets() const { return _packets; }
+
+    /**
+     * @brief Number of packets the writer did not accept
+     */
+    unsigned long dropped() const { return _dropped; }
+
+    /**
+     * @brief Encode a QoS 0 PUBLISH packet
+     * @return Packet size (nothing is written if larger than bufferSize)
+     */
+    static size_t encode(const char* topic, const char* payload, bool retain,
+                         uint8_t* buffer, size_t bufferSize);
+
+    /**
+     * @brief Decode the QoS 0 PUBLISH packet at offset and move past it
+     * @param topic Output buffer for the topic (null-terminated)
+     * @param payload Set to the payload inside data (not null-terminated)
+     * @return false at the end of data or on a malformed packet
+     */
+    static bool decode(const uint8_t* data, size_t length, size_t& offset,
+                       char* topic, size_t topicSize, const uint8_t*& payload,
+                       size_t& payloadLength, bool& retain);
+
+private:
+    uint8_t _buffer[IOT_MQTT_BATCH_BYTES > 0 ? IOT_MQTT_BATCH_BYTES : 1];
+    size_t _used;
+    size_t _staged;
+    size_t _maxBytes;
+    unsigned long _maxDelayMs;
+    unsigned long _firstStagedAt;
+    unsigned long _writes;
+    unsigned long _packets;
+    unsigned long _dropped;
+    BatchWriter _writer;
+};
+
+#endif // PACKET_BATCHER_H
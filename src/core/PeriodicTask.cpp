@@ -0,0 +1,53 @@
+/**
+ * @file PeriodicTask.cpp
+ * @brief Implementation of PeriodicTask
+ */
+
+#include "PeriodicTask.h"
+
+PeriodicTask::PeriodicTask(unsigned long periodMs, uint16_t phase)
+    : _periodMs(periodMs), _phase(phase % IOT_PHASE_STEPS), _next(0), _started(false) {}
+
+void PeriodicTask::setPeriod(unsigned long periodMs) {
+    _periodMs = periodMs;
+    _started = false;
+}
+
+void PeriodicTask::setPhase(uint16_t phase) {
+    _phase = phase % IOT_PHASE_STEPS;
+    _started = false;
+}
+
+bool PeriodicTask::due(unsigned long now) {
+    if (_periodMs == 0) return false;
+
+    if (!_started) {
+        // First grid point at or after now
+        unsigned long off = offset();
+        _next = now < off ? off : off + ((now - off + _periodMs - 1) / _periodMs) * _periodMs;
+        _started = true;
+    }
+
+    // Signed difference keeps working across millis() rollover
+    if ((long)(now - _next) < 0) return false;
+
+    unsigned long late = now - _next;
+    _next += (late / _periodMs + 1) * _periodMs;
+    return true;
+}
+
+unsigned long PeriodicTask::offsetFor(unsigned long periodMs, uint16_t phase) {
+    // 64-bit product: periods of a few hours times 999 overflow 32 bits
+    return (unsigned long)((uint64_t)periodMs * (phase % IOT_PHASE_STEPS) / IOT_PHASE_STEPS);
+}
+
+uint16_t PeriodicTask::phaseFromId(const char* id) {
+    if (!id) return 0;
+    // FNV-1a: neighbouring IDs (sequential MACs) still land far apart
+    uint32_t hash = 2166136261u;
+    for (const char* c = id; *c; c++) {
+        hash ^= static_cast<uint8_t>(*c);
+        hash *= 16777619u;
+    }
+    return hash % IOT_PHASE_STEPS;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file PeriodicTask.h
+ * @brief Fixed-rate schedule with a per-module phase offset
+ */
+
+#ifndef PERIODIC_TASK_H
+#define PERIODIC_TASK_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Number of phase steps in a period (phase is in per-mille)
+ */
+#define IOT_PHASE_STEPS 1000
+
+/**
+ * @brief Periodic deadline on a grid shifted by a phase offset
+ *
+ * The task is due at offset, offset + period, offset + 2 * period, ...
+ * where offset = period * phase / IOT_PHASE_STEPS. Modules that boot
+ * together but use different phases spread their messages over the period
+ * instead of sending them in the same instant.
+ */
+class PeriodicTask {
+public:
+    /**
+     * @param periodMs Period in ms (0 disables the task)
+     * @param phase Phase in per-mille of the period (0-999)
+     */
+    explicit PeriodicTask(unsigned long periodMs = 0, uint16_t phase = 0);
+
+    /**
+     * @brief Change the period (the schedule restarts on the new grid)
+     */
+    void setPeriod(unsigned long periodMs);
+
+    /**
+     * @brief Change the phase (the schedule restarts on the new grid)
+     */
+    void setPhase(uint16_t phase);
+
+    unsigned long period() const { return _periodMs; }
+    uint16_t phase() const { return _phase; }
+
+    /**
+     * @brief Offset of the grid in ms
+     */
+    unsigned long offset() const { return offsetFor(_periodMs, _phase); }
+
+    /**
+     * @brief Check if the deadline passed and move to the next one
+     *
+     * Missed deadlines are skipped: a long blocking call produces one run,
+     * not a burst of catch-up runs.
+     *
+     * @param now Current time in ms
+     * @return true if the task must run now
+     */
+    bool due(unsigned long now);
+
+    /**
+     * @brief Offset of a phase on a given period
+     */
+    static unsigned long offsetFor(unsigned long periodMs, uint16_t phase);
+
+    /**
+     * @brief Deterministic phase derived from a module/chip ID
+     * @return Phase in per-mille (0-999)
+     */
+    static uint16_t phaseFromId(const char* id);
+
+private:
+    unsigned long _periodMs;
+    uint16_t _phase;
+    unsigned long _next;
+    bool _started;
+};
+
+#endif // PERIODIC_TASK_H
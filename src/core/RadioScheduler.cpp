@@ -0,0 +1,170 @@
+/**
+ * @file RadioScheduler.cpp
+ * @brief Implementation of MessageQueue and RadioScheduler
+ */
+
+#include "RadioScheduler.h"
+#include <cstring>
+
+namespace {
+
+const uint8_t FLAG_RETAIN = 0x01;
+const uint8_t FLAG_QOS_1 = 0x02;
+const unsigned long ONE_HOUR_MS = 3600000UL;
+
+} // namespace
+
+// =============================================================================
+// MessageQueue
+// =============================================================================
+
+MessageQueue::MessageQueue() : _used(0), _count(0), _dropped(0) {}
+
+bool MessageQueue::push(const char* topic, const char* payload, bool retain, int8_t qos) {
+    if (!topic || !payload) return false;
+    size_t topicLen = strlen(topic) + 1;
+    size_t payloadLen = strlen(payload) + 1;
+    size_t size = 1 + topicLen + payloadLen;
+    if (size > sizeof(_arena)) return false;
+
+    // Only the latest retained state of a topic is worth sending
+    if (retain) {
+        size_t offset = 0;
+        while (offset < _used) {
+            if ((_arena[offset] & FLAG_RETAIN) &&
+                strcmp(reinterpret_cast<const char*>(&_arena[offset + 1]), topic) == 0) {
+                removeAt(offset);
+                break;
+            }
+            offset += entrySize(offset);
+        }
+    }
+
+    while (_used + size > sizeof(_arena)) {
+        if (!dropOldestVolatile()) {
+            // Only retained state left: make room anyway, oldest first
+            removeAt(0);
+            _dropped++;
+        }
+    }
+
+    uint8_t* entry = &_arena[_used];
+    entry[0] = (retain ? FLAG_RETAIN : 0) | (qos > 0 ? FLAG_QOS_1 : 0);
+    memcpy(entry + 1, topic, topicLen);
+    memcpy(entry + 1 + topicLen, payload, payloadLen);
+    _used += size;
+    _count++;
+    return true;
+}
+
+bool MessageQueue::peek(const char*& topic, const char*& payload, bool& retain) const {
+    int8_t qos;
+    return peek(topic, payload, retain, qos);
+}
+
+bool MessageQueue::peek(const char*& topic, const char*& payload, bool& retain,
+                        int8_t& qos) const {
+    if (_count == 0) return false;
+    topic = reinterpret_cast<const char*>(&_arena[1]);
+    payload = topic + strlen(topic) + 1;
+    retain = (_arena[0] & FLAG_RETAIN) != 0;
+    qos = (_arena[0] & FLAG_QOS_1) ? 1 : 0;
+    return true;
+}
+
+void MessageQueue::pop() {
+    if (_count > 0) removeAt(0);
+}
+
+void MessageQueue::clear() {
+    _used = 0;
+    _count = 0;
+}
+
+size_t MessageQueue::entrySize(size_t offset) const {
+    const char* topic = reinterpret_cast<const char*>(&_arena[offset + 1]);
+    size_t topicLen = strlen(topic) + 1;
+    size_t payloadLen = strlen(topic + topicLen) + 1;
+    return 1 + topicLen + payloadLen;
+}
+
+void MessageQueue::removeAt(size_t offset) {
+    size_t size = entrySize(offset);
+    memmove(&_arena[offset], &_arena[offset + size], _used - offset - size);
+    _used -= size;
+    _count--;
+}
+
+bool MessageQueue::dropOldestVolatile() {
+    size_t offset = 0;
+    while (offset < _used) {
+        if (!(_arena[offset] & FLAG_RETAIN)) {
+            removeAt(offset);
+            _dropped++;
+            return true;
+        }
+        offset += entrySize(offset);
+    }
+    return false;
+}
+
+// =============================================================================
+// RadioScheduler
+// =============================================================================
+
+RadioScheduler::RadioScheduler()
+    : _periodMs(0), _windowMs(0), _windowStart(0), _open(true),
+      _tracking(false), _lastUpdate(0), _onMs(0), _elapsedMs(0) {}
+
+bool RadioScheduler::configure(unsigned long periodMs, unsigned long windowMs,
+                               uint16_t phase) {
+    if (periodMs == 0 || windowMs == 0 || windowMs >= periodMs) return false;
+    _periodMs = periodMs;
+    _windowMs = windowMs;
+    _windows.setPeriod(periodMs);
+    _windows.setPhase(phase);
+    _open = false;
+    return true;
+}
+
+void RadioScheduler::disable() {
+    _periodMs = 0;
+    _windows.setPeriod(0);
+    _open = true;
+}
+
+bool RadioScheduler::update(unsigned long now) {
+    // Account for the time since the last update in the previous state
+    if (_tracking) {
+        unsigned long dt = now - _lastUpdate;
+        _elapsedMs += dt;
+        if (_open) _onMs += dt;
+    }
+    _tracking = true;
+    _lastUpdate = now;
+
+    if (!enabled()) {
+        _open = true;
+        return true;
+    }
+
+    if (_windows.due(now)) {
+        _windowStart = now;
+        _open = true;
+    } else if (_open && now - _windowStart >= _windowMs) {
+        _open = false;
+    }
+    return _open;
+}
+
+unsigned long RadioScheduler::quantize(unsigned long intervalMs) const {
+    if (!enabled()) return intervalMs;
+    // Faster tasks could not send more than once per window anyway
+    if (intervalMs <= _periodMs) return _periodMs;
+    return ((intervalMs + _periodMs - 1) / _periodMs) * _periodMs;
+}
+
+unsigned long RadioScheduler::radioOnPerHour() const {
+    if (_elapsedMs == 0) return 0;
+    return (unsigned long)((uint64_t)_onMs * ONE_HOUR_MS / _elapsedMs);
+}
@@ -0,0 +1,144 @@
+/**
+ * @file RadioScheduler.h
+ * @brief Transmit windows and outgoing message queue for power saving
+ */
+
+#ifndef RADIO_SCHEDULER_H
+#define RADIO_SCHEDULER_H
+
+#include <Arduino.h>
+#include "PeriodicTask.h"
+
+#ifndef IOT_RADIO_QUEUE_BYTES
+#define IOT_RADIO_QUEUE_BYTES 2048
+#endif
+
+/**
+ * @brief Outgoing messages held while the radio sleeps
+ *
+ * Messages are packed into a fixed arena in send order. A retained message
+ * replaces a queued one on the same topic (only the latest state matters);
+ * when the arena is full the oldest non-retained messages are dropped.
+ */
+class MessageQueue {
+public:
+    MessageQueue();
+
+    /**
+     * @brief Queue a message
+     * @param qos Publish QoS kept with the message (0 or 1)
+     * @return false if the message is larger than the whole queue
+     */
+    bool push(const char* topic, const char* payload, bool retain, int8_t qos = 0);
+
+    /**
+     * @brief Get the oldest queued message (pointers valid until pop())
+     * @return false if the queue is empty
+     */
+    bool peek(const char*& topic, const char*& payload, bool& retain) const;
+    bool peek(const char*& topic, const char*& payload, bool& retain, int8_t& qos) const;
+
+    /**
+     * @brief Remove the oldest queued message
+     */
+    void pop();
+
+    /**
+     * @brief Remove all messages
+     */
+    void clear();
+
+    size_t count() const { return _count; }
+    size_t bytes() const { return _used; }
+
+    /**
+     * @brief Number of messages dropped because the queue was full
+     */
+    unsigned long dropped() const { return _dropped; }
+
+private:
+    // Entry layout: [flags][topic\0][payload\0]
+    uint8_t _arena[IOT_RADIO_QUEUE_BYTES];
+    size_t _used;
+    size_t _count;
+    unsigned long _dropped;
+
+    size_t entrySize(size_t offset) const;
+    void removeAt(size_t offset);
+    bool dropOldestVolatile();
+};
+
+/**
+ * @brief Periodic transmit windows
+ *
+ * The radio is on for windowMs at the start of every period (shifted by
+ * the module phase) and in modem sleep in between. While disabled the
+ * radio counts as always on, so radio-on metrics stay comparable.
+ */
+class RadioScheduler {
+public:
+    RadioScheduler();
+
+    /**
+     * @brief Enable transmit windows
+     * @param periodMs Time between window starts (e.g., 60000)
+     * @param windowMs Radio-on time per window (e.g., 2000)
+     * @param phase Phase in per-mille of the period
+     * @return false if the settings are invalid
+     */
+    bool configure(unsigned long periodMs, unsigned long windowMs, uint16_t phase);
+
+    /**
+     * @brief Move the windows to another phase
+     */
+    void setPhase(uint16_t phase) { _windows.setPhase(phase); }
+
+    /**
+     * @brief Back to an always-on radio
+     */
+    void disable();
+
+    bool enabled() const { return _periodMs > 0; }
+    unsigned long period() const { return _periodMs; }
+
+    /**
+     * @brief Advance the schedule
+     * @param now Current time in ms
+     * @return true if the radio must be on
+     */
+    bool update(unsigned long now);
+
+    /**
+     * @brief Check if a window is open (always true when disabled)
+     */
+    bool isOpen() const { return _open; }
+
+    /**
+     * @brief Round an interval up to a whole number of periods
+     */
+    unsigned long quantize(unsigned long intervalMs) const;
+
+    /**
+     * @brief Total radio-on time since start
+     */
+    unsigned long radioOnMs() const { return _onMs; }
+
+    /**
+     * @brief Radio-on time scaled to one hour of operation
+     */
+    unsigned long radioOnPerHour() const;
+
+private:
+    PeriodicTask _windows;
+    unsigned long _periodMs;
+    unsigned long _windowMs;
+    unsigned long _windowStart;
+    bool _open;
+
+    bool _tracking;
+    unsigned long _lastUpdate;
+    unsigned long _onMs;
+    unsigned long _elapsedMs;
+};
+
+#endif // RADIO_SCHEDULER_H
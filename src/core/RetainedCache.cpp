@@ -0,0 +1,74 @@
+/**
+ * @file RetainedCache.cpp
+ * @brief Implementation of RetainedCache
+ */
+
+#include "RetainedCache.h"
+#include <cstring>
+
+RetainedCache::RetainedCache() : _next(0), _suppressed(0), _suppressedBytes(0) {
+    memset(_entries, 0, sizeof(_entries));
+}
+
+bool RetainedCache::shouldSend(const char* topic, const char* payload) {
+    if (!topic || !payload) return true;
+
+    uint32_t topicHash = hash(topic);
+    uint32_t payloadHash = hash(payload);
+    size_t length = strlen(payload);
+
+    RetainedEntry* entry = find(topicHash);
+    if (entry) {
+        if (entry->payloadHash == payloadHash && entry->length == length) {
+            _suppressed++;
+            _suppressedBytes += length;
+            return false;
+        }
+    } else {
+        // Take a free slot, else recycle the oldest one
+        for (size_t i = 0; i < IOT_RETAINED_CACHE_SIZE && !entry; i++) {
+            if (_entries[i].topicHash == 0) entry = &_entries[i];
+        }
+        if (!entry) {
+            entry = &_entries[_next];
+            _next = (_next + 1) % IOT_RETAINED_CACHE_SIZE;
+        }
+        entry->topicHash = topicHash;
+    }
+
+    entry->payloadHash = payloadHash;
+    entry->length = length;
+    return true;
+}
+
+void RetainedCache::invalidate(const char* topic) {
+    if (!topic) return;
+    RetainedEntry* entry = find(hash(topic));
+    if (entry) memset(entry, 0, sizeof(*entry));
+}
+
+void RetainedCache::clear() {
+    memset(_entries, 0, sizeof(_entries));
+    _next = 0;
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+uint32_t RetainedCache::hash(const char* text) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = text; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619u;
+    }
+    // 0 marks a free slot
+    return hash ? hash : 1;
+}
+
+RetainedEntry* RetainedCache::find(uint32_t topicHash) {
+    for (size_t i = 0; i < IOT_RETAINED_CACHE_SIZE; i++) {
+        if (_entries[i].topicHash == topicHash) return &_entries[i];
+    }
+    return nullptr;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file RetainedCache.h
+ * @brief Per-topic fingerprints of the last retained payloads sent
+ */
+
+#ifndef RETAINED_CACHE_H
+#define RETAINED_CACHE_H
+
+#include <Arduino.h>
+
+#ifndef IOT_RETAINED_CACHE_SIZE
+#define IOT_RETAINED_CACHE_SIZE 16
+#endif
+
+/**
+ * @brief Fingerprint of the last retained payload of one topic
+ */
+struct RetainedEntry {
+    uint32_t topicHash;     // 0 = free slot
+    uint32_t payloadHash;
+    size_t length;
+};
+
+/**
+ * @brief Suppresses retained publishes identical to the last one sent
+ *
+ * The broker already holds the last retained payload of a topic, so
+ * rewriting the same bytes only costs persistence I/O. Topics and payloads
+ * are kept as FNV-1a hashes (plus the payload length), so the table stays
+ * small regardless of payload size. When the table is full the oldest
+ * entry is recycled, which at worst lets a duplicate through.
+ */
+class RetainedCache {
+public:
+    RetainedCache();
+
+    /**
+     * @brief Check if a retained payload must be sent, and record it
+     * @param topic MQTT topic
+     * @param payload Message payload
+     * @return false if it is identical to the last payload sent on the topic
+     */
+    bool shouldSend(const char* topic, const char* payload);
+
+    /**
+     * @brief Forget one topic so its next publish goes out
+     */
+    void invalidate(const char* topic);
+
+    /**
+     * @brief Forget every topic (e.g., on reconnect)
+     */
+    void clear();
+
+    /**
+     * @brief Number of publishes suppressed so far
+     */
+    unsigned long suppressed() const { return _suppressed; }
+
+    /**
+     * @brief Payload bytes not sent thanks to suppression
+     */
+    unsigned long suppressedBytes() const { return _suppressedBytes; }
+
+private:
+    RetainedEntry _entries[IOT_RETAINED_CACHE_SIZE];
+    size_t _next;               // Slot recycled when the table is full
+    unsigned long _suppressed;
+    unsigned long _suppressedBytes;
+
+    static uint32_t hash(const char* text);
+    RetainedEntry* find(uint32_t topicHash);
+};
+
+#endif // RETAINED_CACHE_H
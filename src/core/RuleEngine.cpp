@@ -0,0 +1,158 @@
+/**
+ * @file RuleEngine.cpp
+ * @brief Implementation of RuleEngine
+ */
+
+#include "RuleEngine.h"
+#include <cstring>
+
+RuleEngine::RuleEngine() : _count(0) {
+    memset(_rules, 0, sizeof(_rules));
+}
+
+// =============================================================================
+// Deployment
+// =============================================================================
+
+bool RuleEngine::load(const RuleSpec* specs, size_t count, const SensorRegistry& registry) {
+    if (count > IOT_RULES_MAX) return false;
+    if (count > 0 && !specs) return false;
+
+    // Validate the whole set first so a bad rule can't leave a half-deployed set
+    for (size_t i = 0; i < count; i++) {
+        if (!validate(specs[i], registry)) return false;
+    }
+
+    // Release what the current rules hold (e.g., a fan) before replacing them
+    clear();
+    for (size_t i = 0; i < count; i++) {
+        compile(specs[i], registry, _rules[i]);
+    }
+    _count = count;
+    return true;
+}
+
+bool RuleEngine::validate(const RuleSpec& spec, const SensorRegistry& registry) {
+    CompiledRule rule;
+    return compile(spec, registry, rule);
+}
+
+bool RuleEngine::addRule(const RuleSpec& spec, const SensorRegistry& registry) {
+    if (_count >= IOT_RULES_MAX) return false;
+    if (!compile(spec, registry, _rules[_count])) return false;
+    _count++;
+    return true;
+}
+
+void RuleEngine::clear() {
+    for (size_t i = 0; i < _count; i++) {
+        setActive(_rules[i], false);
+    }
+    _count = 0;
+}
+
+const CompiledRule* RuleEngine::getRule(const char* id) const {
+    if (!id) return nullptr;
+    for (size_t i = 0; i < _count; i++) {
+        if (strcmp(_rules[i].id, id) == 0) return &_rules[i];
+    }
+    return nullptr;
+}
+
+// =============================================================================
+// Evaluation
+// =============================================================================
+
+void RuleEngine::onSample(const SensorRef& input, float value, unsigned long now) {
+    if (isnan(value)) return;
+
+    for (size_t i = 0; i < _count; i++) {
+        CompiledRule& rule = _rules[i];
+        if (rule.input.hardware == input.hardware && rule.input.sensor == input.sensor) {
+            evaluate(rule, value, now);
+        }
+    }
+}
+
+void RuleEngine::tick(unsigned long now) {
+    for (size_t i = 0; i < _count; i++) {
+        CompiledRule& rule = _rules[i];
+        if (rule.pending && now - rule.conditionSince >= rule.holdMs) {
+            rule.pending = false;
+            setActive(rule, true);
+        }
+    }
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+bool RuleEngine::compile(const RuleSpec& spec, const SensorRegistry& registry,
+                         CompiledRule& rule) {
+    if (!spec.id || !spec.sensor || !spec.op) return false;
+    if (isnan(spec.threshold) || !(spec.hysteresis >= 0.0f)) return false;
+
+    memset(&rule, 0, sizeof(rule));
+    if (!registry.resolveSensor(spec.sensor, rule.input)) return false;
+
+    if (spec.op[0] == '>') {
+        rule.op = RuleOp::Above;
+    } else if (spec.op[0] == '<') {
+        rule.op = RuleOp::Below;
+    } else {
+        return false;
+    }
+
+    strncpy(rule.id, spec.id, sizeof(rule.id) - 1);
+    strncpy(rule.action, spec.action ? spec.action : "", sizeof(rule.action) - 1);
+    rule.threshold = spec.threshold;
+    rule.hysteresis = spec.hysteresis;
+    rule.holdMs = spec.holdMs;
+    rule.lastValue = NAN;
+    return true;
+}
+
+void RuleEngine::evaluate(CompiledRule& rule, float value, unsigned long now) {
+    rule.lastValue = value;
+
+    bool above = rule.op == RuleOp::Above;
+    bool enter = above ? value > rule.threshold : value < rule.threshold;
+    bool leave = above ? value < rule.threshold - rule.hysteresis
+                       : value > rule.threshold + rule.hysteresis;
+
+    if (rule.active) {
+        if (leave) setActive(rule, false);
+        return;
+    }
+
+    if (!enter) {
+        // The condition must hold for the whole hold time: the hysteresis
+        // band only keeps an active rule active
+        rule.pending = false;
+        return;
+    }
+
+    if (!rule.pending) {
+        rule.pending = true;
+        rule.conditionSince = now;
+    }
+    if (now - rule.conditionSince >= rule.holdMs) {
+        rule.pending = false;
+        setActive(rule, true);
+    }
+}
+
+void RuleEngine::setActive(CompiledRule& rule, bool active) {
+    if (rule.active == active) return;
+    rule.active = active;
+
+    if (_onEvent) {
+        RuleEvent event;
+        event.ruleId = rule.id;
+        event.action = rule.action;
+        event.active = active;
+        event.value = rule.lastValue;
+        _onEvent(event);
+    }
+}
@@ -0,0 +1,151 @@
+/**
+ * @file RuleEngine.h
+ * @brief On-device threshold rules over registry values
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <Arduino.h>
+#include "Callback.h"
+#include "Limits.h"
+#include "SensorRegistry.h"
+
+#ifndef IOT_RULES_MAX
+#define IOT_RULES_MAX IOT_RAM_SIZE(16, 4)  // A full set must fit IOT_RULES_DOC_BYTES
+#endif
+
+/**
+ * @brief Comparison applied by a rule
+ */
+enum class RuleOp : uint8_t {
+    Above,  // active while value > threshold (clears below threshold - hysteresis)
+    Below   // active while value < threshold (clears above threshold + hysteresis)
+};
+
+/**
+ * @brief Rule as deployed (e.g., parsed from the rules topic)
+ */
+struct RuleSpec {
+    const char* id;         // e.g., "hum-high"
+    const char* sensor;     // Composite key, e.g., "dht22:humidity"
+    const char* op;         // ">" or "<"
+    float threshold;
+    float hysteresis;       // Dead band before the rule clears
+    unsigned long holdMs;   // Condition must hold this long before triggering
+    const char* action;     // Free-form action passed to callbacks, e.g., "fan"
+};
+
+/**
+ * @brief Compiled rule: one fixed-size table row with its runtime state
+ */
+struct CompiledRule {
+    char id[24];
+    char action[24];
+    SensorRef input;
+    RuleOp op;
+    float threshold;
+    float hysteresis;
+    unsigned long holdMs;
+
+    bool active;            // Rule currently triggered
+    bool pending;           // Condition true, waiting for holdMs
+    unsigned long conditionSince;
+    float lastValue;
+};
+
+/**
+ * @brief Rule state transition
+ */
+struct RuleEvent {
+    const char* ruleId;
+    const char* action;
+    bool active;
+    float value;
+};
+
+using RuleEventCallback = Callback<void(const RuleEvent& event)>;
+
+/**
+ * @brief Table-driven rule engine evaluated incrementally
+ *
+ * Rules are compiled against the registry into a fixed table. Each sample
+ * only evaluates the rules reading that sensor; tick() handles hold timers.
+ */
+class RuleEngine {
+public:
+    RuleEngine();
+
+    /**
+     * @brief Replace the whole rule set
+     *
+     * Either every rule compiles and the table is swapped, or the current
+     * table is kept untouched. Active rules of the current table clear
+     * first (an event with active = false each); the new ones start
+     * inactive.
+     *
+     * @param specs Rules to compile
+     * @param count Number of rules
+     * @param registry Registry used to resolve sensor keys
+     * @return true if the rule set was deployed
+     */
+    bool load(const RuleSpec* specs, size_t count, const SensorRegistry& registry);
+
+    /**
+     * @brief Check that a rule compiles, without deploying it
+     */
+    static bool validate(const RuleSpec& spec, const SensorRegistry& registry);
+
+    /**
+     * @brief Append a single rule
+     * @return true if the rule compiled and the table had room
+     */
+    bool addRule(const RuleSpec& spec, const SensorRegistry& registry);
+
+    /**
+     * @brief Remove all rules, clearing the active ones first
+     */
+    void clear();
+
+    /**
+     * @brief Feed a new sample of a sensor
+     * @param input Sensor the sample belongs to
+     * @param value Sample value
+     * @param now Current time in ms
+     */
+    void onSample(const SensorRef& input, float value, unsigned long now);
+
+    /**
+     * @brief Fire rules whose hold duration elapsed
+     * @param now Current time in ms
+     */
+    void tick(unsigned long now);
+
+    /**
+     * @brief Set callback for rule transitions
+     */
+    void onEvent(RuleEventCallback callback) { _onEvent = callback; }
+
+    /**
+     * @brief Number of compiled rules
+     */
+    size_t count() const { return _count; }
+
+    /**
+     * @brief Get a compiled rule by id
+     * @return Pointer to rule or nullptr
+     */
+    const CompiledRule* getRule(const char* id) const;
+
+private:
+    CompiledRule _rules[IOT_RULES_MAX];
+    size_t _count;
+    RuleEventCallback _onEvent;
+
+    static bool compile(const RuleSpec& spec, const SensorRegistry& registry,
+                        CompiledRule& rule);
+    void evaluate(CompiledRule& rule, float value, unsigned long now);
+    void setActive(CompiledRule& rule, bool active);
+};
+
+#endif // RULE_ENGINE_H
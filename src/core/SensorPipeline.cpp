@@ -0,0 +1,273 @@
+/**
+ * @file SensorPipeline.cpp
+ * @brief Implementation of SensorPipeline
+ */
+
+#include "SensorPipeline.h"
+#include <cstring>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Named unit conversions, applied as y = gain * x + offset
+ */
+struct UnitConversion {
+    const char* name;
+    float gain;
+    float offset;
+};
+
+const UnitConversion CONVERSIONS[] = {
+    {"c_to_f", 1.8f, 32.0f},
+    {"f_to_c", 1.0f / 1.8f, -32.0f / 1.8f},
+    {"c_to_k", 1.0f, 273.15f},
+    {"k_to_c", 1.0f, -273.15f},
+    {"pa_to_hpa", 0.01f, 0.0f},
+    {"hpa_to_pa", 100.0f, 0.0f},
+    {"hpa_to_kpa", 0.1f, 0.0f},
+    {"mv_to_v", 0.001f, 0.0f},
+    {"ml_to_l", 0.001f, 0.0f},
+};
+
+// Scale factor making the MAD a consistent estimator of the standard deviation
+const float MAD_SCALE = 1.4826f;
+
+void sortSmall(float* values, uint8_t count) {
+    for (uint8_t i = 1; i < count; i++) {
+        float v = values[i];
+        int j = i - 1;
+        while (j >= 0 && values[j] > v) {
+            values[j + 1] = values[j];
+            j--;
+        }
+        values[j + 1] = v;
+    }
+}
+
+float medianOf(float* values, uint8_t count) {
+    sortSmall(values, count);
+    if (count % 2 == 1) return values[count / 2];
+    return (values[count / 2 - 1] + values[count / 2]) * 0.5f;
+}
+
+} // namespace
+
+SensorPipeline::SensorPipeline() : _count(0), _valid(true) {
+    memset(_stages, 0, sizeof(_stages));
+}
+
+// =============================================================================
+// Stage Builders
+// =============================================================================
+
+SensorPipeline& SensorPipeline::linear(float gain, float offset) {
+    PipelineStage* stage = appendStage(StageType::Linear);
+    if (stage) {
+        stage->params[0] = gain;
+        stage->params[1] = offset;
+    }
+    return *this;
+}
+
+SensorPipeline& SensorPipeline::polynomial(const float* coeffs, uint8_t count) {
+    if (!coeffs || count == 0 || count > 4) {
+        _valid = false;
+        return *this;
+    }
+    PipelineStage* stage = appendStage(StageType::Polynomial);
+    if (stage) {
+        for (uint8_t i = 0; i < count; i++) {
+            stage->params[i] = coeffs[i];
+        }
+    }
+    return *this;
+}
+
+SensorPipeline& SensorPipeline::convert(const char* conversion) {
+    if (conversion) {
+        for (const auto& conv : CONVERSIONS) {
+            if (strcmp(conv.name, conversion) == 0) {
+                return linear(conv.gain, conv.offset);
+            }
+        }
+    }
+    _valid = false;
+    return *this;
+}
+
+SensorPipeline& SensorPipeline::ema(float alpha) {
+    if (!(alpha > 0.0f && alpha <= 1.0f)) {
+        _valid = false;
+        return *this;
+    }
+    PipelineStage* stage = appendStage(StageType::Ema);
+    if (stage) {
+        stage->params[0] = alpha;
+    }
+    return *this;
+}
+
+SensorPipeline& SensorPipeline::median(uint8_t window) {
+    if (window == 0 || window > IOT_PIPELINE_MAX_WINDOW) {
+        _valid = false;
+        return *this;
+    }
+    PipelineStage* stage = appendStage(StageType::Median);
+    if (stage) {
+        stage->window = window;
+    }
+    return *this;
+}
+
+SensorPipeline& SensorPipeline::hampel(uint8_t window, float threshold) {
+    if (window < 3 || window > IOT_PIPELINE_MAX_WINDOW || !(threshold > 0.0f)) {
+        _valid = false;
+        return *this;
+    }
+    PipelineStage* stage = appendStage(StageType::Hampel);
+    if (stage) {
+        stage->window = window;
+        stage->params[0] = threshold;
+    }
+    return *this;
+}
+
+SensorPipeline& SensorPipeline::range(float min, float max) {
+    if (!(min <= max)) {
+        _valid = false;
+        return *this;
+    }
+    PipelineStage* stage = appendStage(StageType::Range);
+    if (stage) {
+        stage->params[0] = min;
+        stage->params[1] = max;
+    }
+    return *this;
+}
+
+StageType SensorPipeline::stageTypeFromName(const char* name) {
+    if (!name) return StageType::None;
+    if (strcmp(name, "linear") == 0) return StageType::Linear;
+    if (strcmp(name, "polynomial") == 0) return StageType::Polynomial;
+    if (strcmp(name, "ema") == 0) return StageType::Ema;
+    if (strcmp(name, "median") == 0) return StageType::Median;
+    if (strcmp(name, "hampel") == 0) return StageType::Hampel;
+    if (strcmp(name, "range") == 0) return StageType::Range;
+    return StageType::None;
+}
+
+// =============================================================================
+// Processing
+// =============================================================================
+
+bool SensorPipeline::process(float input, float& output) {
+    output = input;
+
+    // Missing readings flow through untouched so status stays "missing"
+    if (isnan(input)) return true;
+
+    for (uint8_t i = 0; i < _count; i++) {
+        float next;
+        if (!applyStage(_stages[i], output, next)) {
+            return false;
+        }
+        output = next;
+    }
+    return true;
+}
+
+void SensorPipeline::reset() {
+    for (uint8_t i = 0; i < _count; i++) {
+        _stages[i].count = 0;
+        _stages[i].head = 0;
+        memset(_stages[i].state, 0, sizeof(_stages[i].state));
+    }
+}
+
+void SensorPipeline::clear() {
+    memset(_stages, 0, sizeof(_stages));
+    _count = 0;
+    _valid = true;
+}
+
+// =============================================================================
+// Private Helpers
+// =============================================================================
+
+PipelineStage* SensorPipeline::appendStage(StageType type) {
+    if (_count >= IOT_PIPELINE_MAX_STAGES) {
+        _valid = false;
+        return nullptr;
+    }
+    PipelineStage* stage = &_stages[_count++];
+    memset(stage, 0, sizeof(*stage));
+    stage->type = type;
+    return stage;
+}
+
+bool SensorPipeline::applyStage(PipelineStage& stage, float input, float& output) {
+    switch (stage.type) {
+        case StageType::Linear:
+            output = stage.params[0] * input + stage.params[1];
+            return true;
+
+        case StageType::Polynomial:
+            output = ((stage.params[3] * input + stage.params[2]) * input +
+                      stage.params[1]) * input + stage.params[0];
+            return true;
+
+        case StageType::Ema:
+            if (stage.count == 0) {
+                stage.state[0] = input;
+                stage.count = 1;
+            } else {
+                stage.state[0] += stage.params[0] * (input - stage.state[0]);
+            }
+            output = stage.state[0];
+            return true;
+
+        case StageType::Median:
+            pushSample(stage, input);
+            output = windowMedian(stage);
+            return true;
+
+        case StageType::Hampel: {
+            pushSample(stage, input);
+            output = input;
+            if (stage.count < 3) return true;
+
+            float med = windowMedian(stage);
+            float deviations[IOT_PIPELINE_MAX_WINDOW];
+            for (uint8_t i = 0; i < stage.count; i++) {
+                deviations[i] = fabsf(stage.state[i] - med);
+            }
+            float mad = MAD_SCALE * medianOf(deviations, stage.count);
+            if (fabsf(input - med) > stage.params[0] * mad) {
+                output = med;
+            }
+            return true;
+        }
+
+        case StageType::Range:
+            output = input;
+            return input >= stage.params[0] && input <= stage.params[1];
+
+        case StageType::None:
+        default:
+            output = input;
+            return true;
+    }
+}
+
+float SensorPipeline::windowMedian(const PipelineStage& stage) {
+    float sorted[IOT_PIPELINE_MAX_WINDOW];
+    memcpy(sorted, stage.state, stage.count * sizeof(float));
+    return medianOf(sorted, stage.count);
+}
+
+void SensorPipeline::pushSample(PipelineStage& stage, float value) {
+    stage.state[stage.head] = value;
+    stage.head = (stage.head + 1) % stage.window;
+    if (stage.count < stage.window) stage.count++;
+}
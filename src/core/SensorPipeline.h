@@ -0,0 +1,150 @@
+/**
+ * @file SensorPipeline.h
+ * @brief Per-sensor processing pipeline (calibration, conversion, filtering)
+ */
+
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <Arduino.h>
+
+#ifndef IOT_PIPELINE_MAX_STAGES
+#define IOT_PIPELINE_MAX_STAGES 4
+#endif
+
+#ifndef IOT_PIPELINE_MAX_WINDOW
+#define IOT_PIPELINE_MAX_WINDOW 9
+#endif
+
+/**
+ * @brief Stage kinds supported by the pipeline
+ */
+enum class StageType : uint8_t {
+    None,
+    Linear,      // y = gain * x + offset
+    Polynomial,  // y = c0 + c1*x + c2*x^2 + c3*x^3
+    Ema,         // exponential moving average
+    Median,      // sliding median
+    Hampel,      // sliding median outlier replacement
+    Range        // reject samples outside [min, max]
+};
+
+/**
+ * @brief One pipeline stage with its fixed-size state
+ */
+struct PipelineStage {
+    StageType type;
+    uint8_t window;     // Median/Hampel window length
+    uint8_t count;      // Samples currently held
+    uint8_t head;       // Next ring buffer slot
+    float params[4];    // Stage coefficients
+    float state[IOT_PIPELINE_MAX_WINDOW]; // Ring buffer (EMA uses state[0])
+};
+
+/**
+ * @brief Chain of processing stages applied to every raw sample
+ *
+ * All state is stored inline: processing a sample never allocates.
+ *
+ * @example
+ * brain.addSensor("soil", "moisture",
+ *                 SensorPipeline().linear(100.0f / 4095.0f, 0).median(5));
+ */
+class SensorPipeline {
+public:
+    SensorPipeline();
+
+    // =========================================================================
+    // Stage Builders
+    // =========================================================================
+
+    /**
+     * @brief Linear calibration: y = gain * x + offset
+     */
+    SensorPipeline& linear(float gain, float offset);
+
+    /**
+     * @brief Polynomial calibration: y = c[0] + c[1]*x + c[2]*x^2 + c[3]*x^3
+     * @param coeffs Coefficients, lowest order first
+     * @param count Number of coefficients (1 to 4)
+     */
+    SensorPipeline& polynomial(const float* coeffs, uint8_t count);
+
+    /**
+     * @brief Unit conversion by name (e.g., "c_to_f", "pa_to_hpa")
+     */
+    SensorPipeline& convert(const char* conversion);
+
+    /**
+     * @brief Exponential moving average
+     * @param alpha Smoothing factor in (0, 1], higher follows faster
+     */
+    SensorPipeline& ema(float alpha);
+
+    /**
+     * @brief Sliding median filter
+     * @param window Window length (1 to IOT_PIPELINE_MAX_WINDOW)
+     */
+    SensorPipeline& median(uint8_t window);
+
+    /**
+     * @brief Hampel filter: replaces outliers with the window median
+     * @param window Window length (3 to IOT_PIPELINE_MAX_WINDOW)
+     * @param threshold Outlier threshold in scaled MADs (typically 3)
+     */
+    SensorPipeline& hampel(uint8_t window, float threshold = 3.0f);
+
+    /**
+     * @brief Reject samples outside [min, max]
+     */
+    SensorPipeline& range(float min, float max);
+
+    // =========================================================================
+    // Processing
+    // =========================================================================
+
+    /**
+     * @brief Run a raw sample through all stages
+     * @param input Raw sample
+     * @param output Processed sample
+     * @return false if the sample was rejected and must not be published
+     */
+    bool process(float input, float& output);
+
+    /**
+     * @brief Clear filter state, keeping the stage configuration
+     */
+    void reset();
+
+    /**
+     * @brief Remove all stages
+     */
+    void clear();
+
+    /**
+     * @brief Number of configured stages
+     */
+    uint8_t stageCount() const { return _count; }
+
+    /**
+     * @brief false if a stage was refused (bad parameters or too many stages)
+     */
+    bool isValid() const { return _valid; }
+
+    /**
+     * @brief Stage type from its config name ("linear", "ema", ...)
+     */
+    static StageType stageTypeFromName(const char* name);
+
+private:
+    PipelineStage _stages[IOT_PIPELINE_MAX_STAGES];
+    uint8_t _count;
+    bool _valid;
+
+    PipelineStage* appendStage(StageType type);
+    static bool applyStage(PipelineStage& stage, float input, float& output);
+    static float windowMedian(const PipelineStage& stage);
+    static void pushSample(PipelineStage& stage, float value);
+};
+
+#endif // SENSOR_PIPELINE_H
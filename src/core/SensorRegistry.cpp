@@ -4,11 +4,41 @@
  */
 
 #include "SensorRegistry.h"
+#include "Clock.h"
 #include <cstring>
 #include <cstdio>
+#include <cmath>
+#include <cstdarg>
 
-SensorRegistry::SensorRegistry() {
+// snprintf at an offset that may already be past the end (then only counts)
+static size_t appendAt(char* buffer, size_t bufferSize, size_t written,
+                       const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = written < bufferSize
+                     ? vsnprintf(buffer + written, bufferSize - written, format, args)
+                     : vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+    return length > 0 ? (size_t)length : 0;
+}
+
+// Registered strings: copied (truncated) into arrays, kept as is in pointers
+template <size_t N>
+static void storeString(char (&field)[N], const char* value) {
+    strncpy(field, value, N - 1);
+    field[N - 1] = '\0';
+}
+
+static inline void storeString(const char*& field, const char* value) {
+    field = value;
+}
+
+SensorRegistry::SensorRegistry()
+    : _publishPhase(0), _intervalQuantumMs(0), _clockSynced(false), _clockOffsetMs(0),
+      _statusChanged(true) {
+#ifndef IOT_LOW_RAM
     _hardware.reserve(8); // Pre-allocate for typical use
+#endif
 }
 
 // =============================================================================
@@ -20,17 +50,24 @@ bool SensorRegistry::registerHardware(const char* key, const char* name) {
     if (hasHardware(key)) return false; // Already exists
     
     HardwareDef hw;
-    strncpy(hw.key, key, sizeof(hw.key) - 1);
-    hw.key[sizeof(hw.key) - 1] = '\0';
-    
-    strncpy(hw.name, name ? name : key, sizeof(hw.name) - 1);
-    hw.name[sizeof(hw.name) - 1] = '\0';
+    storeString(hw.key, key);
+    storeString(hw.name, name ? name : key);
     
     hw.enabled = true;
     hw.intervalMs = 60000; // Default 60s
-    hw.lastPublishTime = 0; // Initialize to 0 to allow immediate first publish
+    hw.lastPublishTime = 0; // Never published: first publish at the phase offset
+    memset(&hw.adaptive, 0, sizeof(hw.adaptive));
+    hw.overrideIntervalMs = 0;
+    hw.overrideUntil = 0;
+    hw.immediatePublish = false;
+    hw.configPriority = 0;
+    hw.reportPending = ReportField::All;
+    hw.aligned = false;
+    hw.alignedBoundary = 0;
+    hw.alignErrorMs = -1;
     
     _hardware.push_back(hw);
+    _statusChanged = true;
     return true;
 }
 
@@ -44,15 +81,68 @@ bool SensorRegistry::addSensor(const char* hardwareKey, const char* sensorType)
     if (hasSensor(hardwareKey, sensorType)) return false;
     
     SensorDef sensor;
-    strncpy(sensor.type, sensorType, sizeof(sensor.type) - 1);
-    sensor.type[sizeof(sensor.type) - 1] = '\0';
-    
-    strcpy(sensor.status, "missing");
+    storeString(sensor.type, sensorType);
+    sensor.status = "missing";
     sensor.lastValue = 0.0f;
     sensor.hasValue = false;
     sensor.lastUpdate = 0;
+    sensor.pipelineIndex = -1;
+    sensor.derivedIndex = -1;
+    sensor.firstDependent = -1;
+    sensor.prevSample = 0.0f;
+    sensor.prevSampleTime = 0;
     
     hw->sensors.push_back(sensor);
+    _statusChanged = true;
+    return true;
+}
+
+bool SensorRegistry::addSensor(const char* hardwareKey, const char* sensorType,
+                               const SensorPipeline& pipeline) {
+    if (!addSensor(hardwareKey, sensorType)) return false;
+    return setSensorPipeline(hardwareKey, sensorType, pipeline);
+}
+
+bool SensorRegistry::addDerivedSensor(const char* hardwareKey, const char* sensorType,
+                                      const char* const* inputs, uint8_t inputCount,
+                                      DerivedFunction compute) {
+    if (!inputs || inputCount == 0 || inputCount > IOT_DERIVED_MAX_INPUTS) return false;
+    if (!compute) return false;
+    
+    // Resolve inputs before creating the sensor so it can't depend on itself
+    DerivedDef derived;
+    derived.inputCount = inputCount;
+    for (uint8_t i = 0; i < inputCount; i++) {
+        if (!resolveSensor(inputs[i], derived.inputs[i])) return false;
+    }
+    
+    if (!addSensor(hardwareKey, sensorType)) return false;
+    
+    int hwIdx = findHardwareIndex(hardwareKey);
+    derived.output.hardware = static_cast<int16_t>(hwIdx);
+    derived.output.sensor = static_cast<int16_t>(_hardware[hwIdx].sensors.size() - 1);
+    derived.compute = compute;
+    
+    // Compute right away if every input already has a value
+    derived.dirty = false;
+    for (uint8_t i = 0; i < inputCount; i++) {
+        const SensorRef& in = derived.inputs[i];
+        if (_hardware[in.hardware].sensors[in.sensor].hasValue) derived.dirty = true;
+    }
+    
+    int16_t derivedIdx = static_cast<int16_t>(_derived.size());
+    _derived.push_back(derived);
+    _hardware[hwIdx].sensors.back().derivedIndex = derivedIdx;
+    
+    // Register the dependency edges on each input
+    for (uint8_t i = 0; i < inputCount; i++) {
+        SensorDef& input = _hardware[derived.inputs[i].hardware].sensors[derived.inputs[i].sensor];
+        DependencyEdge edge;
+        edge.derived = derivedIdx;
+        edge.next = input.firstDependent;
+        input.firstDependent = static_cast<int16_t>(_dependencies.size());
+        _dependencies.push_back(edge);
+    }
     return true;
 }
 
@@ -91,6 +181,45 @@ SensorDef* SensorRegistry::getSensor(const char* hardwareKey, const char* sensor
     return &hw->sensors[idx];
 }
 
+SensorPipeline* SensorRegistry::getPipeline(const char* hardwareKey, const char* sensorType) {
+    SensorDef* sensor = getSensor(hardwareKey, sensorType);
+    if (!sensor || sensor->pipelineIndex < 0) return nullptr;
+    return &_pipelines[sensor->pipelineIndex];
+}
+
+bool SensorRegistry::findSensorRef(const char* hardwareKey, const char* sensorType,
+                                   SensorRef& ref) const {
+    int hwIdx = findHardwareIndex(hardwareKey);
+    if (hwIdx < 0) return false;
+    int sensorIdx = findSensorIndex(_hardware[hwIdx], sensorType);
+    if (sensorIdx < 0) return false;
+    
+    ref.hardware = static_cast<int16_t>(hwIdx);
+    ref.sensor = static_cast<int16_t>(sensorIdx);
+    return true;
+}
+
+uint16_t SensorRegistry::getSensorTopicId(const char* hardwareKey,
+                                          const char* sensorType) const {
+    SensorRef ref;
+    if (!findSensorRef(hardwareKey, sensorType, ref)) return 0;
+    if (ref.hardware >= 255 || ref.sensor >= 255) return 0;
+    return (uint16_t)(((ref.hardware + 1) << 8) | (ref.sensor + 1));
+}
+
+bool SensorRegistry::resolveSensor(const char* compositeKey, SensorRef& ref) const {
+    char hwKey[32], sensorType[32];
+    if (!parseCompositeKey(compositeKey, hwKey, sensorType, sizeof(hwKey))) return false;
+    return findSensorRef(hwKey, sensorType, ref);
+}
+
+bool SensorRegistry::isDerived(const char* hardwareKey, const char* sensorType) const {
+    const HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw) return false;
+    int idx = findSensorIndex(*hw, sensorType);
+    return idx >= 0 && hw->sensors[idx].derivedIndex >= 0;
+}
+
 // =============================================================================
 // Composite Keys
 // =============================================================================
@@ -129,35 +258,103 @@ void SensorRegistry::updateSensorValue(const char* hardwareKey, const char* sens
     SensorDef* sensor = getSensor(hardwareKey, sensorType);
     if (!sensor) return;
     
+    // Derived sensors only need recomputing when the value actually moves
+    bool changed = !sensor->hasValue || sensor->lastValue != value;
+    
     sensor->lastValue = value;
     sensor->hasValue = true;
-    sensor->lastUpdate = millis();
+    sensor->lastUpdate = Clock::now();
     
     // Update status based on enabled state
     HardwareDef* hw = getHardware(hardwareKey);
+    const char* status;
     if (hw && !hw->enabled) {
-        strcpy(sensor->status, "disabled");
+        status = "disabled";
     } else if (!isnan(value)) {
-        strcpy(sensor->status, "ok");
+        status = "ok";
+    } else {
+        status = "missing";
+    }
+    if (strcmp(sensor->status, status) != 0) {
+        sensor->status = status;
+        _statusChanged = true;
+    }
+    
+    if (changed) {
+        markDependentsDirty(*sensor);
+        _statusChanged = true;
+    }
+}
+
+bool SensorRegistry::setSensorPipeline(const char* hardwareKey, const char* sensorType,
+                                       const SensorPipeline& pipeline) {
+    if (!pipeline.isValid()) return false;
+    
+    SensorDef* sensor = getSensor(hardwareKey, sensorType);
+    if (!sensor) return false;
+    
+    // Reuse the existing slot so repeated config updates don't grow the pool
+    if (sensor->pipelineIndex < 0) {
+        sensor->pipelineIndex = static_cast<int16_t>(_pipelines.size());
+        _pipelines.push_back(pipeline);
     } else {
-        strcpy(sensor->status, "missing");
+        _pipelines[sensor->pipelineIndex] = pipeline;
+    }
+    _pipelines[sensor->pipelineIndex].reset();
+    return true;
+}
+
+bool SensorRegistry::processSample(const char* hardwareKey, const char* sensorType,
+                                   float raw, float& processed) {
+    SensorPipeline* pipeline = getPipeline(hardwareKey, sensorType);
+    if (!pipeline) {
+        processed = raw;
+        return true;
     }
+    return pipeline->process(raw, processed);
+}
+
+bool SensorRegistry::computeNextDerived(const char*& hardwareKey, const char*& sensorType,
+                                        float& value) {
+    for (auto& derived : _derived) {
+        if (!derived.dirty) continue;
+        derived.dirty = false;
+        
+        float inputs[IOT_DERIVED_MAX_INPUTS];
+        bool valid = true;
+        for (uint8_t i = 0; i < derived.inputCount; i++) {
+            const SensorDef& in = _hardware[derived.inputs[i].hardware].sensors[derived.inputs[i].sensor];
+            inputs[i] = in.lastValue;
+            if (!in.hasValue || isnan(in.lastValue)) valid = false;
+        }
+        
+        const HardwareDef& hw = _hardware[derived.output.hardware];
+        hardwareKey = hw.key;
+        sensorType = hw.sensors[derived.output.sensor].type;
+        value = valid ? derived.compute(inputs, derived.inputCount) : NAN;
+        return true;
+    }
+    return false;
 }
 
 void SensorRegistry::setHardwareEnabled(const char* hardwareKey, bool enabled) {
     HardwareDef* hw = getHardware(hardwareKey);
     if (!hw) return;
     
+    if (hw->enabled != enabled) {
+        hw->reportPending |= ReportField::Enabled;
+        _statusChanged = true;
+    }
     hw->enabled = enabled;
     
     // Update all sensor statuses
     for (auto& sensor : hw->sensors) {
         if (!enabled) {
-            strcpy(sensor.status, "disabled");
+            sensor.status = "disabled";
         } else if (sensor.hasValue) {
-            strcpy(sensor.status, "ok");
+            sensor.status = "ok";
         } else {
-            strcpy(sensor.status, "missing");
+            sensor.status = "missing";
         }
     }
 }
@@ -170,15 +367,151 @@ bool SensorRegistry::isHardwareEnabled(const char* hardwareKey) const {
 void SensorRegistry::setHardwareInterval(const char* hardwareKey, int intervalMs) {
     HardwareDef* hw = getHardware(hardwareKey);
     if (hw) {
+        if (hw->intervalMs != intervalMs) hw->reportPending |= ReportField::Interval;
         hw->intervalMs = intervalMs;
     }
 }
 
+void SensorRegistry::setConfigPriority(const char* hardwareKey, uint8_t priority) {
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (hw) {
+        hw->configPriority = priority;
+    }
+}
+
+uint8_t SensorRegistry::getConfigPriority(const char* hardwareKey) const {
+    const HardwareDef* hw = getHardware(hardwareKey);
+    return hw ? hw->configPriority : 0;
+}
+
+bool SensorRegistry::setAdaptiveInterval(const char* hardwareKey, int minIntervalMs,
+                                         int maxIntervalMs, float changeRate) {
+    if (minIntervalMs <= 0 || maxIntervalMs < minIntervalMs || !(changeRate > 0.0f)) {
+        return false;
+    }
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw) return false;
+    
+    AdaptiveSampling& ad = hw->adaptive;
+    bool wasEnabled = ad.enabled;
+    if (!wasEnabled || ad.minIntervalMs != minIntervalMs ||
+        ad.maxIntervalMs != maxIntervalMs || ad.changeRate != changeRate) {
+        hw->reportPending |= ReportField::Adaptive;
+    }
+    ad.enabled = true;
+    ad.minIntervalMs = minIntervalMs;
+    ad.maxIntervalMs = maxIntervalMs;
+    ad.changeRate = changeRate;
+    if (!wasEnabled) {
+        // Start slow: the first fast change pulls the interval down
+        ad.activity = 0.0f;
+        ad.lastActivityUpdate = 0;
+        ad.averageIntervalMs = maxIntervalMs;
+    }
+    updateEffectiveInterval(ad);
+    return true;
+}
+
+void SensorRegistry::clearAdaptiveInterval(const char* hardwareKey) {
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (hw && hw->adaptive.enabled) {
+        hw->adaptive.enabled = false;
+        hw->reportPending |= ReportField::Adaptive;
+    }
+}
+
+void SensorRegistry::observeSample(const char* hardwareKey, const char* sensorType,
+                                   float value, unsigned long now) {
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw || !hw->adaptive.enabled || isnan(value)) return;
+    
+    int idx = findSensorIndex(*hw, sensorType);
+    if (idx < 0) return;
+    SensorDef& sensor = hw->sensors[idx];
+    AdaptiveSampling& ad = hw->adaptive;
+    
+    // Let past activity fade: halves every ADAPTIVE_HALF_LIFE_FACTOR min intervals
+    if (ad.lastActivityUpdate != 0) {
+        float halfLifeMs = (float)ad.minIntervalMs * ADAPTIVE_HALF_LIFE_FACTOR;
+        ad.activity *= powf(0.5f, (float)(now - ad.lastActivityUpdate) / halfLifeMs);
+    }
+    ad.lastActivityUpdate = now;
+    
+    if (sensor.prevSampleTime != 0 && now != sensor.prevSampleTime) {
+        float dtSeconds = (float)(now - sensor.prevSampleTime) / 1000.0f;
+        float rate = fabsf(value - sensor.prevSample) / dtSeconds;
+        float normalized = rate / ad.changeRate;
+        if (normalized > ad.activity) ad.activity = normalized;
+    }
+    sensor.prevSample = value;
+    sensor.prevSampleTime = now;
+    
+    updateEffectiveInterval(ad);
+}
+
+bool SensorRegistry::setIntervalOverride(const char* hardwareKey, int intervalMs,
+                                         unsigned long durationMs, unsigned long now) {
+    if (intervalMs <= 0 || durationMs == 0) return false;
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw) return false;
+    
+    if (hw->overrideIntervalMs != intervalMs) hw->reportPending |= ReportField::Burst;
+    hw->overrideIntervalMs = intervalMs;
+    hw->overrideUntil = now + durationMs;
+    return true;
+}
+
+bool SensorRegistry::clearIntervalOverride(const char* hardwareKey) {
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw || hw->overrideIntervalMs == 0) return false;
+    hw->overrideIntervalMs = 0;
+    hw->reportPending |= ReportField::Burst;
+    return true;
+}
+
+bool SensorRegistry::hasIntervalOverride(const char* hardwareKey) const {
+    const HardwareDef* hw = getHardware(hardwareKey);
+    return hw && hw->overrideIntervalMs > 0;
+}
+
+const char* SensorRegistry::expireNextOverride(unsigned long now) {
+    for (auto& hw : _hardware) {
+        // Signed difference keeps working across millis() rollover
+        if (hw.overrideIntervalMs > 0 && (long)(now - hw.overrideUntil) >= 0) {
+            hw.overrideIntervalMs = 0;
+            hw.reportPending |= ReportField::Burst;
+            return hw.key;
+        }
+    }
+    return nullptr;
+}
+
+int SensorRegistry::getEffectiveInterval(const char* hardwareKey) const {
+    const HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw) return 0;
+    return effectiveInterval(*hw);
+}
+
 bool SensorRegistry::canPublish(const char* hardwareKey) const {
+    return canPublish(hardwareKey, Clock::now());
+}
+
+bool SensorRegistry::canPublish(const char* hardwareKey, unsigned long now) const {
     const HardwareDef* hw = getHardware(hardwareKey);
     if (!hw) return false;
     
-    unsigned long now = millis();
+    // Aligned: publish once the wall clock crosses the next interval boundary
+    if (hw->aligned && _clockSynced) {
+        int interval = effectiveInterval(*hw);
+        if (interval <= 0) return true;
+        int64_t wall = wallClock(now);
+        return wall >= boundaryBefore(hw->alignedBoundary, interval) + interval;
+    }
+    
+    if (hw->lastPublishTime == 0) {
+        return now >= PeriodicTask::offsetFor(effectiveInterval(*hw), _publishPhase);
+    }
+    
     unsigned long elapsed = now - hw->lastPublishTime;
     
     // Handle millis() rollover (occurs every ~49 days)
@@ -186,16 +519,83 @@ bool SensorRegistry::canPublish(const char* hardwareKey) const {
         elapsed = (0xFFFFFFFF - hw->lastPublishTime) + now;
     }
     
-    return elapsed >= (unsigned long)hw->intervalMs;
+    return elapsed >= (unsigned long)effectiveInterval(*hw);
 }
 
 void SensorRegistry::updatePublishTime(const char* hardwareKey) {
+    updatePublishTime(hardwareKey, Clock::now());
+}
+
+void SensorRegistry::updatePublishTime(const char* hardwareKey, unsigned long now) {
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw) return;
+    
+    // Track the interval actually achieved so the reported config matches reality
+    if (hw->adaptive.enabled && hw->lastPublishTime != 0) {
+        int actual = (int)(now - hw->lastPublishTime);
+        hw->adaptive.averageIntervalMs += (actual - hw->adaptive.averageIntervalMs) / 8;
+    }
+    hw->lastPublishTime = now;
+    
+    if (hw->aligned && _clockSynced) {
+        int interval = effectiveInterval(*hw);
+        if (interval > 0) {
+            int64_t wall = wallClock(now);
+            hw->alignedBoundary = boundaryBefore(wall, interval);
+            hw->alignErrorMs = (long)(wall - hw->alignedBoundary);
+        }
+    }
+}
+
+void SensorRegistry::setClock(uint64_t epochMs, unsigned long now) {
+    _clockOffsetMs = (int64_t)epochMs - (int64_t)now;
+    bool firstSync = !_clockSynced;
+    _clockSynced = true;
+    
+    if (firstSync) {
+        for (auto& hw : _hardware) {
+            if (hw.aligned) anchorAligned(hw, now);
+        }
+    }
+}
+
+bool SensorRegistry::setAlignedSampling(const char* hardwareKey, bool aligned,
+                                        unsigned long now) {
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw) return false;
+    if (hw->aligned == aligned) return true;
+    
+    hw->aligned = aligned;
+    hw->alignErrorMs = -1;
+    hw->reportPending |= ReportField::Aligned;
+    if (aligned && _clockSynced) anchorAligned(*hw, now);
+    return true;
+}
+
+bool SensorRegistry::isAligned(const char* hardwareKey) const {
+    const HardwareDef* hw = getHardware(hardwareKey);
+    return hw && hw->aligned;
+}
+
+long SensorRegistry::getAlignmentError(const char* hardwareKey) const {
+    const HardwareDef* hw = getHardware(hardwareKey);
+    return hw ? hw->alignErrorMs : -1;
+}
+
+void SensorRegistry::requestImmediatePublish(const char* hardwareKey) {
     HardwareDef* hw = getHardware(hardwareKey);
     if (hw) {
-        hw->lastPublishTime = millis();
+        hw->immediatePublish = true;
     }
 }
 
+bool SensorRegistry::consumeImmediatePublish(const char* hardwareKey) {
+    HardwareDef* hw = getHardware(hardwareKey);
+    if (!hw || !hw->immediatePublish) return false;
+    hw->immediatePublish = false;
+    return true;
+}
+
 unsigned long SensorRegistry::getLastPublishTime(const char* hardwareKey) const {
     const HardwareDef* hw = getHardware(hardwareKey);
     return hw ? hw->lastPublishTime : 0;
@@ -205,75 +605,224 @@ unsigned long SensorRegistry::getLastPublishTime(const char* hardwareKey) const
 // Status Building
 // =============================================================================
 
-size_t SensorRegistry::buildStatusJson(char* buffer, size_t bufferSize) const {
+size_t SensorRegistry::buildStatusJson(char* buffer, size_t bufferSize,
+                                       const char* hardwareKey) const {
     size_t written = 0;
-    written += snprintf(buffer + written, bufferSize - written, "{");
+    written += appendAt(buffer, bufferSize, written, "{");
     
     bool firstSensor = true;
     
     for (const auto& hw : _hardware) {
+        if (hardwareKey && strcmp(hw.key, hardwareKey) != 0) continue;
+        
         for (const auto& sensor : hw.sensors) {
-            if (!firstSensor) {
-                written += snprintf(buffer + written, bufferSize - written, ",");
-            }
+            written = appendStatusEntry(buffer, bufferSize, written, hw, sensor, firstSensor);
             firstSensor = false;
-            
-            char compositeKey[64];
-            buildCompositeKey(hw.key, sensor.type, compositeKey, sizeof(compositeKey));
-            
-            // Determine effective status
-            const char* effectiveStatus = hw.enabled ? sensor.status : "disabled";
-            
-            if (sensor.hasValue && !isnan(sensor.lastValue)) {
-                written += snprintf(buffer + written, bufferSize - written,
-                    "\"%s\":{\"status\":\"%s\",\"value\":%.2f}",
-                    compositeKey, effectiveStatus, sensor.lastValue);
-            } else {
-                written += snprintf(buffer + written, bufferSize - written,
-                    "\"%s\":{\"status\":\"%s\",\"value\":null}",
-                    compositeKey, effectiveStatus);
-            }
         }
     }
     
-    written += snprintf(buffer + written, bufferSize - written, "}");
+    written += appendAt(buffer, bufferSize, written, "}");
     return written;
 }
 
-size_t SensorRegistry::buildConfigJson(char* buffer, size_t bufferSize) const {
+size_t SensorRegistry::buildStatusPart(char* buffer, size_t bufferSize, size_t& next) const {
     size_t written = 0;
-    written += snprintf(buffer + written, bufferSize - written, "{");
+    written += appendAt(buffer, bufferSize, written, "{");
     
-    bool firstSensor = true;
+    size_t index = 0;
+    size_t count = 0;
+    size_t resume = 0;
     
     for (const auto& hw : _hardware) {
-        // Convert intervalMs to seconds (backend expects seconds)
-        int intervalSeconds = hw.intervalMs / 1000;
-        if (intervalSeconds <= 0) intervalSeconds = 60; // Default 60s
-        
         for (const auto& sensor : hw.sensors) {
-            if (!firstSensor) {
-                written += snprintf(buffer + written, bufferSize - written, ",");
-            }
-            firstSensor = false;
-            
-            char compositeKey[64];
-            buildCompositeKey(hw.key, sensor.type, compositeKey, sizeof(compositeKey));
+            if (index++ < next || resume != 0) continue;
             
-            written += snprintf(buffer + written, bufferSize - written,
-                "\"%s\":{\"interval\":%d,\"enabled\":%s}",
-                compositeKey, intervalSeconds, hw.enabled ? "true" : "false");
+            // Whole entries only, leaving room for the closing brace
+            size_t end = appendStatusEntry(buffer, bufferSize, written, hw, sensor, count == 0);
+            if (end + 1 < bufferSize) {
+                written = end;
+                count++;
+            } else if (count > 0 && end - written + 1 < bufferSize) {
+                // Fits the next part, without its comma
+                resume = index - 1;
+            }
+            // Else larger than a whole part: can never be sent, skipped
         }
     }
     
-    written += snprintf(buffer + written, bufferSize - written, "}");
+    written += appendAt(buffer, bufferSize, written, "}");
+    next = resume;
+    return written;
+}
+
+bool SensorRegistry::consumeStatusChange() {
+    bool changed = _statusChanged;
+    _statusChanged = false;
+    return changed;
+}
+
+void SensorRegistry::shrinkToFit() {
+    _hardware.shrink_to_fit();
+    for (auto& hw : _hardware) {
+        hw.sensors.shrink_to_fit();
+    }
+    _pipelines.shrink_to_fit();
+    _derived.shrink_to_fit();
+    _dependencies.shrink_to_fit();
+}
+
+size_t SensorRegistry::buildReportedJson(char* buffer, size_t bufferSize, bool full,
+                                         size_t* included) const {
+    size_t written = 0;
+    size_t count = 0;
+    written += snprintf(buffer + written, bufferSize - written, "{");
+    
+    for (const auto& hw : _hardware) {
+        uint8_t fields = full ? ReportField::All : hw.reportPending;
+        if (fields == 0) continue;
+        
+        // Whole entries only, leaving room for the closing brace
+        size_t end = appendReportedEntry(buffer, bufferSize, written, hw, fields, count == 0);
+        if (end + 1 >= bufferSize) break;
+        written = end;
+        count++;
+    }
+    
+    if (written < bufferSize) {
+        written += snprintf(buffer + written, bufferSize - written, "}");
+    }
+    if (included) *included = count;
     return written;
 }
 
+bool SensorRegistry::hasPendingReport() const {
+    for (const auto& hw : _hardware) {
+        if (hw.reportPending != 0) return true;
+    }
+    return false;
+}
+
+void SensorRegistry::clearPendingReport() {
+    for (auto& hw : _hardware) {
+        hw.reportPending = 0;
+    }
+}
+
+void SensorRegistry::clearPendingReport(size_t count) {
+    for (auto& hw : _hardware) {
+        if (count == 0) break;
+        if (hw.reportPending == 0) continue;
+        hw.reportPending = 0;
+        count--;
+    }
+}
+
+void SensorRegistry::markReportPending() {
+    for (auto& hw : _hardware) {
+        hw.reportPending = ReportField::All;
+    }
+}
+
 // =============================================================================
 // Private Helpers
 // =============================================================================
 
+size_t SensorRegistry::appendStatusEntry(char* buffer, size_t bufferSize, size_t written,
+                                         const HardwareDef& hw, const SensorDef& sensor,
+                                         bool first) {
+    char compositeKey[64];
+    buildCompositeKey(hw.key, sensor.type, compositeKey, sizeof(compositeKey));
+    
+    // Determine effective status
+    const char* effectiveStatus = hw.enabled ? sensor.status : "disabled";
+    
+    if (sensor.hasValue && !isnan(sensor.lastValue)) {
+        return written + appendAt(buffer, bufferSize, written,
+            "%s\"%s\":{\"status\":\"%s\",\"value\":%.2f}",
+            first ? "" : ",", compositeKey, effectiveStatus, sensor.lastValue);
+    }
+    return written + appendAt(buffer, bufferSize, written,
+        "%s\"%s\":{\"status\":\"%s\",\"value\":null}",
+        first ? "" : ",", compositeKey, effectiveStatus);
+}
+
+size_t SensorRegistry::appendReportedEntry(char* buffer, size_t bufferSize, size_t written,
+                                           const HardwareDef& hw, uint8_t fields,
+                                           bool first) const {
+    written += appendAt(buffer, bufferSize, written, "%s\"%s\":{", first ? "" : ",", hw.key);
+
+    // Fields are written in a fixed order; only the first one has no comma
+    const char* sep = "";
+    if (fields & ReportField::Interval) {
+        written += appendAt(buffer, bufferSize, written, "\"interval\":%d", hw.intervalMs / 1000);
+        sep = ",";
+    }
+    if (fields & ReportField::Enabled) {
+        written += appendAt(buffer, bufferSize, written, "%s\"enabled\":%s", sep,
+                            hw.enabled ? "true" : "false");
+        sep = ",";
+    }
+    if (fields & ReportField::Adaptive) {
+        if (hw.adaptive.enabled) {
+            written += appendAt(buffer, bufferSize, written,
+                "%s\"adaptive\":{\"min\":%d,\"max\":%d,\"rate\":%.3g,\"avg\":%d}", sep,
+                hw.adaptive.minIntervalMs / 1000, hw.adaptive.maxIntervalMs / 1000,
+                hw.adaptive.changeRate, hw.adaptive.averageIntervalMs / 1000);
+        } else {
+            written += appendAt(buffer, bufferSize, written, "%s\"adaptive\":false", sep);
+        }
+        sep = ",";
+    }
+    if (fields & ReportField::Burst) {
+        if (hw.overrideIntervalMs > 0) {
+            written += appendAt(buffer, bufferSize, written, "%s\"burst\":{\"interval\":%d}",
+                                sep, hw.overrideIntervalMs / 1000);
+        } else {
+            written += appendAt(buffer, bufferSize, written, "%s\"burst\":null", sep);
+        }
+        sep = ",";
+    }
+    if (fields & ReportField::Aligned) {
+        written += appendAt(buffer, bufferSize, written, "%s\"aligned\":%s", sep,
+                            hw.aligned ? "true" : "false");
+    }
+    written += appendAt(buffer, bufferSize, written, "}");
+    return written;
+}
+
+void SensorRegistry::updateEffectiveInterval(AdaptiveSampling& ad) {
+    // Linear between max (no activity) and min (activity at or above 1)
+    float level = ad.activity < 1.0f ? ad.activity : 1.0f;
+    ad.effectiveIntervalMs = ad.maxIntervalMs -
+                             (int)((ad.maxIntervalMs - ad.minIntervalMs) * level);
+}
+
+int SensorRegistry::effectiveInterval(const HardwareDef& hw) const {
+    if (hw.overrideIntervalMs > 0) return hw.overrideIntervalMs;
+    int interval = baseInterval(hw);
+    // Power saving: long intervals become whole numbers of radio windows
+    if (_intervalQuantumMs > 0 && interval > _intervalQuantumMs) {
+        interval = ((interval + _intervalQuantumMs - 1) / _intervalQuantumMs) * _intervalQuantumMs;
+    }
+    return interval;
+}
+
+void SensorRegistry::anchorAligned(HardwareDef& hw, unsigned long now) {
+    // First aligned publish waits for the next boundary, never mid-interval
+    int interval = effectiveInterval(hw);
+    if (interval > 0) {
+        hw.alignedBoundary = boundaryBefore(wallClock(now), interval);
+    }
+}
+
+int64_t SensorRegistry::boundaryBefore(int64_t wall, int intervalMs) {
+    return wall - wall % intervalMs;
+}
+
+int SensorRegistry::baseInterval(const HardwareDef& hw) {
+    return hw.adaptive.enabled ? hw.adaptive.effectiveIntervalMs : hw.intervalMs;
+}
+
 int SensorRegistry::findHardwareIndex(const char* key) const {
     for (size_t i = 0; i < _hardware.size(); i++) {
         if (strcmp(_hardware[i].key, key) == 0) {
@@ -283,6 +832,12 @@ int SensorRegistry::findHardwareIndex(const char* key) const {
     return -1;
 }
 
+void SensorRegistry::markDependentsDirty(const SensorDef& sensor) {
+    for (int16_t e = sensor.firstDependent; e >= 0; e = _dependencies[e].next) {
+        _derived[_dependencies[e].derived].dirty = true;
+    }
+}
+
 int SensorRegistry::findSensorIndex(const HardwareDef& hw, const char* sensorType) const {
     for (size_t i = 0; i < hw.sensors.size(); i++) {
         if (strcmp(hw.sensors[i].type, sensorType) == 0) {
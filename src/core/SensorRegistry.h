@@ -7,29 +7,122 @@
 #define SENSOR_REGISTRY_H
 
 #include <Arduino.h>
+#include "Callback.h"
 #include <vector>
 #include <map>
+#include "PeriodicTask.h"
+#include "SensorPipeline.h"
+
+#ifndef IOT_DERIVED_MAX_INPUTS
+#define IOT_DERIVED_MAX_INPUTS 4
+#endif
+
+/**
+ * @brief Function computing a derived value from its input values
+ * @param inputs Input values, in declaration order
+ * @param count Number of inputs
+ */
+using DerivedFunction = Callback<float(const float* inputs, uint8_t count)>;
 
 /**
  * @brief Sensor definition
  */
 struct SensorDef {
+#ifdef IOT_LOW_RAM
+    const char* type;   // Registered string, not copied (must outlive the registry)
+#else
     char type[32];      // e.g., "temperature", "humidity"
-    char status[16];    // "ok", "missing", "disabled"
+#endif
+    const char* status; // "ok", "missing", "disabled" (static strings)
     float lastValue;
-    bool hasValue;
+    float prevSample;       // Previous raw sample, for adaptive sampling
     unsigned long lastUpdate;
+    unsigned long prevSampleTime; // 0 until a first sample was observed
+    int16_t pipelineIndex; // Index into the registry pipelines, -1 if none
+    int16_t derivedIndex;  // Index into the derived definitions, -1 if physical
+    int16_t firstDependent; // Head of the dependency edge list, -1 if none
+    bool hasValue;
+};
+
+/**
+ * @brief Stable reference to a sensor (indices never move once registered)
+ */
+struct SensorRef {
+    int16_t hardware;
+    int16_t sensor;
 };
 
+/**
+ * @brief Derived sensor computed from other registry sensors
+ */
+struct DerivedDef {
+    SensorRef output;
+    SensorRef inputs[IOT_DERIVED_MAX_INPUTS];
+    uint8_t inputCount;
+    bool dirty;         // An input changed since the last computation
+    DerivedFunction compute;
+};
+
+/**
+ * @brief Edge in the per-sensor list of dependent derived sensors
+ */
+struct DependencyEdge {
+    int16_t derived;    // Index into the derived definitions
+    int16_t next;       // Next edge for the same input, -1 at end
+};
+
+/**
+ * @brief Adaptive sampling settings and state of a hardware
+ *
+ * The effective interval moves between minIntervalMs (fast changes) and
+ * maxIntervalMs (stable signal) based on the recent rate of change.
+ */
+struct AdaptiveSampling {
+    bool enabled;
+    int minIntervalMs;
+    int maxIntervalMs;
+    float changeRate;       // Rate of change (units/s) that selects minIntervalMs
+    float activity;         // Decaying peak of rate / changeRate
+    unsigned long lastActivityUpdate;
+    int effectiveIntervalMs;
+    int averageIntervalMs;  // Smoothed interval between actual publishes
+};
+
+/**
+ * @brief Config fields of a hardware, as tracked for shadow reports
+ */
+namespace ReportField {
+    const uint8_t Interval = 0x01;
+    const uint8_t Enabled = 0x02;
+    const uint8_t Adaptive = 0x04;
+    const uint8_t Burst = 0x08;
+    const uint8_t Aligned = 0x10;
+    const uint8_t All = 0x1F;
+}
+
 /**
  * @brief Hardware definition with its sensors
  */
 struct HardwareDef {
+#ifdef IOT_LOW_RAM
+    const char* key;    // Registered strings, not copied (must outlive the registry)
+    const char* name;
+#else
     char key[32];       // e.g., "dht22"
     char name[64];      // e.g., "DHT22 Temperature/Humidity Sensor"
+#endif
     bool enabled;
     int intervalMs;
     unsigned long lastPublishTime;  // Last time data was published for this hardware
+    AdaptiveSampling adaptive;
+    int overrideIntervalMs;         // Temporary (burst) interval, 0 if none
+    unsigned long overrideUntil;    // Time at which the override expires
+    bool immediatePublish;          // Next publish bypasses the interval
+    uint8_t configPriority;         // Priority of the source that last configured it
+    uint8_t reportPending;          // ReportField bits changed since the last report
+    bool aligned;                   // Publish on wall-clock multiples of the interval
+    int64_t alignedBoundary;        // Wall-clock boundary of the last publish
+    long alignErrorMs;              // Delay of the last aligned publish after its boundary
     std::vector<SensorDef> sensors;
 };
 
@@ -46,6 +139,11 @@ public:
     
     /**
      * @brief Register a new hardware
+     *
+     * With IOT_LOW_RAM, key and name are kept as pointers instead of
+     * copies: pass string literals (or strings that outlive the registry).
+     * The same applies to sensor types.
+     *
      * @param key Unique hardware key
      * @param name Human-readable name
      * @return true if registered successfully
@@ -60,6 +158,33 @@ public:
      */
     bool addSensor(const char* hardwareKey, const char* sensorType);
 
+    /**
+     * @brief Add a sensor with a processing pipeline
+     * @param hardwareKey Hardware to add sensor to
+     * @param sensorType Type of sensor measurement
+     * @param pipeline Stages applied to every raw sample
+     * @return true if added successfully
+     */
+    bool addSensor(const char* hardwareKey, const char* sensorType,
+                   const SensorPipeline& pipeline);
+
+    /**
+     * @brief Add a sensor computed from other sensors
+     *
+     * The sensor is recomputed only when one of its inputs changes.
+     * Inputs must already be registered, which also rules out cycles.
+     *
+     * @param hardwareKey Hardware to add the derived sensor to
+     * @param sensorType Type of the derived measurement (e.g., "vpd")
+     * @param inputs Composite keys of the inputs (e.g., "dht22:temperature")
+     * @param inputCount Number of inputs (1 to IOT_DERIVED_MAX_INPUTS)
+     * @param compute Function computing the value from the inputs
+     * @return true if added successfully
+     */
+    bool addDerivedSensor(const char* hardwareKey, const char* sensorType,
+                          const char* const* inputs, uint8_t inputCount,
+                          DerivedFunction compute);
+
     // =========================================================================
     // Queries
     // =========================================================================
@@ -86,6 +211,40 @@ public:
      */
     SensorDef* getSensor(const char* hardwareKey, const char* sensorType);
 
+    /**
+     * @brief Get the pipeline attached to a sensor
+     * @return Pointer to pipeline or nullptr
+     */
+    SensorPipeline* getPipeline(const char* hardwareKey, const char* sensorType);
+
+    /**
+     * @brief Resolve a sensor to its stable reference
+     * @return true if the sensor exists
+     */
+    bool findSensorRef(const char* hardwareKey, const char* sensorType,
+                       SensorRef& ref) const;
+
+    /**
+     * @brief Stable topic ID of a sensor value topic (e.g., MQTT-SN predefined IDs)
+     *
+     * (hardware index + 1) * 256 + sensor index + 1, in registration order,
+     * so a gateway table can be derived from the registration code.
+     *
+     * @return Topic ID, 0 if the sensor is unknown or beyond 255/255
+     */
+    uint16_t getSensorTopicId(const char* hardwareKey, const char* sensorType) const;
+
+    /**
+     * @brief Resolve a composite key (hardware:sensor) to a stable reference
+     * @return true if the sensor exists
+     */
+    bool resolveSensor(const char* compositeKey, SensorRef& ref) const;
+
+    /**
+     * @brief Check if a sensor is derived from other sensors
+     */
+    bool isDerived(const char* hardwareKey, const char* sensorType) const;
+
     // =========================================================================
     // Composite Keys
     // =========================================================================
@@ -122,6 +281,38 @@ public:
     void updateSensorValue(const char* hardwareKey, const char* sensorType, 
                            float value);
     
+    /**
+     * @brief Attach or replace the processing pipeline of a sensor
+     * @return true if the sensor exists and the pipeline is valid
+     */
+    bool setSensorPipeline(const char* hardwareKey, const char* sensorType,
+                           const SensorPipeline& pipeline);
+
+    /**
+     * @brief Run a raw sample through the sensor pipeline
+     * @param hardwareKey Hardware key
+     * @param sensorType Sensor type
+     * @param raw Raw sample
+     * @param processed Output value (raw if the sensor has no pipeline)
+     * @return false if the pipeline rejected the sample
+     */
+    bool processSample(const char* hardwareKey, const char* sensorType,
+                       float raw, float& processed);
+
+    /**
+     * @brief Compute the next derived sensor whose inputs changed
+     *
+     * Clears the sensor's dirty flag. The caller publishes the value, which
+     * in turn marks sensors derived from it dirty.
+     *
+     * @param hardwareKey Output hardware key of the derived sensor
+     * @param sensorType Output sensor type of the derived sensor
+     * @param value Computed value (NAN if an input has no valid value)
+     * @return false when no derived sensor is pending
+     */
+    bool computeNextDerived(const char*& hardwareKey, const char*& sensorType,
+                            float& value);
+
     /**
      * @brief Set hardware enabled state
      */
@@ -137,18 +328,172 @@ public:
      */
     void setHardwareInterval(const char* hardwareKey, int intervalMs);
     
+    /**
+     * @brief Set the priority of the config source that last configured a hardware
+     */
+    void setConfigPriority(const char* hardwareKey, uint8_t priority);
+    
+    /**
+     * @brief Get the priority of the config source that last configured a hardware
+     * @return Priority, 0 if never configured remotely
+     */
+    uint8_t getConfigPriority(const char* hardwareKey) const;
+    
+    /**
+     * @brief Enable adaptive sampling for a hardware
+     * @param hardwareKey Hardware key
+     * @param minIntervalMs Interval used while the signal changes quickly
+     * @param maxIntervalMs Interval used while the signal is stable
+     * @param changeRate Rate of change (units per second) considered fast
+     * @return true if the settings are valid and applied
+     */
+    bool setAdaptiveInterval(const char* hardwareKey, int minIntervalMs,
+                             int maxIntervalMs, float changeRate);
+    
+    /**
+     * @brief Disable adaptive sampling (back to the fixed interval)
+     */
+    void clearAdaptiveInterval(const char* hardwareKey);
+    
+    /**
+     * @brief Record a raw sample for adaptive sampling
+     *
+     * Must see every sample, including the ones that will be throttled.
+     */
+    void observeSample(const char* hardwareKey, const char* sensorType,
+                       float value, unsigned long now);
+    
+    /**
+     * @brief Apply a temporary interval that expires on its own
+     *
+     * The override takes precedence over fixed and adaptive intervals and
+     * is never persisted.
+     *
+     * @param hardwareKey Hardware key
+     * @param intervalMs Temporary interval
+     * @param durationMs How long the override lasts
+     * @param now Current time in ms
+     * @return true if applied
+     */
+    bool setIntervalOverride(const char* hardwareKey, int intervalMs,
+                             unsigned long durationMs, unsigned long now);
+    
+    /**
+     * @brief Remove a temporary interval
+     * @return true if an override was active
+     */
+    bool clearIntervalOverride(const char* hardwareKey);
+    
+    /**
+     * @brief Check if a temporary interval is active
+     */
+    bool hasIntervalOverride(const char* hardwareKey) const;
+    
+    /**
+     * @brief Expire the next elapsed override
+     * @param now Current time in ms
+     * @return Key of the hardware whose override expired, nullptr if none
+     */
+    const char* expireNextOverride(unsigned long now);
+    
+    /**
+     * @brief Get the interval currently applied to a hardware
+     * @return Override if active, else adaptive interval if enabled,
+     *         else fixed interval
+     */
+    int getEffectiveInterval(const char* hardwareKey) const;
+    
     /**
      * @brief Check if enough time has passed since last publish for this hardware
      * @param hardwareKey Hardware to check
      * @return true if publish is allowed based on interval
      */
     bool canPublish(const char* hardwareKey) const;
+    bool canPublish(const char* hardwareKey, unsigned long now) const;
+    
+    /**
+     * @brief Set the publish phase shared by all hardware
+     *
+     * The first publish of a hardware is allowed once millis() reaches its
+     * phase offset (interval * phase / IOT_PHASE_STEPS); later publishes
+     * keep the interval from there, so modules with different phases
+     * publish at different points of the interval.
+     *
+     * @param phase Phase in per-mille (0-999)
+     */
+    void setPublishPhase(uint16_t phase) { _publishPhase = phase % IOT_PHASE_STEPS; }
+    
+    /**
+     * @brief Round intervals longer than a quantum up to whole multiples of it
+     *
+     * Used by power saving so publishes line up with radio windows. Burst
+     * overrides are not rounded.
+     *
+     * @param quantumMs Quantum in ms (0 disables rounding)
+     */
+    void setIntervalQuantum(int quantumMs) { _intervalQuantumMs = quantumMs > 0 ? quantumMs : 0; }
+    
+    /**
+     * @brief Provide the synchronized wall clock (e.g., from NTP)
+     *
+     * Can be called again on every resync; aligned schedules keep their
+     * boundaries.
+     *
+     * @param epochMs Wall-clock time in ms since the Unix epoch
+     * @param now millis() at which epochMs was taken
+     */
+    void setClock(uint64_t epochMs, unsigned long now);
+    
+    /**
+     * @brief Check if a synchronized clock was provided
+     */
+    bool hasClock() const { return _clockSynced; }
+    
+    /**
+     * @brief Publish a hardware on wall-clock boundaries
+     *
+     * With a 60 s interval samples are taken at :00 of every minute on every
+     * module. Without a synchronized clock the hardware keeps the regular
+     * interval (and phase) schedule. The first aligned publish waits for the
+     * next boundary.
+     *
+     * @param hardwareKey Hardware key
+     * @param aligned true to align on the wall clock
+     * @param now Current time in ms
+     * @return true if the hardware exists
+     */
+    bool setAlignedSampling(const char* hardwareKey, bool aligned, unsigned long now);
+    
+    /**
+     * @brief Check if a hardware publishes on wall-clock boundaries
+     */
+    bool isAligned(const char* hardwareKey) const;
+    
+    /**
+     * @brief Delay of the last aligned publish after its boundary
+     * @return Error in ms, -1 if the hardware did not publish aligned yet
+     */
+    long getAlignmentError(const char* hardwareKey) const;
     
     /**
      * @brief Update the last publish time for a hardware
      * @param hardwareKey Hardware to update
      */
     void updatePublishTime(const char* hardwareKey);
+    void updatePublishTime(const char* hardwareKey, unsigned long now);
+    
+    /**
+     * @brief Let the next publish of a hardware bypass its interval
+     *
+     * Used for on-demand reads. The flag is consumed by the next publish.
+     */
+    void requestImmediatePublish(const char* hardwareKey);
+    
+    /**
+     * @brief Consume a pending immediate publish request
+     * @return true if a request was pending
+     */
+    bool consumeImmediatePublish(const char* hardwareKey);
     
     /**
      * @brief Get the last publish time for a hardware
@@ -164,18 +509,83 @@ public:
      * @brief Build status JSON for all sensors
      * @param buffer Output buffer
      * @param bufferSize Buffer size
+     * @param hardwareKey Only include this hardware (nullptr for all)
      * @return Number of bytes written
      */
-    size_t buildStatusJson(char* buffer, size_t bufferSize) const;
+    size_t buildStatusJson(char* buffer, size_t bufferSize,
+                           const char* hardwareKey = nullptr) const;
     
     /**
-     * @brief Build config JSON for all sensors (intervals)
+     * @brief Build status JSON for part of the sensors
+     *
+     * Only whole sensor entries are written, from the next-th sensor on: the
+     * ones that do not fit are left for the next part. An entry larger than
+     * a whole part is skipped.
+     *
      * @param buffer Output buffer
      * @param bufferSize Buffer size
+     * @param next Sensor to start from, advanced past the entries written
+     *             and reset to 0 once the last sensor is written
      * @return Number of bytes written
      */
-    size_t buildConfigJson(char* buffer, size_t bufferSize) const;
+    size_t buildStatusPart(char* buffer, size_t bufferSize, size_t& next) const;
     
+    /**
+     * @brief Check and clear the status change flag
+     *
+     * Set whenever something in the status JSON changes: a value, a sensor
+     * status, an enabled state or a new sensor.
+     *
+     * @return true if the status changed since the previous call
+     */
+    bool consumeStatusChange();
+    
+    /**
+     * @brief Build the reported config of each hardware
+     *
+     * Uses the same shape as a desired config:
+     * { "dht22": { "interval": 60, "enabled": true, "adaptive": false, "burst": null } }
+     *
+     * Only whole hardware entries are written: the ones that do not fit are
+     * left for the next document.
+     *
+     * @param buffer Output buffer
+     * @param bufferSize Buffer size
+     * @param full Report every field, else only fields changed since the last report
+     * @param included Set to the number of hardware entries written
+     * @return Number of bytes written
+     */
+    size_t buildReportedJson(char* buffer, size_t bufferSize, bool full,
+                             size_t* included = nullptr) const;
+    
+    /**
+     * @brief Check if any config field changed since the last report
+     */
+    bool hasPendingReport() const;
+    
+    /**
+     * @brief Mark all config changes as reported
+     */
+    void clearPendingReport();
+    
+    /**
+     * @brief Mark the changes of the first count pending hardware as reported
+     */
+    void clearPendingReport(size_t count);
+    
+    /**
+     * @brief Mark every field of every hardware as changed (full report)
+     */
+    void markReportPending();
+    
+    /**
+     * @brief Release the spare capacity of the registry vectors
+     *
+     * Called once registration is over; vectors grow by doubling, so up to
+     * half of each one is otherwise unused.
+     */
+    void shrinkToFit();
+
     /**
      * @brief Get all hardware definitions
      */
@@ -183,9 +593,33 @@ public:
 
 private:
     std::vector<HardwareDef> _hardware;
+    std::vector<SensorPipeline> _pipelines;
+    std::vector<DerivedDef> _derived;
+    std::vector<DependencyEdge> _dependencies;
+    uint16_t _publishPhase;
+    int _intervalQuantumMs;
+    bool _clockSynced;
+    int64_t _clockOffsetMs;     // Wall clock minus millis()
+    bool _statusChanged;
+    
+    int64_t wallClock(unsigned long now) const { return (int64_t)now + _clockOffsetMs; }
+    void anchorAligned(HardwareDef& hw, unsigned long now);
+    static int64_t boundaryBefore(int64_t wall, int intervalMs);
     
     int findHardwareIndex(const char* key) const;
     int findSensorIndex(const HardwareDef& hw, const char* sensorType) const;
+    void markDependentsDirty(const SensorDef& sensor);
+    int effectiveInterval(const HardwareDef& hw) const;
+    static int baseInterval(const HardwareDef& hw);
+    static void updateEffectiveInterval(AdaptiveSampling& adaptive);
+    size_t appendReportedEntry(char* buffer, size_t bufferSize, size_t written,
+                               const HardwareDef& hw, uint8_t fields, bool first) const;
+    static size_t appendStatusEntry(char* buffer, size_t bufferSize, size_t written,
+                                    const HardwareDef& hw, const SensorDef& sensor,
+                                    bool first);
+    
+    // Activity half-life, in multiples of the adaptive min interval
+    static constexpr float ADAPTIVE_HALF_LIFE_FACTOR = 4.0f;
 };
 
 #endif // SENSOR_REGISTRY_H
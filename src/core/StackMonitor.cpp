@@ -0,0 +1,98 @@
+/**
+ * @file StackMonitor.cpp
+ * @brief Implementation of StackMonitor
+ */
+
+#include "StackMonitor.h"
+#include <cstring>
+
+StackMonitor::StackMonitor() {
+    memset(_depth, 0, sizeof(_depth));
+}
+
+void StackMonitor::record(StackEntry entry, size_t depth) {
+    if (depth > _depth[(uint8_t)entry]) _depth[(uint8_t)entry] = depth;
+}
+
+size_t StackMonitor::taskFreeMin() {
+#if IOT_STACK_WATERMARK
+    return uxTaskGetStackHighWaterMark(nullptr);   // Bytes on ESP-IDF
+#else
+    return 0;
+#endif
+}
+
+const char* StackMonitor::metricName(StackEntry entry) {
+    switch (entry) {
+        case StackEntry::Begin: return "stackBegin";
+        case StackEntry::Loop: return "stackLoop";
+        case StackEntry::Message: return "stackMessage";
+        case StackEntry::Publish: return "stackPublish";
+        default: return "stack";
+    }
+}
+
+#if IOT_STACK_MONITOR
+
+#if IOT_STACK_WATERMARK
+
+void StackProbe::begin() {
+    _freeBefore = StackMonitor::taskFreeMin();
+}
+
+void StackProbe::end() {
+    // Lowest address ever reached by the task, known only when it moved
+    size_t freeAfter = StackMonitor::taskFreeMin();
+    if (freeAfter >= _freeBefore) return;
+    uintptr_t lowest = (uintptr_t)pxTaskGetStackStart(nullptr) + freeAfter;
+    if (lowest < _top) _monitor.record(_entry, _top - lowest);
+}
+
+#else
+
+static const uint8_t PAINT = 0xA5;
+static uintptr_t paintBottom = 0;
+
+// Open probes, and the lowest address reached since the innermost opened
+static uint8_t probing = 0;
+static uintptr_t reached = UINTPTR_MAX;
+
+// Below the caller's frame: the area the entry point is about to use
+static void __attribute__((noinline, no_sanitize_address)) paintStack() {
+    volatile uint8_t area[IOT_STACK_PAINT_BYTES];
+    for (size_t i = 0; i < sizeof(area); i++) area[i] = PAINT;
+    paintBottom = (uintptr_t)&area[0];
+}
+
+// Lowest byte no longer painted; the local area keeps the scan inside the stack
+static uintptr_t __attribute__((noinline, no_sanitize_address)) lowestTouched() {
+    volatile uint8_t area[IOT_STACK_PAINT_BYTES + 512];
+    const volatile uint8_t* p = (const volatile uint8_t*)paintBottom;
+    const volatile uint8_t* top = area + sizeof(area);
+    while (p < top && *p == PAINT) p++;
+    return (uintptr_t)p;
+}
+
+void StackProbe::begin() {
+    // Repainting erases what the open probes used: keep it for them
+    if (probing > 0) {
+        uintptr_t lowest = lowestTouched();
+        if (lowest < reached) reached = lowest;
+    }
+    _reached = reached;
+    reached = UINTPTR_MAX;
+    probing++;
+    paintStack();
+}
+
+void StackProbe::end() {
+    uintptr_t lowest = lowestTouched();
+    if (reached < lowest) lowest = reached;
+    if (lowest < _top) _monitor.record(_entry, _top - lowest);
+    probing--;
+    reached = _reached < lowest ? _reached : lowest;
+}
+
+#endif // IOT_STACK_WATERMARK
+
+#endif // IOT_STACK_MONITOR
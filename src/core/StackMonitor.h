@@ -0,0 +1,125 @@
+/**
+ * @file StackMonitor.h
+ * @brief Stack depth reached by each library entry point
+ */
+
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#ifndef IOT_STACK_MONITOR
+#if defined(ESP32) || defined(NATIVE_BUILD) || defined(IOT_POSIX)
+#define IOT_STACK_MONITOR 1
+#else
+#define IOT_STACK_MONITOR 0
+#endif
+#endif
+
+// FreeRTOS watermarks on ESP32, stack painting elsewhere
+#if defined(ESP32) && !defined(NATIVE_BUILD)
+#define IOT_STACK_WATERMARK 1
+#else
+#define IOT_STACK_WATERMARK 0
+#endif
+
+#ifndef IOT_STACK_PAINT_BYTES
+#define IOT_STACK_PAINT_BYTES 16384     // Area painted below an entry point
+#endif
+
+/**
+ * @brief Library entry points, called from user code or MQTT callbacks
+ */
+enum class StackEntry : uint8_t {
+    Begin = 0,
+    Loop,
+    Message,        // MQTT message callback (network task on ESP32)
+    Publish,
+    Count
+};
+
+/**
+ * @brief Deepest stack use of each entry point
+ *
+ * Native and Linux builds paint IOT_STACK_PAINT_BYTES below the entry point with a
+ * pattern and look for the lowest overwritten byte on return, so every call
+ * is measured. On ESP32 the task high-water mark (FreeRTOS) is read around
+ * the call: an entry point is charged when it pushes the mark of its task
+ * lower, so its depth is the deepest call that set a record. Other targets
+ * compile the probes out (IOT_STACK_MONITOR=1 paints there too).
+ */
+class StackMonitor {
+public:
+    StackMonitor();
+
+    /**
+     * @brief Deepest use of an entry point, in bytes (0 if never measured)
+     */
+    size_t depth(StackEntry entry) const { return _depth[(uint8_t)entry]; }
+
+    /**
+     * @brief Lowest free stack of the calling task, in bytes (ESP32, else 0)
+     */
+    static size_t taskFreeMin();
+
+    /**
+     * @brief Metric name of an entry point ("stackLoop", ...)
+     */
+    static const char* metricName(StackEntry entry);
+
+private:
+    friend class StackProbe;
+
+    size_t _depth[(uint8_t)StackEntry::Count];
+
+    void record(StackEntry entry, size_t depth);
+};
+
+#if IOT_STACK_MONITOR
+
+/**
+ * @brief Measures the enclosing entry point, from construction to scope exit
+ *
+ * Always inlined, so the depth counts from the frame of the entry point
+ * itself. Probes nest (messages dispatched from loop, publish from a
+ * callback): each entry point is charged its own depth, and the enclosing
+ * one includes it.
+ */
+class StackProbe {
+public:
+    __attribute__((always_inline)) StackProbe(StackMonitor& monitor, StackEntry entry)
+        : _monitor(monitor), _entry(entry),
+          _top((uintptr_t)__builtin_frame_address(0)) {
+        begin();
+    }
+
+    ~StackProbe() { end(); }
+
+private:
+    StackMonitor& _monitor;
+    StackEntry _entry;
+    uintptr_t _top;         // Frame of the entry point
+#if IOT_STACK_WATERMARK
+    size_t _freeBefore;
+#else
+    uintptr_t _reached;     // Reach of the enclosing probes when this one opened
+#endif
+
+    void begin();
+    void end();
+
+    StackProbe(const StackProbe&);
+    StackProbe& operator=(const StackProbe&);
+};
+
+#else
+
+class StackProbe {
+public:
+    StackProbe(StackMonitor&, StackEntry) {}
+};
+
+#endif
+
+#endif // STACK_MONITOR_H
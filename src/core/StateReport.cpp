@@ -0,0 +1,61 @@
+/**
+ * @file StateReport.cpp
+ * @brief Implementation of StateReport
+ */
+
+#include "StateReport.h"
+#include <cstdio>
+#include <cstring>
+
+StateReport::StateReport(unsigned long maxSilenceMs)
+    : _count(0), _maxSilenceMs(maxSilenceMs), _lastSent(0), _sentOnce(false) {
+    memset(_fields, 0, sizeof(_fields));
+}
+
+int StateReport::addField(const char* name, long threshold) {
+    if (!name || _count >= IOT_STATE_FIELDS_MAX) return -1;
+    StateField& field = _fields[_count];
+    field.name = name;
+    field.threshold = threshold < 0 ? -threshold : threshold;
+    field.value = 0;
+    field.sent = 0;
+    return static_cast<int>(_count++);
+}
+
+void StateReport::set(int index, long value) {
+    if (index < 0 || (size_t)index >= _count) return;
+    _fields[index].value = value;
+}
+
+bool StateReport::due(unsigned long now) const {
+    if (!_sentOnce) return true;
+    if (_maxSilenceMs > 0 && now - _lastSent >= _maxSilenceMs) return true;
+
+    for (size_t i = 0; i < _count; i++) {
+        const StateField& field = _fields[i];
+        if (field.threshold == 0) continue;
+        long delta = field.value - field.sent;
+        if (delta >= field.threshold || -delta >= field.threshold) return true;
+    }
+    return false;
+}
+
+size_t StateReport::buildJson(char* buffer, size_t bufferSize) const {
+    size_t written = snprintf(buffer, bufferSize, "{");
+    for (size_t i = 0; i < _count && written < bufferSize; i++) {
+        written += snprintf(buffer + written, bufferSize - written, "%s\"%s\":%ld",
+                            i > 0 ? "," : "", _fields[i].name, _fields[i].value);
+    }
+    if (written < bufferSize) {
+        written += snprintf(buffer + written, bufferSize - written, "}");
+    }
+    return written;
+}
+
+void StateReport::markSent(unsigned long now) {
+    for (size_t i = 0; i < _count; i++) {
+        _fields[i].sent = _fields[i].value;
+    }
+    _lastSent = now;
+    _sentOnce = true;
+}
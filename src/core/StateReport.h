@@ -0,0 +1,82 @@
+/**
+ * @file StateReport.h
+ * @brief Volatile values published only when they move past a threshold
+ */
+
+#ifndef STATE_REPORT_H
+#define STATE_REPORT_H
+
+#include <Arduino.h>
+
+#ifndef IOT_STATE_FIELDS_MAX
+#define IOT_STATE_FIELDS_MAX 8
+#endif
+
+/**
+ * @brief One reported value and its deadband
+ */
+struct StateField {
+    const char* name;   // Must point to a string literal
+    long threshold;     // Change that triggers a report, 0 = never triggers
+    long value;
+    long sent;          // Value in the last report
+};
+
+/**
+ * @brief Deadband reporter for volatile device state (heap, RSSI, ...)
+ *
+ * A report is due when any field moved by at least its threshold since the
+ * last report, or after maxSilenceMs without a report. The first report is
+ * always due.
+ */
+class StateReport {
+public:
+    /**
+     * @param maxSilenceMs Longest time without a report (0 = no heartbeat)
+     */
+    explicit StateReport(unsigned long maxSilenceMs = 0);
+
+    /**
+     * @brief Add a field
+     * @return Field index, -1 if the table is full
+     */
+    int addField(const char* name, long threshold);
+
+    /**
+     * @brief Update the current value of a field
+     */
+    void set(int index, long value);
+
+    /**
+     * @brief Check if a report must be sent
+     * @param now Current time in ms
+     */
+    bool due(unsigned long now) const;
+
+    /**
+     * @brief Build the report as a flat JSON object of current values
+     * @return Number of bytes written
+     */
+    size_t buildJson(char* buffer, size_t bufferSize) const;
+
+    /**
+     * @brief Record that the current values were sent
+     */
+    void markSent(unsigned long now);
+
+    /**
+     * @brief Make the next report due (e.g., after a reconnection)
+     */
+    void invalidate() { _sentOnce = false; }
+
+    size_t count() const { return _count; }
+
+private:
+    StateField _fields[IOT_STATE_FIELDS_MAX];
+    size_t _count;
+    unsigned long _maxSilenceMs;
+    unsigned long _lastSent;
+    bool _sentOnce;
+};
+
+#endif // STATE_REPORT_H
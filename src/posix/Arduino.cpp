@@ -0,0 +1,12 @@
+/**
+ * @file Arduino.cpp
+ * @brief Globals of the POSIX Arduino core
+ */
+
+#ifdef IOT_POSIX
+
+#include "Arduino.h"
+
+PosixSerial Serial;
+
+#endif // IOT_POSIX
@@ -0,0 +1,76 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core for the POSIX/Linux port (IOT_POSIX)
+ *
+ * Only what the library uses: fixed-width types, math, millis()/delay()
+ * on the monotonic clock and a Serial object writing to stdout.
+ */
+
+#ifndef IOT_POSIX_ARDUINO_H
+#define IOT_POSIX_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/**
+ * @brief Milliseconds on the monotonic clock (never jumps with NTP)
+ */
+inline unsigned long millis() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000UL + (unsigned long)(ts.tv_nsec / 1000000L);
+}
+
+inline unsigned long micros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + (unsigned long)(ts.tv_nsec / 1000L);
+}
+
+inline void delay(unsigned long ms) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0) {
+        // Interrupted by a signal: sleep for the remainder
+    }
+}
+
+inline void yield() {}
+
+/**
+ * @brief Serial console on stdout
+ */
+class PosixSerial {
+public:
+    void begin(unsigned long baud) {}
+
+    int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        int written = vprintf(format, args);
+        va_end(args);
+        fflush(stdout);
+        return written;
+    }
+
+    size_t print(const char* text) { return (size_t)fputs(text, stdout); }
+    size_t println(const char* text = "") {
+        size_t written = print(text);
+        fputc('\n', stdout);
+        fflush(stdout);
+        return written + 1;
+    }
+    size_t println(int value) { return (size_t)::printf("%d\n", value); }
+    size_t println(float value) { return (size_t)::printf("%.2f\n", value); }
+};
+
+extern PosixSerial Serial;
+
+#endif // IOT_POSIX_ARDUINO_H
@@ -0,0 +1,480 @@
+/**
+ * @file PosixMqttTransport.cpp
+ * @brief Implementation of PosixMqttTransport
+ */
+
+#ifdef IOT_POSIX
+
+#include "PosixMqttTransport.h"
+#include "../core/Logger.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// MQTT 3.1.1 control packet types (high nibble of the fixed header)
+static const uint8_t MQTT_CONNECT = 0x10;
+static const uint8_t MQTT_CONNACK = 0x20;
+static const uint8_t MQTT_PUBLISH = 0x30;
+static const uint8_t MQTT_PUBACK = 0x40;
+static const uint8_t MQTT_SUBSCRIBE = 0x82;   // Reserved flags 0010
+static const uint8_t MQTT_SUBACK = 0x90;
+static const uint8_t MQTT_PINGREQ = 0xC0;
+static const uint8_t MQTT_PINGRESP = 0xD0;
+static const uint8_t MQTT_DISCONNECT = 0xE0;
+
+static size_t remainingLengthSize(size_t length) {
+    if (length < 128) return 1;
+    if (length < 16384) return 2;
+    if (length < 2097152) return 3;
+    return 4;
+}
+
+static uint8_t* putUint16(uint8_t* out, uint16_t value) {
+    *out++ = (uint8_t)(value >> 8);
+    *out++ = (uint8_t)(value & 0xFF);
+    return out;
+}
+
+static uint8_t* putString(uint8_t* out, const char* text, size_t length) {
+    out = putUint16(out, (uint16_t)length);
+    memcpy(out, text, length);
+    return out + length;
+}
+
+PosixMqttTransport::PosixMqttTransport()
+    : _epoll(epoll_create1(EPOLL_CLOEXEC)), _socket(-1), _state(Idle),
+      _txLength(0), _rxLength(0), _rxSkip(0), _nextPacketId(1), _stateSince(0),
+      _lastSent(0), _pingSent(0), _writes(0), _oversized(0), _wantWrite(false) {
+    memset(&_config, 0, sizeof(_config));
+}
+
+PosixMqttTransport::~PosixMqttTransport() {
+    if (_socket >= 0) ::close(_socket);
+    if (_epoll >= 0) ::close(_epoll);
+}
+
+// =============================================================================
+// Session
+// =============================================================================
+
+bool PosixMqttTransport::connect(const MqttSessionConfig& config) {
+    // Strings are owned by MqttClient: CONNECT is framed once TCP is up
+    _config = config;
+    if (_state != Idle) return true;
+    if (_epoll < 0) return false;
+
+    char port[8];
+    snprintf(port, sizeof(port), "%u", (unsigned)config.port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = nullptr;
+    int error = getaddrinfo(config.host, port, &hints, &addresses);
+    if (error != 0) {
+        IOT_LOG_ERROR("[MQTT] Cannot resolve %s: %s", config.host, gai_strerror(error));
+        return false;
+    }
+
+    for (struct addrinfo* it = addresses; it && _socket < 0; it = it->ai_next) {
+        int fd = socket(it->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) continue;
+        // Batching happens above: a write is a complete set of packets
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        if (::connect(fd, it->ai_addr, it->ai_addrlen) == 0 || errno == EINPROGRESS) {
+            _socket = fd;
+        } else {
+            ::close(fd);
+        }
+    }
+    freeaddrinfo(addresses);
+    if (_socket < 0) return false;
+
+    // Writable once the TCP handshake is done
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.fd = _socket;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _socket, &event) != 0) {
+        ::close(_socket);
+        _socket = -1;
+        return false;
+    }
+    _wantWrite = true;
+    _txLength = 0;
+    _rxLength = 0;
+    _rxSkip = 0;
+    _pingSent = 0;
+    setState(Connecting);
+
+    IOT_LOG_INFO("[MQTT] Connecting to %s:%d...", config.host, config.port);
+    return true;
+}
+
+void PosixMqttTransport::disconnect() {
+    if (_state == Idle) return;
+    if (_state == Connected) {
+        sendPacket(MQTT_DISCONNECT);
+        flushTx();
+    }
+    if (_state != Idle) close();
+}
+
+bool PosixMqttTransport::subscribe(const char* topic) {
+    if (_state != Connected) return false;
+
+    size_t topicLength = strlen(topic);
+    uint8_t* p = beginPacket(MQTT_SUBSCRIBE, 2 + 2 + topicLength + 1);
+    if (!p) return false;
+    p = putUint16(p, nextPacketId());
+    p = putString(p, topic, topicLength);
+    *p = 0; // Requested QoS 0
+    return flushTx();
+}
+
+bool PosixMqttTransport::publish(const char* topic, const uint8_t* payload, size_t length,
+                                 int8_t qos, bool retain) {
+    if (_state != Connected) return false;
+    // No session-less publishing over TCP, no QoS 2
+    if (qos < 0) qos = MqttQos::AtMostOnce;
+    if (qos > 1) qos = MqttQos::AtLeastOnce;
+
+    size_t topicLength = strlen(topic);
+    uint8_t header = MQTT_PUBLISH | (uint8_t)(qos << 1) | (retain ? 0x01 : 0x00);
+    uint8_t* p = beginPacket(header, 2 + topicLength + (qos > 0 ? 2 : 0) + length);
+    if (!p) {
+        IOT_LOG_WARN("[MQTT] Send buffer full, dropped %s", topic);
+        return false;
+    }
+    p = putString(p, topic, topicLength);
+    if (qos > 0) p = putUint16(p, nextPacketId());
+    memcpy(p, payload, length);
+    return flushTx();
+}
+
+size_t PosixMqttTransport::writePackets(const uint8_t* data, size_t length,
+                                        size_t& writes) {
+    writes = 0;
+    if (_state != Connected) return 0;
+    unsigned long before = _writes;
+    if (length > sizeof(_tx) - _txLength && (!flushTx() || length > sizeof(_tx) - _txLength)) {
+        IOT_LOG_WARN("[MQTT] Send buffer full, dropped %u bytes", (unsigned)length);
+        return 0;
+    }
+    // Already framed: one copy, one write
+    memcpy(_tx + _txLength, data, length);
+    _txLength += length;
+    flushTx();
+    writes = _writes - before;
+    return length;
+}
+
+void PosixMqttTransport::loop() {
+    if (_state == Idle) return;
+
+    struct epoll_event events[4];
+    int count = epoll_wait(_epoll, events, 4, 0);
+    for (int i = 0; i < count && _state != Idle; i++) {
+        uint32_t ready = events[i].events;
+
+        if (_state == Connecting) {
+            int error = 0;
+            socklen_t errorLength = sizeof(error);
+            getsockopt(_socket, SOL_SOCKET, SO_ERROR, &error, &errorLength);
+            if (error != 0) {
+                IOT_LOG_WARN("[MQTT] Connection failed: %s", strerror(error));
+                close();
+                return;
+            }
+            if (!(ready & EPOLLOUT)) continue;
+            setState(Handshake);
+            sendConnect();
+            continue;
+        }
+
+        if ((ready & EPOLLIN) && !readRx()) return;
+        if ((ready & EPOLLOUT) && !flushTx()) return;
+        if (ready & (EPOLLERR | EPOLLHUP)) {
+            IOT_LOG_WARN("[MQTT] Connection lost");
+            close();
+            return;
+        }
+    }
+    if (_state == Idle) return;
+
+    unsigned long now = millis();
+    if (_state == Connecting || _state == Handshake) {
+        if (now - _stateSince > IOT_POSIX_CONNECT_TIMEOUT_MS) {
+            IOT_LOG_WARN("[MQTT] Connection timed out");
+            close();
+        }
+        return;
+    }
+
+    // Keepalive: the broker drops us (and publishes the will) after 1.5x
+    const unsigned long keepaliveMs = IOT_POSIX_KEEPALIVE_S * 1000UL;
+    if (_pingSent != 0 && now - _pingSent > keepaliveMs) {
+        IOT_LOG_WARN("[MQTT] Broker not responding");
+        close();
+    } else if (_pingSent == 0 && now - _lastSent >= keepaliveMs / 2) {
+        sendPacket(MQTT_PINGREQ);
+        _pingSent = now;
+        flushTx();
+    }
+}
+
+// =============================================================================
+// Framing
+// =============================================================================
+
+uint8_t* PosixMqttTransport::beginPacket(uint8_t header, size_t remainingLength) {
+    size_t total = 1 + remainingLengthSize(remainingLength) + remainingLength;
+    if (total > sizeof(_tx) - _txLength && (!flushTx() || total > sizeof(_tx) - _txLength)) {
+        return nullptr;
+    }
+
+    uint8_t* p = _tx + _txLength;
+    *p++ = header;
+    size_t length = remainingLength;
+    do {
+        uint8_t digit = length % 128;
+        length /= 128;
+        *p++ = length > 0 ? (digit | 0x80) : digit;
+    } while (length > 0);
+    _txLength += total;
+    return p;
+}
+
+void PosixMqttTransport::sendConnect() {
+    static const uint16_t keepalive = IOT_POSIX_KEEPALIVE_S;
+    size_t clientIdLength = strlen(_config.clientId);
+    bool will = _config.willTopic != nullptr;
+    bool user = _config.username && _config.username[0] != '\0';
+    bool password = user && _config.password && _config.password[0] != '\0';
+    size_t willTopicLength = will ? strlen(_config.willTopic) : 0;
+    size_t willPayloadLength = will ? strlen(_config.willPayload) : 0;
+    size_t userLength = user ? strlen(_config.username) : 0;
+    size_t passwordLength = password ? strlen(_config.password) : 0;
+
+    size_t length = 10 + 2 + clientIdLength;
+    if (will) length += 2 + willTopicLength + 2 + willPayloadLength;
+    if (user) length += 2 + userLength;
+    if (password) length += 2 + passwordLength;
+
+    // Clean session; the will is QoS 1 and retained, like on the device
+    uint8_t flags = 0x02;
+    if (will) flags |= 0x04 | (MqttQos::AtLeastOnce << 3) | 0x20;
+    if (user) flags |= 0x80;
+    if (password) flags |= 0x40;
+
+    uint8_t* p = beginPacket(MQTT_CONNECT, length);
+    if (!p) return;
+    p = putString(p, "MQTT", 4);
+    *p++ = 4; // Protocol level 3.1.1
+    *p++ = flags;
+    p = putUint16(p, keepalive);
+    p = putString(p, _config.clientId, clientIdLength);
+    if (will) {
+        p = putString(p, _config.willTopic, willTopicLength);
+        p = putString(p, _config.willPayload, willPayloadLength);
+    }
+    if (user) p = putString(p, _config.username, userLength);
+    if (password) putString(p, _config.password, passwordLength);
+    flushTx();
+}
+
+void PosixMqttTransport::sendPacket(uint8_t header) {
+    beginPacket(header, 0);
+}
+
+// =============================================================================
+// Socket I/O
+// =============================================================================
+
+bool PosixMqttTransport::flushTx() {
+    while (_txLength > 0) {
+        ssize_t sent = send(_socket, _tx, _txLength, MSG_NOSIGNAL);
+        if (sent > 0) {
+            _writes++;
+            _lastSent = millis();
+            _txLength -= (size_t)sent;
+            if (_txLength > 0) memmove(_tx, _tx + sent, _txLength);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break; // Resumed on EPOLLOUT
+        } else {
+            IOT_LOG_WARN("[MQTT] Write failed: %s", strerror(errno));
+            close();
+            return false;
+        }
+    }
+    watch(_txLength > 0);
+    return true;
+}
+
+bool PosixMqttTransport::readRx() {
+    while (true) {
+        ssize_t received = recv(_socket, _rx + _rxLength, sizeof(_rx) - _rxLength, 0);
+        if (received == 0) {
+            IOT_LOG_WARN("[MQTT] Connection closed by broker");
+            close();
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+            IOT_LOG_WARN("[MQTT] Read failed: %s", strerror(errno));
+            close();
+            return false;
+        }
+        _rxLength += (size_t)received;
+
+        // Handle every complete packet, keep the tail for the next read
+        size_t offset = 0;
+        while (true) {
+            // Discard the rest of an oversized packet as it arrives
+            if (_rxSkip > 0) {
+                size_t skipped = _rxLength - offset < _rxSkip ? _rxLength - offset : _rxSkip;
+                offset += skipped;
+                _rxSkip -= skipped;
+                if (_rxSkip > 0) break;
+            }
+            if (_rxLength - offset < 2) break;
+
+            size_t remaining = 0;
+            size_t multiplier = 1;
+            size_t headerLength = 1;
+            bool complete = false;
+            while (offset + headerLength < _rxLength && headerLength <= 4) {
+                uint8_t digit = _rx[offset + headerLength++];
+                remaining += (digit & 0x7F) * multiplier;
+                multiplier *= 128;
+                if (!(digit & 0x80)) {
+                    complete = true;
+                    break;
+                }
+            }
+            if (!complete) {
+                if (headerLength <= 4) break; // Length not fully received
+                close();
+                return false;
+            }
+            if (headerLength + remaining > sizeof(_rx)) {
+                // Skip it rather than reconnect: a large retained message
+                // would be redelivered on every subscribe
+                IOT_LOG_WARN("[MQTT] Packet too large (%u bytes), skipped", (unsigned)remaining);
+                _oversized++;
+                _rxSkip = headerLength + remaining;
+                continue;
+            }
+            if (offset + headerLength + remaining > _rxLength) break;
+
+            handle(_rx[offset], _rx + offset + headerLength, remaining);
+            if (_state == Idle) return false;
+            offset += headerLength + remaining;
+        }
+        if (offset > 0) {
+            _rxLength -= offset;
+            memmove(_rx, _rx + offset, _rxLength);
+        }
+    }
+}
+
+void PosixMqttTransport::handle(uint8_t header, const uint8_t* body, size_t length) {
+    switch (header & 0xF0) {
+    case MQTT_CONNACK:
+        if (length < 2 || body[1] != 0) {
+            IOT_LOG_ERROR("[MQTT] Connection refused (code %u)", length >= 2 ? body[1] : 0);
+            close();
+            return;
+        }
+        if (_state == Handshake) {
+            setState(Connected);
+            IOT_LOG_INFO("[MQTT] Connected");
+            notifyConnect(true);
+        }
+        break;
+    case MQTT_PUBLISH:
+        handlePublish(header, body, length);
+        break;
+    case MQTT_PINGRESP:
+        _pingSent = 0;
+        break;
+    case MQTT_PUBACK:
+    case MQTT_SUBACK:
+    default:
+        break;
+    }
+}
+
+void PosixMqttTransport::handlePublish(uint8_t header, const uint8_t* body, size_t length) {
+    if (length < 2) return;
+    uint8_t qos = (header >> 1) & 0x03;
+    size_t topicLength = ((size_t)body[0] << 8) | body[1];
+    size_t offset = 2 + topicLength;
+    uint16_t packetId = 0;
+    if (qos > 0) {
+        if (offset + 2 > length) return;
+        packetId = (uint16_t)((body[offset] << 8) | body[offset + 1]);
+        offset += 2;
+    }
+    if (offset > length) return;
+
+    if (qos == 1) {
+        uint8_t* p = beginPacket(MQTT_PUBACK, 2);
+        if (p) putUint16(p, packetId);
+        flushTx();
+    }
+
+    // Topic and payload as null-terminated strings
+    size_t payloadLength = length - offset;
+    memcpy(_message, body + 2, topicLength);
+    _message[topicLength] = '\0';
+    char* payload = _message + topicLength + 1;
+    memcpy(payload, body + offset, payloadLength);
+    payload[payloadLength] = '\0';
+    notifyMessage(_message, payload);
+}
+
+void PosixMqttTransport::watch(bool write) {
+    if (_socket < 0 || write == _wantWrite) return;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | (write ? (uint32_t)EPOLLOUT : 0u);
+    event.data.fd = _socket;
+    epoll_ctl(_epoll, EPOLL_CTL_MOD, _socket, &event);
+    _wantWrite = write;
+}
+
+void PosixMqttTransport::close() {
+    if (_socket >= 0) {
+        epoll_ctl(_epoll, EPOLL_CTL_DEL, _socket, nullptr);
+        ::close(_socket);
+        _socket = -1;
+    }
+    _txLength = 0;
+    _rxLength = 0;
+    _pingSent = 0;
+    _wantWrite = false;
+    setState(Idle);
+    notifyConnect(false);
+}
+
+void PosixMqttTransport::setState(State state) {
+    _state = state;
+    _stateSince = millis();
+    if (state == Connected) _lastSent = _stateSince;
+}
+
+uint16_t PosixMqttTransport::nextPacketId() {
+    if (_nextPacketId == 0) _nextPacketId = 1;
+    return _nextPacketId++;
+}
+
+#endif // IOT_POSIX
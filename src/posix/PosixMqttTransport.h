@@ -0,0 +1,109 @@
+/**
+ * @file PosixMqttTransport.h
+ * @brief MQTT 3.1.1 over a non-blocking TCP socket driven by epoll (IOT_POSIX)
+ */
+
+#ifndef POSIX_MQTT_TRANSPORT_H
+#define POSIX_MQTT_TRANSPORT_H
+
+#ifdef IOT_POSIX
+
+#include "../core/MqttTransport.h"
+
+#ifndef IOT_POSIX_TX_BYTES
+#define IOT_POSIX_TX_BYTES 16384
+#endif
+
+#ifndef IOT_POSIX_RX_BYTES
+#define IOT_POSIX_RX_BYTES 4096
+#endif
+
+#ifndef IOT_POSIX_KEEPALIVE_S
+#define IOT_POSIX_KEEPALIVE_S 60
+#endif
+
+#ifndef IOT_POSIX_CONNECT_TIMEOUT_MS
+#define IOT_POSIX_CONNECT_TIMEOUT_MS 10000
+#endif
+
+/**
+ * @brief Default transport on Linux gateways
+ *
+ * A single-threaded MQTT 3.1.1 client: the socket never blocks and all I/O
+ * happens in loop() (epoll with a zero timeout), like AsyncMqttClient on the
+ * device. Outgoing packets are framed into a send buffer that is written as
+ * far as the socket accepts and resumed on EPOLLOUT; a full buffer drops new
+ * publishes instead of blocking the caller. Batches from MqttClient are
+ * already MQTT 3.1.1 packets and go to the socket in one write.
+ *
+ * QoS 1 is only used for presence and is not retransmitted: the session is
+ * clean, so nothing survives a reconnect anyway. The broker name is resolved
+ * with getaddrinfo(), which blocks; use an IP address or a local resolver.
+ */
+class PosixMqttTransport : public MqttTransport {
+public:
+    PosixMqttTransport();
+    ~PosixMqttTransport();
+
+    bool connect(const MqttSessionConfig& config) override;
+    void disconnect() override;
+    bool connected() const override { return _state == Connected; }
+    bool subscribe(const char* topic) override;
+    bool publish(const char* topic, const uint8_t* payload, size_t length,
+                 int8_t qos, bool retain) override;
+    size_t writePackets(const uint8_t* data, size_t length, size_t& writes) override;
+    bool writesBatches() const override { return true; }
+    void loop() override;
+
+    /**
+     * @brief Bytes framed but not yet accepted by the socket
+     */
+    size_t pending() const { return _txLength; }
+
+    /**
+     * @brief Number of write() calls on the socket
+     */
+    unsigned long writes() const { return _writes; }
+
+    /**
+     * @brief Number of incoming packets skipped for exceeding IOT_POSIX_RX_BYTES
+     */
+    unsigned long oversized() const { return _oversized; }
+
+private:
+    enum State { Idle, Connecting, Handshake, Connected };
+
+    int _epoll;
+    int _socket;
+    State _state;
+    MqttSessionConfig _config;
+    uint8_t _tx[IOT_POSIX_TX_BYTES];
+    size_t _txLength;
+    uint8_t _rx[IOT_POSIX_RX_BYTES];
+    size_t _rxLength;
+    size_t _rxSkip;             // Bytes of an oversized packet still to discard
+    char _message[IOT_POSIX_RX_BYTES + 1];
+    uint16_t _nextPacketId;
+    unsigned long _stateSince;
+    unsigned long _lastSent;
+    unsigned long _pingSent;    // 0 = no PINGREQ outstanding
+    unsigned long _writes;
+    unsigned long _oversized;
+    bool _wantWrite;
+
+    uint8_t* beginPacket(uint8_t header, size_t remainingLength);
+    void sendConnect();
+    void sendPacket(uint8_t header);
+    bool flushTx();
+    bool readRx();
+    void handle(uint8_t header, const uint8_t* body, size_t length);
+    void handlePublish(uint8_t header, const uint8_t* body, size_t length);
+    void watch(bool write);
+    void close();
+    void setState(State state);
+    uint16_t nextPacketId();
+};
+
+#endif // IOT_POSIX
+
+#endif // POSIX_MQTT_TRANSPORT_H
@@ -0,0 +1,112 @@
+/**
+ * @file PosixSystem.cpp
+ * @brief Implementation of PosixSystem
+ */
+
+#ifdef IOT_POSIX
+
+#include "PosixSystem.h"
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+namespace PosixSystem {
+
+void machineId(char* id, size_t size) {
+    if (size == 0) return;
+    id[0] = '\0';
+
+    FILE* file = fopen("/etc/machine-id", "r");
+    if (file) {
+        // 16 hex digits, like the ESP32 eFuse MAC ID
+        char line[64];
+        if (fgets(line, sizeof(line), file)) {
+            size_t length = strcspn(line, "\r\n");
+            if (length > 16) length = 16;
+            line[length] = '\0';
+            snprintf(id, size, "%s", line);
+        }
+        fclose(file);
+    }
+    if (id[0] == '\0') {
+        snprintf(id, size, "%08lX", (unsigned long)(uint32_t)gethostid());
+    }
+}
+
+bool network(char* ip, size_t ipSize, char* mac, size_t macSize) {
+    struct ifaddrs* interfaces = nullptr;
+    if (getifaddrs(&interfaces) != 0) return false;
+
+    char name[IF_NAMESIZE] = "";
+    for (struct ifaddrs* it = interfaces; it; it = it->ifa_next) {
+        if (!it->ifa_addr || it->ifa_addr->sa_family != AF_INET) continue;
+        if (!(it->ifa_flags & IFF_UP) || (it->ifa_flags & IFF_LOOPBACK)) continue;
+        const struct sockaddr_in* address = (const struct sockaddr_in*)it->ifa_addr;
+        inet_ntop(AF_INET, &address->sin_addr, ip, (socklen_t)ipSize);
+        snprintf(name, sizeof(name), "%s", it->ifa_name);
+        break;
+    }
+    freeifaddrs(interfaces);
+    if (name[0] == '\0') return false;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/class/net/%s/address", name);
+    FILE* file = fopen(path, "r");
+    if (file) {
+        char line[32];
+        if (fgets(line, sizeof(line), file)) {
+            line[strcspn(line, "\r\n")] = '\0';
+            // Upper case, like WiFi.macAddress()
+            for (char* c = line; *c; c++) {
+                if (*c >= 'a' && *c <= 'f') *c = (char)(*c - 'a' + 'A');
+            }
+            snprintf(mac, macSize, "%s", line);
+        }
+        fclose(file);
+    }
+    return true;
+}
+
+// Value of a /proc/meminfo field in KB
+static uint32_t memInfo(const char* field) {
+    FILE* file = fopen("/proc/meminfo", "r");
+    if (!file) return 0;
+
+    size_t fieldLength = strlen(field);
+    unsigned long value = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, field, fieldLength) == 0 && line[fieldLength] == ':') {
+            value = strtoul(line + fieldLength + 1, nullptr, 10);
+            break;
+        }
+    }
+    fclose(file);
+    return (uint32_t)value;
+}
+
+uint32_t memoryTotalKb() {
+    return memInfo("MemTotal");
+}
+
+uint32_t memoryAvailableKb() {
+    return memInfo("MemAvailable");
+}
+
+const char* machine() {
+    static struct utsname info;
+    if (info.machine[0] == '\0' && uname(&info) != 0) return "Linux";
+    return info.machine;
+}
+
+int cpuCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+} // namespace PosixSystem
+
+#endif // IOT_POSIX
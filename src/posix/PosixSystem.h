@@ -0,0 +1,49 @@
+/**
+ * @file PosixSystem.h
+ * @brief Host facts for system/config and hardware/config on Linux (IOT_POSIX)
+ */
+
+#ifndef IOT_POSIX_SYSTEM_H
+#define IOT_POSIX_SYSTEM_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Linux counterparts of the ESP/WiFi calls used by IotMesurable
+ */
+namespace PosixSystem {
+
+/**
+ * @brief Stable host ID (/etc/machine-id, else gethostid())
+ */
+void machineId(char* id, size_t size);
+
+/**
+ * @brief IPv4 and MAC address of the first non-loopback interface that is up
+ * @return false if no such interface was found (buffers left untouched)
+ */
+bool network(char* ip, size_t ipSize, char* mac, size_t macSize);
+
+/**
+ * @brief Total RAM in KB
+ */
+uint32_t memoryTotalKb();
+
+/**
+ * @brief RAM available to new processes in KB (MemAvailable)
+ */
+uint32_t memoryAvailableKb();
+
+/**
+ * @brief Machine architecture (e.g., "aarch64")
+ */
+const char* machine();
+
+/**
+ * @brief Number of online CPUs
+ */
+int cpuCount();
+
+} // namespace PosixSystem
+
+#endif // IOT_POSIX_SYSTEM_H
@@ -0,0 +1,254 @@
+/**
+ * @file Preferences.cpp
+ * @brief Implementation of the file-backed Preferences
+ */
+
+#ifdef IOT_POSIX
+
+#include "Preferences.h"
+#include "../core/Logger.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// mkdir -p
+static bool makeDirectories(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i < path.size() && path[i] != '/') continue;
+        std::string prefix = path.substr(0, i);
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    }
+    return true;
+}
+
+const char* Preferences::directory() {
+    const char* dir = getenv("IOT_CONFIG_DIR");
+    return (dir && *dir) ? dir : IOT_POSIX_CONFIG_DIR;
+}
+
+bool Preferences::begin(const char* name, bool readOnly) {
+    if (_open) end();
+    if (!name || !*name) return false;
+
+    _path = std::string(directory()) + "/" + name + ".prefs";
+    _readOnly = readOnly;
+    _dirty = false;
+    _open = true;
+    load();
+    return true;
+}
+
+void Preferences::end() {
+    if (!_open) return;
+    if (_dirty && !_readOnly && !save()) {
+        IOT_LOG_ERROR("[Preferences] Failed to write %s (errno %d)", _path.c_str(), errno);
+    }
+    _values.clear();
+    _open = false;
+    _dirty = false;
+}
+
+bool Preferences::isKey(const char* key) const {
+    return find(key) != nullptr;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!_open || _readOnly || !key) return false;
+    if (_values.erase(key) == 0) return false;
+    _dirty = true;
+    return true;
+}
+
+bool Preferences::clear() {
+    if (!_open || _readOnly) return false;
+    _values.clear();
+    _dirty = true;
+    return true;
+}
+
+// =============================================================================
+// Put
+// =============================================================================
+
+size_t Preferences::put(const char* key, const std::string& value, size_t size) {
+    if (!_open || _readOnly || !key || !*key) return 0;
+    std::string& slot = _values[key];
+    if (slot != value) {
+        slot = value;
+        _dirty = true;
+    }
+    return size;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    return put(key, value ? "1" : "0", 1);
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    return put(key, std::to_string((unsigned)value), sizeof(value));
+}
+
+size_t Preferences::putUShort(const char* key, uint16_t value) {
+    return put(key, std::to_string((unsigned)value), sizeof(value));
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    return put(key, std::to_string((long)value), sizeof(value));
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    return put(key, std::to_string((unsigned long)value), sizeof(value));
+}
+
+size_t Preferences::putString(const char* key, const char* value) {
+    if (!value) return 0;
+    std::string text(value);
+    // One value per line
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '\n' || text[i] == '\r') text[i] = ' ';
+    }
+    return put(key, text, text.size());
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!value) return 0;
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    std::string hex;
+    hex.reserve(length * 2);
+    for (size_t i = 0; i < length; i++) {
+        hex.push_back(HEX_DIGITS[bytes[i] >> 4]);
+        hex.push_back(HEX_DIGITS[bytes[i] & 0x0F]);
+    }
+    return put(key, hex, length);
+}
+
+// =============================================================================
+// Get
+// =============================================================================
+
+const std::string* Preferences::find(const char* key) const {
+    if (!_open || !key) return nullptr;
+    std::map<std::string, std::string>::const_iterator it = _values.find(key);
+    return it == _values.end() ? nullptr : &it->second;
+}
+
+long long Preferences::getNumber(const char* key, long long defaultValue) const {
+    const std::string* value = find(key);
+    if (!value || value->empty()) return defaultValue;
+    char* end = nullptr;
+    long long number = strtoll(value->c_str(), &end, 10);
+    return (end && *end == '\0') ? number : defaultValue;
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) const {
+    return getNumber(key, defaultValue ? 1 : 0) != 0;
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) const {
+    return (uint8_t)getNumber(key, defaultValue);
+}
+
+uint16_t Preferences::getUShort(const char* key, uint16_t defaultValue) const {
+    return (uint16_t)getNumber(key, defaultValue);
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) const {
+    return (int32_t)getNumber(key, defaultValue);
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) const {
+    return (uint32_t)getNumber(key, defaultValue);
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLength) const {
+    const std::string* stored = find(key);
+    if (!stored || !value || maxLength == 0) return 0;
+    size_t length = stored->size() < maxLength - 1 ? stored->size() : maxLength - 1;
+    memcpy(value, stored->data(), length);
+    value[length] = '\0';
+    return length;
+}
+
+size_t Preferences::getBytes(const char* key, void* value, size_t maxLength) const {
+    const std::string* hex = find(key);
+    if (!hex || !value || hex->size() % 2 != 0) return 0;
+    size_t length = hex->size() / 2;
+    if (length > maxLength) return 0;
+
+    uint8_t* bytes = static_cast<uint8_t*>(value);
+    for (size_t i = 0; i < length; i++) {
+        int high = hexValue((*hex)[2 * i]);
+        int low = hexValue((*hex)[2 * i + 1]);
+        if (high < 0 || low < 0) return 0;
+        bytes[i] = (uint8_t)((high << 4) | low);
+    }
+    return length;
+}
+
+// =============================================================================
+// File
+// =============================================================================
+
+void Preferences::load() {
+    _values.clear();
+    FILE* file = fopen(_path.c_str(), "r");
+    if (!file) return; // First run
+
+    // Lines have no length limit: saved rule sets run past 1 KB
+    char* line = nullptr;
+    size_t capacity = 0;
+    ssize_t read;
+    while ((read = getline(&line, &capacity, file)) != -1) {
+        size_t length = (size_t)read;
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        if (length == 0 || line[0] == '#') continue;
+        char* separator = strchr(line, '=');
+        if (!separator) continue;
+        *separator = '\0';
+        _values[line] = separator + 1;
+    }
+    free(line);
+    fclose(file);
+}
+
+bool Preferences::save() {
+    size_t slash = _path.rfind('/');
+    if (slash != std::string::npos && slash > 0 && !makeDirectories(_path.substr(0, slash))) {
+        return false;
+    }
+
+    std::string tmpPath = _path + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "w");
+    if (!file) return false;
+
+    bool ok = true;
+    for (std::map<std::string, std::string>::const_iterator it = _values.begin();
+         it != _values.end(); ++it) {
+        if (fprintf(file, "%s=%s\n", it->first.c_str(), it->second.c_str()) < 0) ok = false;
+    }
+    ok = fflush(file) == 0 && ok;
+    ok = fsync(fileno(file)) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(tmpPath.c_str(), _path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    _dirty = false;
+    return true;
+}
+
+#endif // IOT_POSIX
@@ -0,0 +1,84 @@
+/**
+ * @file Preferences.h
+ * @brief File-backed Preferences for the POSIX/Linux port (IOT_POSIX)
+ */
+
+#ifndef IOT_POSIX_PREFERENCES_H
+#define IOT_POSIX_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+#ifndef IOT_POSIX_CONFIG_DIR
+#define IOT_POSIX_CONFIG_DIR "/var/lib/iot-mesurable"
+#endif
+
+/**
+ * @brief Drop-in for the ESP32 Preferences (NVS) API used by ConfigManager
+ *
+ * Each namespace is a text file of "key=value" lines in $IOT_CONFIG_DIR
+ * (IOT_POSIX_CONFIG_DIR if unset), so a gateway can be configured by
+ * editing it. Numbers are stored in decimal, byte blobs in hex. The file is
+ * read by begin() and, if anything changed, replaced atomically by end()
+ * (temporary file, fsync, rename): a power cut keeps the old or the new
+ * file, never half of one.
+ */
+class Preferences {
+public:
+    Preferences() : _open(false), _readOnly(true), _dirty(false) {}
+    ~Preferences() { end(); }
+
+    bool begin(const char* name, bool readOnly = false);
+    void end();
+
+    bool isKey(const char* key) const;
+    bool remove(const char* key);
+    bool clear();
+
+    size_t putBool(const char* key, bool value);
+    size_t putUChar(const char* key, uint8_t value);
+    size_t putUShort(const char* key, uint16_t value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putString(const char* key, const char* value);
+    size_t putBytes(const char* key, const void* value, size_t length);
+
+    bool getBool(const char* key, bool defaultValue = false) const;
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0) const;
+    uint16_t getUShort(const char* key, uint16_t defaultValue = 0) const;
+    int32_t getInt(const char* key, int32_t defaultValue = 0) const;
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) const;
+
+    /**
+     * @brief Copy a string value (null-terminated, truncated to maxLength - 1)
+     * @return Length copied, 0 if the key is missing
+     */
+    size_t getString(const char* key, char* value, size_t maxLength) const;
+
+    /**
+     * @brief Copy a blob
+     * @return Blob size, 0 if the key is missing or the blob is larger than maxLength
+     */
+    size_t getBytes(const char* key, void* value, size_t maxLength) const;
+
+    /**
+     * @brief Directory holding the namespace files
+     */
+    static const char* directory();
+
+private:
+    std::map<std::string, std::string> _values;
+    std::string _path;
+    bool _open;
+    bool _readOnly;
+    bool _dirty;
+
+    size_t put(const char* key, const std::string& value, size_t size);
+    const std::string* find(const char* key) const;
+    long long getNumber(const char* key, long long defaultValue) const;
+    void load();
+    bool save();
+};
+
+#endif // IOT_POSIX_PREFERENCES_H
@@ -0,0 +1,206 @@
+/**
+ * @file test_adaptive_sampling/test_main.cpp
+ * @brief Adaptive sampling validated against recorded signal traces
+ */
+
+#include <unity.h>
+#include "../../src/core/SensorRegistry.h"
+
+// Light sensor, 5 s sampling: lights switch on at sample 60 (t = 300 s)
+static const float LIGHT_TRACE[] = {
+    1.0f, 0.5f, 2.0f, 0.2f, 1.6f, 1.1f, 0.2f, 1.5f, 0.1f, 1.3f, 0.2f, 0.3f, 1.3f,
+    2.5f, 0.4f, 0.7f, 1.9f, 2.8f, 1.7f, 1.2f, 2.9f, 0.1f, 2.6f, 0.9f, 0.4f, 0.4f,
+    0.9f, 2.4f, 0.5f, 1.7f, 1.9f, 1.1f, 1.6f, 0.2f, 0.2f, 0.6f, 2.0f, 1.3f, 0.9f,
+    1.8f, 1.4f, 0.9f, 2.4f, 2.1f, 0.7f, 1.7f, 1.6f, 2.6f, 2.2f, 0.9f, 2.9f, 0.4f,
+    1.3f, 2.3f, 0.5f, 1.5f, 0.1f, 2.0f, 2.3f, 1.7f, 803.8f, 798.1f, 802.0f, 800.9f,
+    800.8f, 799.6f, 803.4f, 804.4f, 799.7f, 801.6f, 795.6f, 802.0f, 801.5f, 804.9f,
+    803.2f, 797.8f, 798.9f, 801.7f, 795.2f, 799.6f, 796.7f, 796.2f, 795.6f, 802.7f,
+    796.3f, 797.5f, 798.9f, 803.7f, 795.8f, 799.5f, 800.5f, 803.8f, 803.2f, 803.6f,
+    797.8f, 799.2f, 798.6f, 803.8f, 804.6f, 796.5f, 796.8f, 797.3f, 797.3f, 799.8f,
+    800.9f, 797.6f, 795.0f, 799.2f, 798.7f, 800.7f, 804.5f, 801.9f, 800.2f, 801.2f,
+    801.8f, 795.5f, 804.0f, 802.8f, 803.7f, 803.0f
+};
+static const unsigned long LIGHT_PERIOD_MS = 5000;
+static const size_t LIGHT_SWITCH_INDEX = 60;
+
+// Soil moisture, 10 s sampling: irrigation from sample 30 to 35
+static const float SOIL_TRACE[] = {
+    40.97f, 40.97f, 40.88f, 41.04f, 40.87f, 40.87f, 40.91f, 40.9f, 40.95f, 40.87f,
+    40.85f, 40.9f, 40.88f, 40.96f, 40.86f, 41.11f, 41.03f, 40.89f, 40.93f, 40.95f,
+    40.96f, 40.89f, 41.1f, 41.15f, 40.99f, 41.0f, 40.88f, 40.88f, 40.95f, 40.93f,
+    46.2f, 50.8f, 55.71f, 61.27f, 66.02f, 70.79f, 70.01f, 69.81f, 69.91f, 69.99f,
+    69.91f, 69.81f, 69.63f, 69.61f, 69.5f, 69.63f, 69.51f, 69.53f, 69.35f, 69.27f,
+    69.39f, 69.4f, 69.31f, 69.24f, 69.2f, 69.12f, 68.92f, 68.96f, 68.86f, 68.71f,
+    68.66f, 68.68f, 68.63f, 68.71f, 68.74f, 68.53f, 68.63f, 68.6f, 68.54f, 68.31f,
+    68.22f, 68.17f, 68.11f, 68.06f, 68.14f, 68.17f, 68.1f, 67.94f, 67.95f, 67.94f,
+    67.68f, 67.8f, 67.82f, 67.73f, 67.68f, 67.54f, 67.4f, 67.54f, 67.35f, 67.44f
+};
+static const unsigned long SOIL_PERIOD_MS = 10000;
+static const size_t SOIL_IRRIGATION_START = 30;
+static const size_t SOIL_IRRIGATION_END = 35;
+
+/**
+ * @brief Replay a trace through the publish decision used by IotMesurable
+ * @param published Output flags, true where the sample was published
+ * @return Number of published samples
+ */
+static size_t replay(SensorRegistry& reg, const float* trace, size_t count,
+                     unsigned long periodMs, bool* published) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        // Offset by one period: a last publish time of 0 means "never"
+        unsigned long now = (i + 1) * periodMs;
+        reg.observeSample("hw", "value", trace[i], now);
+        published[i] = reg.getLastPublishTime("hw") == 0 || reg.canPublish("hw", now);
+        if (published[i]) {
+            reg.updateSensorValue("hw", "value", trace[i]);
+            reg.updatePublishTime("hw", now);
+            total++;
+        }
+    }
+    return total;
+}
+
+static void setupHardware(SensorRegistry& reg) {
+    reg.registerHardware("hw", "Trace");
+    reg.addSensor("hw", "value");
+}
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Configuration Tests
+// =============================================================================
+
+void test_adaptive_rejects_invalid_range() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    TEST_ASSERT_FALSE(reg.setAdaptiveInterval("hw", 0, 1000, 1.0f));
+    TEST_ASSERT_FALSE(reg.setAdaptiveInterval("hw", 5000, 1000, 1.0f));
+    TEST_ASSERT_FALSE(reg.setAdaptiveInterval("hw", 1000, 5000, 0.0f));
+    TEST_ASSERT_EQUAL(60000, reg.getEffectiveInterval("hw"));
+}
+
+void test_adaptive_starts_at_max_interval() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    reg.setAdaptiveInterval("hw", 5000, 120000, 1.0f);
+    TEST_ASSERT_EQUAL(120000, reg.getEffectiveInterval("hw"));
+
+    reg.clearAdaptiveInterval("hw");
+    TEST_ASSERT_EQUAL(60000, reg.getEffectiveInterval("hw"));
+}
+
+void test_reported_json_has_adaptive_range() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    reg.setAdaptiveInterval("hw", 5000, 120000, 1.0f);
+
+    char buffer[256];
+    reg.buildReportedJson(buffer, sizeof(buffer), true);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"interval\":60"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer,
+        "\"adaptive\":{\"min\":5,\"max\":120,\"rate\":1,\"avg\":120}"));
+}
+
+// =============================================================================
+// Trace Replay Tests
+// =============================================================================
+
+void test_light_switch_published_immediately() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    reg.setAdaptiveInterval("hw", 5000, 120000, 10.0f);
+
+    const size_t n = sizeof(LIGHT_TRACE) / sizeof(LIGHT_TRACE[0]);
+    bool published[n];
+    size_t total = replay(reg, LIGHT_TRACE, n, LIGHT_PERIOD_MS, published);
+
+    TEST_ASSERT_TRUE(published[LIGHT_SWITCH_INDEX]);
+    // A fixed 5 s interval would publish every sample
+    TEST_ASSERT_LESS_THAN(n / 3, total);
+}
+
+void test_light_dark_phase_uses_long_interval() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    reg.setAdaptiveInterval("hw", 5000, 120000, 10.0f);
+
+    bool published[LIGHT_SWITCH_INDEX];
+    size_t total = replay(reg, LIGHT_TRACE, LIGHT_SWITCH_INDEX, LIGHT_PERIOD_MS, published);
+
+    // 300 s of noise-only signal: a handful of publishes at most
+    TEST_ASSERT_LESS_OR_EQUAL(4, total);
+    TEST_ASSERT_GREATER_THAN(90000, reg.getEffectiveInterval("hw"));
+}
+
+void test_light_relaxes_after_transition() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    reg.setAdaptiveInterval("hw", 5000, 120000, 10.0f);
+
+    const size_t n = sizeof(LIGHT_TRACE) / sizeof(LIGHT_TRACE[0]);
+    bool published[n];
+    replay(reg, LIGHT_TRACE, n, LIGHT_PERIOD_MS, published);
+
+    // Five minutes of stable light later, the interval is long again
+    TEST_ASSERT_GREATER_THAN(60000, reg.getEffectiveInterval("hw"));
+}
+
+void test_irrigation_rise_sampled_at_min_interval() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    reg.setAdaptiveInterval("hw", 10000, 300000, 0.1f);
+
+    const size_t n = sizeof(SOIL_TRACE) / sizeof(SOIL_TRACE[0]);
+    bool published[n];
+    size_t total = replay(reg, SOIL_TRACE, n, SOIL_PERIOD_MS, published);
+
+    size_t duringRise = 0;
+    for (size_t i = SOIL_IRRIGATION_START; i <= SOIL_IRRIGATION_END; i++) {
+        if (published[i]) duringRise++;
+    }
+    TEST_ASSERT_EQUAL(SOIL_IRRIGATION_END - SOIL_IRRIGATION_START + 1, duringRise);
+    TEST_ASSERT_LESS_THAN(n / 2, total);
+}
+
+void test_fixed_interval_unaffected_by_samples() {
+    SensorRegistry reg;
+    setupHardware(reg);
+    reg.setHardwareInterval("hw", 120000);
+
+    const size_t n = sizeof(LIGHT_TRACE) / sizeof(LIGHT_TRACE[0]);
+    bool published[n];
+    replay(reg, LIGHT_TRACE, n, LIGHT_PERIOD_MS, published);
+    TEST_ASSERT_EQUAL(120000, reg.getEffectiveInterval("hw"));
+    // Without adaptive mode the switch waits for the next fixed slot
+    TEST_ASSERT_FALSE(published[LIGHT_SWITCH_INDEX]);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Configuration
+    RUN_TEST(test_adaptive_rejects_invalid_range);
+    RUN_TEST(test_adaptive_starts_at_max_interval);
+    RUN_TEST(test_reported_json_has_adaptive_range);
+
+    // Trace Replay
+    RUN_TEST(test_light_switch_published_immediately);
+    RUN_TEST(test_light_dark_phase_uses_long_interval);
+    RUN_TEST(test_light_relaxes_after_transition);
+    RUN_TEST(test_irrigation_rise_sampled_at_min_interval);
+    RUN_TEST(test_fixed_interval_unaffected_by_samples);
+
+    return UNITY_END();
+}
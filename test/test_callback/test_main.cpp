@@ -0,0 +1,183 @@
+/**
+ * @file test_callback/test_main.cpp
+ * @brief Tests and dispatch benchmark of Callback
+ */
+
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include "../../src/core/Callback.h"
+
+// Allocations made by the process, counted by the global allocator below
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* ptr = malloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+// Counts live copies, to check copies and destruction of captures
+struct Tracked {
+    static int alive;
+    int value;
+    explicit Tracked(int v) : value(v) { alive++; }
+    Tracked(const Tracked& other) : value(other.value) { alive++; }
+    ~Tracked() { alive--; }
+};
+int Tracked::alive = 0;
+
+static int twice(int value) {
+    return value * 2;
+}
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Behavior Tests
+// =============================================================================
+
+void test_empty_callback() {
+    Callback<void(bool)> callback;
+    TEST_ASSERT_FALSE(callback);
+    Callback<void(bool)> fromNull = nullptr;
+    TEST_ASSERT_FALSE(fromNull);
+    int (*none)(int) = nullptr;
+    Callback<int(int)> fromNullPointer = none;
+    TEST_ASSERT_FALSE(fromNullPointer);
+}
+
+void test_calls_lambda_and_function_pointer() {
+    int base = 10;
+    Callback<int(int)> lambda = [&base](int value) { return base + value; };
+    TEST_ASSERT_TRUE(lambda);
+    TEST_ASSERT_EQUAL(15, lambda(5));
+
+    Callback<int(int)> function = twice;
+    TEST_ASSERT_EQUAL(14, function(7));
+
+    lambda = nullptr;
+    TEST_ASSERT_FALSE(lambda);
+}
+
+void test_mutable_state_and_reassignment() {
+    int calls = 0;
+    Callback<void()> callback = [&calls]() { calls++; };
+    callback();
+    callback();
+    TEST_ASSERT_EQUAL(2, calls);
+
+    callback = [&calls]() { calls += 10; };
+    callback();
+    TEST_ASSERT_EQUAL(12, calls);
+}
+
+void test_copy_and_move_non_trivial_capture() {
+    {
+        Tracked tracked(7);
+        Callback<int()> original = [tracked]() { return tracked.value; };
+        TEST_ASSERT_EQUAL(2, Tracked::alive);
+
+        Callback<int()> copy = original;
+        TEST_ASSERT_EQUAL(3, Tracked::alive);
+        TEST_ASSERT_EQUAL(7, copy());
+
+        Callback<int()> moved = std::move(original);
+        TEST_ASSERT_FALSE(original);
+        TEST_ASSERT_EQUAL(3, Tracked::alive);
+        TEST_ASSERT_EQUAL(7, moved());
+
+        copy = nullptr;
+        TEST_ASSERT_EQUAL(2, Tracked::alive);
+    }
+    TEST_ASSERT_EQUAL(0, Tracked::alive);
+}
+
+void test_never_allocates() {
+    size_t before = allocations;
+    int a = 1, b = 2, c = 3, d = 4;
+    Callback<int()> callback = [&a, &b, &c, &d]() { return a + b + c + d; };
+    Callback<int()> copy = callback;
+    TEST_ASSERT_EQUAL(10, copy());
+    TEST_ASSERT_EQUAL(before, allocations);
+
+    // The same capture in std::function goes to the heap
+    std::function<int()> function = [&a, &b, &c, &d]() { return a + b + c + d; };
+    TEST_ASSERT_EQUAL(10, function());
+    TEST_ASSERT_TRUE(allocations > before);
+}
+
+// =============================================================================
+// Benchmark
+// =============================================================================
+
+static const int CALLS = 2000000;
+
+template <class F>
+static double nsPerCall(const F& callback) {
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        sink = callback(sink);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / CALLS;
+}
+
+void test_dispatch_benchmark() {
+    int step = 1;
+    auto lambda = [&step](int value) { return value + step; };
+    Callback<int(int)> callback = lambda;
+    std::function<int(int)> function = lambda;
+
+    // Warm up, then best of three
+    double callbackNs = 1e9, functionNs = 1e9;
+    nsPerCall(callback);
+    for (int run = 0; run < 3; run++) {
+        double ns = nsPerCall(callback);
+        if (ns < callbackNs) callbackNs = ns;
+        ns = nsPerCall(function);
+        if (ns < functionNs) functionNs = ns;
+    }
+
+    char message[96];
+    snprintf(message, sizeof(message), "Callback %.2f ns/call, std::function %.2f ns/call",
+             callbackNs, functionNs);
+    TEST_MESSAGE(message);
+    // Both are one indirect call: same order of magnitude
+    TEST_ASSERT_TRUE(callbackNs < functionNs * 2 + 1);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Behavior
+    RUN_TEST(test_empty_callback);
+    RUN_TEST(test_calls_lambda_and_function_pointer);
+    RUN_TEST(test_mutable_state_and_reassignment);
+    RUN_TEST(test_copy_and_move_non_trivial_capture);
+    RUN_TEST(test_never_allocates);
+
+    // Benchmark
+    RUN_TEST(test_dispatch_benchmark);
+
+    return UNITY_END();
+}
@@ -0,0 +1,180 @@
+/**
+ * @file test_config_shadow/test_main.cpp
+ * @brief Unit tests for ConfigShadow
+ */
+
+#include <unity.h>
+#include <cstring>
+#include <string>
+#include "../../src/core/ConfigShadow.h"
+#include "../../src/core/SensorRegistry.h"
+
+SensorRegistry* registry;
+ConfigShadow* shadow;
+char buffer[512];
+
+void setUp(void) {
+    registry = new SensorRegistry();
+    shadow = new ConfigShadow();
+    registry->registerHardware("dht22", "DHT22");
+    registry->addSensor("dht22", "temperature");
+    registry->registerHardware("soil", "Soil");
+    registry->addSensor("soil", "moisture");
+}
+
+void tearDown(void) {
+    delete shadow;
+    delete registry;
+}
+
+// =============================================================================
+// Version Tests
+// =============================================================================
+
+void test_desired_applied_once() {
+    TEST_ASSERT_TRUE(shadow->acceptDesired(1));
+    TEST_ASSERT_FALSE(shadow->acceptDesired(1));
+    TEST_ASSERT_FALSE(shadow->acceptDesired(0));
+    TEST_ASSERT_TRUE(shadow->acceptDesired(5));
+    TEST_ASSERT_EQUAL_UINT32(5, shadow->desiredVersion());
+}
+
+void test_restored_version_blocks_redelivery() {
+    shadow->restoreDesiredVersion(9);
+    TEST_ASSERT_FALSE(shadow->acceptDesired(9));
+    TEST_ASSERT_TRUE(shadow->acceptDesired(10));
+}
+
+// =============================================================================
+// Report Tests
+// =============================================================================
+
+void test_full_report_contains_all_hardware() {
+    shadow->buildReport(*registry, buffer, sizeof(buffer), true);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"version\":0,\"seq\":1,\"full\":true,\"sensors\":{"
+        "\"dht22\":{\"interval\":60,\"enabled\":true,\"adaptive\":false,\"burst\":null,"
+        "\"aligned\":false},"
+        "\"soil\":{\"interval\":60,\"enabled\":true,\"adaptive\":false,\"burst\":null,"
+        "\"aligned\":false}}}",
+        buffer);
+    TEST_ASSERT_FALSE(shadow->needsReport(*registry));
+}
+
+void test_delta_report_contains_changed_fields_only() {
+    shadow->buildReport(*registry, buffer, sizeof(buffer), true);
+
+    registry->setHardwareInterval("soil", 300000);
+    TEST_ASSERT_TRUE(shadow->needsReport(*registry));
+    shadow->buildReport(*registry, buffer, sizeof(buffer), false);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"version\":0,\"seq\":2,\"sensors\":{\"soil\":{\"interval\":300}}}", buffer);
+}
+
+void test_unchanged_value_is_not_reported() {
+    shadow->buildReport(*registry, buffer, sizeof(buffer), true);
+    registry->setHardwareInterval("dht22", 60000);
+    registry->setHardwareEnabled("dht22", true);
+    TEST_ASSERT_FALSE(shadow->needsReport(*registry));
+}
+
+void test_new_desired_version_is_reported_without_changes() {
+    shadow->buildReport(*registry, buffer, sizeof(buffer), true);
+
+    // Desired document matching the current state still needs an ack
+    shadow->acceptDesired(3);
+    TEST_ASSERT_TRUE(shadow->needsReport(*registry));
+    shadow->buildReport(*registry, buffer, sizeof(buffer), false);
+    TEST_ASSERT_EQUAL_STRING("{\"version\":3,\"seq\":2,\"sensors\":{}}", buffer);
+    TEST_ASSERT_EQUAL_UINT32(3, shadow->reportedVersion());
+}
+
+void test_local_changes_are_reported() {
+    shadow->buildReport(*registry, buffer, sizeof(buffer), true);
+
+    registry->setIntervalOverride("dht22", 1000, 60000, 0);
+    registry->setHardwareEnabled("soil", false);
+    shadow->buildReport(*registry, buffer, sizeof(buffer), false);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"version\":0,\"seq\":2,\"sensors\":{"
+        "\"dht22\":{\"burst\":{\"interval\":1}},"
+        "\"soil\":{\"enabled\":false}}}", buffer);
+
+    registry->expireNextOverride(60000);
+    shadow->buildReport(*registry, buffer, sizeof(buffer), false);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"version\":0,\"seq\":3,\"sensors\":{\"dht22\":{\"burst\":null}}}", buffer);
+}
+
+void test_truncated_report_keeps_changes() {
+    char small[32];
+    size_t length = shadow->buildReport(*registry, small, sizeof(small), true);
+    TEST_ASSERT_TRUE(length >= sizeof(small));
+    TEST_ASSERT_TRUE(shadow->needsReport(*registry));
+
+    shadow->buildReport(*registry, buffer, sizeof(buffer), false);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"seq\":1"));
+}
+
+void test_large_report_split_into_parts() {
+    static const char* const keys[] = {"pump1", "pump2", "pump3", "pump4", "pump5", "pump6"};
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++) {
+        registry->registerHardware(keys[i], "Pump");
+    }
+    shadow->acceptDesired(4);
+
+    // About two entries per part
+    char part[256];
+    std::string parts[8];
+    size_t count = 0;
+    bool full = true;
+    while (shadow->needsReport(*registry) && count < 8) {
+        size_t length = shadow->buildReport(*registry, part, sizeof(part), full);
+        TEST_ASSERT_TRUE(length < sizeof(part));
+        parts[count++] = part;
+        full = false;
+    }
+    TEST_ASSERT_TRUE(count > 1);
+    TEST_ASSERT_FALSE(shadow->needsReport(*registry));
+    TEST_ASSERT_EQUAL_UINT32(4, shadow->reportedVersion());
+
+    // Every hardware exactly once, "full" on the first part, "more" on all but the last
+    std::string all;
+    for (size_t i = 0; i < count; i++) {
+        char seq[16];
+        snprintf(seq, sizeof(seq), "\"seq\":%u,", (unsigned)(i + 1));
+        TEST_ASSERT_NOT_NULL(strstr(parts[i].c_str(), seq));
+        TEST_ASSERT_EQUAL(i == 0, strstr(parts[i].c_str(), "\"full\":true") != nullptr);
+        TEST_ASSERT_EQUAL(i + 1 < count, strstr(parts[i].c_str(), "\"more\":true") != nullptr);
+        all += parts[i];
+    }
+    const char* names[] = {"\"dht22\":{", "\"soil\":{", "\"pump1\":{", "\"pump6\":{"};
+    for (size_t i = 0; i < 4; i++) {
+        const char* first = strstr(all.c_str(), names[i]);
+        TEST_ASSERT_NOT_NULL(first);
+        TEST_ASSERT_NULL(strstr(first + 1, names[i]));
+    }
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Versions
+    RUN_TEST(test_desired_applied_once);
+    RUN_TEST(test_restored_version_blocks_redelivery);
+
+    // Reports
+    RUN_TEST(test_full_report_contains_all_hardware);
+    RUN_TEST(test_delta_report_contains_changed_fields_only);
+    RUN_TEST(test_unchanged_value_is_not_reported);
+    RUN_TEST(test_new_desired_version_is_reported_without_changes);
+    RUN_TEST(test_local_changes_are_reported);
+    RUN_TEST(test_truncated_report_keeps_changes);
+    RUN_TEST(test_large_report_split_into_parts);
+
+    return UNITY_END();
+}
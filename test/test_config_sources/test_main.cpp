@@ -0,0 +1,124 @@
+/**
+ * @file test_config_sources/test_main.cpp
+ * @brief Unit tests for ConfigSources
+ */
+
+#include <unity.h>
+#include "../../src/core/ConfigSources.h"
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Topic Tests
+// =============================================================================
+
+void test_type_and_group_topics() {
+    ConfigSources sources;
+    TEST_ASSERT_TRUE(sources.joinGroup("greenhouse-a"));
+    TEST_ASSERT_TRUE(sources.setModuleType("climate"));
+
+    TEST_ASSERT_EQUAL(2, sources.count());
+    TEST_ASSERT_EQUAL_STRING("types/climate/sensors/config", sources.get(0).topic);
+    TEST_ASSERT_EQUAL_STRING("groups/greenhouse-a/sensors/config", sources.get(1).topic);
+}
+
+void test_match_topic() {
+    ConfigSources sources;
+    sources.setModuleType("climate");
+    sources.joinGroup("greenhouse-a");
+
+    TEST_ASSERT_EQUAL(0, sources.match("types/climate/sensors/config"));
+    TEST_ASSERT_EQUAL(1, sources.match("groups/greenhouse-a/sensors/config"));
+    TEST_ASSERT_EQUAL(-1, sources.match("groups/other/sensors/config"));
+    TEST_ASSERT_EQUAL(-1, sources.match("growbox-01/sensors/config"));
+}
+
+void test_invalid_group_names_rejected() {
+    ConfigSources sources;
+    TEST_ASSERT_FALSE(sources.joinGroup(""));
+    TEST_ASSERT_FALSE(sources.joinGroup("a/b"));
+    TEST_ASSERT_FALSE(sources.joinGroup("#"));
+    TEST_ASSERT_TRUE(sources.joinGroup("fleet"));
+    TEST_ASSERT_FALSE(sources.joinGroup("fleet"));
+}
+
+void test_group_limit() {
+    ConfigSources sources;
+    const char* names[] = {"g0", "g1", "g2", "g3", "g4"};
+    for (int i = 0; i < IOT_GROUPS_MAX; i++) {
+        TEST_ASSERT_TRUE(sources.joinGroup(names[i]));
+    }
+    TEST_ASSERT_FALSE(sources.joinGroup(names[IOT_GROUPS_MAX]));
+    // The type source does not count against the group limit
+    TEST_ASSERT_TRUE(sources.setModuleType("climate"));
+    TEST_ASSERT_EQUAL(IOT_GROUPS_MAX + 1, sources.count());
+}
+
+// =============================================================================
+// Precedence Tests
+// =============================================================================
+
+void test_priority_order_is_deterministic() {
+    ConfigSources sources;
+    sources.joinGroup("site");
+    sources.joinGroup("greenhouse-a");
+    sources.setModuleType("climate");
+
+    uint8_t type = sources.get(0).priority;
+    uint8_t site = sources.get(1).priority;
+    uint8_t greenhouse = sources.get(2).priority;
+    TEST_ASSERT_TRUE(type < site);
+    TEST_ASSERT_TRUE(site < greenhouse);
+    TEST_ASSERT_TRUE(greenhouse < ConfigSources::MODULE_PRIORITY);
+    TEST_ASSERT_TRUE(ConfigSources::DEFAULT_PRIORITY < type);
+}
+
+// =============================================================================
+// Version Tests
+// =============================================================================
+
+void test_version_applied_once() {
+    ConfigSources sources;
+    sources.joinGroup("fleet");
+    TEST_ASSERT_TRUE(sources.acceptVersion(0, 3));
+    TEST_ASSERT_FALSE(sources.acceptVersion(0, 3));
+    TEST_ASSERT_FALSE(sources.acceptVersion(0, 2));
+    TEST_ASSERT_TRUE(sources.acceptVersion(0, 4));
+}
+
+void test_restored_version_blocks_redelivery() {
+    ConfigSources sources;
+    sources.joinGroup("fleet");
+    sources.restoreVersion(0, 7);
+    TEST_ASSERT_FALSE(sources.acceptVersion(0, 7));
+    TEST_ASSERT_TRUE(sources.acceptVersion(0, 8));
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Topics
+    RUN_TEST(test_type_and_group_topics);
+    RUN_TEST(test_match_topic);
+    RUN_TEST(test_invalid_group_names_rejected);
+    RUN_TEST(test_group_limit);
+
+    // Precedence
+    RUN_TEST(test_priority_order_is_deterministic);
+
+    // Versions
+    RUN_TEST(test_version_applied_once);
+    RUN_TEST(test_restored_version_blocks_redelivery);
+
+    return UNITY_END();
+}
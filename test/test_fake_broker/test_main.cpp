@@ -0,0 +1,343 @@
+/**
+ * @file test_fake_broker/test_main.cpp
+ * @brief Integration tests of MqttClient and IotMesurable over FakeBroker
+ */
+
+#include <unity.h>
+#include <string>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/FakeBroker.h"
+#include "../../src/core/MqttClient.h"
+
+static std::string lastTopic;
+static std::string lastPayload;
+static int disconnects;
+
+void setUp(void) {
+    lastTopic.clear();
+    lastPayload.clear();
+    disconnects = 0;
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+static void connectClient(MqttClient& client, FakeBroker& broker) {
+    client.setTransport(&broker);
+    client.setBroker("broker", 1883);
+    client.setClientId("m");
+    client.setPresenceTopic("m/presence");
+    client.onConnect([](bool connected) {
+        if (!connected) disconnects++;
+    });
+    client.onMessage([](const char* topic, const char* payload) {
+        lastTopic = topic;
+        lastPayload = payload;
+    });
+    client.connect();
+    broker.advance(2 * 100); // Enough for the latencies used below
+    client.loop();
+}
+
+static size_t countTopic(const FakeBroker& broker, const char* topic) {
+    size_t count = 0;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        if (broker.received()[i].topic == topic) count++;
+    }
+    return count;
+}
+
+// One loop tick of the multi-sensor example plus status and system state
+static void publishTick(MqttClient& client) {
+    client.publish("m/dht22/temperature", "21.50");
+    client.publish("m/dht22/humidity", "48.20");
+    client.publish("m/soil/moisture", "37.00");
+    client.publish("m/ldr/light", "812.00");
+    client.publish("m/sensors/status", "{\"moduleId\":\"m\",\"sensors\":{}}", true);
+    client.publish("m/system/state", "{\"uptime\":120,\"heapFreeKb\":180}", true);
+    client.flush();
+}
+
+// =============================================================================
+// Link Tests
+// =============================================================================
+
+void test_connect_takes_one_round_trip() {
+    FakeBroker broker;
+    broker.setLatency(30);
+    MqttClient client;
+    client.setTransport(&broker);
+    client.setBroker("broker", 1883);
+    client.setPresenceTopic("m/presence");
+    client.connect();
+
+    broker.advance(59);
+    client.loop();
+    TEST_ASSERT_FALSE(client.isConnected());
+    broker.advance(1);
+    client.loop();
+    TEST_ASSERT_TRUE(client.isConnected());
+
+    // "online" is one latency away
+    broker.advance(29);
+    TEST_ASSERT_EQUAL(0, broker.received().size());
+    broker.advance(1);
+    TEST_ASSERT_EQUAL(1, broker.received().size());
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("m/presence"));
+}
+
+void test_bandwidth_benchmark_batched_vs_unbatched() {
+    // 2400 bit/s radio link, 40 bytes of TCP/IP headers per write
+    unsigned long elapsed[2];
+    size_t wire[2];
+    for (int batched = 0; batched < 2; batched++) {
+        FakeBroker broker;
+        broker.setBandwidth(300);
+        MqttClient client;
+        connectClient(client, broker);
+        if (!batched) client.setBatching(0, 0);
+        broker.settle();
+        size_t writesBefore = broker.writes();
+        size_t wireBefore = broker.wireBytes();
+
+        publishTick(client);
+        elapsed[batched] = broker.settle();
+        wire[batched] = broker.wireBytes() - wireBefore;
+        TEST_ASSERT_EQUAL(batched ? 1 : 6, broker.writes() - writesBefore);
+        TEST_ASSERT_EQUAL(7, broker.received().size());
+    }
+
+    // Same payloads, 5 x 40 bytes of headers less
+    TEST_ASSERT_EQUAL(200, wire[0] - wire[1]);
+    TEST_ASSERT_TRUE(elapsed[1] < elapsed[0]);
+    TEST_ASSERT_TRUE(elapsed[0] - elapsed[1] >= 600); // 200 B at 300 B/s
+}
+
+void test_loss_retransmits_in_order() {
+    FakeBroker broker;
+    broker.setLatency(10);
+    broker.setLoss(30, 42);
+    MqttClient client;
+    connectClient(client, broker);
+    client.setBatching(0, 0);
+
+    char payload[8];
+    for (int i = 0; i < 20; i++) {
+        snprintf(payload, sizeof(payload), "%d", i);
+        client.publish("m/counter", payload);
+    }
+    broker.settle();
+
+    TEST_ASSERT_TRUE(broker.retransmits() > 0);
+    TEST_ASSERT_EQUAL(20, countTopic(broker, "m/counter"));
+    int expected = 0;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        const BrokerMessage& message = broker.received()[i];
+        if (message.topic != "m/counter") continue;
+        TEST_ASSERT_EQUAL(expected++, atoi(message.payload.c_str()));
+    }
+}
+
+void test_puback_delay_limits_inflight_window() {
+    FakeBroker broker;
+    broker.setLatency(10);
+    broker.setPubackDelay(100);
+    broker.setMaxInflight(2);
+    MqttClient client;
+    connectClient(client, broker);
+    broker.advance(200);
+    client.loop(); // PUBACK of "online"
+
+    const uint8_t payload[] = {'1'};
+    TEST_ASSERT_TRUE(broker.publish("m/a", payload, 1, MqttQos::AtLeastOnce, false));
+    TEST_ASSERT_TRUE(broker.publish("m/b", payload, 1, MqttQos::AtLeastOnce, false));
+    TEST_ASSERT_FALSE(broker.publish("m/c", payload, 1, MqttQos::AtLeastOnce, false));
+    TEST_ASSERT_EQUAL(1, broker.rejected());
+
+    // Arrives after 10 ms, acked 100 ms later, back after 10 ms more
+    broker.advance(119);
+    client.loop();
+    TEST_ASSERT_EQUAL(2, broker.inflight());
+    broker.advance(1);
+    client.loop();
+    TEST_ASSERT_EQUAL(0, broker.inflight());
+    TEST_ASSERT_TRUE(broker.publish("m/c", payload, 1, MqttQos::AtLeastOnce, false));
+}
+
+// =============================================================================
+// Session Tests
+// =============================================================================
+
+void test_drop_loses_inflight_writes_and_publishes_will() {
+    FakeBroker broker;
+    broker.setLatency(50);
+    MqttClient client;
+    connectClient(client, broker);
+    broker.settle();
+
+    client.publish("m/dht22/temperature", "21.50");
+    client.flush();
+    broker.dropConnection();
+    client.loop();
+
+    TEST_ASSERT_FALSE(client.isConnected());
+    TEST_ASSERT_EQUAL(1, disconnects);
+    broker.settle();
+    TEST_ASSERT_EQUAL(0, countTopic(broker, "m/dht22/temperature"));
+    TEST_ASSERT_EQUAL_STRING("offline", broker.retained("m/presence"));
+}
+
+void test_client_reconnects_after_interval() {
+    FakeBroker broker;
+    MqttClient client;
+    connectClient(client, broker);
+    broker.setReachable(false);
+    broker.dropConnection();
+    client.loop();
+
+    // Nothing before the reconnect interval
+    broker.advance(4000);
+    client.loop();
+    TEST_ASSERT_EQUAL(1, broker.connects());
+
+    // First retry after the reconnect interval, refused
+    broker.advance(1001);
+    client.loop();
+    client.loop();
+    TEST_ASSERT_EQUAL(2, broker.connects());
+    TEST_ASSERT_FALSE(client.isConnected());
+
+    broker.setReachable(true);
+    broker.advance(5001);
+    client.loop();
+    client.loop();
+    TEST_ASSERT_TRUE(client.isConnected());
+    TEST_ASSERT_EQUAL(3, broker.connects());
+    broker.settle();
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("m/presence"));
+}
+
+void test_retained_message_delivered_on_subscribe() {
+    FakeBroker broker;
+    broker.setLatency(20);
+    broker.deliver("m/sensors/config", "{\"dht22\":{\"interval\":30}}", true);
+    MqttClient client;
+    connectClient(client, broker);
+
+    client.subscribe("m/sensors/+");
+    broker.advance(39);
+    client.loop();
+    TEST_ASSERT_TRUE(lastPayload.empty());
+    broker.advance(1);
+    client.loop();
+    TEST_ASSERT_EQUAL_STRING("m/sensors/config", lastTopic.c_str());
+
+    TEST_ASSERT_TRUE(broker.deliver("m/sensors/enable", "{\"dht22\":false}"));
+    TEST_ASSERT_FALSE(broker.deliver("other/sensors/enable", "{}"));
+    broker.advance(20);
+    client.loop();
+    TEST_ASSERT_EQUAL_STRING("{\"dht22\":false}", lastPayload.c_str());
+}
+
+void test_topic_filter_matching() {
+    TEST_ASSERT_TRUE(FakeBroker::matches("m/+/temperature", "m/dht22/temperature"));
+    TEST_ASSERT_FALSE(FakeBroker::matches("m/+/temperature", "m/dht22/humidity"));
+    TEST_ASSERT_TRUE(FakeBroker::matches("m/#", "m/sensors/status"));
+    TEST_ASSERT_TRUE(FakeBroker::matches("m/#", "m"));
+    TEST_ASSERT_FALSE(FakeBroker::matches("m/sensors", "m/sensors/status"));
+}
+
+// =============================================================================
+// IotMesurable Tests
+// =============================================================================
+
+void test_iot_mesurable_over_fake_broker() {
+    FakeBroker broker;
+    broker.setLatency(25);
+
+    IotMesurable brain("m");
+    brain.setPhase(0);
+    brain.registerHardware("dht22", "DHT22");
+    brain.addSensor("dht22", "temperature");
+    brain.setTransport(&broker);
+    brain.begin("ssid", "password", "broker", 1883);
+    brain.loop();
+    TEST_ASSERT_FALSE(brain.isConnected());
+
+    broker.advance(50);
+    brain.loop();
+    TEST_ASSERT_TRUE(brain.isConnected());
+    TEST_ASSERT_TRUE(broker.subscribed("m/sensors/config"));
+
+    brain.publish("dht22", "temperature", 21.5f);
+    brain.loop();
+    broker.settle();
+    TEST_ASSERT_EQUAL(1, countTopic(broker, "m/dht22/temperature"));
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("m/presence"));
+}
+
+void test_large_shadow_report_converges() {
+    FakeBroker broker;
+    static const char* const keys[] = {
+        "hardware01", "hardware02", "hardware03", "hardware04", "hardware05", "hardware06",
+        "hardware07", "hardware08", "hardware09", "hardware10", "hardware11", "hardware12"};
+
+    // More hardware than one IOT_REPORT_BYTES report holds
+    IotMesurable brain("m");
+    brain.setPhase(0);
+    for (size_t i = 0; i < 12; i++) {
+        brain.registerHardware(keys[i], "Hardware");
+        brain.addSensor(keys[i], "value");
+    }
+    brain.setTransport(&broker);
+    brain.begin("ssid", "password", "broker", 1883);
+    broker.advance(10);
+    brain.loop();
+    brain.loop();
+    broker.settle();
+
+    std::string all;
+    std::string last;
+    size_t parts = 0;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        const BrokerMessage& message = broker.received()[i];
+        if (message.topic != "m/shadow/reported") continue;
+        TEST_ASSERT_TRUE(message.retain);
+        all += message.payload;
+        last = message.payload;
+        parts++;
+    }
+    TEST_ASSERT_TRUE(parts > 1);
+    TEST_ASSERT_NULL(strstr(last.c_str(), "\"more\""));
+    for (size_t i = 0; i < 12; i++) {
+        TEST_ASSERT_NOT_NULL_MESSAGE(strstr(all.c_str(), keys[i]), keys[i]);
+    }
+    TEST_ASSERT_EQUAL_STRING(last.c_str(), broker.retained("m/shadow/reported"));
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Link
+    RUN_TEST(test_connect_takes_one_round_trip);
+    RUN_TEST(test_bandwidth_benchmark_batched_vs_unbatched);
+    RUN_TEST(test_loss_retransmits_in_order);
+    RUN_TEST(test_puback_delay_limits_inflight_window);
+
+    // Session
+    RUN_TEST(test_drop_loses_inflight_writes_and_publishes_will);
+    RUN_TEST(test_client_reconnects_after_interval);
+    RUN_TEST(test_retained_message_delivered_on_subscribe);
+    RUN_TEST(test_topic_filter_matching);
+
+    // IotMesurable
+    RUN_TEST(test_iot_mesurable_over_fake_broker);
+    RUN_TEST(test_large_shadow_report_converges);
+
+    return UNITY_END();
+}
@@ -0,0 +1,256 @@
+/**
+ * @file test_logger/test_main.cpp
+ * @brief Unit tests for Logger and log delivery
+ */
+
+#include <unity.h>
+#include <string>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/FakeBroker.h"
+#include "../../src/core/JsonEncoder.h"
+#include "../../src/core/Logger.h"
+
+static Logger& logger = Logger::instance();
+
+static char msg[IOT_LOG_BYTES];
+static LogLevel level;
+static unsigned long logTime;
+
+static bool nextMqtt() {
+    return logger.next(LogSink::Mqtt, msg, sizeof(msg), level, logTime);
+}
+
+// One call site, called repeatedly
+static void logFromLoop(int i) {
+    IOT_LOG_WARN("Retry %d", i);
+}
+
+void setUp(void) {
+    logger.clear();
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Recording Tests
+// =============================================================================
+
+void test_records_formatted_on_read() {
+    char name[16] = "dht22";
+    IOT_LOG_INFO("Sensor %s at %d%% (%.1f, %lu)", name, 42, 0.5f, 7ul);
+    strcpy(name, "changed"); // Strings are copied at the call
+
+    TEST_ASSERT_TRUE(nextMqtt());
+    TEST_ASSERT_EQUAL_STRING("Sensor dht22 at 42% (0.5, 7)", msg);
+    TEST_ASSERT_TRUE(level == LogLevel::Info);
+    TEST_ASSERT_EQUAL(millis(), logTime);
+    TEST_ASSERT_FALSE(nextMqtt());
+}
+
+void test_levels_below_minimum_compiled_out() {
+    int evaluated = 0;
+    IOT_LOG_DEBUG("Debug %d", ++evaluated);
+    TEST_ASSERT_EQUAL(0, evaluated);
+    TEST_ASSERT_FALSE(logger.hasPending(LogSink::Mqtt));
+
+    IOT_LOG_ERROR("Error %d", ++evaluated);
+    TEST_ASSERT_EQUAL(1, evaluated);
+    TEST_ASSERT_TRUE(nextMqtt());
+    TEST_ASSERT_TRUE(level == LogLevel::Error);
+}
+
+void test_mismatched_arguments_not_formatted() {
+    static LogSite site = {"%s and %d", LogLevel::Info, 0, 0, 0};
+    logger.record(site, 5);
+    TEST_ASSERT_TRUE(nextMqtt());
+    TEST_ASSERT_EQUAL_STRING("? and ?", msg);
+}
+
+void test_rate_limited_per_call_site() {
+    for (int i = 0; i < 8; i++) {
+        logFromLoop(i);
+    }
+    IOT_LOG_WARN("Other site");
+
+    int records = 0;
+    while (nextMqtt()) records++;
+    TEST_ASSERT_EQUAL(IOT_LOG_SITE_BURST + 1, records);
+    TEST_ASSERT_EQUAL(8 - IOT_LOG_SITE_BURST, logger.suppressed());
+
+    // Next window: the first record carries the count
+    delay(IOT_LOG_SITE_WINDOW_MS);
+    logFromLoop(8);
+    TEST_ASSERT_TRUE(nextMqtt());
+    TEST_ASSERT_EQUAL_STRING("Retry 8 (3 suppressed)", msg);
+}
+
+// =============================================================================
+// Buffer Tests
+// =============================================================================
+
+void test_sinks_read_independently() {
+    logger.write(LogLevel::Info, "one");
+    logger.write(LogLevel::Info, "two");
+
+    TEST_ASSERT_TRUE(logger.next(LogSink::Console, msg, sizeof(msg), level, logTime));
+    TEST_ASSERT_TRUE(logger.next(LogSink::Console, msg, sizeof(msg), level, logTime));
+    TEST_ASSERT_FALSE(logger.hasPending(LogSink::Console));
+
+    TEST_ASSERT_TRUE(nextMqtt());
+    TEST_ASSERT_EQUAL_STRING("one", msg);
+}
+
+void test_oldest_dropped_when_full() {
+    char text[64];
+    int written = 0;
+    while (logger.dropped() < 3) {
+        snprintf(text, sizeof(text), "message %03d ................................", written);
+        logger.write(LogLevel::Info, text);
+        written++;
+    }
+
+    // Survivors are intact and in order, after the dropped ones
+    int expected = (int)logger.dropped();
+    while (nextMqtt()) {
+        snprintf(text, sizeof(text), "message %03d ................................", expected);
+        TEST_ASSERT_EQUAL_STRING(text, msg);
+        expected++;
+    }
+    TEST_ASSERT_EQUAL(written, expected);
+}
+
+// =============================================================================
+// Delivery Tests
+// =============================================================================
+
+void test_encoder_escapes_message() {
+    char buffer[128];
+    size_t length = JsonEncoder::log(buffer, sizeof(buffer), "warn",
+                                     "bad \"json\"\n\\ end", 12);
+    TEST_ASSERT_EQUAL(strlen(buffer), length);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"level\":\"warn\",\"msg\":\"bad \\\"json\\\"\\n\\\\ end\",\"time\":12}", buffer);
+
+    // Too small: reported like snprintf
+    TEST_ASSERT_TRUE(JsonEncoder::log(buffer, 20, "warn", "bad \"json\"", 12) >= 20);
+}
+
+void test_offline_logs_delivered_on_connect() {
+    FakeBroker broker;
+    IotMesurable module("m");
+    module.log("warn", "offline \"quoted\"");
+    module.log("debug", "below the minimum level");
+
+    module.setPhase(0);
+    module.setTransport(&broker);
+    module.begin("ssid", "password", "broker", 1883);
+    broker.advance(10);
+    module.loop();
+    broker.settle();
+
+    const char* payload = nullptr;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        if (broker.received()[i].topic == "m/logs" &&
+            broker.received()[i].payload.find("offline") != std::string::npos) {
+            payload = broker.received()[i].payload.c_str();
+        }
+        TEST_ASSERT_TRUE(broker.received()[i].payload.find("below the minimum") ==
+                         std::string::npos);
+    }
+    TEST_ASSERT_NOT_NULL(payload);
+    TEST_ASSERT_TRUE(strstr(payload, "\"level\":\"warn\"") != nullptr);
+    TEST_ASSERT_TRUE(strstr(payload, "\"msg\":\"offline \\\"quoted\\\"\"") != nullptr);
+}
+
+// Payloads a topic received on either broker, ';'-separated
+static std::string payloadsOf(const FakeBroker& first, const FakeBroker& second,
+                              const char* topic) {
+    std::string payloads;
+    const FakeBroker* brokers[] = {&first, &second};
+    for (const FakeBroker* broker : brokers) {
+        for (size_t i = 0; i < broker->received().size(); i++) {
+            if (broker->received()[i].topic == topic) {
+                payloads += broker->received()[i].payload + ";";
+            }
+        }
+    }
+    return payloads;
+}
+
+void test_records_go_to_the_module_that_logged() {
+    FakeBroker climateBroker;
+    FakeBroker irrigationBroker;
+    IotMesurable climate("climate-01");
+    IotMesurable irrigation("irrigation-01");
+    climate.setPhase(0);
+    irrigation.setPhase(0);
+    climate.setTransport(&climateBroker);
+    irrigation.setTransport(&irrigationBroker);
+    climate.begin("ssid", "password", "broker", 1883);
+    irrigation.begin("ssid", "password", "broker", 1883);
+    climateBroker.advance(10);
+    irrigationBroker.advance(10);
+    climate.loop();
+    irrigation.loop();
+
+    climate.log("warn", "Fan stalled");
+    irrigation.log("warn", "Pump dry run");
+    irrigation.loop(); // Loops first: the climate record still goes to its topic
+    climate.loop();
+    climateBroker.settle();
+    irrigationBroker.settle();
+
+    std::string climateLogs = payloadsOf(climateBroker, irrigationBroker, "climate-01/logs");
+    std::string irrigationLogs =
+        payloadsOf(climateBroker, irrigationBroker, "irrigation-01/logs");
+    TEST_ASSERT_TRUE(climateLogs.find("\"msg\":\"Fan stalled\"") != std::string::npos);
+    TEST_ASSERT_TRUE(irrigationLogs.find("\"msg\":\"Pump dry run\"") != std::string::npos);
+    TEST_ASSERT_TRUE(climateLogs.find("Pump dry run") == std::string::npos);
+    TEST_ASSERT_TRUE(irrigationLogs.find("Fan stalled") == std::string::npos);
+}
+
+void test_source_prefixed_unless_asked_for() {
+    char source[16];
+    logger.write(LogLevel::Warn, "Fan stalled", "climate-01");
+    logger.write(LogLevel::Info, "Library record");
+
+    TEST_ASSERT_TRUE(logger.next(LogSink::Console, msg, sizeof(msg), level, logTime));
+    TEST_ASSERT_EQUAL_STRING("[climate-01] Fan stalled", msg);
+    TEST_ASSERT_TRUE(logger.next(LogSink::Mqtt, msg, sizeof(msg), level, logTime,
+                                 source, sizeof(source)));
+    TEST_ASSERT_EQUAL_STRING("Fan stalled", msg);
+    TEST_ASSERT_EQUAL_STRING("climate-01", source);
+    TEST_ASSERT_TRUE(level == LogLevel::Warn);
+    TEST_ASSERT_TRUE(logger.next(LogSink::Mqtt, msg, sizeof(msg), level, logTime,
+                                 source, sizeof(source)));
+    TEST_ASSERT_EQUAL_STRING("Library record", msg);
+    TEST_ASSERT_EQUAL_STRING("", source);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Recording
+    RUN_TEST(test_records_formatted_on_read);
+    RUN_TEST(test_levels_below_minimum_compiled_out);
+    RUN_TEST(test_mismatched_arguments_not_formatted);
+    RUN_TEST(test_rate_limited_per_call_site);
+
+    // Buffer
+    RUN_TEST(test_sinks_read_independently);
+    RUN_TEST(test_oldest_dropped_when_full);
+
+    // Delivery
+    RUN_TEST(test_encoder_escapes_message);
+    RUN_TEST(test_offline_logs_delivered_on_connect);
+    RUN_TEST(test_records_go_to_the_module_that_logged);
+    RUN_TEST(test_source_prefixed_unless_asked_for);
+
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+/**
+ * @file test_low_ram/test_main.cpp
+ * @brief RAM used per sensor by the registry, and a 100-sensor status (run with
+ *        and without IOT_LOW_RAM)
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/FakeBroker.h"
+#include "../../src/core/SensorRegistry.h"
+
+// Live heap bytes, counted by the global allocator below
+static size_t heapBytes = 0;
+
+void* operator new(size_t size) {
+    size_t* block = static_cast<size_t*>(malloc(size + sizeof(size_t)));
+    if (!block) throw std::bad_alloc();
+    *block = size;
+    heapBytes += size;
+    return block + 1;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    size_t* block = static_cast<size_t*>(ptr) - 1;
+    heapBytes -= *block;
+    free(block);
+}
+
+// Per sensor, native 64-bit (pointers and longs are half as large on ESP8266)
+#ifdef IOT_LOW_RAM
+static const size_t SENSOR_BUDGET = 80;
+#else
+static const size_t SENSOR_BUDGET = 160;
+#endif
+
+static const int HARDWARE_COUNT = 20;
+static const int SENSORS_PER_HARDWARE = 5;
+
+static const char* const HARDWARE_KEYS[HARDWARE_COUNT] = {
+    "hw00", "hw01", "hw02", "hw03", "hw04", "hw05", "hw06", "hw07", "hw08", "hw09",
+    "hw10", "hw11", "hw12", "hw13", "hw14", "hw15", "hw16", "hw17", "hw18", "hw19"};
+static const char* const SENSOR_TYPES[SENSORS_PER_HARDWARE] = {
+    "temperature", "humidity", "pressure", "co2", "light"};
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+static void registerAll(SensorRegistry& registry) {
+    for (int h = 0; h < HARDWARE_COUNT; h++) {
+        registry.registerHardware(HARDWARE_KEYS[h], "Climate sensor");
+        for (int s = 0; s < SENSORS_PER_HARDWARE; s++) {
+            registry.addSensor(HARDWARE_KEYS[h], SENSOR_TYPES[s]);
+        }
+    }
+}
+
+// =============================================================================
+// RAM Tests
+// =============================================================================
+
+void test_hundred_sensors_within_budget() {
+    size_t before = heapBytes;
+    SensorRegistry* registry = new SensorRegistry();
+    registerAll(*registry);
+    registry->shrinkToFit();
+
+    size_t sensors = HARDWARE_COUNT * SENSORS_PER_HARDWARE;
+    size_t perSensor = (heapBytes - before) / sensors;
+    char message[64];
+    snprintf(message, sizeof(message), "%u bytes per sensor", (unsigned)perSensor);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(perSensor <= SENSOR_BUDGET);
+
+    delete registry;
+    TEST_ASSERT_EQUAL(before, heapBytes);
+}
+
+void test_shrink_releases_spare_capacity() {
+    SensorRegistry registry;
+    registerAll(registry);
+    size_t grown = heapBytes;
+    registry.shrinkToFit();
+    TEST_ASSERT_TRUE(heapBytes < grown);
+
+    // Registration still works afterwards
+    TEST_ASSERT_TRUE(registry.addSensor("hw00", "voltage"));
+    TEST_ASSERT_TRUE(registry.hasSensor("hw00", "voltage"));
+}
+
+void test_strings_stored_by_registration_mode() {
+    SensorRegistry registry;
+    registerAll(registry);
+    const HardwareDef* hw = registry.getHardware("hw07");
+    TEST_ASSERT_NOT_NULL(hw);
+    TEST_ASSERT_EQUAL_STRING("hw07", hw->key);
+    TEST_ASSERT_EQUAL_STRING("humidity", hw->sensors[1].type);
+#ifdef IOT_LOW_RAM
+    // Pointers to the registered literals, not copies
+    TEST_ASSERT_TRUE(hw->key == HARDWARE_KEYS[7]);
+    TEST_ASSERT_TRUE(hw->sensors[1].type == SENSOR_TYPES[1]);
+#endif
+}
+
+// =============================================================================
+// Status Tests
+// =============================================================================
+
+void test_hundred_sensor_status_published() {
+    FakeBroker broker;
+    IotMesurable module("m");
+    module.setPhase(0);
+    for (int h = 0; h < HARDWARE_COUNT; h++) {
+        module.registerHardware(HARDWARE_KEYS[h], "Climate sensor");
+        for (int s = 0; s < SENSORS_PER_HARDWARE; s++) {
+            module.addSensor(HARDWARE_KEYS[h], SENSOR_TYPES[s]);
+        }
+    }
+    module.setTransport(&broker);
+    module.begin("ssid", "password", "broker", 1883);
+    broker.advance(10);
+    module.loop();
+    module.publishStatusNow();
+    module.loop();
+    broker.settle();
+
+    // Every sensor in one of the parts, each within IOT_STATUS_BYTES
+    std::string all;
+    std::string last;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        const BrokerMessage& message = broker.received()[i];
+        if (message.topic != "m/sensors/status") continue;
+        TEST_ASSERT_TRUE(message.payload.size() < IOT_STATUS_BYTES);
+        all += message.payload;
+        last = message.payload;
+    }
+    TEST_ASSERT_NULL(strstr(last.c_str(), "\"more\""));
+    char key[32];
+    for (int h = 0; h < HARDWARE_COUNT; h++) {
+        for (int s = 0; s < SENSORS_PER_HARDWARE; s++) {
+            snprintf(key, sizeof(key), "\"%s:%s\"", HARDWARE_KEYS[h], SENSOR_TYPES[s]);
+            TEST_ASSERT_NOT_NULL_MESSAGE(strstr(all.c_str(), key), key);
+        }
+    }
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // RAM
+    RUN_TEST(test_hundred_sensors_within_budget);
+    RUN_TEST(test_shrink_releases_spare_capacity);
+    RUN_TEST(test_strings_stored_by_registration_mode);
+
+    // Status
+    RUN_TEST(test_hundred_sensor_status_published);
+
+    return UNITY_END();
+}
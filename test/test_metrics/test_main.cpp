@@ -0,0 +1,67 @@
+/**
+ * @file test_metrics/test_main.cpp
+ * @brief Unit tests for Metrics
+ */
+
+#include <unity.h>
+#include "../../src/core/Metrics.h"
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+void test_counter_and_gauge() {
+    Metrics m;
+    m.add("burstStarted");
+    m.add("burstStarted");
+    m.set("burstActive", 1);
+    TEST_ASSERT_EQUAL(2, m.get("burstStarted"));
+    TEST_ASSERT_EQUAL(1, m.get("burstActive"));
+    TEST_ASSERT_EQUAL(0, m.get("unknown"));
+}
+
+void test_keep_max() {
+    Metrics m;
+    m.keepMax("peak", 5);
+    m.keepMax("peak", 3);
+    TEST_ASSERT_EQUAL(5, m.get("peak"));
+}
+
+void test_build_json() {
+    Metrics m;
+    char buffer[64];
+    m.buildJson(buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("{}", buffer);
+
+    m.add("a", 2);
+    m.set("b", -1);
+    m.buildJson(buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("{\"a\":2,\"b\":-1}", buffer);
+}
+
+void test_table_full_ignores_new_names() {
+    // Names must outlive the table
+    static char names[IOT_METRICS_MAX + 1][8];
+    Metrics m;
+    for (int i = 0; i <= IOT_METRICS_MAX; i++) {
+        snprintf(names[i], sizeof(names[i]), "m%d", i);
+        m.add(names[i]);
+    }
+    TEST_ASSERT_EQUAL(IOT_METRICS_MAX, m.count());
+    TEST_ASSERT_EQUAL(0, m.get(names[IOT_METRICS_MAX]));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_counter_and_gauge);
+    RUN_TEST(test_keep_max);
+    RUN_TEST(test_build_json);
+    RUN_TEST(test_table_full_ignores_new_names);
+
+    return UNITY_END();
+}
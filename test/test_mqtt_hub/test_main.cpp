@@ -0,0 +1,392 @@
+/**
+ * @file test_mqtt_hub/test_main.cpp
+ * @brief Tests of MqttHub over FakeBroker
+ */
+
+#include <unity.h>
+#include <string>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/FakeBroker.h"
+#include "../../src/core/MqttHub.h"
+
+static std::string climateTopics;
+static std::string irrigationTopics;
+static int climateConnects;
+static int irrigationConnects;
+
+void setUp(void) {
+    climateTopics.clear();
+    irrigationTopics.clear();
+    climateConnects = 0;
+    irrigationConnects = 0;
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+static void attachClimate(MqttHub& hub) {
+    hub.attach("climate-01",
+               [](bool connected) {
+                   if (connected) climateConnects++;
+               },
+               [](const char* topic, const char*) {
+                   climateTopics += topic;
+                   climateTopics += ";";
+               });
+}
+
+static void attachIrrigation(MqttHub& hub) {
+    hub.attach("irrigation-01",
+               [](bool connected) {
+                   if (connected) irrigationConnects++;
+               },
+               [](const char* topic, const char*) {
+                   irrigationTopics += topic;
+                   irrigationTopics += ";";
+               });
+}
+
+static void connectHub(MqttHub& hub, FakeBroker& broker) {
+    hub.client().setTransport(&broker);
+    hub.client().setBroker("broker", 1883);
+    TEST_ASSERT_TRUE(hub.connect());
+    broker.advance(100);
+    hub.client().loop();
+    TEST_ASSERT_TRUE(hub.client().isConnected());
+}
+
+static size_t countTopic(const FakeBroker& broker, const char* topic) {
+    size_t count = 0;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        if (broker.received()[i].topic == topic) count++;
+    }
+    return count;
+}
+
+static size_t countPrefix(const FakeBroker& broker, const char* prefix) {
+    size_t count = 0;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        if (broker.received()[i].topic.compare(0, strlen(prefix), prefix) == 0) count++;
+    }
+    return count;
+}
+
+// =============================================================================
+// Session Tests
+// =============================================================================
+
+void test_modules_share_one_session() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+    connectHub(hub, broker);
+    TEST_ASSERT_TRUE(hub.connect()); // Second module: no new session
+    hub.client().loop();
+    broker.settle();
+
+    TEST_ASSERT_EQUAL(1, broker.connects());
+    TEST_ASSERT_EQUAL(2, hub.modules());
+    TEST_ASSERT_EQUAL(1, climateConnects);
+    TEST_ASSERT_EQUAL(1, irrigationConnects);
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("greenhouse/presence"));
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("climate-01/presence"));
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("irrigation-01/presence"));
+}
+
+void test_late_attach_is_told_connected() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    connectHub(hub, broker);
+
+    attachIrrigation(hub);
+    TEST_ASSERT_EQUAL(1, irrigationConnects);
+    hub.client().loop();
+    broker.settle();
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("irrigation-01/presence"));
+}
+
+void test_detach_marks_module_offline() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+    connectHub(hub, broker);
+
+    hub.detach("irrigation-01");
+    hub.client().loop();
+    broker.settle();
+    TEST_ASSERT_EQUAL(1, hub.modules());
+    TEST_ASSERT_NULL(hub.stats("irrigation-01"));
+    TEST_ASSERT_EQUAL_STRING("offline", broker.retained("irrigation-01/presence"));
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("climate-01/presence"));
+    TEST_ASSERT_TRUE(hub.client().isConnected());
+}
+
+void test_drop_publishes_hub_will() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    connectHub(hub, broker);
+    hub.client().loop();
+    broker.settle();
+
+    broker.dropConnection();
+    hub.client().loop();
+    // One will per session: only the hub topic changes
+    TEST_ASSERT_EQUAL_STRING("offline", broker.retained("greenhouse/presence"));
+    TEST_ASSERT_EQUAL_STRING("online", broker.retained("climate-01/presence"));
+}
+
+void test_full_hub_refuses_module() {
+    MqttHub hub("greenhouse");
+    static const char* ids[] = {"m0", "m1", "m2", "m3", "m4"};
+    for (size_t i = 0; i < IOT_MQTT_HUB_MODULES; i++) {
+        TEST_ASSERT_TRUE(hub.attach(ids[i], nullptr, nullptr));
+    }
+    TEST_ASSERT_FALSE(hub.attach(ids[IOT_MQTT_HUB_MODULES], nullptr, nullptr));
+    // Re-attaching replaces callbacks, no new slot
+    TEST_ASSERT_TRUE(hub.attach(ids[0], nullptr, nullptr));
+}
+
+// =============================================================================
+// Routing Tests
+// =============================================================================
+
+void test_messages_routed_by_module_prefix() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+    connectHub(hub, broker);
+    hub.subscribe("climate-01", "climate-01/sensors/enable");
+    hub.subscribe("irrigation-01", "irrigation-01/sensors/enable");
+
+    broker.deliver("climate-01/sensors/enable", "{}");
+    broker.advance(0);
+    hub.client().loop();
+    TEST_ASSERT_EQUAL_STRING("climate-01/sensors/enable;", climateTopics.c_str());
+    TEST_ASSERT_TRUE(irrigationTopics.empty());
+
+    TEST_ASSERT_EQUAL(1, hub.stats("climate-01")->received);
+    TEST_ASSERT_EQUAL(0, hub.stats("irrigation-01")->received);
+}
+
+void test_shared_topic_routed_to_subscribers() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+    connectHub(hub, broker);
+    hub.subscribe("climate-01", "groups/north/sensors/config");
+    hub.subscribe("irrigation-01", "groups/north/sensors/config");
+    hub.subscribe("irrigation-01", "types/pump/sensors/config");
+
+    broker.deliver("groups/north/sensors/config", "{}");
+    broker.deliver("types/pump/sensors/config", "{}");
+    broker.advance(0);
+    hub.client().loop();
+    TEST_ASSERT_EQUAL_STRING("groups/north/sensors/config;", climateTopics.c_str());
+    TEST_ASSERT_EQUAL_STRING("groups/north/sensors/config;types/pump/sensors/config;",
+                             irrigationTopics.c_str());
+
+    // Routes of a detached module are dropped
+    hub.detach("irrigation-01");
+    broker.deliver("types/pump/sensors/config", "{}");
+    broker.advance(0);
+    hub.client().loop();
+    TEST_ASSERT_EQUAL_STRING("groups/north/sensors/config;", climateTopics.c_str());
+}
+
+void test_wildcard_filters_routed() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+    connectHub(hub, broker);
+    hub.subscribe("climate-01", "groups/+/sensors/config");
+    hub.subscribe("irrigation-01", "types/pump/#");
+
+    broker.deliver("groups/north/sensors/config", "{}");
+    broker.deliver("types/pump/sensors/config", "{}");
+    broker.deliver("groups/north/sensors/desired", "{}");
+    broker.advance(0);
+    hub.client().loop();
+    TEST_ASSERT_EQUAL_STRING("groups/north/sensors/config;", climateTopics.c_str());
+    TEST_ASSERT_EQUAL_STRING("types/pump/sensors/config;", irrigationTopics.c_str());
+}
+
+void test_publish_stats_per_module() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+    connectHub(hub, broker);
+
+    hub.publish("climate-01/dht22/temperature", "21.50");
+    hub.publish("climate-01/dht22/humidity", "48.20");
+    hub.publish("irrigation-01/pump/flow", "3.1");
+    hub.client().loop();
+    broker.settle();
+
+    // Presence is the hub's, not counted
+    TEST_ASSERT_EQUAL(2, hub.stats("climate-01")->published);
+    TEST_ASSERT_EQUAL(10, hub.stats("climate-01")->publishedBytes);
+    TEST_ASSERT_EQUAL(1, hub.stats("irrigation-01")->published);
+    TEST_ASSERT_EQUAL(3, hub.stats("irrigation-01")->publishedBytes);
+}
+
+// =============================================================================
+// Tick Tests
+// =============================================================================
+
+void test_one_write_per_round_of_module_loops() {
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+    connectHub(hub, broker);
+    size_t writes = hub.client().batchWrites();
+
+    // The first module's tick leaves its publish for the end of the round
+    hub.beginTick("climate-01");
+    hub.publish("climate-01/dht22/temperature", "21.50");
+    hub.endTick("climate-01");
+    TEST_ASSERT_EQUAL(writes, hub.client().batchWrites());
+
+    hub.beginTick("irrigation-01");
+    hub.publish("irrigation-01/pump/flow", "3.1");
+    hub.endTick("irrigation-01");
+    TEST_ASSERT_EQUAL(writes + 1, hub.client().batchWrites());
+    broker.settle();
+    TEST_ASSERT_EQUAL(1, countTopic(broker, "climate-01/dht22/temperature"));
+    TEST_ASSERT_EQUAL(1, countTopic(broker, "irrigation-01/pump/flow"));
+
+    // A module that skips a round does not hold the others back for long
+    hub.beginTick("climate-01");
+    hub.publish("climate-01/dht22/temperature", "21.60");
+    hub.endTick("climate-01");
+    hub.beginTick("climate-01");
+    TEST_ASSERT_EQUAL(writes + 2, hub.client().batchWrites());
+}
+
+void test_modem_sleeps_once_no_module_needs_it() {
+    MqttHub hub("greenhouse");
+    attachClimate(hub);
+    attachIrrigation(hub);
+
+    TEST_ASSERT_FALSE(hub.setRadioNeeded("climate-01", false));
+    TEST_ASSERT_TRUE(hub.setRadioNeeded("irrigation-01", false));
+    TEST_ASSERT_TRUE(hub.setRadioNeeded("climate-01", true));
+    TEST_ASSERT_FALSE(hub.setRadioNeeded("irrigation-01", true));
+}
+
+// =============================================================================
+// IotMesurable Tests
+// =============================================================================
+
+void test_iot_mesurable_modules_over_hub() {
+    FakeBroker broker;
+    broker.setLatency(25);
+    MqttHub hub("greenhouse");
+    hub.client().setTransport(&broker);
+
+    HubModule climate("climate-01", hub);
+    climate.setPhase(0);
+    climate.registerHardware("dht22", "DHT22");
+    climate.addSensor("dht22", "temperature");
+    HubModule irrigation("irrigation-01", hub);
+    irrigation.setPhase(0);
+    irrigation.registerHardware("flow", "YF-S201");
+    irrigation.addSensor("flow", "flow");
+
+    climate.begin("ssid", "password", "broker", 1883);
+    irrigation.begin("ssid", "password", "broker", 1883);
+    broker.advance(50);
+    climate.loop();
+    irrigation.loop();
+    TEST_ASSERT_TRUE(climate.isConnected());
+    TEST_ASSERT_TRUE(irrigation.isConnected());
+    TEST_ASSERT_EQUAL(1, broker.connects());
+    TEST_ASSERT_TRUE(broker.subscribed("climate-01/sensors/config"));
+    TEST_ASSERT_TRUE(broker.subscribed("irrigation-01/sensors/config"));
+
+    climate.publish("dht22", "temperature", 21.5f);
+    irrigation.publish("flow", "flow", 3.0f);
+    climate.loop();
+    irrigation.loop();
+    broker.settle();
+    TEST_ASSERT_EQUAL(1, countTopic(broker, "climate-01/dht22/temperature"));
+    TEST_ASSERT_EQUAL(1, countTopic(broker, "irrigation-01/flow/flow"));
+
+    // Each module's stats cover its own traffic only (presence excluded)
+    TEST_ASSERT_EQUAL(countPrefix(broker, "climate-01/") - 1,
+                      hub.stats("climate-01")->published);
+    TEST_ASSERT_EQUAL(countPrefix(broker, "irrigation-01/") - 1,
+                      hub.stats("irrigation-01")->published);
+}
+
+void test_logs_go_to_hub_topic() {
+    Logger::instance().clear();
+    FakeBroker broker;
+    MqttHub hub("greenhouse");
+    hub.client().setTransport(&broker);
+    HubModule climate("climate-01", hub);
+    HubModule irrigation("irrigation-01", hub);
+    climate.begin("ssid", "password", "broker", 1883);
+    irrigation.begin("ssid", "password", "broker", 1883);
+    broker.advance(50);
+    climate.loop();
+    irrigation.loop();
+
+    climate.log("warn", "Fan stalled");
+    irrigation.log("warn", "Pump dry run");
+    irrigation.loop(); // Loops first: still delivers the climate record once
+    climate.loop();
+    broker.settle();
+
+    TEST_ASSERT_EQUAL(0, countTopic(broker, "climate-01/logs"));
+    TEST_ASSERT_EQUAL(0, countTopic(broker, "irrigation-01/logs"));
+    std::string logs;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        if (broker.received()[i].topic == "greenhouse/logs") {
+            logs += broker.received()[i].payload;
+        }
+    }
+    TEST_ASSERT_TRUE(logs.find("[climate-01] Fan stalled") != std::string::npos);
+    TEST_ASSERT_TRUE(logs.find("[irrigation-01] Pump dry run") != std::string::npos);
+    TEST_ASSERT_EQUAL(logs.find("Fan stalled"), logs.rfind("Fan stalled"));
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Session
+    RUN_TEST(test_modules_share_one_session);
+    RUN_TEST(test_late_attach_is_told_connected);
+    RUN_TEST(test_detach_marks_module_offline);
+    RUN_TEST(test_drop_publishes_hub_will);
+    RUN_TEST(test_full_hub_refuses_module);
+
+    // Routing
+    RUN_TEST(test_messages_routed_by_module_prefix);
+    RUN_TEST(test_shared_topic_routed_to_subscribers);
+    RUN_TEST(test_wildcard_filters_routed);
+    RUN_TEST(test_publish_stats_per_module);
+
+    // Ticks
+    RUN_TEST(test_one_write_per_round_of_module_loops);
+    RUN_TEST(test_modem_sleeps_once_no_module_needs_it);
+
+    // IotMesurable
+    RUN_TEST(test_iot_mesurable_modules_over_hub);
+    RUN_TEST(test_logs_go_to_hub_topic);
+
+    return UNITY_END();
+}
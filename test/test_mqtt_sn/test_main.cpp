@@ -0,0 +1,270 @@
+/**
+ * @file test_mqtt_sn/test_main.cpp
+ * @brief Unit tests for MqttSnTransport against the loopback gateway
+ */
+
+#include <unity.h>
+#include <string>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/MqttClient.h"
+#include "../../src/core/MqttSnLoopback.h"
+#include "../../src/core/MqttSnTransport.h"
+
+static const uint8_t SN_CONNECT = 0x04;
+static const uint8_t SN_REGISTER = 0x0A;
+
+static std::string lastTopic;
+static std::string lastPayload;
+
+void setUp(void) {
+    lastTopic.clear();
+    lastPayload.clear();
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+static MqttSessionConfig sessionConfig(const char* willTopic) {
+    MqttSessionConfig config;
+    config.host = "gateway";
+    config.port = 1884;
+    config.clientId = "m";
+    config.username = "";
+    config.password = "";
+    config.willTopic = willTopic;
+    config.willPayload = "offline";
+    return config;
+}
+
+static void publishText(MqttSnTransport& sn, const char* topic, const char* payload) {
+    sn.publish(topic, (const uint8_t*)payload, strlen(payload), MqttQos::AtMostOnce, false);
+}
+
+// =============================================================================
+// Session Tests
+// =============================================================================
+
+void test_connect_with_will() {
+    MqttSnLoopback gateway;
+    MqttSnTransport sn(gateway);
+    TEST_ASSERT_TRUE(sn.connect(sessionConfig("m/presence")));
+    TEST_ASSERT_FALSE(sn.connected());
+
+    sn.loop(); // WILLTOPICREQ, WILLMSGREQ, CONNACK
+    TEST_ASSERT_TRUE(sn.connected());
+    TEST_ASSERT_TRUE(gateway.clientConnected());
+
+    gateway.dropClient();
+    TEST_ASSERT_EQUAL(1, gateway.published().size());
+    TEST_ASSERT_EQUAL_STRING("m/presence", gateway.published()[0].topic.c_str());
+    TEST_ASSERT_EQUAL_STRING("offline", gateway.published()[0].payload.c_str());
+    TEST_ASSERT_TRUE(gateway.published()[0].retain);
+}
+
+void test_sessionless_publishes_predefined_topics() {
+    MqttSnLoopback gateway;
+    gateway.predefine("m/dht22/temperature", 0x0101);
+    MqttSnTransport sn(gateway);
+    sn.setSessionless(true);
+    sn.predefineTopic("m/dht22/temperature", 0x0101);
+    sn.connect(sessionConfig(nullptr));
+
+    publishText(sn, "m/dht22/temperature", "21.50");
+    publishText(sn, "m/sensors/status", "{}"); // Not predefined: dropped
+
+    TEST_ASSERT_EQUAL(0, gateway.count(SN_CONNECT));
+    TEST_ASSERT_EQUAL(1, gateway.published().size());
+    TEST_ASSERT_EQUAL(-1, gateway.published()[0].qos);
+    TEST_ASSERT_EQUAL_STRING("21.50", gateway.published()[0].payload.c_str());
+}
+
+void test_topic_registered_once() {
+    MqttSnLoopback gateway;
+    MqttSnTransport sn(gateway);
+    sn.connect(sessionConfig(nullptr));
+    sn.loop();
+
+    publishText(sn, "m/sensors/status", "{\"a\":1}");
+    TEST_ASSERT_EQUAL(1, sn.held()); // Waits for REGACK
+    sn.loop();
+    TEST_ASSERT_EQUAL(0, sn.held());
+    publishText(sn, "m/sensors/status", "{\"a\":2}");
+
+    TEST_ASSERT_EQUAL(1, gateway.count(SN_REGISTER));
+    TEST_ASSERT_EQUAL(2, gateway.published().size());
+    TEST_ASSERT_EQUAL_STRING("{\"a\":2}", gateway.published()[1].payload.c_str());
+}
+
+void test_held_message_keeps_its_qos() {
+    MqttSnLoopback gateway;
+    MqttSnTransport sn(gateway);
+    sn.connect(sessionConfig(nullptr));
+    sn.loop();
+
+    // Held for the REGACK, sent at the QoS it was published with
+    const char* payload = "online";
+    sn.publish("m/presence", (const uint8_t*)payload, strlen(payload),
+               MqttQos::AtLeastOnce, true);
+    TEST_ASSERT_EQUAL(1, sn.held());
+    sn.loop();
+    publishText(sn, "m/presence", "online");
+
+    TEST_ASSERT_EQUAL(2, gateway.published().size());
+    TEST_ASSERT_EQUAL(MqttQos::AtLeastOnce, gateway.published()[0].qos);
+    TEST_ASSERT_TRUE(gateway.published()[0].retain);
+    TEST_ASSERT_EQUAL(MqttQos::AtMostOnce, gateway.published()[1].qos);
+}
+
+void test_subscription_delivers_messages() {
+    MqttSnLoopback gateway;
+    MqttSnTransport sn(gateway);
+    sn.onMessage([](const char* topic, const char* payload) {
+        lastTopic = topic;
+        lastPayload = payload;
+    });
+    sn.connect(sessionConfig(nullptr));
+    sn.loop();
+    sn.subscribe("m/sensors/enable");
+    sn.loop();
+
+    TEST_ASSERT_TRUE(gateway.deliver("m/sensors/enable", "{\"dht22\":false}"));
+    sn.loop();
+    TEST_ASSERT_EQUAL_STRING("m/sensors/enable", lastTopic.c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"dht22\":false}", lastPayload.c_str());
+}
+
+void test_asleep_client_gets_held_messages_on_wake() {
+    MqttSnLoopback gateway;
+    MqttSnTransport sn(gateway);
+    sn.onMessage([](const char* topic, const char* payload) { lastPayload = payload; });
+    sn.connect(sessionConfig(nullptr));
+    sn.loop();
+    sn.subscribe("m/sensors/burst");
+    sn.loop();
+
+    sn.sleep(60000);
+    TEST_ASSERT_TRUE(sn.asleep());
+    TEST_ASSERT_TRUE(sn.connected());
+    TEST_ASSERT_TRUE(gateway.clientAsleep());
+    TEST_ASSERT_EQUAL(60 + IOT_MQTTSN_KEEPALIVE_S, gateway.sleepDuration());
+
+    gateway.deliver("m/sensors/burst", "{\"interval\":1}");
+    sn.loop();
+    TEST_ASSERT_TRUE(lastPayload.empty());
+
+    sn.wake();
+    publishText(sn, "m/sensors/burst/ack", "{}"); // Held until CONNACK
+    sn.loop();
+    TEST_ASSERT_FALSE(sn.asleep());
+    TEST_ASSERT_EQUAL_STRING("{\"interval\":1}", lastPayload.c_str());
+    TEST_ASSERT_EQUAL(0, sn.held());
+    TEST_ASSERT_EQUAL(1, gateway.published().size());
+}
+
+// =============================================================================
+// Client Integration Tests
+// =============================================================================
+
+void test_mqtt_client_over_mqtt_sn() {
+    MqttSnLoopback gateway;
+    MqttSnTransport sn(gateway);
+    MqttClient client;
+    client.setTransport(&sn);
+    client.setBroker("gateway", 1884);
+    client.setClientId("m");
+    client.setPresenceTopic("m/presence");
+    TEST_ASSERT_TRUE(client.connect());
+    client.loop();
+    TEST_ASSERT_TRUE(client.isConnected());
+
+    // Batched publishes are replayed through the transport
+    client.publish("m/dht22/temperature", "21.50");
+    client.publish("m/dht22/humidity", "48.20");
+    client.flush();
+    client.loop();
+
+    const std::vector<LoopbackMessage>& published = gateway.published();
+    TEST_ASSERT_EQUAL(3, published.size());
+    TEST_ASSERT_EQUAL_STRING("m/presence", published[0].topic.c_str());
+    TEST_ASSERT_EQUAL_STRING("online", published[0].payload.c_str());
+    TEST_ASSERT_EQUAL_STRING("m/dht22/humidity", published[2].topic.c_str());
+}
+
+void test_iot_mesurable_over_mqtt_sn() {
+    MqttSnLoopback gateway;
+    gateway.predefine("m/dht22/temperature", 0x0101);
+    MqttSnTransport sn(gateway);
+
+    IotMesurable brain("m");
+    brain.setPhase(0);
+    brain.registerHardware("dht22", "DHT22");
+    brain.addSensor("dht22", "temperature");
+    brain.setTransport(&sn);
+    TEST_ASSERT_EQUAL(0x0101, sn.topicId("m/dht22/temperature"));
+
+    brain.begin("ssid", "password", "gateway", 1884);
+    brain.loop();
+    TEST_ASSERT_TRUE(brain.isConnected());
+
+    brain.publish("dht22", "temperature", 21.5f);
+    brain.loop();
+
+    bool found = false;
+    for (size_t i = 0; i < gateway.published().size(); i++) {
+        const LoopbackMessage& message = gateway.published()[i];
+        if (message.topic == "m/dht22/temperature" && message.payload == "21.50") found = true;
+    }
+    TEST_ASSERT_TRUE(found);
+}
+
+void test_iot_mesurable_over_sessionless_mqtt_sn() {
+    MqttSnLoopback gateway;
+    gateway.predefine("m/dht22/temperature", 0x0101);
+    MqttSnTransport sn(gateway);
+    sn.setSessionless(true);
+
+    IotMesurable brain("m");
+    brain.setPhase(0);
+    brain.registerHardware("dht22", "DHT22");
+    brain.addSensor("dht22", "temperature");
+    brain.setTransport(&sn);
+
+    brain.begin("ssid", "password", "gateway", 1884);
+    brain.loop();
+    TEST_ASSERT_TRUE(brain.isConnected());
+
+    brain.publish("dht22", "temperature", 21.5f);
+    brain.loop();
+
+    // No session, and only the predefined sensor topic goes out (QoS -1)
+    TEST_ASSERT_EQUAL(0, gateway.count(SN_CONNECT));
+    TEST_ASSERT_EQUAL(0, gateway.count(SN_REGISTER));
+    TEST_ASSERT_EQUAL(1, gateway.published().size());
+    TEST_ASSERT_EQUAL_STRING("m/dht22/temperature", gateway.published()[0].topic.c_str());
+    TEST_ASSERT_EQUAL_STRING("21.50", gateway.published()[0].payload.c_str());
+    TEST_ASSERT_EQUAL(-1, gateway.published()[0].qos);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Session
+    RUN_TEST(test_connect_with_will);
+    RUN_TEST(test_sessionless_publishes_predefined_topics);
+    RUN_TEST(test_topic_registered_once);
+    RUN_TEST(test_held_message_keeps_its_qos);
+    RUN_TEST(test_subscription_delivers_messages);
+    RUN_TEST(test_asleep_client_gets_held_messages_on_wake);
+
+    // Client Integration
+    RUN_TEST(test_mqtt_client_over_mqtt_sn);
+    RUN_TEST(test_iot_mesurable_over_mqtt_sn);
+    RUN_TEST(test_iot_mesurable_over_sessionless_mqtt_sn);
+
+    return UNITY_END();
+}
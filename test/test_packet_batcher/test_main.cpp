@@ -0,0 +1,288 @@
+/**
+ * @file test_packet_batcher/test_main.cpp
+ * @brief Unit tests for PacketBatcher
+ */
+
+#include <unity.h>
+#include <cstring>
+#include "../../src/core/MqttClient.h"
+#include "../../src/core/MqttTransport.h"
+#include "../../src/core/PacketBatcher.h"
+
+// Fake transport: records every write like a socket would see it
+static uint8_t written[4096];
+static size_t writtenBytes;
+static int writeCalls;
+static size_t largestWrite;
+
+static size_t fakeWrite(const uint8_t* data, size_t length, size_t& writes) {
+    writes = 1;
+    memcpy(written + writtenBytes, data, length);
+    writtenBytes += length;
+    writeCalls++;
+    if (length > largestWrite) largestWrite = length;
+    return length;
+}
+
+// Transport framing its own packets: uses the default batch replay
+class ReplayTransport : public MqttTransport {
+public:
+    ReplayTransport() : accepted(0), capacity(100) {}
+
+    bool connect(const MqttSessionConfig& config) override { return true; }
+    void disconnect() override {}
+    bool connected() const override { return true; }
+    bool subscribe(const char* topic) override { return true; }
+    bool publish(const char* topic, const uint8_t* payload, size_t length,
+                 int8_t qos, bool retain) override {
+        if (accepted >= capacity) return false; // Send queue full
+        accepted++;
+        return true;
+    }
+
+    int accepted;
+    int capacity;
+};
+
+void setUp(void) {
+    writtenBytes = 0;
+    writeCalls = 0;
+    largestWrite = 0;
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// One loop tick of the multi-sensor example plus status and system state
+static void publishTick(PacketBatcher& batcher, unsigned long now) {
+    batcher.add("m/dht22/temperature", "21.50", false, now);
+    batcher.add("m/dht22/humidity", "48.20", false, now);
+    batcher.add("m/soil/moisture", "37.00", false, now);
+    batcher.add("m/ldr/light", "812.00", false, now);
+    batcher.add("m/sensors/status", "{\"moduleId\":\"m\",\"sensors\":{}}", true, now);
+    batcher.add("m/system/state", "{\"uptime\":120,\"heapFreeKb\":180}", true, now);
+}
+
+// =============================================================================
+// Encoding Tests
+// =============================================================================
+
+void test_encode_publish_packet() {
+    uint8_t buffer[32];
+    size_t size = PacketBatcher::encode("a/b", "42", true, buffer, sizeof(buffer));
+    const uint8_t expected[] = {0x31, 0x07, 0x00, 0x03, 'a', '/', 'b', '4', '2'};
+    TEST_ASSERT_EQUAL(sizeof(expected), size);
+    TEST_ASSERT_EQUAL_MEMORY(expected, buffer, sizeof(expected));
+}
+
+void test_decode_round_trip_long_payload() {
+    char payload[201];
+    memset(payload, 'x', 200);
+    payload[200] = '\0';
+    uint8_t buffer[256];
+    size_t size = PacketBatcher::encode("m/logs", payload, false, buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL(1 + 2 + 2 + 6 + 200, size); // Two-byte remaining length
+
+    size_t offset = 0;
+    char topic[32];
+    const uint8_t* data;
+    size_t length;
+    bool retain;
+    TEST_ASSERT_TRUE(PacketBatcher::decode(buffer, size, offset, topic, sizeof(topic),
+                                           data, length, retain));
+    TEST_ASSERT_EQUAL_STRING("m/logs", topic);
+    TEST_ASSERT_EQUAL(200, length);
+    TEST_ASSERT_FALSE(retain);
+    TEST_ASSERT_EQUAL(size, offset);
+    TEST_ASSERT_FALSE(PacketBatcher::decode(buffer, size, offset, topic, sizeof(topic),
+                                            data, length, retain));
+}
+
+// =============================================================================
+// Coalescing Tests
+// =============================================================================
+
+void test_unbatched_tick_writes_every_packet() {
+    PacketBatcher batcher;
+    batcher.setWriter(fakeWrite);
+    batcher.setLimits(IOT_MQTT_BATCH_BYTES, 0);
+    publishTick(batcher, 1000);
+    TEST_ASSERT_EQUAL(6, writeCalls);
+}
+
+void test_batched_tick_is_one_write() {
+    PacketBatcher batcher;
+    batcher.setWriter(fakeWrite);
+    publishTick(batcher, 1000);
+    TEST_ASSERT_EQUAL(0, writeCalls);
+    batcher.flush();
+    TEST_ASSERT_EQUAL(1, writeCalls);
+    TEST_ASSERT_EQUAL(6, batcher.packets());
+
+    // Same bytes on the wire, in publish order
+    size_t offset = 0;
+    char topic[32];
+    const uint8_t* data;
+    size_t length;
+    bool retain;
+    int count = 0;
+    while (PacketBatcher::decode(written, writtenBytes, offset, topic, sizeof(topic),
+                                 data, length, retain)) {
+        if (count == 0) TEST_ASSERT_EQUAL_STRING("m/dht22/temperature", topic);
+        count++;
+    }
+    TEST_ASSERT_EQUAL(6, count);
+    TEST_ASSERT_EQUAL(writtenBytes, offset);
+}
+
+void test_size_cap_splits_batches() {
+    PacketBatcher batcher;
+    batcher.setWriter(fakeWrite);
+    batcher.setLimits(64, 1000);
+    publishTick(batcher, 1000);
+    batcher.flush();
+    TEST_ASSERT_TRUE(writeCalls > 1);
+    TEST_ASSERT_TRUE(writeCalls < 6);
+    TEST_ASSERT_TRUE(largestWrite <= 64);
+    TEST_ASSERT_EQUAL(6, batcher.packets());
+}
+
+void test_oversized_packet_is_rejected() {
+    PacketBatcher batcher;
+    batcher.setWriter(fakeWrite);
+    batcher.setLimits(16, 1000);
+    TEST_ASSERT_FALSE(batcher.add("m/sensors/status", "{\"sensors\":{}}", true, 0));
+    TEST_ASSERT_EQUAL(0, batcher.pending());
+}
+
+void test_max_delay_bounds_latency() {
+    PacketBatcher batcher;
+    batcher.setWriter(fakeWrite);
+    batcher.setLimits(IOT_MQTT_BATCH_BYTES, 50);
+    batcher.add("m/dht22/temperature", "21.50", false, 1000);
+    batcher.add("m/dht22/humidity", "48.20", false, 1030);
+    batcher.poll(1049);
+    TEST_ASSERT_EQUAL(0, writeCalls);
+    batcher.poll(1050);
+    TEST_ASSERT_EQUAL(1, writeCalls);
+    TEST_ASSERT_EQUAL(0, batcher.pending());
+}
+
+void test_clear_drops_staged_packets() {
+    PacketBatcher batcher;
+    batcher.setWriter(fakeWrite);
+    publishTick(batcher, 1000);
+    batcher.clear();
+    TEST_ASSERT_EQUAL(0, batcher.flush());
+    TEST_ASSERT_EQUAL(0, writeCalls);
+}
+
+void test_replay_counts_one_write_per_packet() {
+    ReplayTransport transport;
+    PacketBatcher batcher;
+    batcher.setWriter([&transport](const uint8_t* data, size_t length, size_t& writes) {
+        return transport.writePackets(data, length, writes);
+    });
+    publishTick(batcher, 1000);
+    batcher.flush();
+    TEST_ASSERT_EQUAL(6, transport.accepted);
+    TEST_ASSERT_EQUAL(6, batcher.writes());
+    TEST_ASSERT_EQUAL(6, batcher.packets());
+    TEST_ASSERT_EQUAL(0, batcher.dropped());
+}
+
+void test_refused_packets_are_counted_dropped() {
+    ReplayTransport transport;
+    transport.capacity = 4;
+    PacketBatcher batcher;
+    batcher.setWriter([&transport](const uint8_t* data, size_t length, size_t& writes) {
+        return transport.writePackets(data, length, writes);
+    });
+    publishTick(batcher, 1000);
+    batcher.flush();
+    TEST_ASSERT_EQUAL(4, batcher.writes());
+    TEST_ASSERT_EQUAL(4, batcher.packets());
+    TEST_ASSERT_EQUAL(2, batcher.dropped());
+    TEST_ASSERT_EQUAL(0, batcher.pending());
+}
+
+void test_replaying_transport_is_not_batched() {
+    ReplayTransport transport;
+    MqttClient client;
+    client.setTransport(&transport);
+    client.publish("m/dht22/temperature", "21.50", false);
+    TEST_ASSERT_EQUAL(1, transport.accepted);
+    TEST_ASSERT_EQUAL(0, client.batchPackets());
+}
+
+// =============================================================================
+// Retained Tests
+// =============================================================================
+
+void test_refused_retained_publish_is_sent_again() {
+    ReplayTransport transport;
+    transport.capacity = 0;
+    MqttClient client;
+    client.setTransport(&transport);
+    client.setBatching(0, 0);
+
+    client.publish("m/sensors/status", "{}", true);
+    TEST_ASSERT_EQUAL(0, transport.accepted);
+
+    // Not a duplicate: the broker never got it
+    transport.capacity = 100;
+    client.publish("m/sensors/status", "{}", true);
+    TEST_ASSERT_EQUAL(1, transport.accepted);
+    client.publish("m/sensors/status", "{}", true);
+    TEST_ASSERT_EQUAL(1, transport.accepted);
+}
+
+void test_dropped_retained_packet_is_sent_again() {
+    ReplayTransport transport;
+    transport.capacity = 1;
+    MqttClient client;
+    client.setTransport(&transport);
+    client.setBatching(IOT_MQTT_BATCH_BYTES, IOT_MQTT_BATCH_DELAY_MS);
+
+    client.publish("m/dht22/temperature", "21.50", false);
+    client.publish("m/sensors/status", "{}", true);
+    client.flush();
+    TEST_ASSERT_EQUAL(1, client.batchDropped());
+
+    transport.capacity = 100;
+    client.publish("m/sensors/status", "{}", true);
+    client.flush();
+    TEST_ASSERT_EQUAL(2, transport.accepted);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Encoding
+    RUN_TEST(test_encode_publish_packet);
+    RUN_TEST(test_decode_round_trip_long_payload);
+
+    // Coalescing
+    RUN_TEST(test_unbatched_tick_writes_every_packet);
+    RUN_TEST(test_batched_tick_is_one_write);
+    RUN_TEST(test_size_cap_splits_batches);
+    RUN_TEST(test_oversized_packet_is_rejected);
+    RUN_TEST(test_max_delay_bounds_latency);
+    RUN_TEST(test_clear_drops_staged_packets);
+
+    // Transport Writes
+    RUN_TEST(test_replay_counts_one_write_per_packet);
+    RUN_TEST(test_refused_packets_are_counted_dropped);
+    RUN_TEST(test_replaying_transport_is_not_batched);
+
+    // Retained
+    RUN_TEST(test_refused_retained_publish_is_sent_again);
+    RUN_TEST(test_dropped_retained_packet_is_sent_again);
+
+    return UNITY_END();
+}
@@ -0,0 +1,180 @@
+/**
+ * @file test_phase_spread/test_main.cpp
+ * @brief Unit tests for PeriodicTask and a fleet publish-rate simulation
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include <cstring>
+#include "../../src/core/PeriodicTask.h"
+#include "../../src/core/SensorRegistry.h"
+
+// Fleet powered up together after an outage
+const int FLEET_SIZE = 100;
+const unsigned long SIM_DURATION = 120000;
+const unsigned long SIM_STEP = 100;                 // Loop granularity
+const int BUCKETS = SIM_DURATION / SIM_STEP;
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// Chip IDs as built by IotMesurable (sequential MACs from one batch)
+void chipId(int module, char* out, size_t size) {
+    snprintf(out, size, "%016llX", 0x0000A4CF12345600ULL + (unsigned long long)module);
+}
+
+/**
+ * @brief Run status (5 s), system (30 s) and telemetry (60 s) schedules of
+ *        the whole fleet and return the peak number of messages per step
+ */
+int simulateFleet(bool spread, int* total) {
+    static int perStep[BUCKETS];
+    memset(perStep, 0, sizeof(perStep));
+    *total = 0;
+
+    for (int m = 0; m < FLEET_SIZE; m++) {
+        char id[17];
+        chipId(m, id, sizeof(id));
+        uint16_t phase = spread ? PeriodicTask::phaseFromId(id) : 0;
+
+        PeriodicTask status(5000, phase);
+        PeriodicTask system(30000, phase);
+        SensorRegistry reg;
+        reg.setPublishPhase(phase);
+        reg.registerHardware("dht22", "DHT22");
+        reg.addSensor("dht22", "temperature");
+
+        for (int step = 0; step < BUCKETS; step++) {
+            // Boot takes a moment: loop starts after WiFi is up
+            unsigned long now = 1000 + step * SIM_STEP;
+            if (status.due(now)) perStep[step]++;
+            if (system.due(now)) perStep[step] += 3; // system, hardware, metrics
+            if (reg.canPublish("dht22", now)) {
+                reg.updatePublishTime("dht22", now);
+                perStep[step]++;
+            }
+        }
+    }
+
+    int peak = 0;
+    for (int step = 0; step < BUCKETS; step++) {
+        *total += perStep[step];
+        if (perStep[step] > peak) peak = perStep[step];
+    }
+    return peak;
+}
+
+// =============================================================================
+// PeriodicTask Tests
+// =============================================================================
+
+void test_task_runs_on_phase_grid() {
+    PeriodicTask task(1000, 250);
+    TEST_ASSERT_EQUAL(250, task.offset());
+    TEST_ASSERT_FALSE(task.due(100));
+    TEST_ASSERT_TRUE(task.due(250));
+    TEST_ASSERT_FALSE(task.due(1000));
+    TEST_ASSERT_TRUE(task.due(1250));
+    TEST_ASSERT_TRUE(task.due(2300));
+}
+
+void test_task_skips_missed_deadlines() {
+    PeriodicTask task(1000, 0);
+    TEST_ASSERT_TRUE(task.due(0));
+    // Blocked for several periods: one run, then back on the grid
+    TEST_ASSERT_TRUE(task.due(5500));
+    TEST_ASSERT_FALSE(task.due(5900));
+    TEST_ASSERT_TRUE(task.due(6000));
+}
+
+void test_task_starts_on_next_grid_point() {
+    PeriodicTask task(1000, 500);
+    TEST_ASSERT_FALSE(task.due(3700));
+    TEST_ASSERT_TRUE(task.due(4500));
+}
+
+void test_task_zero_period_never_due() {
+    PeriodicTask task(0, 0);
+    TEST_ASSERT_FALSE(task.due(0));
+    TEST_ASSERT_FALSE(task.due(100000));
+}
+
+void test_task_phase_change_moves_grid() {
+    PeriodicTask task(1000, 0);
+    TEST_ASSERT_TRUE(task.due(2000));
+    task.setPhase(300);
+    TEST_ASSERT_FALSE(task.due(2100));
+    TEST_ASSERT_TRUE(task.due(2300));
+    TEST_ASSERT_TRUE(task.due(3300));
+}
+
+void test_phase_from_id_is_deterministic() {
+    TEST_ASSERT_EQUAL(PeriodicTask::phaseFromId("A4CF12345600"),
+                      PeriodicTask::phaseFromId("A4CF12345600"));
+    TEST_ASSERT_TRUE(PeriodicTask::phaseFromId("A4CF12345600") < IOT_PHASE_STEPS);
+    TEST_ASSERT_NOT_EQUAL(PeriodicTask::phaseFromId("A4CF12345600"),
+                          PeriodicTask::phaseFromId("A4CF12345601"));
+}
+
+// =============================================================================
+// Registry Phase Tests
+// =============================================================================
+
+void test_first_publish_waits_for_phase() {
+    SensorRegistry reg;
+    reg.setPublishPhase(500);
+    reg.registerHardware("dht22", "DHT22");
+    reg.setHardwareInterval("dht22", 60000);
+
+    TEST_ASSERT_FALSE(reg.canPublish("dht22", 29999));
+    TEST_ASSERT_TRUE(reg.canPublish("dht22", 30000));
+    reg.updatePublishTime("dht22", 30000);
+    TEST_ASSERT_FALSE(reg.canPublish("dht22", 89999));
+    TEST_ASSERT_TRUE(reg.canPublish("dht22", 90000));
+}
+
+// =============================================================================
+// Fleet Simulation Tests
+// =============================================================================
+
+void test_fleet_rate_is_flattened() {
+    int lockstepTotal, spreadTotal;
+    int lockstepPeak = simulateFleet(false, &lockstepTotal);
+    int spreadPeak = simulateFleet(true, &spreadTotal);
+
+    // Same traffic, spread over time
+    TEST_ASSERT_INT_WITHIN(FLEET_SIZE * 6, lockstepTotal, spreadTotal);
+    // In lockstep every module hits the same instant
+    TEST_ASSERT_TRUE(lockstepPeak >= FLEET_SIZE);
+    // 100 modules over 50 status slots: a handful per step at most
+    TEST_ASSERT_TRUE(spreadPeak * 10 <= lockstepPeak);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // PeriodicTask
+    RUN_TEST(test_task_runs_on_phase_grid);
+    RUN_TEST(test_task_skips_missed_deadlines);
+    RUN_TEST(test_task_starts_on_next_grid_point);
+    RUN_TEST(test_task_zero_period_never_due);
+    RUN_TEST(test_task_phase_change_moves_grid);
+    RUN_TEST(test_phase_from_id_is_deterministic);
+
+    // Registry phase
+    RUN_TEST(test_first_publish_waits_for_phase);
+
+    // Fleet simulation
+    RUN_TEST(test_fleet_rate_is_flattened);
+
+    return UNITY_END();
+}
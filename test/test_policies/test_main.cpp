@@ -0,0 +1,233 @@
+/**
+ * @file test_policies/test_main.cpp
+ * @brief Tests of BasicIotMesurable configurations over FakeBroker
+ */
+
+#include <unity.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "../../src/IotMesurableImpl.h"
+#include "../../src/core/FakeBroker.h"
+
+// Values with one decimal, everything else as JSON
+struct ShortEncoder : JsonEncoder {
+    static size_t value(char* buffer, size_t bufferSize, float value) {
+        return snprintf(buffer, bufferSize, "%.1f", value);
+    }
+};
+
+// Room for a two-sensor status, not for more
+struct SmallLimits : DefaultLimits {
+    static const size_t MODULE_ID = 16;
+    static const size_t TOPIC = 32;
+    static const size_t STATUS = 160;
+};
+
+typedef BasicIotMesurable<MqttClient, ConfigManager, ShortEncoder, DefaultLimits> ShortModule;
+typedef BasicIotMesurable<MqttClient, ConfigManager, JsonEncoder, SmallLimits> SmallModule;
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+static size_t countTopic(const FakeBroker& broker, const char* topic) {
+    size_t count = 0;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        if (broker.received()[i].topic == topic) count++;
+    }
+    return count;
+}
+
+template <class Module>
+static void connect(Module& module, FakeBroker& broker) {
+    module.setPhase(0);
+    module.setTransport(&broker);
+    module.begin("ssid", "password", "broker", 1883);
+    broker.advance(10);
+    module.loop();
+    TEST_ASSERT_TRUE(module.isConnected());
+}
+
+// =============================================================================
+// Configuration Tests
+// =============================================================================
+
+void test_default_configuration_is_iot_mesurable() {
+    TEST_ASSERT_TRUE((std::is_same<IotMesurable, BasicIotMesurable<> >::value));
+    // Policies are called directly: no vtable in the module
+    TEST_ASSERT_FALSE(std::is_polymorphic<IotMesurable>::value);
+    TEST_ASSERT_FALSE(std::is_polymorphic<JsonEncoder>::value);
+    // The module holds its MQTT client by value and hands out this
+    TEST_ASSERT_FALSE(std::is_copy_constructible<IotMesurable>::value);
+    TEST_ASSERT_FALSE(std::is_copy_assignable<IotMesurable>::value);
+}
+
+void test_hub_module_holds_no_client() {
+    TEST_ASSERT_TRUE(sizeof(HubModule) + sizeof(MqttClient) <= sizeof(IotMesurable));
+    // A hub module needs its hub, a module with its own client has none
+    TEST_ASSERT_FALSE((std::is_constructible<HubModule, const char*>::value));
+    TEST_ASSERT_TRUE((std::is_constructible<HubModule, const char*, MqttHub&>::value));
+    TEST_ASSERT_FALSE((std::is_constructible<IotMesurable, const char*, MqttHub&>::value));
+}
+
+void test_limits_size_the_module() {
+    TEST_ASSERT_TRUE(sizeof(SmallModule) < sizeof(IotMesurable));
+    TEST_ASSERT_EQUAL(sizeof(IotMesurable), sizeof(ShortModule));
+}
+
+// =============================================================================
+// Encoder Tests
+// =============================================================================
+
+void test_encoder_formats_values() {
+    FakeBroker broker;
+    ShortModule module("m");
+    module.registerHardware("dht22", "DHT22");
+    module.addSensor("dht22", "temperature");
+    connect(module, broker);
+
+    module.publish("dht22", "temperature", 21.54f);
+    module.loop();
+    broker.settle();
+    TEST_ASSERT_EQUAL(1, countTopic(broker, "m/dht22/temperature"));
+    TEST_ASSERT_EQUAL_STRING("21.5", broker.received().back().payload.c_str());
+}
+
+void test_json_encoder_status_in_place() {
+    SensorRegistry registry;
+    registry.registerHardware("dht22", "DHT22");
+    registry.addSensor("dht22", "temperature");
+
+    char buffer[128];
+    size_t length = JsonEncoder::status(buffer, sizeof(buffer), "m", "climate", registry);
+    TEST_ASSERT_EQUAL(strlen(buffer), length);
+    TEST_ASSERT_EQUAL_STRING("{\"moduleId\":\"m\",\"moduleType\":\"climate\",\"sensors\":"
+                             "{\"dht22:temperature\":{\"status\":\"missing\",\"value\":null}}}",
+                             buffer);
+
+    // Too small: reported, nothing written past the end
+    char small[40];
+    memset(small, 'x', sizeof(small));
+    TEST_ASSERT_TRUE(JsonEncoder::status(small, 32, "m", "climate", registry) >= 32);
+    TEST_ASSERT_EQUAL('x', small[32]);
+}
+
+void test_json_encoder_status_parts() {
+    SensorRegistry registry;
+    registry.registerHardware("dht22", "DHT22");
+    registry.addSensor("dht22", "temperature");
+    registry.addSensor("dht22", "humidity");
+
+    // One entry per part
+    char buffer[128];
+    size_t next = 0;
+    JsonEncoder::status(buffer, 120, "m", "climate", registry, &next);
+    TEST_ASSERT_EQUAL(1, next);
+    TEST_ASSERT_EQUAL_STRING("{\"moduleId\":\"m\",\"moduleType\":\"climate\",\"sensors\":"
+                             "{\"dht22:temperature\":{\"status\":\"missing\",\"value\":null}},"
+                             "\"more\":true}", buffer);
+    JsonEncoder::status(buffer, 120, "m", "climate", registry, &next);
+    TEST_ASSERT_EQUAL(0, next);
+    TEST_ASSERT_EQUAL_STRING("{\"moduleId\":\"m\",\"moduleType\":\"climate\",\"sensors\":"
+                             "{\"dht22:humidity\":{\"status\":\"missing\",\"value\":null}}}",
+                             buffer);
+
+    // An entry larger than a whole part is left out, never cut
+    registry.addSensor("dht22", "volumetric_water_content");
+    next = 0;
+    size_t length = JsonEncoder::status(buffer, 120, "m", "climate", registry, &next);
+    TEST_ASSERT_EQUAL(1, next);
+    length = JsonEncoder::status(buffer, 120, "m", "climate", registry, &next);
+    TEST_ASSERT_EQUAL(0, next);
+    TEST_ASSERT_TRUE(length < 120);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "dht22:humidity"));
+    TEST_ASSERT_NULL(strstr(buffer, "volumetric"));
+}
+
+// =============================================================================
+// Limits Tests
+// =============================================================================
+
+void test_oversized_status_sent_in_parts() {
+    FakeBroker broker;
+    SmallModule module("m");
+    module.registerHardware("dht22", "DHT22");
+    module.addSensor("dht22", "temperature");
+    connect(module, broker);
+    broker.settle();
+    size_t published = countTopic(broker, "m/sensors/status");
+
+    module.publishStatusNow();
+    module.loop();
+    broker.settle();
+    TEST_ASSERT_EQUAL(published + 1, countTopic(broker, "m/sensors/status"));
+    TEST_ASSERT_NULL(strstr(broker.retained("m/sensors/status"), "\"more\""));
+
+    // Three sensors no longer fit in 160 bytes: whole entries in two parts
+    module.addSensor("dht22", "humidity");
+    module.addSensor("dht22", "dew_point");
+    module.publishStatusNow();
+    module.loop();
+    broker.settle();
+
+    std::string all;
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        const BrokerMessage& message = broker.received()[i];
+        if (message.topic != "m/sensors/status") continue;
+        TEST_ASSERT_TRUE(message.retain);
+        TEST_ASSERT_TRUE(message.payload.size() < SmallLimits::STATUS);
+        parts.push_back(message.payload);
+        if (parts.size() > published + 1) all += message.payload;
+    }
+    TEST_ASSERT_EQUAL(published + 3, parts.size());
+    TEST_ASSERT_NOT_NULL(strstr(parts[published + 1].c_str(), ",\"more\":true}"));
+    TEST_ASSERT_NULL(strstr(parts[published + 2].c_str(), "\"more\""));
+    TEST_ASSERT_NOT_NULL(strstr(all.c_str(), "\"dht22:temperature\""));
+    TEST_ASSERT_NOT_NULL(strstr(all.c_str(), "\"dht22:humidity\""));
+    TEST_ASSERT_NOT_NULL(strstr(all.c_str(), "\"dht22:dew_point\""));
+}
+
+void test_long_topics_dropped() {
+    FakeBroker broker;
+    SmallModule module("m");
+    module.registerHardware("a-very-long-hardware-key", "Sensor");
+    module.addSensor("a-very-long-hardware-key", "temperature");
+    connect(module, broker);
+    broker.settle();
+
+    size_t before = broker.received().size();
+    module.publish("a-very-long-hardware-key", "temperature", 20.0f);
+    module.loop();
+    broker.settle();
+    TEST_ASSERT_EQUAL(before, broker.received().size());
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Configuration
+    RUN_TEST(test_default_configuration_is_iot_mesurable);
+    RUN_TEST(test_hub_module_holds_no_client);
+    RUN_TEST(test_limits_size_the_module);
+
+    // Encoder
+    RUN_TEST(test_encoder_formats_values);
+    RUN_TEST(test_json_encoder_status_in_place);
+    RUN_TEST(test_json_encoder_status_parts);
+
+    // Limits
+    RUN_TEST(test_oversized_status_sent_in_parts);
+    RUN_TEST(test_long_topics_dropped);
+
+    return UNITY_END();
+}
@@ -0,0 +1,423 @@
+/**
+ * @file test_posix_port/test_main.cpp
+ * @brief Tests for the POSIX/Linux port (pio test -e linux)
+ *
+ * The broker side is played by the test over a loopback TCP socket, so the
+ * real epoll transport, framing and MqttClient run unmodified.
+ */
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../../src/core/ConfigManager.h"
+#include "../../src/core/MqttClient.h"
+#include "../../src/posix/PosixMqttTransport.h"
+
+static std::string lastTopic;
+static std::string lastPayload;
+static std::vector<bool> connectEvents;
+
+void setUp(void) {
+    lastTopic.clear();
+    lastPayload.clear();
+    connectEvents.clear();
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Broker Stand-In
+// =============================================================================
+
+struct Packet {
+    uint8_t header;
+    std::vector<uint8_t> body;
+};
+
+static int listenLocal(uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&address, sizeof(address));
+    listen(fd, 1);
+    socklen_t length = sizeof(address);
+    getsockname(fd, (struct sockaddr*)&address, &length);
+    port = ntohs(address.sin_port);
+    return fd;
+}
+
+static int acceptClient(int listener) {
+    int fd = accept(listener, nullptr, nullptr);
+    struct timeval timeout = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static bool readExactly(int fd, uint8_t* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(fd, buffer, length, 0);
+        if (received <= 0) return false;
+        buffer += received;
+        length -= (size_t)received;
+    }
+    return true;
+}
+
+static bool readPacket(int fd, Packet& packet) {
+    if (!readExactly(fd, &packet.header, 1)) return false;
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    uint8_t digit;
+    do {
+        if (!readExactly(fd, &digit, 1)) return false;
+        remaining += (digit & 0x7F) * multiplier;
+        multiplier *= 128;
+    } while (digit & 0x80);
+    packet.body.assign(remaining, 0);
+    return remaining == 0 || readExactly(fd, packet.body.data(), remaining);
+}
+
+// Topic of a PUBLISH body
+static std::string publishTopic(const Packet& packet) {
+    size_t length = (packet.body[0] << 8) | packet.body[1];
+    return std::string((const char*)packet.body.data() + 2, length);
+}
+
+static std::string publishPayload(const Packet& packet) {
+    size_t offset = 2 + publishTopic(packet).size() + (((packet.header >> 1) & 0x03) ? 2 : 0);
+    return std::string((const char*)packet.body.data() + offset, packet.body.size() - offset);
+}
+
+static void sendBytes(int fd, const std::vector<uint8_t>& bytes) {
+    send(fd, bytes.data(), bytes.size(), 0);
+}
+
+// QoS 0 PUBLISH from the broker
+static std::vector<uint8_t> publishBytes(const std::string& topic, const std::string& payload,
+                                         bool retain) {
+    std::vector<uint8_t> bytes;
+    bytes.push_back(retain ? 0x31 : 0x30);
+    size_t remaining = 2 + topic.size() + payload.size();
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        if (remaining > 0) digit |= 0x80;
+        bytes.push_back(digit);
+    } while (remaining > 0);
+    bytes.push_back((uint8_t)(topic.size() >> 8));
+    bytes.push_back((uint8_t)(topic.size() & 0xFF));
+    bytes.insert(bytes.end(), topic.begin(), topic.end());
+    bytes.insert(bytes.end(), payload.begin(), payload.end());
+    return bytes;
+}
+
+static void pump(MqttClient& client, bool (*done)(MqttClient&)) {
+    for (int i = 0; i < 200 && !done(client); i++) {
+        client.loop();
+        delay(1);
+    }
+}
+
+static bool isConnected(MqttClient& client) { return client.isConnected(); }
+static bool isDisconnected(MqttClient& client) { return !client.isConnected(); }
+static bool hasMessage(MqttClient& client) { return !lastPayload.empty(); }
+
+// Connects a client with a presence topic, answers CONNACK
+static int connectClient(MqttClient& client, int listener, uint16_t port) {
+    client.setBroker("127.0.0.1", port);
+    client.setClientId("gateway");
+    client.setPresenceTopic("gateway/presence");
+    client.onConnect([](bool connected) { connectEvents.push_back(connected); });
+    client.onMessage([](const char* topic, const char* payload) {
+        lastTopic = topic;
+        lastPayload = payload;
+    });
+    TEST_ASSERT_TRUE(client.connect());
+
+    int fd = acceptClient(listener);
+    client.loop(); // TCP up: CONNECT goes out
+
+    Packet connect;
+    TEST_ASSERT_TRUE(readPacket(fd, connect));
+    TEST_ASSERT_EQUAL_HEX8(0x10, connect.header);
+    sendBytes(fd, {0x20, 0x02, 0x00, 0x00});
+    pump(client, isConnected);
+    return fd;
+}
+
+// =============================================================================
+// Clock Tests
+// =============================================================================
+
+void test_millis_follows_the_monotonic_clock() {
+    unsigned long start = millis();
+    delay(20);
+    unsigned long elapsed = millis() - start;
+    TEST_ASSERT_TRUE(elapsed >= 20);
+    TEST_ASSERT_TRUE(elapsed < 1000);
+}
+
+// =============================================================================
+// Preferences Tests
+// =============================================================================
+
+void test_preferences_round_trip_through_file() {
+    uint8_t blob[3] = {0x01, 0xAB, 0xFF};
+    {
+        Preferences prefs;
+        TEST_ASSERT_TRUE(prefs.begin("unit", false));
+        prefs.clear();
+        prefs.putString("broker", "10.0.0.2");
+        prefs.putUShort("port", 1884);
+        prefs.putInt("offset", -42);
+        prefs.putBool("enabled", true);
+        prefs.putBytes("blob", blob, sizeof(blob));
+        prefs.end();
+    }
+
+    Preferences prefs;
+    prefs.begin("unit", true);
+    char broker[32];
+    TEST_ASSERT_EQUAL(8, prefs.getString("broker", broker, sizeof(broker)));
+    TEST_ASSERT_EQUAL_STRING("10.0.0.2", broker);
+    TEST_ASSERT_EQUAL(1884, prefs.getUShort("port", 1883));
+    TEST_ASSERT_EQUAL(-42, prefs.getInt("offset"));
+    TEST_ASSERT_TRUE(prefs.getBool("enabled"));
+    TEST_ASSERT_EQUAL(7, prefs.getUInt("missing", 7));
+
+    uint8_t read[3] = {0, 0, 0};
+    TEST_ASSERT_EQUAL(3, prefs.getBytes("blob", read, sizeof(read)));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(blob, read, 3);
+    prefs.end();
+
+    // Human-editable on the gateway
+    std::string path = std::string(Preferences::directory()) + "/unit.prefs";
+    FILE* file = fopen(path.c_str(), "r");
+    TEST_ASSERT_NOT_NULL(file);
+    char contents[256] = "";
+    size_t length = fread(contents, 1, sizeof(contents) - 1, file);
+    contents[length] = '\0';
+    fclose(file);
+    TEST_ASSERT_NOT_NULL(strstr(contents, "broker=10.0.0.2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(contents, "blob=01abff\n"));
+}
+
+void test_config_manager_persists_broker() {
+    {
+        ConfigManager config;
+        config.setBroker("broker.local", 8883);
+    }
+    ConfigManager config;
+    config.loadConfig();
+    TEST_ASSERT_EQUAL_STRING("broker.local", config.getBroker());
+    TEST_ASSERT_EQUAL(8883, config.getPort());
+}
+
+void test_config_manager_persists_rules() {
+    // Longer than a kilobyte, on one line
+    std::string rules = "{\"rules\":[";
+    for (int i = 0; i < 16; i++) {
+        if (i > 0) rules += ",";
+        rules += "{\"id\":\"rule" + std::to_string(i) + "\",\"sensor\":\"dht22:humidity\","
+                 "\"op\":\">\",\"value\":85,\"hysteresis\":3,\"for\":60,\"action\":\"fan\"}";
+    }
+    rules += "]}";
+    TEST_ASSERT_GREATER_THAN(1024, rules.size());
+
+    char stored[2048];
+    {
+        ConfigManager config;
+        TEST_ASSERT_EQUAL(0, config.loadRules(stored, sizeof(stored)));
+        config.saveRules(rules.c_str());
+    }
+    ConfigManager config;
+    TEST_ASSERT_EQUAL(rules.size(), config.loadRules(stored, sizeof(stored)));
+    TEST_ASSERT_EQUAL_STRING(rules.c_str(), stored);
+}
+
+// =============================================================================
+// Transport Tests
+// =============================================================================
+
+void test_connect_sends_will_and_publishes_online() {
+    uint16_t port;
+    int listener = listenLocal(port);
+    MqttClient client;
+    int fd = connectClient(client, listener, port);
+    TEST_ASSERT_TRUE(client.isConnected());
+    TEST_ASSERT_EQUAL(1, connectEvents.size());
+
+    Packet presence;
+    TEST_ASSERT_TRUE(readPacket(fd, presence));
+    TEST_ASSERT_EQUAL_HEX8(0x33, presence.header); // PUBLISH, QoS 1, retain
+    TEST_ASSERT_EQUAL_STRING("gateway/presence", publishTopic(presence).c_str());
+    TEST_ASSERT_EQUAL_STRING("online", publishPayload(presence).c_str());
+
+    close(fd);
+    close(listener);
+}
+
+void test_batch_is_one_socket_write() {
+    uint16_t port;
+    int listener = listenLocal(port);
+    PosixMqttTransport transport;
+    MqttClient client;
+    client.setTransport(&transport);
+    int fd = connectClient(client, listener, port);
+    Packet packet;
+    readPacket(fd, packet); // online
+
+    unsigned long writes = transport.writes();
+    client.publish("gateway/modbus1/power", "1520.0");
+    client.publish("gateway/modbus1/energy", "88.25");
+    client.publish("gateway/modbus1/voltage", "231.4");
+    client.flush();
+    TEST_ASSERT_EQUAL(writes + 1, transport.writes());
+    TEST_ASSERT_EQUAL(0, transport.pending());
+
+    const char* topics[] = {"gateway/modbus1/power", "gateway/modbus1/energy",
+                            "gateway/modbus1/voltage"};
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(readPacket(fd, packet));
+        TEST_ASSERT_EQUAL_HEX8(0x30, packet.header);
+        TEST_ASSERT_EQUAL_STRING(topics[i], publishTopic(packet).c_str());
+    }
+
+    close(fd);
+    close(listener);
+}
+
+void test_incoming_publish_is_delivered_and_acked() {
+    uint16_t port;
+    int listener = listenLocal(port);
+    MqttClient client;
+    int fd = connectClient(client, listener, port);
+    Packet packet;
+    readPacket(fd, packet); // online
+
+    client.subscribe("gateway/sensors/enable");
+    TEST_ASSERT_TRUE(readPacket(fd, packet));
+    TEST_ASSERT_EQUAL_HEX8(0x82, packet.header);
+
+    // QoS 1 PUBLISH, packet ID 7, split across two segments
+    std::string topic = "gateway/sensors/enable";
+    std::string payload = "{\"modbus1\":false}";
+    std::vector<uint8_t> bytes;
+    bytes.push_back(0x32);
+    bytes.push_back((uint8_t)(2 + topic.size() + 2 + payload.size()));
+    bytes.push_back(0);
+    bytes.push_back((uint8_t)topic.size());
+    bytes.insert(bytes.end(), topic.begin(), topic.end());
+    bytes.push_back(0);
+    bytes.push_back(7);
+    bytes.insert(bytes.end(), payload.begin(), payload.end());
+    sendBytes(fd, std::vector<uint8_t>(bytes.begin(), bytes.begin() + 10));
+    client.loop();
+    TEST_ASSERT_TRUE(lastPayload.empty());
+    sendBytes(fd, std::vector<uint8_t>(bytes.begin() + 10, bytes.end()));
+    pump(client, hasMessage);
+
+    TEST_ASSERT_EQUAL_STRING("gateway/sensors/enable", lastTopic.c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"modbus1\":false}", lastPayload.c_str());
+    TEST_ASSERT_TRUE(readPacket(fd, packet));
+    TEST_ASSERT_EQUAL_HEX8(0x40, packet.header); // PUBACK
+    TEST_ASSERT_EQUAL(7, packet.body[1]);
+
+    close(fd);
+    close(listener);
+}
+
+void test_oversized_packet_is_skipped() {
+    uint16_t port;
+    int listener = listenLocal(port);
+    PosixMqttTransport transport;
+    MqttClient client;
+    client.setTransport(&transport);
+    int fd = connectClient(client, listener, port);
+    Packet packet;
+    readPacket(fd, packet); // online
+
+    // A retained message larger than the receive buffer, redelivered on
+    // subscribe, then a regular one
+    std::vector<uint8_t> large = publishBytes("gateway/sensors/config",
+                                              std::string(IOT_POSIX_RX_BYTES + 500, 'x'), true);
+    std::vector<uint8_t> small = publishBytes("gateway/sensors/enable", "{\"modbus1\":true}", false);
+    sendBytes(fd, std::vector<uint8_t>(large.begin(), large.begin() + 1000));
+    client.loop();
+    sendBytes(fd, std::vector<uint8_t>(large.begin() + 1000, large.end()));
+    sendBytes(fd, small);
+    pump(client, hasMessage);
+
+    TEST_ASSERT_TRUE(client.isConnected());
+    TEST_ASSERT_EQUAL(1, connectEvents.size());
+    TEST_ASSERT_EQUAL(1, transport.oversized());
+    TEST_ASSERT_EQUAL_STRING("gateway/sensors/enable", lastTopic.c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"modbus1\":true}", lastPayload.c_str());
+
+    close(fd);
+    close(listener);
+}
+
+void test_clean_disconnect_and_broker_loss() {
+    uint16_t port;
+    int listener = listenLocal(port);
+    MqttClient client;
+    int fd = connectClient(client, listener, port);
+    Packet packet;
+    readPacket(fd, packet); // online
+
+    // Broker goes away: reported through onConnect(false)
+    close(fd);
+    pump(client, isDisconnected);
+    TEST_ASSERT_FALSE(client.isConnected());
+    TEST_ASSERT_EQUAL(2, connectEvents.size());
+    TEST_ASSERT_FALSE(connectEvents[1]);
+
+    // Clean disconnect: "offline" then DISCONNECT
+    fd = connectClient(client, listener, port);
+    readPacket(fd, packet); // online
+    client.disconnect();
+    TEST_ASSERT_TRUE(readPacket(fd, packet));
+    TEST_ASSERT_EQUAL_STRING("offline", publishPayload(packet).c_str());
+    TEST_ASSERT_TRUE(readPacket(fd, packet));
+    TEST_ASSERT_EQUAL_HEX8(0xE0, packet.header);
+
+    close(fd);
+    close(listener);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    char dir[] = "/tmp/iot-mesurable-XXXXXX";
+    setenv("IOT_CONFIG_DIR", mkdtemp(dir), 1);
+
+    UNITY_BEGIN();
+
+    // Clock
+    RUN_TEST(test_millis_follows_the_monotonic_clock);
+
+    // Preferences
+    RUN_TEST(test_preferences_round_trip_through_file);
+    RUN_TEST(test_config_manager_persists_broker);
+    RUN_TEST(test_config_manager_persists_rules);
+
+    // Transport
+    RUN_TEST(test_connect_sends_will_and_publishes_online);
+    RUN_TEST(test_batch_is_one_socket_write);
+    RUN_TEST(test_incoming_publish_is_delivered_and_acked);
+    RUN_TEST(test_oversized_packet_is_skipped);
+    RUN_TEST(test_clean_disconnect_and_broker_loss);
+
+    return UNITY_END();
+}
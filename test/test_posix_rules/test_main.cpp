@@ -0,0 +1,62 @@
+/**
+ * @file test_posix_rules/test_main.cpp
+ * @brief Tests for rule sets kept across restarts (pio test -e linux)
+ *
+ * Rule sets are parsed with ArduinoJson, compiled out of native builds. The
+ * module starts without a reachable broker, as a device rebooting offline.
+ */
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/ConfigManager.h"
+
+static std::vector<std::string> activeRules;
+
+void setUp(void) {
+    activeRules.clear();
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Restore Tests
+// =============================================================================
+
+void test_saved_rules_run_after_restart() {
+    {
+        ConfigManager config;
+        config.saveRules("{\"rules\":[{\"id\":\"hot\",\"sensor\":\"dht22:temperature\","
+                         "\"op\":\">\",\"value\":30,\"action\":\"fan\"}]}");
+    }
+
+    IotMesurable module("m");
+    module.addSensor("dht22", "temperature");
+    module.onRule([](const char* ruleId, const char* action, bool active) {
+        if (active) activeRules.push_back(ruleId);
+    });
+    module.begin("", "", "127.0.0.1", 1); // Nothing listens on port 1
+
+    module.publish("dht22", "temperature", 35.0f);
+    TEST_ASSERT_EQUAL(1, activeRules.size());
+    TEST_ASSERT_EQUAL_STRING("hot", activeRules[0].c_str());
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    char dir[] = "/tmp/iot-mesurable-XXXXXX";
+    setenv("IOT_CONFIG_DIR", mkdtemp(dir), 1);
+
+    UNITY_BEGIN();
+
+    // Restore
+    RUN_TEST(test_saved_rules_run_after_restart);
+
+    return UNITY_END();
+}
@@ -0,0 +1,245 @@
+/**
+ * @file test_posix_stack_budget/test_main.cpp
+ * @brief Stack depth of the library entry points against a budget (pio test -e linux)
+ *
+ * Config, rules and system info handling need ArduinoJson and are compiled
+ * out of native builds, so the budget is checked here: the module runs over
+ * the real epoll transport against a broker played by the test on a
+ * loopback TCP socket.
+ */
+
+#include <unity.h>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/StackMonitor.h"
+
+// Budget of the entry points called from the sketch, in bytes: three
+// quarters of the 8 KB ESP32 loopTask, measured here with 64-bit pointers
+// and without optimization
+#ifndef IOT_STACK_BUDGET
+#define IOT_STACK_BUDGET 6144
+#endif
+
+// Budget of the message callback, which runs on the async_tcp task
+// (CONFIG_ASYNC_TCP_STACK_SIZE, 16 KB by default) below AsyncMqttClient's
+// own frames: half of that task
+#ifndef IOT_MESSAGE_STACK_BUDGET
+#define IOT_MESSAGE_STACK_BUDGET 8192
+#endif
+
+static int configuredInterval;
+
+void setUp(void) {
+    configuredInterval = 0;
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Broker Stand-In
+// =============================================================================
+
+struct Packet {
+    uint8_t header;
+    std::vector<uint8_t> body;
+};
+
+static int listenLocal(uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&address, sizeof(address));
+    listen(fd, 1);
+    socklen_t length = sizeof(address);
+    getsockname(fd, (struct sockaddr*)&address, &length);
+    port = ntohs(address.sin_port);
+    return fd;
+}
+
+static int acceptClient(int listener) {
+    int fd = accept(listener, nullptr, nullptr);
+    struct timeval timeout = {0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+static bool readExactly(int fd, uint8_t* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t received = recv(fd, buffer, length, 0);
+        if (received <= 0) return false;
+        buffer += received;
+        length -= (size_t)received;
+    }
+    return true;
+}
+
+static bool readPacket(int fd, Packet& packet) {
+    if (!readExactly(fd, &packet.header, 1)) return false;
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    uint8_t digit;
+    do {
+        if (!readExactly(fd, &digit, 1)) return false;
+        remaining += (digit & 0x7F) * multiplier;
+        multiplier *= 128;
+    } while (digit & 0x80);
+    packet.body.assign(remaining, 0);
+    return remaining == 0 || readExactly(fd, packet.body.data(), remaining);
+}
+
+static std::string publishTopic(const Packet& packet) {
+    size_t length = (packet.body[0] << 8) | packet.body[1];
+    return std::string((const char*)packet.body.data() + 2, length);
+}
+
+static std::string publishPayload(const Packet& packet) {
+    size_t offset = 2 + publishTopic(packet).size() + (((packet.header >> 1) & 0x03) ? 2 : 0);
+    return std::string((const char*)packet.body.data() + offset, packet.body.size() - offset);
+}
+
+static void sendBytes(int fd, const std::vector<uint8_t>& bytes) {
+    send(fd, bytes.data(), bytes.size(), 0);
+}
+
+// QoS 0 PUBLISH from the broker
+static std::vector<uint8_t> publishBytes(const std::string& topic, const std::string& payload) {
+    std::vector<uint8_t> bytes;
+    bytes.push_back(0x30);
+    size_t remaining = 2 + topic.size() + payload.size();
+    do {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        if (remaining > 0) digit |= 0x80;
+        bytes.push_back(digit);
+    } while (remaining > 0);
+    bytes.push_back((uint8_t)(topic.size() >> 8));
+    bytes.push_back((uint8_t)(topic.size() & 0xFF));
+    bytes.insert(bytes.end(), topic.begin(), topic.end());
+    bytes.insert(bytes.end(), payload.begin(), payload.end());
+    return bytes;
+}
+
+static void pump(IotMesurable& module, int ticks) {
+    for (int i = 0; i < ticks; i++) {
+        module.loop();
+        delay(1);
+    }
+}
+
+// Topic and payload of every PUBLISH sent since the last call
+static void collect(int fd, std::vector<std::pair<std::string, std::string> >& published) {
+    Packet packet;
+    while (readPacket(fd, packet)) {
+        if ((packet.header & 0xF0) == 0x30) {
+            published.push_back(std::make_pair(publishTopic(packet), publishPayload(packet)));
+        }
+    }
+}
+
+// Last payload sent on a topic, nullptr if none
+static const char* payloadOf(const std::vector<std::pair<std::string, std::string> >& published,
+                             const char* topic) {
+    const char* payload = nullptr;
+    for (size_t i = 0; i < published.size(); i++) {
+        if (published[i].first == topic) payload = published[i].second.c_str();
+    }
+    return payload;
+}
+
+static void report(const IotMesurable& module) {
+    char message[128];
+    snprintf(message, sizeof(message), "begin %u, loop %u, message %u, publish %u bytes",
+             (unsigned)module.getStackDepth(StackEntry::Begin),
+             (unsigned)module.getStackDepth(StackEntry::Loop),
+             (unsigned)module.getStackDepth(StackEntry::Message),
+             (unsigned)module.getStackDepth(StackEntry::Publish));
+    TEST_MESSAGE(message);
+}
+
+// =============================================================================
+// Budget Tests
+// =============================================================================
+
+void test_entry_points_within_budget() {
+    uint16_t port;
+    int listener = listenLocal(port);
+    // begin() restores the rule set saved by the last deployment
+    ConfigManager().saveRules("{\"rules\":[{\"id\":\"cold\",\"sensor\":\"dht22:temperature\","
+                              "\"op\":\"<\",\"value\":5}]}");
+    IotMesurable module("m");
+    module.addSensor("dht22", "temperature");
+    module.addSensor("dht22", "humidity");
+    module.setPhase(0);
+    module.onConfigChange([](const char* hardware, int intervalMs) {
+        configuredInterval = intervalMs;
+    });
+    TEST_ASSERT_TRUE(module.begin("", "", "127.0.0.1", port));
+
+    int fd = acceptClient(listener);
+    module.loop(); // TCP up: CONNECT goes out
+    Packet connect;
+    TEST_ASSERT_TRUE(readPacket(fd, connect));
+    TEST_ASSERT_EQUAL_HEX8(0x10, connect.header);
+    sendBytes(fd, {0x20, 0x02, 0x00, 0x00});
+
+    // Subscriptions, then the birth messages (phase 0: right away)
+    pump(module, 20);
+    TEST_ASSERT_TRUE(module.isConnected());
+    module.publish("dht22", "temperature", 21.5f);
+    module.publish("dht22", "humidity", 55.0f);
+
+    sendBytes(fd, publishBytes("m/sensors/config", "{\"sensors\":{\"dht22\":{\"interval\":30}}}"));
+    sendBytes(fd, publishBytes("m/rules",
+                               "{\"rules\":[{\"id\":\"hot\",\"sensor\":\"dht22:temperature\","
+                               "\"op\":\">\",\"value\":30}]}"));
+    pump(module, 20);
+
+    std::vector<std::pair<std::string, std::string> > published;
+    collect(fd, published);
+    report(module);
+
+    // Every path under budget actually ran
+    TEST_ASSERT_EQUAL(30000, configuredInterval);
+    TEST_ASSERT_EQUAL_STRING("{\"ok\":true,\"count\":1}", payloadOf(published, "m/rules/status"));
+    char saved[IOT_RULES_BYTES];
+    TEST_ASSERT_GREATER_THAN(0, ConfigManager().loadRules(saved, sizeof(saved)));
+    TEST_ASSERT_NOT_NULL(payloadOf(published, "m/system/config"));
+    TEST_ASSERT_NOT_NULL(payloadOf(published, "m/hardware/config"));
+    TEST_ASSERT_NOT_NULL(payloadOf(published, "m/system/state"));
+
+    for (uint8_t entry = 0; entry < (uint8_t)StackEntry::Count; entry++) {
+        size_t depth = module.getStackDepth((StackEntry)entry);
+        size_t budget = (StackEntry)entry == StackEntry::Message ? IOT_MESSAGE_STACK_BUDGET
+                                                                 : IOT_STACK_BUDGET;
+        TEST_ASSERT_TRUE_MESSAGE(depth > 0, StackMonitor::metricName((StackEntry)entry));
+        TEST_ASSERT_TRUE_MESSAGE(depth <= budget, StackMonitor::metricName((StackEntry)entry));
+    }
+
+    close(fd);
+    close(listener);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    char dir[] = "/tmp/iot-mesurable-XXXXXX";
+    setenv("IOT_CONFIG_DIR", mkdtemp(dir), 1);
+
+    UNITY_BEGIN();
+
+    // Budget
+    RUN_TEST(test_entry_points_within_budget);
+
+    return UNITY_END();
+}
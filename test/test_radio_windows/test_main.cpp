@@ -0,0 +1,228 @@
+/**
+ * @file test_radio_windows/test_main.cpp
+ * @brief Unit tests for MessageQueue, RadioScheduler and a one-hour
+ *        simulated-clock power model
+ */
+
+#include <unity.h>
+#include <cstring>
+#include "../../src/core/RadioScheduler.h"
+#include "../../src/core/SensorRegistry.h"
+
+const unsigned long ONE_HOUR = 3600000UL;
+const unsigned long LOOP_STEP = 50;    // Simulated loop() period
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+/**
+ * @brief Simulate one hour of a module: status every 5 s, system info every
+ *        30 s and two hardware (10 s and 90 s intervals)
+ */
+struct SimResult {
+    unsigned long radioOnPerHour;
+    unsigned long sent;
+    unsigned long wakeups;
+};
+
+SimResult simulateHour(bool powerSaving) {
+    RadioScheduler radio;
+    MessageQueue queue;
+    SensorRegistry reg;
+    if (powerSaving) {
+        radio.configure(60000, 2000, 0);
+        reg.setIntervalQuantum(60000);
+    }
+    PeriodicTask status(radio.quantize(5000));
+    PeriodicTask system(radio.quantize(30000));
+    reg.registerHardware("soil", "Soil");
+    reg.setHardwareInterval("soil", 10000);
+    reg.registerHardware("dht22", "DHT22");
+    reg.setHardwareInterval("dht22", 90000);
+
+    SimResult result = {0, 0, 0};
+    bool wasOn = false;
+    for (unsigned long now = 0; now <= ONE_HOUR; now += LOOP_STEP) {
+        bool on = radio.update(now);
+        if (on && !wasOn) result.wakeups++;
+        wasOn = on;
+
+        if (status.due(now)) queue.push("m/sensors/status", "{}", true);
+        if (system.due(now)) queue.push("m/system", "{}", true);
+        const char* hardware[] = {"soil", "dht22"};
+        for (const char* hw : hardware) {
+            if (reg.canPublish(hw, now)) {
+                reg.updatePublishTime(hw, now == 0 ? 1 : now);
+                queue.push(hw, "1.00", false);
+            }
+        }
+
+        if (on) {
+            const char* topic;
+            const char* payload;
+            bool retain;
+            while (queue.peek(topic, payload, retain)) {
+                queue.pop();
+                result.sent++;
+            }
+        }
+    }
+    result.radioOnPerHour = radio.radioOnPerHour();
+    return result;
+}
+
+// =============================================================================
+// MessageQueue Tests
+// =============================================================================
+
+void test_queue_keeps_order() {
+    MessageQueue q;
+    q.push("a", "1", false);
+    q.push("b", "2", false);
+
+    const char* topic;
+    const char* payload;
+    bool retain;
+    TEST_ASSERT_TRUE(q.peek(topic, payload, retain));
+    TEST_ASSERT_EQUAL_STRING("a", topic);
+    TEST_ASSERT_EQUAL_STRING("1", payload);
+    q.pop();
+    TEST_ASSERT_TRUE(q.peek(topic, payload, retain));
+    TEST_ASSERT_EQUAL_STRING("b", topic);
+    q.pop();
+    TEST_ASSERT_FALSE(q.peek(topic, payload, retain));
+    TEST_ASSERT_EQUAL(0, q.bytes());
+}
+
+void test_queue_coalesces_retained_state() {
+    MessageQueue q;
+    q.push("m/sensors/status", "{\"v\":1}", true);
+    q.push("m/soil/moisture", "40", false);
+    q.push("m/sensors/status", "{\"v\":2}", true);
+    q.push("m/soil/moisture", "41", false);
+    TEST_ASSERT_EQUAL(3, q.count());
+
+    const char* topic;
+    const char* payload;
+    bool retain;
+    q.peek(topic, payload, retain);
+    TEST_ASSERT_EQUAL_STRING("m/soil/moisture", topic);
+    q.pop();
+    q.peek(topic, payload, retain);
+    TEST_ASSERT_EQUAL_STRING("{\"v\":2}", payload);
+    TEST_ASSERT_TRUE(retain);
+}
+
+void test_queue_full_drops_oldest_volatile() {
+    MessageQueue q;
+    char payload[200];
+    memset(payload, 'x', sizeof(payload) - 1);
+    payload[sizeof(payload) - 1] = '\0';
+
+    q.push("state", "{}", true);
+    for (int i = 0; i < 20; i++) {
+        q.push("values", payload, false);
+    }
+    TEST_ASSERT_TRUE(q.bytes() <= IOT_RADIO_QUEUE_BYTES);
+    TEST_ASSERT_TRUE(q.dropped() > 0);
+
+    // Retained state survives, older samples went first
+    const char* topic;
+    const char* p;
+    bool retain;
+    q.peek(topic, p, retain);
+    TEST_ASSERT_EQUAL_STRING("state", topic);
+}
+
+void test_queue_rejects_oversized_message() {
+    static char huge[IOT_RADIO_QUEUE_BYTES + 1];
+    memset(huge, 'x', sizeof(huge) - 1);
+    MessageQueue q;
+    TEST_ASSERT_FALSE(q.push("t", huge, false));
+    TEST_ASSERT_EQUAL(0, q.count());
+}
+
+// =============================================================================
+// RadioScheduler Tests
+// =============================================================================
+
+void test_disabled_radio_always_on() {
+    RadioScheduler radio;
+    TEST_ASSERT_TRUE(radio.update(0));
+    TEST_ASSERT_TRUE(radio.update(100000));
+    TEST_ASSERT_EQUAL(ONE_HOUR, radio.radioOnPerHour());
+    TEST_ASSERT_EQUAL(5000, radio.quantize(5000));
+}
+
+void test_windows_open_and_close() {
+    RadioScheduler radio;
+    TEST_ASSERT_TRUE(radio.configure(60000, 2000, 500));
+    TEST_ASSERT_FALSE(radio.update(1000));
+    TEST_ASSERT_TRUE(radio.update(30000));
+    TEST_ASSERT_TRUE(radio.update(31999));
+    TEST_ASSERT_FALSE(radio.update(32000));
+    TEST_ASSERT_TRUE(radio.update(90000));
+}
+
+void test_invalid_window_rejected() {
+    RadioScheduler radio;
+    TEST_ASSERT_FALSE(radio.configure(60000, 60000, 0));
+    TEST_ASSERT_FALSE(radio.configure(0, 1000, 0));
+    TEST_ASSERT_FALSE(radio.enabled());
+}
+
+void test_quantize_harmonizes_intervals() {
+    RadioScheduler radio;
+    radio.configure(60000, 2000, 0);
+    TEST_ASSERT_EQUAL(60000, radio.quantize(5000));
+    TEST_ASSERT_EQUAL(120000, radio.quantize(90000));
+    TEST_ASSERT_EQUAL(300000, radio.quantize(300000));
+}
+
+// =============================================================================
+// Power Model Tests
+// =============================================================================
+
+void test_power_saving_cuts_radio_time() {
+    SimResult alwaysOn = simulateHour(false);
+    SimResult saving = simulateHour(true);
+
+    // Radio on about 2 s per minute instead of the whole hour
+    TEST_ASSERT_EQUAL(ONE_HOUR, alwaysOn.radioOnPerHour);
+    TEST_ASSERT_UINT_WITHIN(5000, 120000, saving.radioOnPerHour);
+    // One wakeup per window
+    TEST_ASSERT_UINT_WITHIN(1, 60, saving.wakeups);
+    // Every 10 s sample still goes out, status/system are coalesced
+    TEST_ASSERT_TRUE(saving.sent >= 360);
+    TEST_ASSERT_TRUE(saving.sent < alwaysOn.sent);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // MessageQueue
+    RUN_TEST(test_queue_keeps_order);
+    RUN_TEST(test_queue_coalesces_retained_state);
+    RUN_TEST(test_queue_full_drops_oldest_volatile);
+    RUN_TEST(test_queue_rejects_oversized_message);
+
+    // RadioScheduler
+    RUN_TEST(test_disabled_radio_always_on);
+    RUN_TEST(test_windows_open_and_close);
+    RUN_TEST(test_invalid_window_rejected);
+    RUN_TEST(test_quantize_harmonizes_intervals);
+
+    // Power model
+    RUN_TEST(test_power_saving_cuts_radio_time);
+
+    return UNITY_END();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file test_retained_cache/test_main.cpp
+ * @brief Unit tests for RetainedCache
+ */
+
+#include <unity.h>
+#include <cstdio>
+#include "../../src/core/RetainedCache.h"
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Deduplication Tests
+// =============================================================================
+
+void test_first_publish_is_sent() {
+    RetainedCache cache;
+    TEST_ASSERT_TRUE(cache.shouldSend("m/sensors/status", "{\"a\":1}"));
+}
+
+void test_identical_payload_is_suppressed() {
+    RetainedCache cache;
+    cache.shouldSend("m/sensors/status", "{\"a\":1}");
+    TEST_ASSERT_FALSE(cache.shouldSend("m/sensors/status", "{\"a\":1}"));
+    TEST_ASSERT_EQUAL(1, cache.suppressed());
+    TEST_ASSERT_EQUAL(7, cache.suppressedBytes());
+}
+
+void test_changed_payload_is_sent() {
+    RetainedCache cache;
+    cache.shouldSend("m/sensors/status", "{\"a\":1}");
+    TEST_ASSERT_TRUE(cache.shouldSend("m/sensors/status", "{\"a\":2}"));
+    TEST_ASSERT_FALSE(cache.shouldSend("m/sensors/status", "{\"a\":2}"));
+    // Back to an older payload: the broker holds the newer one
+    TEST_ASSERT_TRUE(cache.shouldSend("m/sensors/status", "{\"a\":1}"));
+}
+
+void test_topics_are_independent() {
+    RetainedCache cache;
+    cache.shouldSend("m/system/config", "{}");
+    TEST_ASSERT_TRUE(cache.shouldSend("m/hardware/config", "{}"));
+    TEST_ASSERT_FALSE(cache.shouldSend("m/system/config", "{}"));
+}
+
+// =============================================================================
+// Refresh Tests
+// =============================================================================
+
+void test_invalidate_forces_one_topic() {
+    RetainedCache cache;
+    cache.shouldSend("m/system/config", "{}");
+    cache.shouldSend("m/hardware/config", "{}");
+    cache.invalidate("m/system/config");
+    TEST_ASSERT_TRUE(cache.shouldSend("m/system/config", "{}"));
+    TEST_ASSERT_FALSE(cache.shouldSend("m/hardware/config", "{}"));
+}
+
+void test_clear_forces_all_topics() {
+    RetainedCache cache;
+    cache.shouldSend("m/system/config", "{}");
+    cache.shouldSend("m/hardware/config", "{}");
+    cache.clear();
+    TEST_ASSERT_TRUE(cache.shouldSend("m/system/config", "{}"));
+    TEST_ASSERT_TRUE(cache.shouldSend("m/hardware/config", "{}"));
+}
+
+void test_full_table_recycles_oldest() {
+    RetainedCache cache;
+    char topic[32];
+    for (int i = 0; i <= IOT_RETAINED_CACHE_SIZE; i++) {
+        snprintf(topic, sizeof(topic), "m/topic/%d", i);
+        TEST_ASSERT_TRUE(cache.shouldSend(topic, "x"));
+    }
+    // Topic 0 was recycled: a duplicate gets through, the newest is still known
+    TEST_ASSERT_TRUE(cache.shouldSend("m/topic/0", "x"));
+    snprintf(topic, sizeof(topic), "m/topic/%d", IOT_RETAINED_CACHE_SIZE);
+    TEST_ASSERT_FALSE(cache.shouldSend(topic, "x"));
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Deduplication
+    RUN_TEST(test_first_publish_is_sent);
+    RUN_TEST(test_identical_payload_is_suppressed);
+    RUN_TEST(test_changed_payload_is_sent);
+    RUN_TEST(test_topics_are_independent);
+
+    // Refresh
+    RUN_TEST(test_invalidate_forces_one_topic);
+    RUN_TEST(test_clear_forces_all_topics);
+    RUN_TEST(test_full_table_recycles_oldest);
+
+    return UNITY_END();
+}
@@ -0,0 +1,211 @@
+/**
+ * @file test_rule_engine/test_main.cpp
+ * @brief Unit tests for RuleEngine
+ */
+
+#include <unity.h>
+#include "../../src/core/RuleEngine.h"
+
+static SensorRegistry registry;
+static RuleEngine engine;
+static SensorRef humidity;
+static int eventCount;
+static bool lastActive;
+
+void setUp(void) {
+    registry = SensorRegistry();
+    registry.registerHardware("dht22", "DHT22");
+    registry.addSensor("dht22", "temperature");
+    registry.addSensor("dht22", "humidity");
+    registry.findSensorRef("dht22", "humidity", humidity);
+
+    engine = RuleEngine();
+    eventCount = 0;
+    lastActive = false;
+    engine.onEvent([](const RuleEvent& event) {
+        eventCount++;
+        lastActive = event.active;
+    });
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+static RuleSpec humidityRule(float hysteresis, unsigned long holdMs) {
+    RuleSpec spec = {"hum-high", "dht22:humidity", ">", 85.0f, hysteresis, holdMs, "fan"};
+    return spec;
+}
+
+// =============================================================================
+// Compilation Tests
+// =============================================================================
+
+void test_compile_valid_rule() {
+    TEST_ASSERT_TRUE(engine.addRule(humidityRule(0, 0), registry));
+    TEST_ASSERT_EQUAL(1, engine.count());
+    TEST_ASSERT_NOT_NULL(engine.getRule("hum-high"));
+}
+
+void test_compile_unknown_sensor_fails() {
+    RuleSpec spec = {"r", "dht22:pressure", ">", 1.0f, 0, 0, "x"};
+    TEST_ASSERT_FALSE(engine.addRule(spec, registry));
+}
+
+void test_load_is_atomic() {
+    engine.addRule(humidityRule(0, 0), registry);
+    RuleSpec specs[] = {
+        {"temp-low", "dht22:temperature", "<", 10.0f, 0, 0, "heater"},
+        {"bad", "dht22:temperature", "=", 10.0f, 0, 0, "x"},
+    };
+    TEST_ASSERT_FALSE(engine.load(specs, 2, registry));
+    TEST_ASSERT_EQUAL(1, engine.count());
+    TEST_ASSERT_NOT_NULL(engine.getRule("hum-high"));
+
+    TEST_ASSERT_TRUE(engine.load(specs, 1, registry));
+    TEST_ASSERT_NULL(engine.getRule("hum-high"));
+    TEST_ASSERT_NOT_NULL(engine.getRule("temp-low"));
+}
+
+void test_load_full_table() {
+    RuleSpec specs[IOT_RULES_MAX + 1];
+    char ids[IOT_RULES_MAX + 1][8];
+    for (size_t i = 0; i <= IOT_RULES_MAX; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "r%u", (unsigned)i);
+        specs[i] = humidityRule(0, 0);
+        specs[i].id = ids[i];
+    }
+    TEST_ASSERT_FALSE(engine.load(specs, IOT_RULES_MAX + 1, registry));
+    TEST_ASSERT_TRUE(engine.load(specs, IOT_RULES_MAX, registry));
+    TEST_ASSERT_EQUAL(IOT_RULES_MAX, engine.count());
+
+    // Every rule compiled in place
+    engine.onSample(humidity, 90.0f, 0);
+    TEST_ASSERT_EQUAL(IOT_RULES_MAX, eventCount);
+    TEST_ASSERT_NOT_NULL(engine.getRule(ids[IOT_RULES_MAX - 1]));
+}
+
+void test_redeploy_clears_active_rules() {
+    engine.addRule(humidityRule(0, 0), registry);
+    engine.onSample(humidity, 90.0f, 0);
+    TEST_ASSERT_TRUE(lastActive);
+
+    // The fan of the removed rule is released
+    RuleSpec spec = {"temp-low", "dht22:temperature", "<", 10.0f, 0, 0, "heater"};
+    TEST_ASSERT_TRUE(engine.load(&spec, 1, registry));
+    TEST_ASSERT_EQUAL(2, eventCount);
+    TEST_ASSERT_FALSE(lastActive);
+
+    // A rule deployed again starts over
+    RuleSpec same = humidityRule(0, 0);
+    engine.load(&same, 1, registry);
+    TEST_ASSERT_EQUAL(2, eventCount);
+    engine.onSample(humidity, 90.0f, 10);
+    TEST_ASSERT_EQUAL(3, eventCount);
+    TEST_ASSERT_TRUE(lastActive);
+}
+
+// =============================================================================
+// Evaluation Tests
+// =============================================================================
+
+void test_threshold_triggers_immediately() {
+    engine.addRule(humidityRule(0, 0), registry);
+    engine.onSample(humidity, 80.0f, 0);
+    TEST_ASSERT_EQUAL(0, eventCount);
+    engine.onSample(humidity, 86.0f, 10);
+    TEST_ASSERT_EQUAL(1, eventCount);
+    TEST_ASSERT_TRUE(lastActive);
+}
+
+void test_other_sensor_does_not_trigger() {
+    engine.addRule(humidityRule(0, 0), registry);
+    SensorRef temperature;
+    registry.findSensorRef("dht22", "temperature", temperature);
+    engine.onSample(temperature, 99.0f, 0);
+    TEST_ASSERT_EQUAL(0, eventCount);
+}
+
+void test_hysteresis_prevents_chatter() {
+    engine.addRule(humidityRule(3.0f, 0), registry);
+    engine.onSample(humidity, 86.0f, 0);
+    engine.onSample(humidity, 84.0f, 10);  // Inside dead band
+    engine.onSample(humidity, 86.0f, 20);
+    TEST_ASSERT_EQUAL(1, eventCount);
+
+    engine.onSample(humidity, 81.0f, 30);  // Below 85 - 3
+    TEST_ASSERT_EQUAL(2, eventCount);
+    TEST_ASSERT_FALSE(lastActive);
+}
+
+void test_hold_duration_via_tick() {
+    engine.addRule(humidityRule(0, 60000), registry);
+    engine.onSample(humidity, 90.0f, 1000);
+    engine.tick(30000);
+    TEST_ASSERT_EQUAL(0, eventCount);
+    engine.tick(61000);
+    TEST_ASSERT_EQUAL(1, eventCount);
+    TEST_ASSERT_TRUE(lastActive);
+}
+
+void test_hold_duration_cancelled_by_drop() {
+    engine.addRule(humidityRule(0, 60000), registry);
+    engine.onSample(humidity, 90.0f, 1000);
+    engine.onSample(humidity, 70.0f, 20000);
+    engine.tick(61000);
+    TEST_ASSERT_EQUAL(0, eventCount);
+}
+
+void test_hold_duration_cancelled_in_hysteresis_band() {
+    engine.addRule(humidityRule(3.0f, 60000), registry);
+    engine.onSample(humidity, 90.0f, 1000);
+    engine.onSample(humidity, 84.0f, 2000);  // Below 85, inside the band
+    engine.tick(61000);
+    TEST_ASSERT_EQUAL(0, eventCount);
+
+    // The hold time starts over once the value is back above
+    engine.onSample(humidity, 90.0f, 62000);
+    engine.tick(121000);
+    TEST_ASSERT_EQUAL(0, eventCount);
+    engine.tick(122000);
+    TEST_ASSERT_EQUAL(1, eventCount);
+}
+
+void test_below_rule() {
+    RuleSpec spec = {"temp-low", "dht22:temperature", "<", 10.0f, 1.0f, 0, "heater"};
+    engine.addRule(spec, registry);
+    SensorRef temperature;
+    registry.findSensorRef("dht22", "temperature", temperature);
+    engine.onSample(temperature, 9.0f, 0);
+    TEST_ASSERT_TRUE(lastActive);
+    engine.onSample(temperature, 10.5f, 10);
+    TEST_ASSERT_TRUE(lastActive);
+    engine.onSample(temperature, 11.5f, 20);
+    TEST_ASSERT_FALSE(lastActive);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Compilation
+    RUN_TEST(test_compile_valid_rule);
+    RUN_TEST(test_compile_unknown_sensor_fails);
+    RUN_TEST(test_load_is_atomic);
+    RUN_TEST(test_load_full_table);
+    RUN_TEST(test_redeploy_clears_active_rules);
+
+    // Evaluation
+    RUN_TEST(test_threshold_triggers_immediately);
+    RUN_TEST(test_other_sensor_does_not_trigger);
+    RUN_TEST(test_hysteresis_prevents_chatter);
+    RUN_TEST(test_hold_duration_via_tick);
+    RUN_TEST(test_hold_duration_cancelled_by_drop);
+    RUN_TEST(test_hold_duration_cancelled_in_hysteresis_band);
+    RUN_TEST(test_below_rule);
+
+    return UNITY_END();
+}
@@ -0,0 +1,217 @@
+/**
+ * @file test_sensor_pipeline/test_main.cpp
+ * @brief Unit tests for SensorPipeline
+ */
+
+#include <unity.h>
+#include "../../src/core/SensorPipeline.h"
+#include "../../src/core/SensorRegistry.h"
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Calibration Tests
+// =============================================================================
+
+void test_empty_pipeline_passes_through() {
+    SensorPipeline p;
+    float out;
+    TEST_ASSERT_TRUE(p.process(12.5f, out));
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, out);
+}
+
+void test_linear_calibration() {
+    SensorPipeline p;
+    p.linear(100.0f / 4095.0f, 0.0f);
+    float out;
+    TEST_ASSERT_TRUE(p.process(4095.0f, out));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 100.0f, out);
+}
+
+void test_polynomial_calibration() {
+    const float coeffs[] = {1.0f, 2.0f, 3.0f};
+    SensorPipeline p;
+    p.polynomial(coeffs, 3);
+    float out;
+    p.process(2.0f, out);
+    TEST_ASSERT_EQUAL_FLOAT(17.0f, out); // 1 + 2*2 + 3*4
+}
+
+void test_unit_conversion() {
+    SensorPipeline p;
+    p.convert("c_to_f");
+    float out;
+    p.process(100.0f, out);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 212.0f, out);
+}
+
+void test_unknown_conversion_invalidates() {
+    SensorPipeline p;
+    p.convert("furlongs_to_parsecs");
+    TEST_ASSERT_FALSE(p.isValid());
+}
+
+void test_too_many_stages_invalidates() {
+    SensorPipeline p;
+    for (int i = 0; i <= IOT_PIPELINE_MAX_STAGES; i++) {
+        p.linear(1.0f, 0.0f);
+    }
+    TEST_ASSERT_FALSE(p.isValid());
+    TEST_ASSERT_EQUAL(IOT_PIPELINE_MAX_STAGES, p.stageCount());
+}
+
+// =============================================================================
+// Filter Tests
+// =============================================================================
+
+void test_ema_smooths() {
+    SensorPipeline p;
+    p.ema(0.5f);
+    float out;
+    p.process(10.0f, out);
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, out);
+    p.process(20.0f, out);
+    TEST_ASSERT_EQUAL_FLOAT(15.0f, out);
+}
+
+void test_median_rejects_single_spike() {
+    SensorPipeline p;
+    p.median(3);
+    float out;
+    p.process(20.0f, out);
+    p.process(21.0f, out);
+    p.process(500.0f, out);
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, out);
+}
+
+void test_hampel_replaces_outlier() {
+    SensorPipeline p;
+    p.hampel(5, 3.0f);
+    const float trace[] = {20.0f, 20.2f, 19.9f, 20.1f, 85.0f};
+    float out = 0;
+    for (float v : trace) {
+        p.process(v, out);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 20.1f, out);
+}
+
+void test_hampel_keeps_normal_sample() {
+    SensorPipeline p;
+    p.hampel(5, 3.0f);
+    const float trace[] = {20.0f, 21.0f, 19.0f, 20.5f, 20.4f};
+    float out = 0;
+    for (float v : trace) {
+        p.process(v, out);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(20.4f, out);
+}
+
+void test_range_rejects_out_of_bounds() {
+    SensorPipeline p;
+    p.range(-40.0f, 80.0f);
+    float out;
+    TEST_ASSERT_TRUE(p.process(25.0f, out));
+    TEST_ASSERT_FALSE(p.process(150.0f, out));
+}
+
+void test_nan_passes_without_touching_state() {
+    SensorPipeline p;
+    p.ema(0.5f);
+    float out;
+    p.process(10.0f, out);
+    TEST_ASSERT_TRUE(p.process(NAN, out));
+    TEST_ASSERT_TRUE(isnan(out));
+    p.process(20.0f, out);
+    TEST_ASSERT_EQUAL_FLOAT(15.0f, out);
+}
+
+void test_stages_compose_in_order() {
+    SensorPipeline p;
+    p.linear(2.0f, 0.0f).range(0.0f, 10.0f);
+    float out;
+    TEST_ASSERT_TRUE(p.process(4.0f, out));
+    TEST_ASSERT_FALSE(p.process(6.0f, out)); // 12 after calibration
+}
+
+// =============================================================================
+// Registry Integration Tests
+// =============================================================================
+
+void test_registry_sensor_with_pipeline() {
+    SensorRegistry reg;
+    reg.registerHardware("soil", "Soil");
+    TEST_ASSERT_TRUE(reg.addSensor("soil", "moisture", SensorPipeline().linear(0.5f, 1.0f)));
+
+    float out;
+    TEST_ASSERT_TRUE(reg.processSample("soil", "moisture", 10.0f, out));
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, out);
+}
+
+void test_registry_sensor_without_pipeline() {
+    SensorRegistry reg;
+    reg.registerHardware("soil", "Soil");
+    reg.addSensor("soil", "moisture");
+
+    float out;
+    TEST_ASSERT_TRUE(reg.processSample("soil", "moisture", 10.0f, out));
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, out);
+    TEST_ASSERT_NULL(reg.getPipeline("soil", "moisture"));
+}
+
+void test_registry_replace_pipeline() {
+    SensorRegistry reg;
+    reg.registerHardware("soil", "Soil");
+    reg.addSensor("soil", "moisture", SensorPipeline().linear(2.0f, 0.0f));
+    TEST_ASSERT_TRUE(reg.setSensorPipeline("soil", "moisture", SensorPipeline().linear(3.0f, 0.0f)));
+
+    float out;
+    reg.processSample("soil", "moisture", 1.0f, out);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, out);
+}
+
+void test_registry_rejects_invalid_pipeline() {
+    SensorRegistry reg;
+    reg.registerHardware("soil", "Soil");
+    reg.addSensor("soil", "moisture");
+    TEST_ASSERT_FALSE(reg.setSensorPipeline("soil", "moisture", SensorPipeline().ema(2.0f)));
+    TEST_ASSERT_NULL(reg.getPipeline("soil", "moisture"));
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Calibration
+    RUN_TEST(test_empty_pipeline_passes_through);
+    RUN_TEST(test_linear_calibration);
+    RUN_TEST(test_polynomial_calibration);
+    RUN_TEST(test_unit_conversion);
+    RUN_TEST(test_unknown_conversion_invalidates);
+    RUN_TEST(test_too_many_stages_invalidates);
+
+    // Filters
+    RUN_TEST(test_ema_smooths);
+    RUN_TEST(test_median_rejects_single_spike);
+    RUN_TEST(test_hampel_replaces_outlier);
+    RUN_TEST(test_hampel_keeps_normal_sample);
+    RUN_TEST(test_range_rejects_out_of_bounds);
+    RUN_TEST(test_nan_passes_without_touching_state);
+    RUN_TEST(test_stages_compose_in_order);
+
+    // Registry Integration
+    RUN_TEST(test_registry_sensor_with_pipeline);
+    RUN_TEST(test_registry_sensor_without_pipeline);
+    RUN_TEST(test_registry_replace_pipeline);
+    RUN_TEST(test_registry_rejects_invalid_pipeline);
+
+    return UNITY_END();
+}
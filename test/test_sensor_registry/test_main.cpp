@@ -0,0 +1,487 @@
+/**
+ * @file test_sensor_registry/test_main.cpp
+ * @brief Unit tests for SensorRegistry
+ */
+
+#include <unity.h>
+#include "../../src/core/SensorRegistry.h"
+#include "../../src/core/DerivedFunctions.h"
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Registration Tests
+// =============================================================================
+
+void test_register_hardware_success() {
+    SensorRegistry reg;
+    TEST_ASSERT_TRUE(reg.registerHardware("dht22", "DHT22 Sensor"));
+    TEST_ASSERT_TRUE(reg.hasHardware("dht22"));
+}
+
+void test_register_hardware_duplicate_fails() {
+    SensorRegistry reg;
+    TEST_ASSERT_TRUE(reg.registerHardware("dht22", "DHT22"));
+    TEST_ASSERT_FALSE(reg.registerHardware("dht22", "DHT22 Again"));
+}
+
+void test_register_hardware_empty_key_fails() {
+    SensorRegistry reg;
+    TEST_ASSERT_FALSE(reg.registerHardware("", "Empty Key"));
+    TEST_ASSERT_FALSE(reg.registerHardware(nullptr, "Null Key"));
+}
+
+void test_add_sensor_success() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    TEST_ASSERT_TRUE(reg.addSensor("dht22", "temperature"));
+    TEST_ASSERT_TRUE(reg.hasSensor("dht22", "temperature"));
+}
+
+void test_add_sensor_to_missing_hardware_fails() {
+    SensorRegistry reg;
+    TEST_ASSERT_FALSE(reg.addSensor("missing", "temperature"));
+}
+
+void test_add_sensor_duplicate_fails() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    TEST_ASSERT_TRUE(reg.addSensor("dht22", "temperature"));
+    TEST_ASSERT_FALSE(reg.addSensor("dht22", "temperature"));
+}
+
+// =============================================================================
+// Composite Key Tests
+// =============================================================================
+
+void test_build_composite_key() {
+    char buffer[64];
+    SensorRegistry::buildCompositeKey("dht22", "temperature", buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("dht22:temperature", buffer);
+}
+
+void test_parse_composite_key_success() {
+    char hw[32], sensor[32];
+    TEST_ASSERT_TRUE(SensorRegistry::parseCompositeKey("dht22:temperature", hw, sensor, 32));
+    TEST_ASSERT_EQUAL_STRING("dht22", hw);
+    TEST_ASSERT_EQUAL_STRING("temperature", sensor);
+}
+
+void test_parse_composite_key_no_colon_fails() {
+    char hw[32], sensor[32];
+    TEST_ASSERT_FALSE(SensorRegistry::parseCompositeKey("nodot", hw, sensor, 32));
+}
+
+void test_parse_composite_key_empty_parts_fails() {
+    char hw[32], sensor[32];
+    TEST_ASSERT_FALSE(SensorRegistry::parseCompositeKey(":sensor", hw, sensor, 32));
+    TEST_ASSERT_FALSE(SensorRegistry::parseCompositeKey("hw:", hw, sensor, 32));
+}
+
+// =============================================================================
+// State Tests
+// =============================================================================
+
+void test_update_sensor_value() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    
+    reg.updateSensorValue("dht22", "temperature", 23.5);
+    
+    SensorDef* sensor = reg.getSensor("dht22", "temperature");
+    TEST_ASSERT_NOT_NULL(sensor);
+    TEST_ASSERT_EQUAL_FLOAT(23.5, sensor->lastValue);
+    TEST_ASSERT_TRUE(sensor->hasValue);
+    TEST_ASSERT_EQUAL_STRING("ok", sensor->status);
+}
+
+void test_hardware_enabled_default() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    TEST_ASSERT_TRUE(reg.isHardwareEnabled("dht22"));
+}
+
+void test_set_hardware_disabled() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    
+    reg.setHardwareEnabled("dht22", false);
+    
+    TEST_ASSERT_FALSE(reg.isHardwareEnabled("dht22"));
+    
+    SensorDef* sensor = reg.getSensor("dht22", "temperature");
+    TEST_ASSERT_EQUAL_STRING("disabled", sensor->status);
+}
+
+// =============================================================================
+// JSON Status Tests
+// =============================================================================
+
+void test_build_status_json_empty() {
+    SensorRegistry reg;
+    char buffer[256];
+    reg.buildStatusJson(buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("{}", buffer);
+}
+
+void test_build_status_json_with_sensor() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    reg.updateSensorValue("dht22", "temperature", 25.0);
+    
+    char buffer[256];
+    reg.buildStatusJson(buffer, sizeof(buffer));
+    
+    // Should contain the composite key and value
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "dht22:temperature"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "25.00"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "ok"));
+}
+
+void test_build_status_json_disabled_hardware() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    reg.setHardwareEnabled("dht22", false);
+    
+    char buffer[256];
+    reg.buildStatusJson(buffer, sizeof(buffer));
+    
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "disabled"));
+}
+
+void test_build_status_json_single_hardware() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    reg.registerHardware("soil", "Soil");
+    reg.addSensor("soil", "moisture");
+    
+    char buffer[256];
+    reg.buildStatusJson(buffer, sizeof(buffer), "soil");
+    
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "soil:moisture"));
+    TEST_ASSERT_NULL(strstr(buffer, "dht22"));
+}
+
+void test_immediate_publish_consumed_once() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    TEST_ASSERT_FALSE(reg.consumeImmediatePublish("dht22"));
+    reg.requestImmediatePublish("dht22");
+    TEST_ASSERT_TRUE(reg.consumeImmediatePublish("dht22"));
+    TEST_ASSERT_FALSE(reg.consumeImmediatePublish("dht22"));
+}
+
+void test_status_change_only_on_change() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    TEST_ASSERT_TRUE(reg.consumeStatusChange());
+    TEST_ASSERT_FALSE(reg.consumeStatusChange());
+
+    reg.updateSensorValue("dht22", "temperature", 21.5f);
+    TEST_ASSERT_TRUE(reg.consumeStatusChange());
+    reg.updateSensorValue("dht22", "temperature", 21.5f);
+    TEST_ASSERT_FALSE(reg.consumeStatusChange());
+}
+
+void test_status_change_on_enable_and_status() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    reg.consumeStatusChange();
+
+    reg.setHardwareEnabled("dht22", true);
+    TEST_ASSERT_FALSE(reg.consumeStatusChange());
+    reg.setHardwareEnabled("dht22", false);
+    TEST_ASSERT_TRUE(reg.consumeStatusChange());
+}
+
+// =============================================================================
+// Derived Sensor Tests
+// =============================================================================
+
+static float sumInputs(const float* inputs, uint8_t count) {
+    float total = 0;
+    for (uint8_t i = 0; i < count; i++) total += inputs[i];
+    return total;
+}
+
+static void setupClimate(SensorRegistry& reg) {
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    reg.addSensor("dht22", "humidity");
+    reg.registerHardware("climate", "Climate");
+}
+
+void test_derived_requires_existing_inputs() {
+    SensorRegistry reg;
+    setupClimate(reg);
+    const char* inputs[] = {"dht22:temperature", "dht22:pressure"};
+    TEST_ASSERT_FALSE(reg.addDerivedSensor("climate", "sum", inputs, 2, sumInputs));
+    TEST_ASSERT_FALSE(reg.hasSensor("climate", "sum"));
+}
+
+void test_derived_not_computed_until_input_changes() {
+    SensorRegistry reg;
+    setupClimate(reg);
+    const char* inputs[] = {"dht22:temperature", "dht22:humidity"};
+    TEST_ASSERT_TRUE(reg.addDerivedSensor("climate", "sum", inputs, 2, sumInputs));
+    TEST_ASSERT_TRUE(reg.isDerived("climate", "sum"));
+
+    const char* hw;
+    const char* type;
+    float value;
+    TEST_ASSERT_FALSE(reg.computeNextDerived(hw, type, value));
+
+    reg.updateSensorValue("dht22", "temperature", 20.0f);
+    reg.updateSensorValue("dht22", "humidity", 50.0f);
+    TEST_ASSERT_TRUE(reg.computeNextDerived(hw, type, value));
+    TEST_ASSERT_EQUAL_STRING("climate", hw);
+    TEST_ASSERT_EQUAL_STRING("sum", type);
+    TEST_ASSERT_EQUAL_FLOAT(70.0f, value);
+
+    // Computed once for both input updates, then clean
+    TEST_ASSERT_FALSE(reg.computeNextDerived(hw, type, value));
+}
+
+void test_derived_unchanged_input_stays_clean() {
+    SensorRegistry reg;
+    setupClimate(reg);
+    const char* inputs[] = {"dht22:temperature"};
+    reg.addDerivedSensor("climate", "copy", inputs, 1, sumInputs);
+
+    const char* hw;
+    const char* type;
+    float value;
+    reg.updateSensorValue("dht22", "temperature", 20.0f);
+    TEST_ASSERT_TRUE(reg.computeNextDerived(hw, type, value));
+    reg.updateSensorValue("dht22", "temperature", 20.0f);
+    TEST_ASSERT_FALSE(reg.computeNextDerived(hw, type, value));
+}
+
+void test_derived_missing_input_is_nan() {
+    SensorRegistry reg;
+    setupClimate(reg);
+    const char* inputs[] = {"dht22:temperature", "dht22:humidity"};
+    reg.addDerivedSensor("climate", "sum", inputs, 2, sumInputs);
+
+    const char* hw;
+    const char* type;
+    float value;
+    reg.updateSensorValue("dht22", "temperature", 20.0f);
+    TEST_ASSERT_TRUE(reg.computeNextDerived(hw, type, value));
+    TEST_ASSERT_TRUE(isnan(value));
+}
+
+void test_derived_chain_propagates() {
+    SensorRegistry reg;
+    setupClimate(reg);
+    const char* first[] = {"dht22:temperature"};
+    const char* second[] = {"climate:copy"};
+    reg.addDerivedSensor("climate", "copy", first, 1, sumInputs);
+    reg.addDerivedSensor("climate", "copy2", second, 1, sumInputs);
+
+    const char* hw;
+    const char* type;
+    float value;
+    reg.updateSensorValue("dht22", "temperature", 5.0f);
+    TEST_ASSERT_TRUE(reg.computeNextDerived(hw, type, value));
+    TEST_ASSERT_EQUAL_STRING("copy", type);
+
+    // Publishing the derived value marks the next level dirty
+    reg.updateSensorValue(hw, type, value);
+    TEST_ASSERT_TRUE(reg.computeNextDerived(hw, type, value));
+    TEST_ASSERT_EQUAL_STRING("copy2", type);
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, value);
+}
+
+void test_psychrometric_functions() {
+    const float inputs[] = {25.0f, 60.0f};
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 16.7f, DerivedFunctions::dewPoint(inputs, 2));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.27f, DerivedFunctions::vpd(inputs, 2));
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 13.8f, DerivedFunctions::absoluteHumidity(inputs, 2));
+}
+
+// =============================================================================
+// Interval Override Tests
+// =============================================================================
+
+void test_override_takes_precedence() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.setHardwareInterval("dht22", 60000);
+    TEST_ASSERT_TRUE(reg.setIntervalOverride("dht22", 1000, 600000, 5000));
+    TEST_ASSERT_TRUE(reg.hasIntervalOverride("dht22"));
+    TEST_ASSERT_EQUAL(1000, reg.getEffectiveInterval("dht22"));
+}
+
+void test_override_expires_on_its_own() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.setHardwareInterval("dht22", 60000);
+    reg.setIntervalOverride("dht22", 1000, 600000, 5000);
+
+    TEST_ASSERT_NULL(reg.expireNextOverride(604999));
+    TEST_ASSERT_EQUAL_STRING("dht22", reg.expireNextOverride(605000));
+    TEST_ASSERT_NULL(reg.expireNextOverride(605000));
+    TEST_ASSERT_EQUAL(60000, reg.getEffectiveInterval("dht22"));
+}
+
+void test_override_not_reported_as_base_interval() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.addSensor("dht22", "temperature");
+    reg.setHardwareInterval("dht22", 60000);
+    reg.setIntervalOverride("dht22", 1000, 600000, 0);
+
+    char buffer[256];
+    reg.buildReportedJson(buffer, sizeof(buffer), true);
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"interval\":60"));
+    TEST_ASSERT_NOT_NULL(strstr(buffer, "\"burst\":{\"interval\":1}"));
+}
+
+void test_override_cleared() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    TEST_ASSERT_FALSE(reg.clearIntervalOverride("dht22"));
+    reg.setIntervalOverride("dht22", 1000, 600000, 0);
+    TEST_ASSERT_TRUE(reg.clearIntervalOverride("dht22"));
+    TEST_ASSERT_FALSE(reg.hasIntervalOverride("dht22"));
+}
+
+// =============================================================================
+// Aligned Sampling Tests
+// =============================================================================
+
+// Wall clock 1699999990000 ms at millis() 0: the next minute starts at
+// millis() 50000 (1700000040000 ms)
+const uint64_t EPOCH_AT_10S = 1700000000000ULL;
+
+void test_aligned_first_publish_waits_for_boundary() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.setHardwareInterval("dht22", 60000);
+    reg.setClock(EPOCH_AT_10S, 10000);
+    reg.setAlignedSampling("dht22", true, 10000);
+
+    TEST_ASSERT_FALSE(reg.canPublish("dht22", 10000));
+    TEST_ASSERT_FALSE(reg.canPublish("dht22", 49999));
+    TEST_ASSERT_TRUE(reg.canPublish("dht22", 50000));
+}
+
+void test_aligned_late_publish_does_not_drift() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.setHardwareInterval("dht22", 60000);
+    reg.setAlignedSampling("dht22", true, 0);
+    reg.setClock(EPOCH_AT_10S, 10000);
+
+    reg.updatePublishTime("dht22", 50250);
+    TEST_ASSERT_EQUAL(250, reg.getAlignmentError("dht22"));
+    // Next deadline is the next boundary, not 60 s after the late sample
+    TEST_ASSERT_FALSE(reg.canPublish("dht22", 109999));
+    TEST_ASSERT_TRUE(reg.canPublish("dht22", 110000));
+
+    // A long stall skips the missed boundaries
+    reg.updatePublishTime("dht22", 290100);
+    TEST_ASSERT_EQUAL(100, reg.getAlignmentError("dht22"));
+    TEST_ASSERT_FALSE(reg.canPublish("dht22", 349999));
+    TEST_ASSERT_TRUE(reg.canPublish("dht22", 350000));
+}
+
+void test_aligned_modules_share_boundaries() {
+    // Second module booted 7.3 s later: same wall time, different millis()
+    SensorRegistry a, b;
+    a.registerHardware("dht22", "DHT22");
+    b.registerHardware("dht22", "DHT22");
+    a.setAlignedSampling("dht22", true, 0);
+    b.setAlignedSampling("dht22", true, 0);
+    a.setClock(EPOCH_AT_10S, 10000);
+    b.setClock(EPOCH_AT_10S, 2700);
+
+    TEST_ASSERT_FALSE(a.canPublish("dht22", 49999));
+    TEST_ASSERT_FALSE(b.canPublish("dht22", 42699));
+    TEST_ASSERT_TRUE(a.canPublish("dht22", 50000));
+    TEST_ASSERT_TRUE(b.canPublish("dht22", 42700));
+}
+
+void test_aligned_without_clock_uses_interval() {
+    SensorRegistry reg;
+    reg.registerHardware("dht22", "DHT22");
+    reg.setHardwareInterval("dht22", 60000);
+    reg.setAlignedSampling("dht22", true, 0);
+
+    TEST_ASSERT_TRUE(reg.canPublish("dht22", 1000));
+    reg.updatePublishTime("dht22", 1000);
+    TEST_ASSERT_EQUAL(-1, reg.getAlignmentError("dht22"));
+    TEST_ASSERT_TRUE(reg.canPublish("dht22", 61000));
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    
+    // Registration
+    RUN_TEST(test_register_hardware_success);
+    RUN_TEST(test_register_hardware_duplicate_fails);
+    RUN_TEST(test_register_hardware_empty_key_fails);
+    RUN_TEST(test_add_sensor_success);
+    RUN_TEST(test_add_sensor_to_missing_hardware_fails);
+    RUN_TEST(test_add_sensor_duplicate_fails);
+    
+    // Composite Keys
+    RUN_TEST(test_build_composite_key);
+    RUN_TEST(test_parse_composite_key_success);
+    RUN_TEST(test_parse_composite_key_no_colon_fails);
+    RUN_TEST(test_parse_composite_key_empty_parts_fails);
+    
+    // State
+    RUN_TEST(test_update_sensor_value);
+    RUN_TEST(test_hardware_enabled_default);
+    RUN_TEST(test_set_hardware_disabled);
+    
+    // JSON Status
+    RUN_TEST(test_build_status_json_empty);
+    RUN_TEST(test_build_status_json_with_sensor);
+    RUN_TEST(test_build_status_json_disabled_hardware);
+    RUN_TEST(test_build_status_json_single_hardware);
+    RUN_TEST(test_immediate_publish_consumed_once);
+    RUN_TEST(test_status_change_only_on_change);
+    RUN_TEST(test_status_change_on_enable_and_status);
+    
+    // Derived Sensors
+    RUN_TEST(test_derived_requires_existing_inputs);
+    RUN_TEST(test_derived_not_computed_until_input_changes);
+    RUN_TEST(test_derived_unchanged_input_stays_clean);
+    RUN_TEST(test_derived_missing_input_is_nan);
+    RUN_TEST(test_derived_chain_propagates);
+    RUN_TEST(test_psychrometric_functions);
+    
+    // Interval Overrides
+    RUN_TEST(test_override_takes_precedence);
+    RUN_TEST(test_override_expires_on_its_own);
+    RUN_TEST(test_override_not_reported_as_base_interval);
+    RUN_TEST(test_override_cleared);
+    
+    // Aligned Sampling
+    RUN_TEST(test_aligned_first_publish_waits_for_boundary);
+    RUN_TEST(test_aligned_late_publish_does_not_drift);
+    RUN_TEST(test_aligned_modules_share_boundaries);
+    RUN_TEST(test_aligned_without_clock_uses_interval);
+    
+    return UNITY_END();
+}
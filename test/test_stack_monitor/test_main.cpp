@@ -0,0 +1,139 @@
+/**
+ * @file test_stack_monitor/test_main.cpp
+ * @brief Stack depth probes of the library entry points
+ */
+
+#include <unity.h>
+#include "../../src/IotMesurable.h"
+#include "../../src/core/FakeBroker.h"
+#include "../../src/core/StackMonitor.h"
+
+// Connects and runs the module through the paths compiled into native
+// builds; the budget over config, rules and system info messages is checked
+// by test_posix_stack_budget
+static void exercise(IotMesurable& module, FakeBroker& broker) {
+    module.addSensor("dht22", "temperature");
+    module.setPhase(0);
+    module.setTransport(&broker);
+    module.begin("ssid", "password", "broker", 1883);
+    broker.advance(10);
+    module.loop();
+    broker.settle();
+
+    module.publish("dht22", "temperature", 21.5f);
+    broker.deliver("m/sensors/get", "{}");
+    broker.settle();
+
+    // Status and metrics
+    broker.advance(30000);
+    module.loop();
+    broker.settle();
+    module.loop();
+}
+
+void setUp(void) {
+    // Runs before each test
+}
+
+void tearDown(void) {
+    // Runs after each test
+}
+
+// =============================================================================
+// Metrics Tests
+// =============================================================================
+
+void test_depths_reported_in_metrics() {
+    FakeBroker broker;
+    IotMesurable module("m");
+    exercise(module, broker);
+
+    const char* payload = nullptr;
+    for (size_t i = 0; i < broker.received().size(); i++) {
+        if (broker.received()[i].topic == "m/system/metrics") {
+            payload = broker.received()[i].payload.c_str();
+        }
+    }
+    TEST_ASSERT_NOT_NULL(payload);
+
+    // Every entry point ran before the report: each depth is measured, and
+    // probes only keep the deepest call since
+    char key[32];
+    for (uint8_t entry = 0; entry < (uint8_t)StackEntry::Count; entry++) {
+        const char* name = StackMonitor::metricName((StackEntry)entry);
+        snprintf(key, sizeof(key), "\"%s\":", name);
+        const char* value = strstr(payload, key);
+        TEST_ASSERT_NOT_NULL_MESSAGE(value, name);
+        long reported = atol(value + strlen(key));
+        TEST_ASSERT_TRUE_MESSAGE(reported > 0, name);
+        TEST_ASSERT_TRUE_MESSAGE((size_t)reported <= module.getStackDepth((StackEntry)entry), name);
+    }
+}
+
+// =============================================================================
+// Probe Tests
+// =============================================================================
+
+// Nested calls of 256-byte frames, each written in full; the recursion goes
+// through a volatile pointer so the optimizer keeps every frame
+static int useStack(int frames);
+static int (*volatile recurse)(int) = useStack;
+
+static int __attribute__((noinline)) useStack(int frames) {
+    volatile uint8_t area[256];
+    for (size_t i = 0; i < sizeof(area); i++) area[i] = (uint8_t)frames;
+    return area[0] + (frames > 1 ? recurse(frames - 1) : 0);
+}
+
+void test_probe_measures_enclosing_scope() {
+    StackMonitor monitor;
+    {
+        StackProbe probe(monitor, StackEntry::Loop);
+        useStack(8);
+    }
+    size_t deep = monitor.depth(StackEntry::Loop);
+    TEST_ASSERT_TRUE(deep >= 2048);
+    TEST_ASSERT_TRUE(deep < 2 * 2048);
+
+    // The deepest call is kept
+    {
+        StackProbe probe(monitor, StackEntry::Loop);
+        useStack(1);
+    }
+    TEST_ASSERT_EQUAL(deep, monitor.depth(StackEntry::Loop));
+    TEST_ASSERT_EQUAL(0, monitor.depth(StackEntry::Publish));
+}
+
+void test_nested_probe_measured() {
+    StackMonitor monitor;
+    {
+        StackProbe outer(monitor, StackEntry::Loop);
+        useStack(8);
+        {
+            StackProbe inner(monitor, StackEntry::Publish);
+            useStack(2);
+        }
+    }
+    size_t inner = monitor.depth(StackEntry::Publish);
+    TEST_ASSERT_TRUE(inner >= 512);
+    TEST_ASSERT_TRUE(inner < 512 + 512);
+    // Repainting for the inner probe keeps what the outer one used before
+    TEST_ASSERT_TRUE(monitor.depth(StackEntry::Loop) >= 2048);
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Metrics
+    RUN_TEST(test_depths_reported_in_metrics);
+
+    // Probe
+    RUN_TEST(test_probe_measures_enclosing_scope);
+    RUN_TEST(test_nested_probe_measured);
+
+    return UNITY_END();
+}
@@ -0,0 +1,118 @@
+/**
+ * @file test_state_report/test_main.cpp
+ * @brief Unit tests for StateReport
+ */
+
+#include <unity.h>
+#include "../../src/core/StateReport.h"
+
+StateReport* report;
+int uptime, heap, rssi;
+
+void setUp(void) {
+    report = new StateReport(600000);
+    uptime = report->addField("uptime", 0);
+    heap = report->addField("heapFreeKb", 4);
+    rssi = report->addField("rssi", 6);
+}
+
+void tearDown(void) {
+    delete report;
+}
+
+// =============================================================================
+// Deadband Tests
+// =============================================================================
+
+void test_first_report_always_due() {
+    TEST_ASSERT_TRUE(report->due(0));
+    report->markSent(0);
+    TEST_ASSERT_FALSE(report->due(1000));
+}
+
+void test_small_changes_are_suppressed() {
+    report->set(heap, 180);
+    report->set(rssi, -60);
+    report->markSent(0);
+
+    report->set(heap, 177);
+    report->set(rssi, -64);
+    TEST_ASSERT_FALSE(report->due(30000));
+}
+
+void test_change_past_threshold_triggers() {
+    report->set(heap, 180);
+    report->set(rssi, -60);
+    report->markSent(0);
+
+    report->set(rssi, -66);
+    TEST_ASSERT_TRUE(report->due(30000));
+    report->markSent(30000);
+
+    // Deadband is relative to the last sent value, not the previous sample
+    report->set(heap, 178);
+    TEST_ASSERT_FALSE(report->due(60000));
+    report->set(heap, 176);
+    TEST_ASSERT_TRUE(report->due(90000));
+}
+
+void test_counter_field_never_triggers() {
+    report->markSent(0);
+    report->set(uptime, 100000);
+    TEST_ASSERT_FALSE(report->due(30000));
+}
+
+void test_heartbeat_after_max_silence() {
+    report->markSent(0);
+    TEST_ASSERT_FALSE(report->due(599999));
+    TEST_ASSERT_TRUE(report->due(600000));
+}
+
+void test_invalidate_forces_report() {
+    report->markSent(0);
+    report->invalidate();
+    TEST_ASSERT_TRUE(report->due(1000));
+}
+
+// =============================================================================
+// JSON Tests
+// =============================================================================
+
+void test_build_json() {
+    report->set(uptime, 3600);
+    report->set(heap, 180);
+    report->set(rssi, -61);
+    char buffer[128];
+    report->buildJson(buffer, sizeof(buffer));
+    TEST_ASSERT_EQUAL_STRING("{\"uptime\":3600,\"heapFreeKb\":180,\"rssi\":-61}", buffer);
+}
+
+void test_field_table_limit() {
+    StateReport r;
+    for (int i = 0; i < IOT_STATE_FIELDS_MAX; i++) {
+        TEST_ASSERT_EQUAL(i, r.addField("f", 1));
+    }
+    TEST_ASSERT_EQUAL(-1, r.addField("extra", 1));
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+
+    // Deadbands
+    RUN_TEST(test_first_report_always_due);
+    RUN_TEST(test_small_changes_are_suppressed);
+    RUN_TEST(test_change_past_threshold_triggers);
+    RUN_TEST(test_counter_field_never_triggers);
+    RUN_TEST(test_heartbeat_after_max_silence);
+    RUN_TEST(test_invalidate_forces_report);
+
+    // JSON
+    RUN_TEST(test_build_json);
+    RUN_TEST(test_field_table_limit);
+
+    return UNITY_END();
+}